@@ -25,6 +25,7 @@
 #define WIFI_TIMEOUT 15                  // Timeout in seconds for saved WiFi connect attempt
 #define WIFI_AUTOCONNECT true           // Auto-connect to stored WiFi
 #define WIFI_PORTAL_TIMEOUT 300         // Portal timeout in seconds (5 mins)
+#define WIFI_CHECK_INTERVAL_MS 5000UL   // WiFi watchdog period (reconnect if lost)
 
 // Portal web server settings
 #define PORTAL_PORT 80                   // Web portal HTTP port
@@ -37,13 +38,38 @@
 // GitHub OTA Configuration
 #define GITHUB_OWNER "articxdev"    // GitHub username
 #define GITHUB_REPO "espota"            // GitHub repository name
+#ifndef VERSION_JSON_URL   // -D override: local stand-in (scripts/standin_server.py ota)
 #define VERSION_JSON_URL "https://raw.githubusercontent.com/" \
                          GITHUB_OWNER "/" GITHUB_REPO "/main/version.json"
+#endif
 #define FIRMWARE_URL_BASE "https://github.com/" \
                           GITHUB_OWNER "/" GITHUB_REPO "/releases/download"
 
 // OTA Check Interval
 #define OTA_CHECK_INTERVAL_SECONDS 60  // Check for updates every 60 seconds (for testing)
+#define OTA_CHECK_BACKOFF_MAX_MS   3600000UL  // Failed checks back off up to 1 hour
+#define OTA_CHECK_JITTER_PCT       25         // Each wait is stretched by a per-device random 0..25 %
+#define OTA_CHECK_POLL_MS          5000UL     // How often the network task asks whether a check is due
+#define OTA_ROLLOUT_WAVE_S         600        // Gap between rollout waves when version.json has no wave_s
+
+// OTA download job (background FreeRTOS task, below the network task)
+#define OTA_TASK_CORE           0
+#define OTA_TASK_PRIORITY       1
+#define OTA_TASK_STACK_BYTES    10240    // HTTPS client + TLS records
+#define OTA_BUFFER_BYTES        4096     // Heap buffer, one flash sector per write
+#define OTA_STALL_TIMEOUT_MS    30000UL  // Abort if no data arrives for this long
+#define OTA_MONITOR_INTERVAL_MS 500UL    // How often the network task polls job state
+#define OTA_REQUIRE_SHA256      true     // Refuse images without a published sha256
+
+// OTA resume (HTTP Range + NVS checkpoint in NVS_NAMESPACE_OTA)
+#define OTA_SECTOR_BYTES          4096       // Flash erase unit; checkpoints align to it
+#define OTA_CHECKPOINT_BYTES      65536      // Save offset to NVS every 64 KB
+#define OTA_RESUME_MAX_ATTEMPTS   5          // Range retries within one job
+#define OTA_RESUME_RETRY_DELAY_MS 5000UL     // Backoff step between retries
+
+// Smaller OTA transfers (fields in version.json, built by CI)
+#define OTA_ALLOW_COMPRESSED      true       // Use "gzip_url" when present
+#define OTA_ALLOW_DELTA           true       // Use a "deltas" entry matching the running image
 
 // HTTPS verification (keep for security, disable for testing)
 #define REQUIRE_HTTPS_CERT true
@@ -97,6 +123,34 @@
 #define PIN_I2C_SCL         22   // I2C SCL
 #define I2C_SENSOR_ADDR     0x44 // SHT31 default address (change if needed)
 
+// ----- SENSOR SAMPLING -----
+#define SENSOR_SAMPLE_PERIOD_MS  2000UL  // Sensor read + control tick
+#define DS18B20_RESOLUTION_BITS  12      // 9..12 bits: 94/188/375/750 ms conversion
+#define CONTROL_TASK_DEADLINE_MS 500UL   // Control tick counts as missed if it ends later
+
+// ----- SENSOR FILTERING -----
+// DS18B20s convert back to back and the SHT30 is read every
+// SENSOR_FAST_SAMPLE_MS; the control tick uses the filtered values
+// (range check -> rate-of-change rejection -> median of 5 -> EMA)
+#define SENSOR_FAST_SAMPLE_MS          500UL   // SHT30 read period
+#define SENSOR_STALE_MS                6000UL  // No good sample for this long = sensor invalid
+#define SENSOR_FILTER_MIN_STEP_CENTI   25      // Moves up to 0.25 always accepted (quantization / noise)
+#define DS18B20_MAX_RATE_CENTI_PER_S   100     // Faster than 1 °C/s = outlier
+#define AMBIENT_MAX_RATE_CENTI_PER_S   100     // Faster than 1 °C/s = outlier
+#define HUMIDITY_MAX_RATE_CENTI_PER_S  500     // Faster than 5 %RH/s = outlier
+
+// ----- DS18B20 PROBES (sensor registry) -----
+// Any number of probes per bus up to SENSOR_PROBES_MAX in total.
+// Unnamed probes: first on a bus is temp1/temp2, then temp1_2, ...
+// The first probe found on a bus drives control, whatever its name.
+#define SENSOR_PROBES_MAX              8       // All buses together
+#define SENSOR_PROBE_NAME_MAX          16      // Incl. terminator; also the telemetry key (sensors/<name>)
+#define SENSOR_RESCAN_FAILURES         3       // Failed reads in a row before the bus is searched again
+#define SENSOR_RESCAN_INTERVAL_MS      30000UL // Bus searches on fault are at most this frequent
+// ROM (16 hex digits as printed at boot) -> name, e.g.
+//   {"28FF4A1C62160387", "shelf_top"}, {"28FF0B2D62160412", "shelf_bottom"},
+#define SENSOR_PROBE_NAMES
+
 // ----- AUTOMATIC TEMPERATURE CONTROL -----
 #define FAN_ON_DURATION_MS      120000UL  // Fan ON time (2 minutes)
 #define FAN_OFF_DURATION_MS      60000UL  // Fan OFF time (1 minute)
@@ -120,12 +174,133 @@
 // FIREBASE_URL and FIREBASE_AUTH are defined in secrets.h
 #define FIREBASE_DEVICE_ID  "esp32_001"
 #define FIREBASE_BASE_PATH  "/devices/" FIREBASE_DEVICE_ID
+// Absolute RTDB paths are joined at compile time: string literals in
+// flash, no String temporaries per Firebase call
+#define FB_PATH(child)      FIREBASE_BASE_PATH child
 #define FIREBASE_UPDATE_INTERVAL_MS  5000  // Push data every 5 seconds
 
-// Remote relay control polling
-#define RELAY_CONTROL_PULL_INTERVAL_MS  1000
+// Batched publish: one multi-path PATCH (updateNode) per cycle instead of
+// ~20 individual set calls. Set false to fall back to per-path writes.
+#define FIREBASE_BATCHED_PUSH        true
+#define TELEMETRY_PAYLOAD_MAX_BYTES  1024  // Fixed buffer for the batched JSON document
+
+// Delta telemetry (batched mode only): send a field only when it moved past
+// its dead-band; last_seen/uptime go out at the slower heartbeat rate.
+#define FIREBASE_DELTA_PUSH                 true
+#define FIREBASE_HEARTBEAT_INTERVAL_MS      60000UL   // last_seen refresh (app offline check uses 2x)
+#define FIREBASE_FULL_SYNC_INTERVAL_MS      600000UL  // Re-send every field every 10 minutes
+#define TELEMETRY_DEADBAND_TEMP_C           0.2f      // temp1/temp2/ambient_temp
+#define TELEMETRY_DEADBAND_HUMIDITY_PCT     1.0f      // ambient_humidity (%RH)
+#define TELEMETRY_DEADBAND_RSSI_DBM         5         // status/rssi
+#define TELEMETRY_DEADBAND_FREE_HEAP_BYTES  4096      // status/free_heap, min_free_heap, largest_free_block
+
+// Remote relay control: streamed (SSE) from the device node, filtered to
+// relays/ and settings/, with polling as the fallback whenever the
+// stream is down or timed out
+#define RELAY_CONTROL_USE_STREAM        true
+#define RELAY_CONTROL_STREAM_RETRY_MS   30000UL  // Re-begin a failed stream
+#define RELAY_CONTROL_PULL_INTERVAL_MS  2000UL   // Poll fallback while a stream is down
 #define RELAY_CONTROL_DEFAULT_AUTO_MODE false
 
+// Offline store-and-forward: while WiFi/Firebase is down, samples go to a
+// ring log in the spiffs partition and are uploaded in batches to history/
+#define TELEMETRY_BACKLOG_ENABLED            true
+#define TELEMETRY_BACKLOG_PARTITION_OFFSET   0              // Slice start inside "spiffs"
+#define TELEMETRY_BACKLOG_BYTES              (128 * 1024)   // 32 sectors, ~6500 samples
+#define TELEMETRY_BACKLOG_SAMPLE_MS          30000UL        // One stored sample per 30 s (~54 h offline)
+#define TELEMETRY_BACKLOG_DRAIN_INTERVAL_MS  3000UL         // At most one upload batch per interval
+#define TELEMETRY_BACKLOG_BATCH              32             // Samples per upload (one PATCH)
+#define TELEMETRY_BACKLOG_UPLOAD_BYTES       5120           // JSON buffer for one batch (~150 B per sample)
+#define TELEMETRY_BACKLOG_MIN_EPOCH          1600000000UL   // Clock not synced yet: nothing to key a sample by
+
+// Local history: every control sample, delta/bit packed into the rest of
+// the spiffs partition (see timeseries.h). ~1 bit per unchanged sample,
+// so a mostly steady week at 2 s (~300k samples) fits in 320 KB
+#define HISTORY_ENABLED                true
+#define HISTORY_PARTITION_OFFSET       (128 * 1024)   // Right after the backlog slice
+#define HISTORY_BYTES                  (320 * 1024)   // 80 sectors
+#define HISTORY_SAMPLE_PERIOD_S        2              // = SENSOR_SAMPLE_PERIOD_MS
+#define HISTORY_SEAL_INTERVAL_S        600            // Open block is RAM only: lose at most 10 min on a crash
+#define HISTORY_BLOCK_MAX_BYTES        1024           // Block = unit of query decoding
+#define HISTORY_DEADBAND_TEMP_DECI     2              // Temperature moves < 0.2 °C are stored as unchanged
+#define HISTORY_DEADBAND_RH_DECI       5              // Humidity moves < 0.5 %RH are stored as unchanged
+
+// ============================================================
+// HTTPS CONNECTION POOL (version checks, firmware downloads,
+// telemetry PATCHes)
+// TLS session budget, ~40 KB heap each: the control stream, up to
+// HTTPS_POOL_SLOTS pooled connections, and fbdo. With batched pushes
+// and FIREBASE_PATCH_VIA_POOL, fbdo is closed after the boot writes and
+// only reopens for the poll fallback, i.e. while the stream's
+// session is down. Peak is 1 + HTTPS_POOL_SLOTS = 3 sessions
+// (~120 KB), plus the 43 KB inflate window during a gzip/delta OTA
+// ============================================================
+#define HTTPS_POOL_SLOTS                2          // Each live TLS session holds ~40 KB heap
+#define HTTPS_POOL_IDLE_TIMEOUT_MS      90000UL    // Outlives one OTA check interval
+#define HTTPS_POOL_HANDSHAKE_TIMEOUT_S  15
+#define HTTPS_POOL_SWEEP_INTERVAL_MS    10000UL    // How often idle connections are closed
+#define FIREBASE_TCP_KEEPALIVE          true       // Keep fbdo's session open between pushes (not pooled)
+// true: hal.rtdb PATCHes (telemetry, backlog) go through the pool as REST
+// calls. Streams, poll fallback and boot writes stay on the Firebase client
+#define FIREBASE_PATCH_VIA_POOL         true
+
+// ============================================================
+// TELEMETRY TRANSPORT (RTDB or MQTT)
+// ============================================================
+
+// 0: telemetry + backlog PATCHed to the RTDB, commands streamed from it.
+// 1: one persistent MQTT session instead (mqtt_transport.h); see
+// [env:esp32_mqtt] in platformio.ini. MQTT_BROKER_HOST, MQTT_USER and
+// MQTT_PASS are defined in secrets.h
+#ifndef TELEMETRY_TRANSPORT_MQTT
+#define TELEMETRY_TRANSPORT_MQTT 0
+#endif
+#define MQTT_BROKER_PORT            1883
+#define MQTT_TOPIC_ROOT             "espota/" FIREBASE_DEVICE_ID
+#define MQTT_CLIENT_ID              "espota-" FIREBASE_DEVICE_ID
+#define MQTT_KEEPALIVE_S            30        // Broker fires the last will after ~1.5x this
+#define MQTT_SOCKET_TIMEOUT_S       5         // Bounds a connect/publish stall in the network task
+#define MQTT_RECONNECT_INTERVAL_MS  10000UL   // At most one connect attempt per interval
+
+// MQTT carries the same multi-path documents as the batched RTDB push
+static_assert(!TELEMETRY_TRANSPORT_MQTT || FIREBASE_BATCHED_PUSH,
+              "TELEMETRY_TRANSPORT_MQTT needs FIREBASE_BATCHED_PUSH");
+
+// ============================================================
+// LAN HTTP (/metrics, /state)
+// ============================================================
+#define LAN_HTTP_ENABLED            true
+#define LAN_HTTP_PORT               8080      // 80 belongs to the provisioning portal
+#define LAN_HTTP_CHUNK_BYTES        1024      // Response buffer, sent to the socket whenever full
+#define LAN_HTTP_REQUEST_TIMEOUT_MS 250       // Slow clients are dropped, the network loop moves on
+
+// ============================================================
+// TASKS (FreeRTOS)
+// ============================================================
+
+// Control task: sensors, control decisions, relays, safety overrides.
+// Runs on the APP core, away from the WiFi/LwIP stack.
+#define CONTROL_TASK_CORE          1
+#define CONTROL_TASK_PRIORITY      5
+#define CONTROL_TASK_STACK_BYTES   6144
+#define CONTROL_TASK_MAX_SLEEP_MS  100     // Upper bound on one idle wait
+
+// Network task: WiFi, telnet, Firebase, OTA. Shares the PRO core with WiFi.
+#define NETWORK_TASK_CORE          0
+#define NETWORK_TASK_PRIORITY      2
+#define NETWORK_TASK_STACK_BYTES   16384   // TLS + Firebase client need a deep stack
+#define NETWORK_TASK_POLL_MS       5       // Yield between network loop passes
+
+// Log drain: empties the log ring to UART + telnet below every other task
+#define LOG_DRAIN_TASK_CORE        0
+#define LOG_DRAIN_TASK_PRIORITY    1
+#define LOG_DRAIN_TASK_STACK_BYTES 3072
+#define LOG_DRAIN_INTERVAL_MS      20      // Max latency before buffered logs go out
+#define LOG_RING_BYTES             8192    // Power of two; full ring drops new writes
+
+// Remote commands network -> control (per producer, power of two)
+#define REMOTE_COMMAND_QUEUE_SIZE  32
+
 // ============================================================
 // SYSTEM SETTINGS
 // ============================================================
@@ -134,6 +309,10 @@
 #define ENABLE_WATCHDOG true
 #define WATCHDOG_TIMEOUT_SECONDS 30
 
+// Loop latency report (avg/max loop() time over each interval)
+#define LOOP_STATS_ENABLED true
+#define LOOP_STATS_INTERVAL_MS 60000UL
+
 // Serial debug
 #define SERIAL_DEBUG true
 #define SERIAL_BAUD_RATE 115200
@@ -163,6 +342,35 @@
 #define NVS_NAMESPACE_OTA "ota_status"
 #define NVS_NAMESPACE_VERSION "fw_version"
 
+// ============================================================
+// HEAP INSTRUMENTATION
+// ============================================================
+
+// Count every malloc/calloc/realloc (link-time wrappers). Needs the
+// matching -Wl,--wrap flags, see [env:esp32_heapsoak] in platformio.ini
+#ifndef HEAP_COUNT_ALLOCS
+#define HEAP_COUNT_ALLOCS 0
+#endif
+#define HEAP_TRACKED_TASKS 4       // Tasks with their own allocation counter
+
+// ============================================================
+// LATENCY BENCHMARK
+// ============================================================
+
+// Per-stage latency histograms (p50/p95/p99/max), dumped with the
+// [PERF] stats / on 'l' over telnet and pushed to status/latency_ms.
+// See [env:esp32_bench] in platformio.ini
+#ifndef LATENCY_BENCH_ENABLED
+#define LATENCY_BENCH_ENABLED 0
+#endif
+#define LATENCY_BENCH_PUSH_INTERVAL_MS 60000UL   // status/latency_ms refresh
+
+// Scoped CPU-cycle counters on hot functions (cycle_profiler.h),
+// reported with the [PERF] stats; also on in [env:esp32_bench]
+#ifndef CYCLE_PROFILE_ENABLED
+#define CYCLE_PROFILE_ENABLED 0
+#endif
+
 // ============================================================
 // LOGGING LEVELS
 // ============================================================
@@ -173,6 +381,37 @@
 #define LOG_DEBUG 4
 #define LOG_TRACE 5
 
+// Build-time level, the default for every LOG_LEVEL_<TAG> below:
+// LOGx() calls above their tag's level are compiled out, arguments
+// included. Override per build with -DCURRENT_LOG_LEVEL=...
+#ifndef CURRENT_LOG_LEVEL
 #define CURRENT_LOG_LEVEL LOG_INFO
+#endif
+
+// Per-subsystem levels, above or below CURRENT_LOG_LEVEL, e.g. build
+// with -DLOG_LEVEL_CTRL=LOG_DEBUG to see every control decision
+#ifndef LOG_LEVEL_SENSOR
+#define LOG_LEVEL_SENSOR CURRENT_LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_CTRL
+#define LOG_LEVEL_CTRL CURRENT_LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_RELAY
+#define LOG_LEVEL_RELAY CURRENT_LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_FB
+#define LOG_LEVEL_FB CURRENT_LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_OTA
+#define LOG_LEVEL_OTA CURRENT_LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_TELNET
+#define LOG_LEVEL_TELNET CURRENT_LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_HTTP
+#define LOG_LEVEL_HTTP CURRENT_LOG_LEVEL
+#endif
+
+#define LOG_LINE_MAX 160    // Stack buffer per LOGx() line, longer lines are truncated
 
 #endif // CONFIG_H
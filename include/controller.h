@@ -0,0 +1,63 @@
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#include <atomic>
+#include <stdint.h>
+#include "config.h"
+
+// ============================================================
+// TEMPERATURE CONTROLLER
+// - Heater / refrig hysteresis, fan duty cycle, manual mode with
+//   safety cut-offs, startup / provisioning relay hold
+// - State below is owned by the control task; other tasks read
+//   it through the control snapshot
+// - Board access only through hal (clock, GPIO), so the same
+//   code runs in the native build
+// ============================================================
+
+// Filtered sensor values; -127 = sensor invalid
+extern float temp1;             // DS18B20 bus 1
+extern float temp2;             // DS18B20 bus 2
+extern float ambientTemp;       // SHT30 temperature
+extern float ambientHumidity;   // SHT30 humidity
+
+// Relay states and mode
+extern bool heaterOn;
+extern bool refrigOn;
+extern bool fanOn;
+extern bool autoRelayControl;
+
+// Fan cycle state (FAN_ON_DURATION_MS on / FAN_OFF_DURATION_MS off)
+extern uint32_t fanCycleStartMillis;
+extern bool fanCycleOnPhase;
+
+// Setpoints (Firebase settings/ or defaults)
+extern float heaterOnTemp;
+extern float heaterOffTemp;
+extern float refrigOnTemp;
+extern float refrigOffTemp;
+
+// Last manual relay commands received from Firebase (applied in MANUAL mode)
+extern bool heaterCmd, heaterCmdKnown;
+extern bool refrigCmd, refrigCmdKnown;
+extern bool fanCmd, fanCmdKnown;
+
+// Relay hold inputs
+extern uint32_t bootStartMillis;
+extern std::atomic<bool> provisioningMode;   // written by the network task
+
+bool isValidDs18b20(float value);
+bool isValidAmbientTemp(float value);
+
+bool shouldHoldRelaysOff();
+void enforceRelaysOff();
+void updateFanCycle();
+void updateAutomaticControl();
+// One control decision + relay write (sensor tick or remote change)
+void runControlCycle();
+
+void applyRelayStates();
+void writeRelay(uint8_t pin, bool on, bool activeLow);
+void setAllLedsImmediate(bool on);
+
+#endif // CONTROLLER_H
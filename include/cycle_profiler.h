@@ -0,0 +1,105 @@
+#ifndef CYCLE_PROFILER_H
+#define CYCLE_PROFILER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include <atomic>
+#include <chrono>
+#endif
+
+// ============================================================
+// SCOPED CYCLE COUNTERS
+// - ScopedCycles prof(PROF_x); at the top of a scope adds the
+//   cycles spent until the scope closes to counter PROF_x
+//   (calls, total, min, max)
+// - Ticks are CPU cycles (ESP.getCycleCount(), per core; the
+//   profiled code runs in core-pinned tasks) or nanoseconds in
+//   the native build; 32-bit, so one scope must stay < ~17 s
+// - Without CYCLE_PROFILE_ENABLED ScopedCycles is an empty class
+//   and every call site compiles to nothing
+// - The table sits behind one short spinlock: add() from any
+//   task, snapshot(+reset) from another sees a consistent copy
+// ============================================================
+
+enum ProfCounter {
+    PROF_PUSH = 0,         // pushToFirebase(), either transport
+    PROF_PAYLOAD,          // telemetry JSON build
+    PROF_AUTO_CONTROL,     // updateAutomaticControl()
+    PROF_WRITE_RELAY,      // writeRelay()
+    PROF_OTA_CHUNK,        // decode + hash + flash write of one download chunk
+    PROF_COUNTER_COUNT
+};
+
+struct CycleCounter {
+    uint32_t calls;
+    uint64_t totalTicks;
+    uint32_t minTicks;
+    uint32_t maxTicks;
+};
+
+class CycleProfiler {
+public:
+    CycleProfiler();
+
+    static uint32_t now() {
+#if defined(ARDUINO)
+        return ESP.getCycleCount();
+#else
+        return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+    static uint32_t ticksPerUs();
+    static const char *counterName(ProfCounter id);
+
+    void add(ProfCounter id, uint32_t ticks);
+
+    // Copy the whole table at one instant; optionally zero it in the
+    // same critical section so no call is lost or counted twice
+    void snapshot(CycleCounter out[PROF_COUNTER_COUNT], bool reset);
+
+    // One [PERF] line per counter with calls since the last report; resets
+    void report();
+
+private:
+    void _lock();
+    void _unlock();
+
+    CycleCounter _counters[PROF_COUNTER_COUNT];
+#if defined(ARDUINO)
+    portMUX_TYPE _mux;
+#else
+    std::atomic_flag _busy;
+#endif
+};
+
+extern CycleProfiler cycleProfiler;
+
+template <bool Enabled>
+class ScopedCyclesT {
+public:
+    explicit ScopedCyclesT(ProfCounter id) : _id(id), _start(CycleProfiler::now()) {}
+    ~ScopedCyclesT() { cycleProfiler.add(_id, CycleProfiler::now() - _start); }
+
+    ScopedCyclesT(const ScopedCyclesT &) = delete;
+    ScopedCyclesT &operator=(const ScopedCyclesT &) = delete;
+
+private:
+    ProfCounter _id;
+    uint32_t _start;
+};
+
+template <>
+class ScopedCyclesT<false> {
+public:
+    explicit ScopedCyclesT(ProfCounter) {}
+};
+
+typedef ScopedCyclesT<CYCLE_PROFILE_ENABLED != 0> ScopedCycles;
+
+#endif // CYCLE_PROFILER_H
@@ -0,0 +1,99 @@
+#ifndef FLASH_REGION_H
+#define FLASH_REGION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================
+// FLASH REGION
+// - Byte-addressed window onto NOR flash with NOR semantics:
+//   eraseSector() sets a whole sector to 0xFF, write() can only
+//   clear bits (1 -> 0)
+// - map() exposes the region as read-only memory where the
+//   platform can (flash cache mmap / mmap(2)); nullptr = use read()
+// - EspPartitionRegion: a slice of an esp_partition (device)
+// - FileFlashRegion: the same semantics over a partition image
+//   file, so storage code builds and runs on a Linux host
+// ============================================================
+
+class FlashRegion {
+public:
+    virtual ~FlashRegion() {}
+
+    virtual uint32_t size() const = 0;
+    virtual uint32_t sectorSize() const = 0;
+
+    virtual bool read(uint32_t offset, void *dst, size_t len) = 0;
+    virtual bool write(uint32_t offset, const void *src, size_t len) = 0;
+    // offset must be sector aligned
+    virtual bool eraseSector(uint32_t offset) = 0;
+
+    virtual const uint8_t *map() { return nullptr; }
+};
+
+// CRC-16/CCITT-FALSE, for record / block integrity checks
+uint16_t flashCrc16(const uint8_t *data, size_t len);
+
+#if defined(ARDUINO)
+#include <esp_partition.h>
+
+class EspPartitionRegion : public FlashRegion {
+public:
+    EspPartitionRegion();
+
+    // Maps [offset, offset + size) of the partition; both sector aligned
+    bool begin(const esp_partition_t *part, uint32_t offset, uint32_t size);
+
+    uint32_t size() const override { return _size; }
+    uint32_t sectorSize() const override { return SECTOR_BYTES; }
+
+    bool read(uint32_t offset, void *dst, size_t len) override;
+    bool write(uint32_t offset, const void *src, size_t len) override;
+    bool eraseSector(uint32_t offset) override;
+
+    // Mapped through the flash cache on first use (data MMU pages);
+    // IDF invalidates the cache on writes/erases through the partition API
+    const uint8_t *map() override;
+
+    static const uint32_t SECTOR_BYTES = 4096;   // ESP32 SPI flash erase unit
+
+private:
+    const esp_partition_t *_part;
+    uint32_t _offset;
+    uint32_t _size;
+    const void *_mapped;
+    spi_flash_mmap_handle_t _mapHandle;
+};
+
+#else
+#include <stdio.h>
+
+class FileFlashRegion : public FlashRegion {
+public:
+    FileFlashRegion();
+    ~FileFlashRegion() override;
+
+    // Opens an image file, creating it fully erased (0xFF) if missing
+    // or shorter than size
+    bool open(const char *path, uint32_t size, uint32_t sectorSize = 4096);
+    void close();
+
+    uint32_t size() const override { return _size; }
+    uint32_t sectorSize() const override { return _sectorSize; }
+
+    bool read(uint32_t offset, void *dst, size_t len) override;
+    bool write(uint32_t offset, const void *src, size_t len) override;
+    bool eraseSector(uint32_t offset) override;
+
+    // Shared mmap(2) of the image: sees every write()/eraseSector()
+    const uint8_t *map() override;
+
+private:
+    FILE *_file;
+    uint32_t _size;
+    uint32_t _sectorSize;
+    void *_mapped;
+};
+#endif
+
+#endif // FLASH_REGION_H
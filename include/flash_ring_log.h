@@ -0,0 +1,84 @@
+#ifndef FLASH_RING_LOG_H
+#define FLASH_RING_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "flash_region.h"
+
+// ============================================================
+// FLASH RING LOG
+// - Append-only log of fixed-size records over a FlashRegion
+// - Sectors are filled in order and erased only when the head
+//   wraps onto them again: every sector sees the same number of
+//   erase cycles (wear levelling by construction)
+// - Consuming a record only clears bits in its state byte, so
+//   reading the backlog costs no erases
+// - Full ring: the oldest sector is recycled, its records lost
+// - Power-safe: state is rebuilt by scanning in begin(), torn
+//   writes are caught by a per-record CRC
+// - Not thread-safe: use from one task
+//
+// Sector layout (slot = 4-byte header + record, 4-byte aligned):
+//   slot 0     : magic "FRL1" | seq (u32, +1 per opened sector)
+//   slot 1..n  : state | 0xFF | crc16(record) | record
+// ============================================================
+
+class FlashRingLog {
+public:
+    FlashRingLog(FlashRegion &region, uint16_t recordSize);
+
+    // Scans the region and recovers head/tail; false if the
+    // region is too small for two sectors of records
+    bool begin();
+    // Erases every sector (drops the whole backlog)
+    bool format();
+
+    bool append(const void *record);
+
+    // Copies up to maxRecords of the oldest pending records to out
+    // (recordSize bytes each) without removing them
+    size_t peek(void *out, size_t maxRecords);
+    // Marks the oldest count pending records as consumed
+    size_t consume(size_t count);
+
+    uint32_t pending() const { return _pending; }
+    uint32_t capacity() const { return _sectorCount * (_slotsPerSector - 1); }
+    uint32_t overwritten() const { return _overwritten; }   // lost to wrap-around
+    uint32_t corrupt() const { return _corrupt; }           // failed CRC, skipped
+
+private:
+    struct Pos {
+        uint32_t sector;
+        uint32_t slot;
+    };
+
+    static const uint32_t MAGIC = 0x314C5246;   // "FRL1"
+    static const uint8_t STATE_EMPTY    = 0xFF;
+    static const uint8_t STATE_WRITTEN  = 0xFE;
+    static const uint8_t STATE_CONSUMED = 0xFC;
+
+    uint32_t _slotOffset(const Pos &p) const { return p.sector * _sectorSize + p.slot * _slotSize; }
+    bool _readHeader(uint32_t sector, uint32_t &seq);
+    uint8_t _readState(const Pos &p);
+    uint32_t _countWritten(uint32_t sector);
+    bool _next(Pos &p) const;   // false once p reaches the head
+    bool _openNextSector();
+
+    FlashRegion &_region;
+    uint16_t _recordSize;
+    uint32_t _slotSize;
+    uint32_t _sectorSize;
+    uint32_t _sectorCount;
+    uint32_t _slotsPerSector;
+
+    bool _mounted;
+    bool _hasHead;          // false until the first sector is opened
+    Pos _head;              // next slot to write
+    Pos _tail;              // oldest slot that may still be pending
+    uint32_t _seq;          // seq of the head sector
+    uint32_t _pending;
+    uint32_t _overwritten;
+    uint32_t _corrupt;
+};
+
+#endif // FLASH_RING_LOG_H
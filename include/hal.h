@@ -0,0 +1,305 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================
+// HARDWARE ABSTRACTION
+// - Controller, sensor registry and telemetry code reach the
+//   board only through these interfaces, via the global hal
+// - Esp32* / Dallas* / Sht3x* / Firebase*: the real peripherals
+//   (ARDUINO builds)
+// - Sim*: in-memory stand-ins for the native (Linux) build; the
+//   simulator and host tests drive them directly
+// ============================================================
+
+class HalClock {
+public:
+    virtual ~HalClock() {}
+    virtual uint32_t millis() = 0;
+    virtual uint32_t micros() = 0;
+    virtual uint32_t epoch() = 0;          // wall clock; small = not synced yet
+};
+
+class HalGpio {
+public:
+    virtual ~HalGpio() {}
+    virtual void setOutput(uint8_t pin) = 0;
+    virtual void write(uint8_t pin, bool level) = 0;
+};
+
+// One DS18B20 OneWire bus
+class HalTempBus {
+public:
+    virtual ~HalTempBus() {}
+    // Enumeration: resetSearch(), then searchNext() until false;
+    // only CRC-valid ROMs are returned
+    virtual void resetSearch() = 0;
+    virtual bool searchNext(uint8_t rom[8]) = 0;
+    virtual uint8_t resolution(const uint8_t rom[8]) = 0;
+    virtual void setResolution(const uint8_t rom[8], uint8_t bits) = 0;
+    virtual uint32_t conversionMs(uint8_t bits) = 0;
+    // Skip ROM + convert: every probe on the bus at once, no waiting
+    virtual void convertAll() = 0;
+    // Addressed scratchpad read in 1/128 °C; false = no answer / CRC error
+    virtual bool readRaw(const uint8_t rom[8], int32_t &raw) = 0;
+};
+
+// SHT3x temperature + humidity
+class HalAmbientSensor {
+public:
+    virtual ~HalAmbientSensor() {}
+    virtual bool begin() = 0;
+    // One measurement for both values
+    virtual bool read(float &tempC, float &humidityPct) = 0;
+};
+
+class HalNetwork {
+public:
+    virtual ~HalNetwork() {}
+    virtual bool connected() = 0;
+    virtual int32_t rssi() = 0;
+};
+
+// Firebase RTDB: multi-path PATCH of a JSON document onto path
+class HalRtdb {
+public:
+    virtual ~HalRtdb() {}
+    virtual bool ready() = 0;
+    virtual bool update(const char *path, const char *json) = 0;
+    virtual const char *lastError() = 0;
+};
+
+#define HAL_TEMP_BUSES 2
+
+struct Hal {
+    HalClock *clock;
+    HalGpio *gpio;
+    HalTempBus *tempBus[HAL_TEMP_BUSES];
+    HalAmbientSensor *ambient;
+    HalNetwork *network;
+    HalRtdb *rtdb;
+};
+
+// Wired to the board (ARDUINO) or to the Sim* instances below
+extern Hal hal;
+
+#if defined(ARDUINO)
+#include <OneWire.h>
+#include <DallasTemperature.h>
+#include <Adafruit_SHT31.h>
+
+class FirebaseData;
+
+class Esp32Clock : public HalClock {
+public:
+    uint32_t millis() override;
+    uint32_t micros() override;
+    uint32_t epoch() override;
+};
+
+class Esp32Gpio : public HalGpio {
+public:
+    void setOutput(uint8_t pin) override;
+    void write(uint8_t pin, bool level) override;
+};
+
+class DallasTempBus : public HalTempBus {
+public:
+    explicit DallasTempBus(uint8_t pin);
+
+    void resetSearch() override;
+    bool searchNext(uint8_t rom[8]) override;
+    uint8_t resolution(const uint8_t rom[8]) override;
+    void setResolution(const uint8_t rom[8], uint8_t bits) override;
+    uint32_t conversionMs(uint8_t bits) override;
+    void convertAll() override;
+    bool readRaw(const uint8_t rom[8], int32_t &raw) override;
+
+private:
+    OneWire _wire;
+    DallasTemperature _dallas;
+};
+
+class Sht3xSensor : public HalAmbientSensor {
+public:
+    explicit Sht3xSensor(uint8_t address) : _address(address) {}
+
+    bool begin() override;
+    bool read(float &tempC, float &humidityPct) override;
+
+private:
+    Adafruit_SHT31 _sht;
+    uint8_t _address;
+};
+
+class Esp32Network : public HalNetwork {
+public:
+    bool connected() override;
+    int32_t rssi() override;
+};
+
+class FirebaseRtdb : public HalRtdb {
+public:
+    FirebaseRtdb() : _fbdo(nullptr) {}
+    // Data object used for the PATCH requests (shared connection)
+    void attach(FirebaseData *fbdo) { _fbdo = fbdo; }
+
+    bool ready() override;
+    bool update(const char *path, const char *json) override;
+    const char *lastError() override;
+
+private:
+    FirebaseData *_fbdo;
+};
+
+extern FirebaseRtdb firebaseRtdb;
+
+// Same PATCH as a REST call on an HttpsPool connection
+// (FIREBASE_URL + path + ".json?auth=..."), so telemetry shares the
+// pool's keep-alive sessions and per-request stats with OTA traffic
+class PooledRtdb : public HalRtdb {
+public:
+    bool ready() override;
+    bool update(const char *path, const char *json) override;
+    const char *lastError() override { return _error; }
+
+private:
+    char _error[48] = "";
+};
+
+extern PooledRtdb pooledRtdb;
+
+#else
+#include <string>
+
+class SimClock : public HalClock {
+public:
+    SimClock() : _us(0), _epochBase(0) {}
+
+    uint32_t millis() override { return (uint32_t)(_us / 1000); }
+    uint32_t micros() override { return (uint32_t)_us; }
+    uint32_t epoch() override { return _epochBase ? _epochBase + (uint32_t)(_us / 1000000) : 0; }
+
+    void advanceMs(uint32_t ms) { _us += (uint64_t)ms * 1000; }
+    void setEpoch(uint32_t epochAtZero) { _epochBase = epochAtZero; }
+
+private:
+    uint64_t _us;
+    uint32_t _epochBase;
+};
+
+class SimGpio : public HalGpio {
+public:
+    static const uint8_t PINS = 40;
+
+    SimGpio() : _level(), _output(), _writes(0) {}
+
+    void setOutput(uint8_t pin) override { if (pin < PINS) _output[pin] = true; }
+    void write(uint8_t pin, bool level) override {
+        if (pin < PINS) _level[pin] = level;
+        _writes++;
+    }
+
+    bool level(uint8_t pin) const { return pin < PINS && _level[pin]; }
+    bool isOutput(uint8_t pin) const { return pin < PINS && _output[pin]; }
+    uint32_t writes() const { return _writes; }
+
+private:
+    bool _level[PINS];
+    bool _output[PINS];
+    uint32_t _writes;
+};
+
+class SimTempBus : public HalTempBus {
+public:
+    static const uint8_t MAX_PROBES = 8;
+
+    SimTempBus() : _count(0), _searchPos(0), _conversions(0) {}
+
+    // Adds a probe (valid DS18B20 ROM built from id); returns its index
+    int addProbe(uint32_t id, float tempC);
+    void setTemp(int probe, float tempC) { _probes[probe].tempC = tempC; }
+    void setPresent(int probe, bool present) { _probes[probe].present = present; }
+    uint32_t conversions() const { return _conversions; }
+
+    void resetSearch() override { _searchPos = 0; }
+    bool searchNext(uint8_t rom[8]) override;
+    uint8_t resolution(const uint8_t rom[8]) override;
+    void setResolution(const uint8_t rom[8], uint8_t bits) override;
+    uint32_t conversionMs(uint8_t bits) override { return 750u >> (12 - bits); }
+    void convertAll() override;
+    bool readRaw(const uint8_t rom[8], int32_t &raw) override;
+
+private:
+    struct Probe {
+        uint8_t rom[8];
+        float tempC;
+        float latchedC;    // value of the last conversion
+        uint8_t bits;
+        bool present;
+    };
+    int _find(const uint8_t rom[8]) const;
+
+    Probe _probes[MAX_PROBES];
+    uint8_t _count;
+    uint8_t _searchPos;
+    uint32_t _conversions;
+};
+
+class SimAmbientSensor : public HalAmbientSensor {
+public:
+    SimAmbientSensor() : tempC(25.0f), humidityPct(50.0f), present(true), reads(0) {}
+
+    bool begin() override { return present; }
+    bool read(float &t, float &h) override {
+        reads++;
+        if (!present) return false;
+        t = tempC;
+        h = humidityPct;
+        return true;
+    }
+
+    float tempC;
+    float humidityPct;
+    bool present;
+    uint32_t reads;
+};
+
+class SimNetwork : public HalNetwork {
+public:
+    SimNetwork() : up(true), signal(-60) {}
+
+    bool connected() override { return up; }
+    int32_t rssi() override { return up ? signal : 0; }
+
+    bool up;
+    int32_t signal;
+};
+
+// Records what would have been PATCHed
+class SimRtdb : public HalRtdb {
+public:
+    SimRtdb() : online(true), updates(0), bytes(0) {}
+
+    bool ready() override { return online; }
+    bool update(const char *path, const char *json) override;
+    const char *lastError() override { return online ? "" : "offline (sim)"; }
+
+    bool online;
+    uint32_t updates;
+    uint32_t bytes;
+    std::string lastPath;
+    std::string lastJson;
+};
+
+extern SimClock simClock;
+extern SimGpio simGpio;
+extern SimTempBus simTempBus[HAL_TEMP_BUSES];
+extern SimAmbientSensor simAmbient;
+extern SimNetwork simNetwork;
+extern SimRtdb simRtdb;
+#endif
+
+#endif // HAL_H
@@ -0,0 +1,65 @@
+#ifndef HEAP_MONITOR_H
+#define HEAP_MONITOR_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "config.h"
+
+// ============================================================
+// HEAP INSTRUMENTATION
+// - Free heap, low-water mark and largest free block, to watch
+//   fragmentation over long soaks (also published as telemetry)
+// - With HEAP_COUNT_ALLOCS (see [env:esp32_heapsoak]) malloc,
+//   calloc and realloc are wrapped at link time and every
+//   allocation is counted, per tracked task
+// - Cycles (control tick, Firebase push/poll) are bracketed with
+//   taskAllocs() / endCycle() to get allocations per cycle
+// ============================================================
+
+enum HeapCycle {
+    HEAP_CYCLE_CONTROL = 0,   // sensor read + control decision + relays
+    HEAP_CYCLE_FB_PUSH,       // one telemetry push
+    HEAP_CYCLE_FB_POLL,       // one relay/settings poll
+    HEAP_CYCLE_COUNT
+};
+
+struct HeapCycleStats {
+    uint32_t cycles;
+    uint32_t allocs;          // summed over all cycles
+    uint32_t maxAllocs;       // worst single cycle
+};
+
+class HeapMonitor {
+public:
+    HeapMonitor();
+
+    // Count allocations made by the calling task separately
+    // (up to HEAP_TRACKED_TASKS tasks); no-op without HEAP_COUNT_ALLOCS
+    void trackCurrentTask();
+
+    // Allocation events so far: by the calling task / by everyone.
+    // Always 0 when HEAP_COUNT_ALLOCS is off.
+    uint32_t taskAllocs() const;
+    uint32_t totalAllocs() const;
+
+    // Close a cycle opened with start = taskAllocs(); each cycle
+    // type must always be recorded from the same task
+    void endCycle(HeapCycle cycle, uint32_t startAllocs);
+
+    uint32_t freeBytes() const        { return ESP.getFreeHeap(); }
+    uint32_t minFreeBytes() const     { return ESP.getMinFreeHeap(); }   // since boot
+    uint32_t largestFreeBlock() const { return ESP.getMaxAllocHeap(); }
+    // 0 = all free memory in one block
+    uint8_t fragmentationPct() const;
+
+    void report();
+    void resetCycleStats();
+
+private:
+    HeapCycleStats _cycles[HEAP_CYCLE_COUNT];
+};
+
+extern HeapMonitor heapMonitor;
+
+#endif // HEAP_MONITOR_H
@@ -0,0 +1,86 @@
+#ifndef HTTPS_POOL_H
+#define HTTPS_POOL_H
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "config.h"
+
+// ============================================================
+// HTTPS CONNECTION POOL
+// - A few long-lived WiFiClientSecure + HTTPClient pairs with
+//   keep-alive; a request to a host that still has an open
+//   connection skips TCP + TLS setup entirely
+// - acquire() returns a begun HTTPClient, release() ends the
+//   request but leaves the socket open when the server allows
+// - Redirects are NOT followed inside the pool (a followed
+//   redirect would leave the slot connected to another host);
+//   callers re-acquire with the Location URL instead
+// - Per-channel stats: requests, new handshakes, latency
+// - No TLS session resumption: WiFiClientSecure runs
+//   mbedtls_ssl_setup() and the handshake in one call
+//   (start_ssl_client), so a saved session can never be
+//   mbedtls_ssl_set_session()'d in between. Every new connection
+//   is a full handshake; report() prints "resumed n/a" rather
+//   than a count that would always read 0
+// ============================================================
+
+enum HttpsChannel {
+    HTTPS_CH_OTA_CHECK = 0,
+    HTTPS_CH_OTA_DOWNLOAD,
+    HTTPS_CH_FIREBASE,        // pooled RTDB PATCHes, or recorded from the Firebase client's session
+    HTTPS_CH_COUNT
+};
+
+struct HttpsChannelStats {
+    uint32_t requests;
+    uint32_t handshakes;      // requests that had to open a new connection
+    uint64_t totalUs;
+    uint32_t maxUs;
+    uint64_t reusedTotalUs;   // latency summed over kept-alive requests only
+};
+
+class HttpsPool {
+public:
+    HttpsPool();
+
+    void begin();
+
+    // Starts a request on a pooled connection; nullptr if all slots are busy
+    HTTPClient *acquire(HttpsChannel channel, const String& url);
+    // keepAlive=false closes the socket (e.g. body not fully read)
+    void release(HTTPClient *http, bool keepAlive = true);
+
+    // For clients that manage their own session (Firebase)
+    void record(HttpsChannel channel, uint32_t elapsedUs, bool reused);
+
+    // Close connections idle longer than HTTPS_POOL_IDLE_TIMEOUT_MS
+    void closeIdle();
+
+    void report();
+    void resetStats();
+
+private:
+    struct Slot {
+        WiFiClientSecure client;
+        HTTPClient http;
+        String host;
+        HttpsChannel channel;
+        bool inUse;
+        bool reused;
+        uint32_t startUs;
+        unsigned long lastUsedMs;
+    };
+
+    static String _hostOf(const String& url);
+
+    Slot _slots[HTTPS_POOL_SLOTS];
+    HttpsChannelStats _stats[HTTPS_CH_COUNT];
+    SemaphoreHandle_t _mutex;
+};
+
+extern HttpsPool httpsPool;
+
+#endif // HTTPS_POOL_H
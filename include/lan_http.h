@@ -0,0 +1,55 @@
+#ifndef LAN_HTTP_H
+#define LAN_HTTP_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "config.h"
+#include "lan_status.h"
+
+// ============================================================
+// LAN HTTP ENDPOINTS
+// - GET /metrics (Prometheus text) and GET /state (JSON) on
+//   LAN_HTTP_PORT, for scrapers on the local network; works
+//   with the internet (and Firebase) down
+// - Served from the network task, one request per poll(); the
+//   control task is never touched: the status comes from the
+//   control snapshot via the provider callback
+// - HTTP/1.0, Connection: close; the body is streamed from one
+//   LAN_HTTP_CHUNK_BYTES buffer, no heap String anywhere
+// - A client that has not sent its request line within
+//   LAN_HTTP_REQUEST_TIMEOUT_MS is dropped
+// ============================================================
+
+typedef void (*LanStatusProvider)(LanStatus &status);
+
+class LanHttpServer {
+public:
+    explicit LanHttpServer(uint16_t port);
+
+    void setStatusProvider(LanStatusProvider provider) { _provider = provider; }
+
+    // Network task: listens while the station is connected; serves
+    // at most one pending request per call
+    void poll(bool networkUp);
+
+    void report();
+
+private:
+    bool _readRequestLine(WiFiClient &client, char *line, size_t cap);
+    void _respond(WiFiClient &client, const char *requestLine);
+    static bool _sinkThunk(void *client, const char *data, size_t len);
+
+    WiFiServer _server;
+    uint16_t _port;
+    bool _started;
+    LanStatusProvider _provider;
+    char _chunk[LAN_HTTP_CHUNK_BYTES];
+    LanStatus _status;            // static storage: off the network task stack
+    uint32_t _requests;
+    uint32_t _failures;           // timeouts, bad requests, client gone mid-send
+    uint32_t _maxServeUs;
+};
+
+extern LanHttpServer lanHttp;
+
+#endif // LAN_HTTP_H
@@ -0,0 +1,66 @@
+#ifndef LAN_STATUS_H
+#define LAN_STATUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+#include "latency_profiler.h"
+#include "telemetry.h"
+
+// ============================================================
+// LAN STATUS DOCUMENTS (/metrics, /state)
+// - Rendered from one LanStatus copy (control snapshot + network
+//   side stats), so a scrape never touches control-task state
+// - Output goes through a ChunkWriter: a caller-owned fixed
+//   buffer flushed to a sink whenever it fills, so a document of
+//   any length needs no heap and no String
+// - No Arduino dependency; the native simulator renders the same
+//   documents from the simulated HAL
+// ============================================================
+
+struct LanStatus {
+    TelemetrySnapshot t;          // sensors, relays, rssi, heap, uptime
+    float    heaterOnTemp;
+    float    heaterOffTemp;
+    float    refrigOnTemp;
+    float    refrigOffTemp;
+    uint32_t loopIterations;      // network task passes since boot
+    uint64_t loopTotalUs;
+    uint32_t loopMaxUs;           // worst pass in the current stats interval
+    bool     hasLatency;          // latency[] filled (LATENCY_BENCH_ENABLED)
+    LatencySummary latency[LAT_STAGE_COUNT];
+};
+
+// Returns false when the sink could not take the data (client gone)
+typedef bool (*ChunkSink)(void *ctx, const char *data, size_t len);
+
+class ChunkWriter {
+public:
+    ChunkWriter(char *buf, size_t capacity, ChunkSink sink, void *ctx);
+
+    void write(const char *text);
+    void printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+    // Flushes the rest; false if any write failed or a line was cut
+    bool finish();
+    size_t bytes() const { return _total; }
+
+private:
+    bool _flush();
+
+    char  *_buf;
+    size_t _cap;
+    size_t _len;
+    size_t _total;
+    ChunkSink _sink;
+    void  *_ctx;
+    bool   _failed;
+};
+
+// Prometheus text exposition format 0.0.4
+bool renderMetrics(const LanStatus &s, ChunkWriter &out);
+
+// One JSON object; invalid sensors are null
+bool renderState(const LanStatus &s, ChunkWriter &out);
+
+#endif // LAN_STATUS_H
@@ -0,0 +1,93 @@
+#ifndef LATENCY_PROFILER_H
+#define LATENCY_PROFILER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+class TelemetryPayload;
+
+// ============================================================
+// PER-STAGE LATENCY HISTOGRAMS (benchmark mode)
+// - Fixed log-linear buckets: 4 per power of two from 1 us to
+//   ~134 s, so any percentile is within 25% of the true value
+// - All storage is static; record() is a few instructions and
+//   compiles to nothing without LATENCY_BENCH_ENABLED
+// - Cumulative since boot: a rare 6 s outage stays visible in
+//   max/p99 until the next restart
+// - Each stage is recorded from one task only; readers in other
+//   tasks may see a count or two in flight, never a torn value
+// ============================================================
+
+#define LATENCY_BUCKETS 104
+
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(uint32_t us);
+    void reset();
+
+    uint32_t count() const { return _count; }
+    uint32_t maxUs() const { return _maxUs; }
+    // Upper edge of the bucket holding the pct-th percentile, capped at max
+    uint32_t percentileUs(uint8_t pct) const;
+
+    static uint8_t bucketOf(uint32_t us);
+    static uint32_t bucketUpperUs(uint8_t bucket);
+
+private:
+    uint32_t _counts[LATENCY_BUCKETS];
+    uint32_t _count;
+    uint32_t _maxUs;
+};
+
+enum LatencyStage {
+    LAT_WIFI_PROCESS = 0,     // wifiManager.process()
+    LAT_TELNET,               // handleTelnetLogger()
+    LAT_NETWORK_PASS,         // one whole network task pass
+    LAT_READ_SENSORS,         // readSensors()
+    LAT_DS18B20_COLLECT,      // addressed scratchpad reads of every probe
+    LAT_FB_PULL,              // relay/settings poll (stream down)
+    LAT_PUSH,                 // telemetry push (RTDB or MQTT)
+    LAT_APPLY_RELAYS,         // applyRelayStates()
+    LAT_OTA_CHECK,            // version.json check
+    LAT_COMMAND_TO_RELAY,     // remote command queued -> relays written
+    LAT_STAGE_COUNT
+};
+
+struct LatencySummary {
+    uint32_t count;
+    uint32_t p50Us;
+    uint32_t p95Us;
+    uint32_t p99Us;
+    uint32_t maxUs;
+};
+
+class LatencyProfiler {
+public:
+    void record(LatencyStage stage, uint32_t us) {
+#if LATENCY_BENCH_ENABLED
+        _stages[stage].record(us);
+#else
+        (void)stage;
+        (void)us;
+#endif
+    }
+
+    LatencySummary summary(LatencyStage stage) const;
+    static const char *stageName(LatencyStage stage);
+
+    // One [PERF] line per stage that has samples
+    void report() const;
+
+    // "status/latency_ms/<stage>": "p50/p95/p99/max"
+    bool buildSummary(TelemetryPayload &payload) const;
+
+private:
+    LatencyHistogram _stages[LAT_STAGE_COUNT];
+};
+
+extern LatencyProfiler latencyProfiler;
+
+#endif // LATENCY_PROFILER_H
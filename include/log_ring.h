@@ -0,0 +1,74 @@
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// ============================================================
+// LOG RING BUFFER
+// - Byte ring behind WiFiSerialLogger; no I/O, no allocation
+// - push() is all-or-nothing: a record (text + optional
+//   suffix) fits whole or is refused, never split or torn
+// - Producers must be serialised by the caller (the logger's
+//   spinlock); one consumer reads contiguous runs lock-free
+// - Positions are free-running 32-bit counters, so N must be a
+//   power of two
+// ============================================================
+
+template <uint32_t N>
+class LogRing {
+    static_assert((N & (N - 1)) == 0, "LogRing size must be a power of two");
+
+public:
+    LogRing() : head_(0), tail_(0) {}
+
+    // Producer side. fill receives the bytes in use after an
+    // accepted push
+    bool push(const uint8_t *data, size_t len, const uint8_t *suffix, size_t suffixLen, uint32_t &fill) {
+        const size_t size = len + suffixLen;
+        const uint32_t head = head_.load(std::memory_order_relaxed);
+        const uint32_t used = head - tail_.load(std::memory_order_acquire);
+        if (size > N - used) return false;
+        copyIn(head, data, len);
+        if (suffixLen) copyIn(head + len, suffix, suffixLen);
+        head_.store(head + size, std::memory_order_release);
+        fill = used + size;
+        return true;
+    }
+
+    // Consumer side: longest contiguous readable run (0 if empty),
+    // valid until consume()
+    size_t peek(const uint8_t *&data) const {
+        const uint32_t tail = tail_.load(std::memory_order_relaxed);
+        const uint32_t head = head_.load(std::memory_order_acquire);
+        const uint32_t pos = tail & (N - 1);
+        const uint32_t avail = head - tail;
+        data = ring_ + pos;
+        return (avail < N - pos) ? avail : N - pos;
+    }
+
+    void consume(size_t len) {
+        tail_.store(tail_.load(std::memory_order_relaxed) + (uint32_t)len, std::memory_order_release);
+    }
+
+    uint32_t used() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    // Copies into reserved space at absolute position at (may wrap)
+    void copyIn(uint32_t at, const uint8_t *data, size_t len) {
+        const uint32_t pos = at & (N - 1);
+        const size_t first = (len < N - pos) ? len : N - pos;
+        memcpy(ring_ + pos, data, first);
+        memcpy(ring_, data + first, len - first);
+    }
+
+    uint8_t ring_[N];
+    std::atomic<uint32_t> head_;   // producers
+    std::atomic<uint32_t> tail_;   // consumer
+};
+
+#endif // LOG_RING_H
@@ -0,0 +1,124 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include "config.h"
+#include "log_ring.h"
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#include <WiFi.h>
+#include <atomic>
+
+// ============================================================
+// SERIAL + TELNET LOGGER
+// - Print sink shared by all tasks and modules through Log
+// - write() only copies into a fixed ring buffer and returns;
+//   a low-priority drain task pushes the ring to UART and the
+//   telnet client in large contiguous chunks
+// - A full ring drops the whole write and counts it, so a slow
+//   telnet peer can never stall the control loop
+// - Until startDrain() (early boot) writes go out directly
+// ============================================================
+
+class WiFiSerialLogger : public Print {
+public:
+    WiFiSerialLogger();
+
+    void attachSerial(HardwareSerial *serial);
+    void setClient(WiFiClient *client) { client_ = client; }
+
+    // Creates the drain task; from here on write() never blocks on I/O
+    bool startDrain();
+
+    // Held by the drain while it writes to the client, and by the
+    // telnet handler while the client object is being replaced
+    void lock()   { if (lock_) xSemaphoreTakeRecursive(lock_, portMAX_DELAY); }
+    void unlock() { if (lock_) xSemaphoreGiveRecursive(lock_); }
+
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override { return enqueue(buffer, size, nullptr, 0); }
+
+    // Text and CRLF reserved in the ring together, so lines from
+    // different tasks never interleave (Print would write twice)
+    using Print::println;
+    size_t println(const char *line);
+    size_t println(const String &line) { return println(line.c_str()); }
+
+    // One formatted line "[TAG] msg\r\n" built on the stack and
+    // enqueued with a single write(); use the LOGx() macros below
+    void logf(uint8_t level, const char *tag, const char *fmt, ...)
+        __attribute__((format(printf, 4, 5)));
+
+    // Synchronously empties the ring (before a restart)
+    void flush() override;
+
+    uint32_t droppedWrites() const { return droppedWrites_.load(std::memory_order_relaxed); }
+    uint32_t droppedBytes() const { return droppedBytes_.load(std::memory_order_relaxed); }
+    void report();
+
+private:
+    size_t enqueue(const uint8_t *data, size_t len, const uint8_t *suffix, size_t suffixLen);
+    static void drainTaskEntry(void *param);
+    size_t drainOnce();
+    void writeOut(const uint8_t *data, size_t len);
+
+    HardwareSerial *serial_ = nullptr;
+    WiFiClient *client_ = nullptr;
+    SemaphoreHandle_t lock_ = nullptr;
+    TaskHandle_t drainTask_ = nullptr;
+    portMUX_TYPE ringMux_;
+
+    LogRing<LOG_RING_BYTES> ring_;          // producers under ringMux_, drain under lock_
+    std::atomic<uint32_t> droppedWrites_;
+    std::atomic<uint32_t> droppedBytes_;
+    uint32_t reportedDrops_ = 0;            // drain task only
+
+    // Cost accounting: caller-side enqueue vs. drain-side I/O (CPU cycles)
+    uint32_t enqueueCount_ = 0;
+    uint64_t enqueueCycles_ = 0;
+    uint32_t drainedBytes_ = 0;
+    uint64_t drainCycles_ = 0;
+};
+
+extern WiFiSerialLogger Log;
+
+#else
+#include <stdint.h>
+
+// Native builds: same Log / LOGx() interface, straight to stdout
+class HostLogger {
+public:
+    void logf(uint8_t level, const char *tag, const char *fmt, ...)
+        __attribute__((format(printf, 4, 5)));
+    void println(const char *line);
+    void flush() {}
+    void report() {}
+};
+
+extern HostLogger Log;
+#endif
+
+// ============================================================
+// LEVELED LOGGING
+// LOGE / LOGW / LOGI / LOGD / LOGT(TAG, fmt, ...) with TAG one of
+// SENSOR, CTRL, RELAY, FB, OTA, TELNET and a printf format
+// - Levels above LOG_LEVEL_<TAG> (config.h, defaults to
+//   CURRENT_LOG_LEVEL) are a constant-false branch: call and
+//   arguments compile out. A tag may be set above the build level
+// - Enabled lines never allocate (no String temporaries)
+// ============================================================
+
+#define LOG_AT(level, tag, fmt, ...)                        \
+    do {                                                    \
+        if ((level) <= LOG_LEVEL_##tag) {                   \
+            Log.logf((level), #tag, fmt, ##__VA_ARGS__);    \
+        }                                                   \
+    } while (0)
+
+#define LOGE(tag, fmt, ...) LOG_AT(LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#define LOGW(tag, fmt, ...) LOG_AT(LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#define LOGI(tag, fmt, ...) LOG_AT(LOG_INFO, tag, fmt, ##__VA_ARGS__)
+#define LOGD(tag, fmt, ...) LOG_AT(LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+#define LOGT(tag, fmt, ...) LOG_AT(LOG_TRACE, tag, fmt, ##__VA_ARGS__)
+
+#endif // LOGGER_H
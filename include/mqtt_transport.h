@@ -0,0 +1,68 @@
+#ifndef MQTT_TRANSPORT_H
+#define MQTT_TRANSPORT_H
+
+#include "config.h"
+
+#if TELEMETRY_TRANSPORT_MQTT
+#include <Arduino.h>
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include "transport.h"
+
+// ============================================================
+// MQTT TRANSPORT (PubSubClient)
+// - One persistent TCP session to MQTT_BROKER_HOST, kept alive
+//   from the network task; reconnects at most every
+//   MQTT_RECONNECT_INTERVAL_MS
+// - Topics under MQTT_TOPIC_ROOT (= "<root>/<device>"):
+//     telemetry            batched document, one per push
+//     backlog              offline samples, one batch per publish
+//     status/state         "online" (retained) after connect,
+//                          "offline" as last will: the broker marks
+//                          the device offline when the session dies
+//     relays/auto_mode, relays/control/<relay>, settings/<name>
+//                          subscribed; the app publishes settings
+//                          retained, so setpoints arrive on connect
+// - Session buffer sized once at boot for the largest document
+// ============================================================
+
+class MqttTransport : public TelemetryTransport {
+public:
+    MqttTransport();
+
+    const char *name() const override { return "mqtt"; }
+    bool ready() override;
+    void service() override;
+
+    bool publishTelemetry(const char *json) override;
+    bool publishBacklog(const char *json) override;
+    const char *lastError() override;
+
+    // Sessions opened since boot; a new one means subscribers may have
+    // missed deltas, so the caller re-sends every field
+    uint32_t sessions() const { return _connects; }
+    void report();
+
+private:
+    bool _connect();
+    bool _publish(const char *topic, const char *json, bool retained);
+    void _onMessage(char *topic, uint8_t *payload, unsigned int length);
+    static void _onMessageThunk(char *topic, uint8_t *payload, unsigned int length);
+
+    WiFiClient _net;
+    PubSubClient _client;
+    uint32_t _lastConnectAttempt;
+    bool _everAttempted;
+    bool _configured;
+    char _error[48];
+    uint32_t _connects;
+    uint32_t _published;
+    uint32_t _publishFailures;
+    uint32_t _commands;
+};
+
+extern MqttTransport mqttTransport;
+
+#endif // TELEMETRY_TRANSPORT_MQTT
+
+#endif // MQTT_TRANSPORT_H
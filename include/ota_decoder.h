@@ -0,0 +1,121 @@
+#ifndef OTA_DECODER_H
+#define OTA_DECODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================
+// OTA STREAM DECODERS
+// - Push-style: feed() whatever the socket delivered, decoded
+//   bytes go to a sink callback in order
+// - No dependency on Arduino/WiFi; the inflater uses the ROM
+//   miniz (lib/tinfl, same interface, on native builds), the
+//   patcher reads its base through a callback
+// ============================================================
+
+// Receives decoded output; return false to abort the stream
+typedef bool (*OtaSinkFn)(void *ctx, const uint8_t *data, size_t len);
+
+// Reads len bytes of the base image at offset (delta COPY source)
+typedef bool (*OtaBaseReadFn)(void *ctx, uint32_t offset, uint8_t *out, size_t len);
+
+// ============================================================
+// GZIP INFLATER
+// - RFC 1952 header is parsed here, the deflate body goes
+//   through the ROM tinfl with a 32 KB wrapping window
+// - The gzip CRC32 trailer is skipped: the caller already
+//   SHA-256s the decoded image
+// ============================================================
+
+#define OTA_INFLATE_WINDOW_BYTES 32768   // fixed by deflate
+
+class GzipInflater {
+public:
+    GzipInflater();
+    ~GzipInflater();
+
+    // Allocates the window + decompressor state (~43 KB heap)
+    bool begin(OtaSinkFn sink, void *ctx);
+    void end();
+
+    bool feed(const uint8_t *data, size_t len);
+    bool isDone() const { return _done; }
+    bool hasError() const { return _error; }
+
+private:
+    enum HeaderState { GZ_FIXED, GZ_EXTRA_LEN, GZ_EXTRA, GZ_NAME, GZ_COMMENT, GZ_HCRC, GZ_BODY };
+
+    size_t _parseHeader(const uint8_t *data, size_t len);
+    void _nextHeaderField(HeaderState done);
+
+    OtaSinkFn _sink;
+    void *_ctx;
+    void *_inflator;          // tinfl_decompressor
+    uint8_t *_window;
+    size_t _windowPos;
+    HeaderState _hdrState;
+    uint8_t _flags;
+    uint16_t _hdrCount;       // bytes left in the current header field
+    uint16_t _extraLen;
+    bool _done;
+    bool _error;
+};
+
+// ============================================================
+// DELTA PATCHER
+// Stream format ("EDL1", little endian), produced by
+// scripts/make_delta.py:
+//   header : "EDL1" | base_size u32 | base_sha256[32] | target_size u32
+//   ops    : 0x01 COPY   src_offset u32 | len u32   (from base)
+//            0x02 INSERT len u32 | bytes[len]
+//            0x00 END
+// ============================================================
+
+#define OTA_DELTA_MAGIC "EDL1"
+
+class DeltaPatcher {
+public:
+    DeltaPatcher();
+
+    // The header must name this exact base (size + sha256).
+    // scratch is used for COPY reads from the base image.
+    void begin(OtaSinkFn sink, void *sinkCtx, OtaBaseReadFn baseRead, void *baseCtx,
+               uint32_t baseSize, const uint8_t *baseSha256,
+               uint8_t *scratch, size_t scratchLen);
+
+    bool feed(const uint8_t *data, size_t len);
+
+    // Valid once the header has been parsed
+    uint32_t targetSize() const { return _targetSize; }
+
+    bool isDone() const { return _state == DP_DONE; }
+    bool hasError() const { return _state == DP_ERROR; }
+
+    // Sink adapter so a GzipInflater can feed straight into a patcher
+    static bool feedThunk(void *self, const uint8_t *data, size_t len);
+
+private:
+    enum State { DP_HEADER, DP_OP, DP_COPY_ARGS, DP_INSERT_LEN, DP_INSERT_DATA, DP_DONE, DP_ERROR };
+
+    bool _copyFromBase(uint32_t offset, uint32_t len);
+    static uint32_t _u32(const uint8_t *p);
+
+    OtaSinkFn _sink;
+    void *_sinkCtx;
+    OtaBaseReadFn _baseRead;
+    void *_baseCtx;
+    uint32_t _baseSize;
+    const uint8_t *_baseSha256;
+    uint8_t *_scratch;
+    size_t _scratchLen;
+
+    State _state;
+    uint8_t _header[44];
+    uint8_t _args[8];
+    size_t _have;             // bytes collected for the current field
+    uint32_t _remaining;      // INSERT bytes still to pass through
+    uint32_t _targetSize;
+    uint32_t _produced;
+};
+
+#endif // OTA_DECODER_H
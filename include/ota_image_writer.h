@@ -0,0 +1,48 @@
+#ifndef OTA_IMAGE_WRITER_H
+#define OTA_IMAGE_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "flash_region.h"
+#include "sha256.h"
+
+// ============================================================
+// OTA IMAGE WRITER
+// - Streams image bytes into a FlashRegion (the inactive OTA
+//   partition on target, an image file on the host), erasing
+//   sectors lazily just ahead of the write position
+// - SHA-256 is updated chunk by chunk as it is written, so the
+//   image is verified without a second pass over the partition
+// - resume() rebuilds the hash by re-reading the written prefix
+//   from flash (hash state is not checkpointed)
+// - No HTTP, NVS or esp_ota code: the native build runs it as is
+// ============================================================
+
+class OtaImageWriter {
+public:
+    explicit OtaImageWriter(FlashRegion &region);
+
+    // Start over at offset 0
+    void restart();
+    // Continue at offset (sector aligned) after re-hashing the
+    // bytes already in flash through scratch; false = start over
+    bool resume(uint32_t offset, uint8_t *scratch, size_t scratchLen);
+
+    // Erase ahead (as needed), program, hash; false on a flash error
+    bool write(const uint8_t *data, size_t len);
+
+    uint32_t offset() const { return _offset; }
+
+    // Compares the hash of everything written with expectedHex
+    // (case-insensitive); actualHex gets the 64-digit digest.
+    // Ends the hash: restart() or resume() before writing again
+    bool verify(const char *expectedHex, char actualHex[2 * Sha256::DIGEST_BYTES + 1]);
+
+private:
+    FlashRegion &_region;
+    Sha256 _sha;
+    uint32_t _offset;
+    uint32_t _erasedEnd;     // erased up to here (sector aligned)
+};
+
+#endif // OTA_IMAGE_WRITER_H
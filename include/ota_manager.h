@@ -4,10 +4,14 @@
 #include <Arduino.h>
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
-#include <Update.h>
 #include <esp_ota_ops.h>
 #include <esp_system.h>
+#include <atomic>
 #include "config.h"
+#include "flash_region.h"
+#include "ota_decoder.h"
+#include "ota_image_writer.h"
+#include "ota_policy.h"
 
 // ============================================================
 // OTA STATE MACHINE
@@ -34,57 +38,148 @@ struct FirmwareVersion {
     String sha256;
     long fileSize;
     bool isValid;
+    String gzipUrl;      // optional gzip of the same image
+    String deltaUrl;     // optional delta against the running image
 };
 
 // ============================================================
 // OTA MANAGER CLASS
+// - Version check runs in the caller's task (small JSON GET,
+//   conditional on the cached ETag / Last-Modified)
+// - Download + flash runs as a background FreeRTOS job with its
+//   own buffer, so control and networking keep running
+// - State/progress/throughput are safe to read from any task
+// - SHA-256 is hashed chunk by chunk as it is written, so the
+//   image is verified without a second pass over the partition
+//   (OtaImageWriter); a full image that fails verification is
+//   remembered in NVS and not fetched again until version.json
+//   offers a different sha256
+// - Writes go straight to the inactive OTA partition; the offset
+//   is checkpointed in NVS and dropped transfers continue with
+//   an HTTP Range request, also across reboots
+// - Prefers a delta against the running image, then gzip, then
+//   the full image; an interrupted or undecodable compressed
+//   transfer continues from the full image
+// - Checks are spread with per-device jitter; a release installs
+//   only when its staged rollout selects this device (ota_policy.h)
 // ============================================================
 
 class OTAManager {
 public:
     OTAManager();
-    
+
     // Initialize OTA system
     bool begin();
-    
+
     // Check state of current firmware (called at boot)
     bool validateCurrentFirmware();
-    
-    // Check for updates from GitHub
+
+    // Next version check is due (jittered interval / failure backoff)
+    bool checkDue();
+
+    // Check for updates from GitHub; starts the background install if newer
+    // and this device's rollout turn has come
     bool checkForUpdates();
-    
+
     // Get latest version info
     FirmwareVersion getLatestVersion();
-    
-    // Download and install firmware
-    bool downloadAndInstall(const String& downloadUrl);
-    
+
+    // Start background download and install (false if a job is running)
+    bool downloadAndInstall(const String& downloadUrl, const String& expectedSha256 = "");
+
     // Get OTA state
     OTAState getState();
-    
+
     // Get progress percentage (0-100)
     int getProgress();
-    
+
+    // Download job running (checking/downloading/installing)
+    bool isBusy();
+
+    // Bytes written so far / image size of the current job
+    uint32_t getBytesWritten();
+    uint32_t getTotalBytes();
+
+    // Average download throughput of the current/last job (bytes/s)
+    uint32_t getThroughputBps();
+
     // Get last error message
     String getLastError();
-    
+
     // Manual rollback to previous firmware
     bool forcedRollback();
-    
+
     // Mark current firmware as valid (done after boot validation)
     bool markCurrentFirmwareValid();
 
 private:
-    OTAState _state;
-    int _progress;
+    std::atomic<int> _state;
+    std::atomic<int> _progress;
+    std::atomic<uint32_t> _bytesWritten;
+    std::atomic<uint32_t> _totalBytes;
+    std::atomic<uint32_t> _throughputBps;
     String _lastError;
-    unsigned long _lastUpdateCheck;
-    
+    uint32_t _nextCheckMs;         // millis() of the next version check
+    uint8_t _checkFailures;        // consecutive failed version checks
+    uint64_t _deviceId;            // eFuse MAC: rollout cohort + poll jitter
+    uint32_t _jitterState;
+    String _rolloutSha;            // release the first sighting below belongs to
+    uint32_t _rolloutSeenEpoch;    // first OTA_ACT_DEFER for it, 0 = none yet
+    bool _validatorsLoaded;
+    String _versionEtag;           // validators of the last up-to-date version.json
+    String _versionLastModified;
+    FirmwareVersion _latest;
+
+    // Background job
+    String _jobUrl;                // full image (also used for Range resume)
+    String _jobSha256;
+    String _jobSourceUrl;          // gzip/delta source when encoded
+    OtaEncoding _jobEncoding;
+    uint32_t _jobSize;             // decoded size, required for encoded sources
+    TaskHandle_t _task;
+    uint8_t *_buffer;
+    uint32_t _checkpointed;        // offset last saved to NVS
+    const esp_partition_t *_part;  // partition being written
+    EspPartitionRegion _partRegion;
+    OtaImageWriter _writer;        // flash + running hash of bytes written so far
+    bool _writeFailed;
+
+    // Running image identity, for picking a delta
+    uint8_t _runningSha[32];
+    uint32_t _runningSize;
+    bool _runningShaValid;
+    String _encodedFailedSha;      // compressed/delta failed for this release
+    String _imageFailedSha;        // full image failed verification (NVS)
+    bool _imageFailedLoaded;
+
+    enum DownloadResult { DL_COMPLETE, DL_INTERRUPTED, DL_FATAL };
+
+    bool _startJob(const String& url, const String& sha256, const String& sourceUrl,
+                   OtaEncoding encoding, uint32_t size);
+    static void _downloadTaskEntry(void *param);
+    void _runDownloadJob();
+    void _fail(const String& error);
+    void _checkFailed(const String& error);
+    void _checkSucceeded();
+    OtaAction _rolloutGate(const OtaRollout& rollout);
+    void _loadVersionValidators();
+    void _saveVersionValidators(const String& etag, const String& lastModified);
+    bool _imageFailedBefore(const String& sha256);
+    void _saveImageFailedSha(const String& sha256);
+
     // Internal helper functions
     bool _validateSHA256(const String& hash);
-    bool _downloadFile(const String& url, uint32_t& downloadedSize);
+    DownloadResult _downloadFrom();
+    bool _emit(const uint8_t *data, size_t len);
+    static bool _emitThunk(void *self, const uint8_t *data, size_t len);
+    static bool _readBaseThunk(void *part, uint32_t offset, uint8_t *out, size_t len);
+    bool _hashRunningImage();
+    bool _runningShaMatches(const String& hex);
+    uint32_t _loadCheckpoint(const esp_partition_t *part);
+    void _saveCheckpoint(uint32_t offset);
+    void _clearCheckpoint();
     bool _verifyDownloadHash(const String& expectedHash);
-    esp_partition_t* _getNextOtaPartition();
+    const esp_partition_t* _getNextOtaPartition();
 };
 
 // ============================================================
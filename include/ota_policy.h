@@ -0,0 +1,110 @@
+#ifndef OTA_POLICY_H
+#define OTA_POLICY_H
+
+#include <stdint.h>
+#include "config.h"
+
+// ============================================================
+// OTA UPDATE DECISION
+// - What to do with one version.json offer, kept free of HTTP,
+//   NVS and partition code so the native build runs it as is
+// - OTAManager fills an OtaOffer from the parsed JSON and acts
+//   on the result
+// - Staged rollout and jittered polling are keyed on a 64-bit
+//   device id (the eFuse MAC), so the host can run them for any
+//   number of virtual devices
+// ============================================================
+
+// How the job's source URL is encoded (output is always the raw image)
+enum OtaEncoding {
+    OTA_ENC_RAW = 0,
+    OTA_ENC_GZIP = 1,
+    OTA_ENC_DELTA = 2    // gzip-compressed EDL1 patch
+};
+
+enum OtaAction {
+    OTA_ACT_NONE = 0,     // up to date (or nothing installable offered)
+    OTA_ACT_REJECT,       // newer, but sha256 missing / malformed
+    OTA_ACT_INSTALL,      // start a job with the chosen encoding
+    OTA_ACT_DEFER,        // in the rollout, its start time not reached yet
+    OTA_ACT_NOT_SELECTED, // outside rollout_percent for now
+    OTA_ACT_BLOCKED       // this sha256 failed verification before
+};
+
+struct OtaOffer {
+    const char *version;
+    const char *sha256;           // "" when absent
+    uint32_t fileSize;            // decoded size, 0 when absent
+    bool hasDownloadUrl;
+    bool hasGzipUrl;
+    bool hasDeltaUrl;             // delta from the running image offered
+    bool encodedFailedBefore;     // gzip/delta already failed for this sha256
+    bool imageFailedBefore;       // the full image already failed verification
+};
+
+// Delta first, then gzip, then the full image. An image that failed
+// verification is BLOCKED until the offer names another sha256
+OtaAction otaDecide(const OtaOffer &offer, const char *currentVersion, OtaEncoding &encoding);
+
+// 64 hex digits
+bool otaSha256WellFormed(const char *hex);
+
+// Wait before the next version check after `failures` failed
+// checks in a row: interval * 2^(failures-1), capped
+uint32_t otaCheckBackoffMs(uint8_t failures);
+
+// "bytes <first>-<last>/<total>" of a 206 reply; false when malformed,
+// inconsistent or the total is "*"
+bool otaParseContentRange(const char *header, uint32_t &first, uint32_t &total);
+
+// ============================================================
+// STAGED ROLLOUT (optional version.json fields)
+// - Every device has a stable cohort in [0, OTA_COHORT_SPAN)
+//   hashed from its id; rollout_percent P selects the cohorts
+//   below P% of the span, so raising P only ever adds devices
+// - max_concurrent + fleet_size split the selected cohorts into
+//   waves of ~max_concurrent devices, wave_s apart, counted from
+//   not_before or from when this device first saw the release
+//   selected, whichever is later
+// - force_update, or a running version below min_version, skips
+//   rollout_percent and not_before; the wave stagger still applies
+// ============================================================
+#define OTA_COHORT_SPAN 10000   // cohort resolution: 0.01 %
+#define OTA_EPOCH_SYNCED_MIN 1600000000UL   // below this the clock was never set
+
+struct OtaRollout {
+    uint8_t  percent;          // rollout_percent, 100 when absent
+    uint32_t notBefore;        // not_before (epoch s), 0 when absent
+    uint16_t maxConcurrent;    // max_concurrent, 0 = no stagger
+    uint32_t fleetSize;        // fleet_size, 0 = no stagger
+    uint32_t waveS;            // wave_s, OTA_ROLLOUT_WAVE_S when absent
+    const char *minVersion;    // "" when absent
+    bool forceUpdate;
+};
+
+uint16_t otaCohort(uint64_t deviceId);
+
+// Dotted numeric compare ("1.10.0" > "1.9.2"), leading 'v' ignored;
+// <0, 0, >0 like strcmp
+int otaVersionCompare(const char *a, const char *b);
+
+// Gate for an offer otaDecide() would install. firstSeenEpoch: when
+// this device first got OTA_ACT_DEFER for this release with the
+// clock set (0, or anything below OTA_EPOCH_SYNCED_MIN = now).
+// startEpoch: when the install may begin (0 = now); DEFER with
+// startEpoch 0 means the clock is not set yet
+OtaAction otaRolloutDecide(const OtaRollout &rollout, const char *currentVersion, uint64_t deviceId,
+                           uint32_t nowEpoch, uint32_t firstSeenEpoch, uint32_t &startEpoch);
+
+// ============================================================
+// JITTERED POLLING
+// - Each check waits the interval (or the failure backoff) plus
+//   a random 0..OTA_CHECK_JITTER_PCT % of it, from a per-device
+//   PRNG, so a fleet that booted together drifts apart
+// - The first check after boot lands anywhere in one interval
+// ============================================================
+uint32_t otaJitterSeed(uint64_t deviceId);
+uint32_t otaFirstCheckMs(uint32_t &jitterState);
+uint32_t otaNextCheckMs(uint8_t failures, uint32_t &jitterState);
+
+#endif // OTA_POLICY_H
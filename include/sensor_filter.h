@@ -0,0 +1,242 @@
+#ifndef SENSOR_FILTER_H
+#define SENSOR_FILTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================
+// FIXED-POINT SENSOR FILTERS
+// - Integer samples (e.g. 1/100 °C), no floats, no heap: every
+//   filter keeps its state inline and is sized at compile time
+// - SensorChannel chains them: range check -> rate-of-change
+//   outlier rejection -> running median -> EMA, and marks the
+//   channel invalid when no good sample arrived for a while
+// - Not thread-safe: one task feeds and reads a channel
+// ============================================================
+
+// Last N samples, oldest overwritten
+template <typename T, size_t N>
+class RingWindow {
+    static_assert(N >= 1, "RingWindow needs at least one slot");
+
+public:
+    RingWindow() : _next(0), _count(0) {}
+
+    void push(T value) {
+        _items[_next] = value;
+        _next = (_next + 1) % N;
+        if (_count < N) _count++;
+    }
+
+    void clear() { _next = 0; _count = 0; }
+    size_t size() const { return _count; }
+    bool full() const { return _count == N; }
+
+    // 0 = oldest
+    T at(size_t i) const { return _items[(_next + N - _count + i) % N]; }
+
+private:
+    T _items[N];
+    size_t _next;
+    size_t _count;
+};
+
+// Running median of the last N samples (N odd, small: insertion sort)
+template <typename T, size_t N>
+class MedianFilter {
+    static_assert(N % 2 == 1, "MedianFilter window must be odd");
+
+public:
+    T update(T value) {
+        _window.push(value);
+        T sorted[N];
+        const size_t n = _window.size();
+        for (size_t i = 0; i < n; i++) {
+            const T v = _window.at(i);
+            size_t j = i;
+            for (; j > 0 && sorted[j - 1] > v; j--) sorted[j] = sorted[j - 1];
+            sorted[j] = v;
+        }
+        return sorted[n / 2];
+    }
+
+    void reset() { _window.clear(); }
+
+private:
+    RingWindow<T, N> _window;
+};
+
+// y += (x - y) / 2^Shift, with FracBits extra bits of state so
+// small steps are not lost to truncation
+template <typename T, uint8_t Shift, uint8_t FracBits = 8>
+class EmaFilter {
+    static_assert(Shift < FracBits + 16, "EMA shift too large for the state");
+
+public:
+    EmaFilter() : _acc(0), _primed(false) {}
+
+    T update(T sample) {
+        const int64_t x = (int64_t)sample * (1 << FracBits);
+        if (!_primed) {
+            _acc = x;   // start on the first sample instead of ramping from 0
+            _primed = true;
+        } else {
+            _acc += (x - _acc) / (1 << Shift);
+        }
+        return value();
+    }
+
+    T value() const {
+        const int64_t half = 1 << (FracBits - 1);
+        return (T)((_acc >= 0 ? _acc + half : _acc - half) / (1 << FracBits));
+    }
+
+    void reset() { _primed = false; }
+
+private:
+    int64_t _acc;
+    bool _primed;
+};
+
+// Rejects samples that move faster than maxPerS from the last
+// accepted one. Reacquire consecutive rejects that agree with each
+// other are taken as a real step and accepted.
+template <typename T, uint8_t Reacquire = 3>
+class RateLimiter {
+public:
+    RateLimiter(T maxPerS, T minStep)
+        : _maxPerS(maxPerS), _minStep(minStep), _last(0), _candidate(0), _lastMs(0),
+          _hasLast(false), _stepped(false), _rejects(0) {}
+
+    // true = accept
+    bool check(T value, uint32_t nowMs) {
+        if (!_hasLast) {
+            _accept(value, nowMs);
+            return true;
+        }
+        const int32_t allowed = (int32_t)_minStep + (int32_t)(((int64_t)_maxPerS * (nowMs - _lastMs)) / 1000);
+        const int32_t step = (int32_t)value - (int32_t)_last;
+        if (step <= allowed && step >= -allowed) {
+            _accept(value, nowMs);
+            return true;
+        }
+
+        // Outlier, unless it is the Reacquire-th in a row near the previous one
+        const int32_t fromCandidate = (int32_t)value - (int32_t)_candidate;
+        if (_rejects > 0 && fromCandidate <= (int32_t)_minStep && fromCandidate >= -(int32_t)_minStep) {
+            _rejects++;
+        } else {
+            _rejects = 1;
+        }
+        _candidate = value;
+        if (_rejects >= Reacquire) {
+            _accept(value, nowMs);
+            return true;
+        }
+        return false;
+    }
+
+    // true once after a step was reacquired (downstream state is stale)
+    bool stepped() {
+        const bool s = _stepped;
+        _stepped = false;
+        return s;
+    }
+
+    void reset() { _hasLast = false; _rejects = 0; }
+
+private:
+    void _accept(T value, uint32_t nowMs) {
+        _stepped = _hasLast && _rejects >= Reacquire;
+        _last = value;
+        _lastMs = nowMs;
+        _hasLast = true;
+        _rejects = 0;
+    }
+
+    T _maxPerS;
+    T _minStep;       // always allowed (sensor quantization / noise)
+    T _last;
+    T _candidate;
+    uint32_t _lastMs;
+    bool _hasLast;
+    bool _stepped;
+    uint8_t _rejects;
+};
+
+struct SensorChannelConfig {
+    int32_t minValid;       // outside [minValid, maxValid] = dropout / fault code
+    int32_t maxValid;
+    int32_t maxRatePerS;    // outlier rejection
+    int32_t minStep;
+    uint32_t staleMs;       // no accepted sample for this long = invalid
+};
+
+struct SensorChannelStats {
+    uint32_t samples;
+    uint32_t outOfRange;
+    uint32_t outliers;
+    uint32_t steps;         // reacquired real steps
+};
+
+template <size_t MedianN = 5, uint8_t EmaShift = 2>
+class SensorChannel {
+public:
+    explicit SensorChannel(const SensorChannelConfig &config)
+        : _config(config), _limiter(config.maxRatePerS, config.minStep), _value(0), _valid(false),
+          _lastGoodMs(0), _stats() {}
+
+    // Raw sample in fixed point; returns true when it was used
+    bool update(int32_t raw, uint32_t nowMs) {
+        _stats.samples++;
+        if (raw < _config.minValid || raw > _config.maxValid) {
+            _stats.outOfRange++;
+            _expire(nowMs);
+            return false;
+        }
+        if (!_valid) {
+            // First good sample after a dropout: do not rate-limit against old data
+            _limiter.reset();
+            _median.reset();
+            _ema.reset();
+        }
+        if (!_limiter.check(raw, nowMs)) {
+            _stats.outliers++;
+            _expire(nowMs);
+            return false;
+        }
+        if (_limiter.stepped()) {
+            _stats.steps++;
+            _median.reset();
+            _ema.reset();
+        }
+        _value = _ema.update(_median.update(raw));
+        _valid = true;
+        _lastGoodMs = nowMs;
+        return true;
+    }
+
+    // Call on read failures too, so a dead sensor goes invalid
+    void expire(uint32_t nowMs) { _expire(nowMs); }
+
+    bool valid() const { return _valid; }
+    int32_t value() const { return _value; }
+    const SensorChannelStats &stats() const { return _stats; }
+    void resetStats() { _stats = SensorChannelStats(); }
+
+private:
+    void _expire(uint32_t nowMs) {
+        if (_valid && nowMs - _lastGoodMs >= _config.staleMs) _valid = false;
+    }
+
+    SensorChannelConfig _config;
+    RateLimiter<int32_t> _limiter;
+    MedianFilter<int32_t, MedianN> _median;
+    EmaFilter<int32_t, EmaShift> _ema;
+    int32_t _value;
+    bool _valid;
+    uint32_t _lastGoodMs;
+    SensorChannelStats _stats;
+};
+
+#endif // SENSOR_FILTER_H
@@ -0,0 +1,97 @@
+#ifndef SENSOR_REGISTRY_H
+#define SENSOR_REGISTRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+#include "hal.h"
+#include "sensor_filter.h"
+
+// ============================================================
+// DS18B20 SENSOR REGISTRY
+// - Each OneWire bus is enumerated once at boot; ROM addresses
+//   are cached and every read is one addressed scratchpad read
+// - One broadcast (skip ROM) convert per bus per cycle, however
+//   many probes hang off it
+// - A bus is searched again only after a probe on it failed
+//   SENSOR_RESCAN_FAILURES reads in a row (or it has no probes),
+//   at most every SENSOR_RESCAN_INTERVAL_MS
+// - Probes keep their slot and name for the life of the boot;
+//   a probe that vanishes stays registered, goes not-present
+//   and its filter goes invalid
+// - The first probe found on a bus is its primary (temp1 /
+//   temp2 for control), tracked by slot whatever its name. A
+//   new probe found while the primary is gone replaces it in
+//   the same slot
+// - Names: SENSOR_PROBE_NAMES (ROM -> name) first, else the
+//   first probe on bus N is "tempN", the others "tempN_<k>"
+// - Owned by the control task
+// ============================================================
+
+#define SENSOR_BUSES_MAX HAL_TEMP_BUSES
+
+struct SensorProbe {
+    uint8_t rom[8];
+    uint8_t bus;
+    bool present;
+    uint8_t failures;                  // consecutive failed reads
+    char name[SENSOR_PROBE_NAME_MAX];
+    SensorChannel<> filter;            // 1/100 °C
+
+    SensorProbe();
+};
+
+class SensorRegistry {
+public:
+    SensorRegistry();
+
+    // Register a bus before begin(); probes on it are named "temp<index+1>..."
+    bool addBus(HalTempBus &bus);
+
+    // Enumerate every bus and set the resolution on each probe
+    void begin(uint8_t resolutionBits);
+
+    // Broadcast convert on every bus (returns immediately)
+    void requestConversion();
+    uint32_t conversionMs() const { return _conversionMs; }
+
+    // Read every present probe by address into its filter;
+    // rescans a bus that has been failing
+    void collect(uint32_t nowMs);
+
+    size_t count() const { return _count; }
+    SensorProbe &probe(size_t i) { return _probes[i]; }
+    const SensorProbe &probe(size_t i) const { return _probes[i]; }
+    SensorProbe *find(const char *name);
+    // Control probe of a bus (temp1 / temp2), nullptr if none yet
+    SensorProbe *primary(uint8_t bus);
+
+    void report();
+
+private:
+    struct Bus {
+        HalTempBus *io;
+        uint32_t lastScanMs;
+        uint8_t found;     // probes seen by the last scan
+        int8_t primary;    // slot of the control probe, -1 = none yet
+    };
+
+    void _scan(uint8_t bus, uint32_t nowMs);
+    bool _needsRescan(uint8_t bus) const;
+    int _indexOf(const uint8_t *rom) const;
+    void _name(SensorProbe &p);
+    static bool _configuredName(const uint8_t *rom, char *name, size_t size);
+
+    Bus _buses[SENSOR_BUSES_MAX];
+    uint8_t _busCount;
+    SensorProbe _probes[SENSOR_PROBES_MAX];
+    size_t _count;
+    uint8_t _resolutionBits;
+    uint32_t _conversionMs;
+    uint32_t _scans;
+    uint32_t _readFailures;
+};
+
+extern SensorRegistry sensorRegistry;
+
+#endif // SENSOR_REGISTRY_H
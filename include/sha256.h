@@ -0,0 +1,49 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(ARDUINO)
+#include <mbedtls/sha256.h>
+#endif
+
+// ============================================================
+// SHA-256
+// - Incremental: update() per chunk, finish() once
+// - mbedtls on target (routed to the ESP32 SHA peripheral);
+//   a plain C++ implementation on the host
+// ============================================================
+
+class Sha256 {
+public:
+    static const size_t DIGEST_BYTES = 32;
+
+    Sha256();
+    ~Sha256();
+
+    void reset();
+    void update(const uint8_t *data, size_t len);
+    // Digest of everything since reset(); reset() before reuse
+    void finish(uint8_t digest[DIGEST_BYTES]);
+
+    // 64 lowercase hex digits + NUL
+    static void toHex(const uint8_t digest[DIGEST_BYTES], char hex[2 * DIGEST_BYTES + 1]);
+
+private:
+    Sha256(const Sha256 &) = delete;
+    Sha256 &operator=(const Sha256 &) = delete;
+
+#if defined(ARDUINO)
+    mbedtls_sha256_context _ctx;
+#else
+    void _block(const uint8_t *p);
+
+    uint32_t _h[8];
+    uint64_t _length;      // bytes hashed
+    uint8_t  _buf[64];
+    size_t   _used;
+#endif
+};
+
+#endif // SHA256_H
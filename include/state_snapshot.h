@@ -0,0 +1,54 @@
+#ifndef STATE_SNAPSHOT_H
+#define STATE_SNAPSHOT_H
+
+#include <atomic>
+#include <stdint.h>
+
+// ============================================================
+// SEQLOCK STATE SNAPSHOT
+// - One writer publishes whole copies of T; any number of
+//   readers take consistent copies without locks
+// - Writer makes the sequence odd, writes, then makes it even
+//   again; a reader retries unless it saw the same even value
+//   before and after its copy
+// - T must be trivially copyable (plain struct)
+// ============================================================
+
+template <typename T>
+class StateSnapshot {
+public:
+    StateSnapshot() : _seq(0) {
+        _value = T();
+    }
+
+    // Writer side (single task)
+    void publish(const T &value) {
+        const uint32_t seq = _seq.load(std::memory_order_relaxed);
+        _seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        _value = value;
+        _seq.store(seq + 2, std::memory_order_release);
+    }
+
+    // Reader side; returns the (even) sequence number of the copy
+    uint32_t read(T &out) const {
+        for (;;) {
+            const uint32_t before = _seq.load(std::memory_order_acquire);
+            if (before & 1) continue;   // write in progress
+            out = _value;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (_seq.load(std::memory_order_relaxed) == before) {
+                return before;
+            }
+        }
+    }
+
+    // Even while idle; advances by 2 per publish
+    uint32_t sequence() const { return _seq.load(std::memory_order_acquire); }
+
+private:
+    T _value;
+    std::atomic<uint32_t> _seq;
+};
+
+#endif // STATE_SNAPSHOT_H
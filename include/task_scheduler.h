@@ -0,0 +1,81 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================
+// COOPERATIVE PERIODIC TASK SCHEDULER
+// - Fixed task table, no heap
+// - Drift-free: next due time advances by the period, never
+//   "now + period", so work time does not accumulate as drift
+// - One task per runNext() call, highest priority first, so a
+//   network overrun cannot push the control task back a period
+// - Clock is injected (millis() on target, a fake clock on host)
+// ============================================================
+
+#ifndef SCHEDULER_MAX_TASKS
+#define SCHEDULER_MAX_TASKS 12
+#endif
+
+typedef uint32_t (*SchedulerClock)();
+typedef void (*SchedulerCallback)();
+
+struct TaskStats {
+    uint32_t runs;
+    uint32_t lastRunMs;       // duration of the most recent run
+    uint32_t maxRunMs;
+    uint64_t totalRunMs;
+    uint32_t lastLatenessMs;  // start time minus due time
+    uint32_t maxLatenessMs;
+    uint32_t deadlineMisses;  // finished later than due + deadline
+    uint32_t skippedPeriods;  // whole periods dropped after an overrun
+};
+
+struct ScheduledTask {
+    const char       *name;
+    SchedulerCallback callback;
+    uint32_t          periodMs;
+    uint32_t          phaseMs;     // offset of the first run from start()
+    uint32_t          deadlineMs;  // relative to due time
+    uint8_t           priority;    // higher runs first
+    bool              enabled;
+    uint32_t          nextDueMs;
+    TaskStats         stats;
+};
+
+class TaskScheduler {
+public:
+    explicit TaskScheduler(SchedulerClock clock);
+
+    // Returns task id, or -1 when the table is full.
+    // deadlineMs = 0 means "finish within one period".
+    int addTask(const char *name, SchedulerCallback callback, uint32_t periodMs,
+                uint32_t phaseMs = 0, uint8_t priority = 0, uint32_t deadlineMs = 0);
+
+    // Anchor every task's first due time at now + phase
+    void start();
+
+    // Run the highest-priority due task; false if none was due
+    bool runNext();
+
+    // Milliseconds until the next enabled task is due (0 = due now)
+    uint32_t msUntilNextDue() const;
+
+    void setEnabled(int id, bool enabled);
+    void resetStats();
+
+    size_t taskCount() const { return _count; }
+    const ScheduledTask *task(int id) const;
+
+private:
+    ScheduledTask  _tasks[SCHEDULER_MAX_TASKS];
+    size_t         _count;
+    SchedulerClock _clock;
+
+    static bool _isDue(const ScheduledTask &t, uint32_t now) {
+        return (int32_t)(now - t.nextDueMs) >= 0;
+    }
+};
+
+#endif // TASK_SCHEDULER_H
@@ -0,0 +1,143 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+// ============================================================
+// TELEMETRY SNAPSHOT
+// - One consistent copy of everything published per cycle
+// - Validity flags are resolved by the caller (DS18B20 -127 etc.)
+// ============================================================
+
+struct TelemetrySnapshot {
+    float    temp1;
+    float    temp2;
+    float    ambientTemp;
+    float    ambientHumidity;
+    bool     temp1Valid;
+    bool     temp2Valid;
+    bool     ambientValid;
+
+    // DS18B20 probes besides temp1/temp2, published as sensors/<name>
+    uint8_t     probeCount;
+    const char *probeName[SENSOR_PROBES_MAX];
+    float       probeTemp[SENSOR_PROBES_MAX];
+    bool        probeValid[SENSOR_PROBES_MAX];
+
+    bool     heaterOn;
+    bool     refrigOn;
+    bool     fanOn;
+    bool     autoMode;
+
+    int32_t  rssi;
+    uint32_t freeHeap;
+    uint32_t minFreeHeap;     // low-water mark since boot
+    uint32_t maxAllocHeap;    // largest free block (fragmentation)
+    uint32_t uptimeS;
+    uint32_t epoch;
+};
+
+// ============================================================
+// MULTI-PATH JSON PAYLOAD
+// - Fixed buffer, no heap: keys are paths relative to the node
+//   the payload is PATCHed onto ("sensors/temp1", ...)
+// - Overflow is sticky; a truncated payload is never sent
+// ============================================================
+
+class TelemetryPayload {
+public:
+    TelemetryPayload();
+
+    void reset();
+
+    void addFloat(const char *path, float value, uint8_t decimals = 2);
+    void addInt(const char *path, int32_t value);
+    void addUInt(const char *path, uint32_t value);
+    void addBool(const char *path, bool value);
+    void addString(const char *path, const char *value);
+
+    // Closes the object; returns false if anything was truncated
+    bool finish();
+
+    const char *c_str() const { return _buf; }
+    size_t length() const { return _len; }
+    size_t fieldCount() const { return _fields; }
+    bool overflowed() const { return _overflow; }
+
+private:
+    char   _buf[TELEMETRY_PAYLOAD_MAX_BYTES];
+    size_t _len;
+    size_t _fields;
+    bool   _overflow;
+    bool   _closed;
+
+    void _appendKey(const char *path);
+    void _appendRaw(const char *text, size_t n);
+};
+
+// ============================================================
+// TELEMETRY FIELDS (bit mask)
+// ============================================================
+
+enum TelemetryField : uint32_t {
+    TF_TEMPERATURE_UNIT = 1u << 0,
+    TF_TEMP1            = 1u << 1,
+    TF_TEMP2            = 1u << 2,
+    TF_AMBIENT_TEMP     = 1u << 3,
+    TF_AMBIENT_HUMIDITY = 1u << 4,
+    TF_SENSORS_VALID    = 1u << 5,
+    TF_LAST_UPDATE      = 1u << 6,
+    TF_HEATER_STATE     = 1u << 7,
+    TF_REFRIG_STATE     = 1u << 8,
+    TF_FAN_STATE        = 1u << 9,
+    TF_AUTO_MODE_STATE  = 1u << 10,
+    TF_STATUS_STATE     = 1u << 11,
+    TF_LAST_SEEN        = 1u << 12,
+    TF_RSSI             = 1u << 13,
+    TF_FREE_HEAP        = 1u << 14,
+    TF_UPTIME           = 1u << 15,
+    TF_MIN_FREE_HEAP    = 1u << 16,
+    TF_MAX_ALLOC_HEAP   = 1u << 17,
+    TF_PROBES           = 1u << 18,   // all extra probes together
+
+    TF_ALL              = (1u << 19) - 1
+};
+
+// Fill payload with the full sensors/relays/status document
+bool buildTelemetryPayload(const TelemetrySnapshot &snap, TelemetryPayload &payload);
+
+// Fill payload with only the fields selected in mask
+bool buildTelemetryPayload(const TelemetrySnapshot &snap, uint32_t fields, TelemetryPayload &payload);
+
+// ============================================================
+// DELTA TRACKER
+// - Remembers the last *published* value of every field
+// - Selects fields that moved past their dead-band, plus the
+//   heartbeat (last_seen/uptime) at FIREBASE_HEARTBEAT_INTERVAL_MS
+// - Everything is re-sent after invalidate() or every
+//   FIREBASE_FULL_SYNC_INTERVAL_MS to heal out-of-band edits
+// ============================================================
+
+class TelemetryTracker {
+public:
+    TelemetryTracker();
+
+    // Returns the mask of fields that should be published now (0 = nothing)
+    uint32_t select(const TelemetrySnapshot &snap, uint32_t nowMs) const;
+
+    // Record a successful publish of the given fields
+    void commit(const TelemetrySnapshot &snap, uint32_t fields, uint32_t nowMs);
+
+    // Force a full publish on the next select() (boot, reconnect)
+    void invalidate() { _hasBaseline = false; }
+
+private:
+    TelemetrySnapshot _published;
+    bool     _hasBaseline;
+    uint32_t _lastHeartbeatMs;
+    uint32_t _lastFullSyncMs;
+};
+
+#endif // TELEMETRY_H
@@ -0,0 +1,75 @@
+#ifndef TELEMETRY_BACKLOG_H
+#define TELEMETRY_BACKLOG_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "flash_region.h"
+#include "flash_ring_log.h"
+#include "telemetry.h"
+
+// ============================================================
+// OFFLINE TELEMETRY BACKLOG
+// - While offline, one sample per TELEMETRY_BACKLOG_SAMPLE_MS is
+//   appended to a FlashRingLog in the spiffs partition
+// - Once back online the backlog is uploaded oldest first as
+//   multi-path PATCHes of "history/<epoch>" nodes, one batch per
+//   drain interval so live pushes keep their slot
+// - Network task only (the ring log is single-task)
+// ============================================================
+
+// 16-byte fixed-point sample as stored in flash
+struct BacklogSample {
+    uint32_t epoch;
+    int16_t  temp1;            // 1/100 °C
+    int16_t  temp2;
+    int16_t  ambientTemp;
+    uint16_t ambientHumidity;  // 1/100 %RH
+    uint8_t  flags;            // BACKLOG_* bits
+    uint8_t  reserved[3];
+};
+
+enum BacklogFlag : uint8_t {
+    BACKLOG_TEMP1_VALID   = 1 << 0,
+    BACKLOG_TEMP2_VALID   = 1 << 1,
+    BACKLOG_AMBIENT_VALID = 1 << 2,
+    BACKLOG_HEATER_ON     = 1 << 3,
+    BACKLOG_REFRIG_ON     = 1 << 4,
+    BACKLOG_FAN_ON        = 1 << 5,
+    BACKLOG_AUTO_MODE     = 1 << 6,
+};
+
+class TelemetryBacklog {
+public:
+    TelemetryBacklog();
+
+    // Mounts the ring log on the spiffs partition slice
+    bool begin();
+    bool isReady() const { return _ready; }
+
+    // Stores snap if TELEMETRY_BACKLOG_SAMPLE_MS passed since the
+    // last stored sample; skipped while the clock is not synced
+    void record(const TelemetrySnapshot &snap, uint32_t nowMs);
+
+    // Builds one JSON batch (multi-path, relative to the device
+    // node) from the oldest samples; returns the samples included
+    size_t buildBatch(char *buf, size_t cap, size_t &len);
+    // After a successful upload: drop the samples from the log
+    void commitBatch(size_t samples);
+
+    uint32_t pending() const { return _ready ? _log.pending() : 0; }
+    void report();
+
+private:
+    EspPartitionRegion _region;
+    FlashRingLog _log;
+    bool _ready;
+    bool _hasRecorded;
+    uint32_t _lastRecordMs;
+    uint32_t _stored;
+    uint32_t _uploaded;
+    BacklogSample _batch[TELEMETRY_BACKLOG_BATCH];
+};
+
+extern TelemetryBacklog telemetryBacklog;
+
+#endif // TELEMETRY_BACKLOG_H
@@ -0,0 +1,156 @@
+#ifndef TIMESERIES_H
+#define TIMESERIES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "flash_region.h"
+
+// ============================================================
+// TIME-SERIES STORE
+// - Fixed-rate samples (temp1, temp2, ambient, humidity, relay
+//   bits) in 0.1 fixed point, delta + bit packed into blocks
+// - A block = 28-byte header (start epoch, count, keyframe) +
+//   bit stream; blocks are sealed when full, on a time gap or
+//   every sealInterval, and never span a flash sector
+// - Sectors are reused round-robin, oldest first
+// - Range queries read only block headers until a block
+//   overlaps the range; headers and payloads are read straight
+//   from FlashRegion::map() (flash cache mmap), no copies
+// - Not thread-safe: append and query from one task
+//
+// Per-sample bit stream (after the keyframe sample):
+//   0                      unchanged
+//   1 mmmmm                changed channels (t1 t2 ta rh relays)
+//     per numeric channel: zigzag delta z
+//       0  zz              z 1..4
+//       10 zzzzz           z 5..36
+//       110 zzzzzzzz       z 37..292
+//       111 <16 bit raw>   anything else / invalid transitions
+//     relays: 4 raw bits
+// ============================================================
+
+#define TS_INVALID  ((int16_t)-32768)   // sensor disconnected
+
+enum TsRelayBit : uint8_t {
+    TS_RELAY_HEATER = 1 << 0,
+    TS_RELAY_REFRIG = 1 << 1,
+    TS_RELAY_FAN    = 1 << 2,
+    TS_RELAY_AUTO   = 1 << 3,
+};
+
+enum TsChannel {
+    TS_CH_TEMP1 = 0,
+    TS_CH_TEMP2,
+    TS_CH_AMBIENT,
+    TS_CH_HUMIDITY,
+    TS_NUMERIC_CHANNELS
+};
+
+struct TsSample {
+    uint32_t epoch;
+    int16_t  value[TS_NUMERIC_CHANNELS];   // 1/10 °C, 1/10 %RH, or TS_INVALID
+    uint8_t  relays;                       // TsRelayBit
+};
+
+struct TsConfig {
+    uint8_t  periodS;                       // nominal seconds between samples
+    uint32_t sealIntervalS;                 // max age of the open (RAM) block
+    uint16_t blockMaxBytes;                 // header included, <= 1024
+    int16_t  deadband[TS_NUMERIC_CHANNELS]; // moves below this keep the old value
+};
+
+// Returning false stops the query
+typedef bool (*TsVisitFn)(void *ctx, const TsSample &sample);
+
+class TimeSeriesStore {
+public:
+    static const uint16_t MAX_BLOCK_BYTES = 1024;
+
+    TimeSeriesStore(FlashRegion &region, const TsConfig &config);
+
+    // Scans sector chains, finds the newest block and the append point
+    bool begin();
+    bool format();
+
+    // Adds one sample; epoch must be >= the previous one
+    bool append(const TsSample &sample);
+    // Seals the open block to flash now (before a restart)
+    bool flush();
+
+    // Visits every stored sample with from <= epoch <= to, oldest first;
+    // returns the number visited
+    size_t query(uint32_t from, uint32_t to, TsVisitFn fn, void *ctx);
+
+    uint32_t oldestEpoch();
+    uint32_t newestEpoch() const { return _hasLast ? _last.epoch : 0; }
+
+    // Stats
+    uint32_t blocksSealed() const { return _blocksSealed; }
+    uint32_t samplesAppended() const { return _samplesAppended; }
+    uint32_t bitsWritten() const { return _bitsWritten; }
+    uint32_t lastQueryBlocksScanned() const { return _lastScanned; }
+    uint32_t lastQueryBlocksDecoded() const { return _lastDecoded; }
+    uint32_t sectorCount() const { return _sectorCount; }
+    uint32_t bytesUsed();
+
+private:
+    struct BlockHeader {
+        uint16_t magic;
+        uint16_t count;
+        uint32_t startEpoch;
+        uint32_t seq;
+        uint16_t bytes;       // payload bytes
+        uint16_t crc;         // CRC-16 of the payload
+        uint8_t  periodS;
+        uint8_t  relays;      // keyframe
+        uint16_t reserved;
+        int16_t  key[TS_NUMERIC_CHANNELS];
+    };
+    static_assert(sizeof(BlockHeader) == 28, "block header layout is stored in flash");
+
+    static const uint16_t MAGIC = 0x5354;   // "TS"
+    static const uint32_t MAX_SAMPLE_BITS = 1 + 5 + TS_NUMERIC_CHANNELS * 19 + 4;
+
+    // Block access (mmap or read() into _scratch)
+    const uint8_t *_blockAt(uint32_t offset, BlockHeader &hdr);
+    bool _validHeader(const BlockHeader &hdr, uint32_t offsetInSector) const;
+    bool _startBlock(const TsSample &sample);
+    bool _seal();
+    bool _advanceSector();
+    bool _decodeBlock(const BlockHeader &hdr, const uint8_t *payload, uint32_t from, uint32_t to,
+                      TsVisitFn fn, void *ctx, size_t &visited);
+
+    // Bit stream
+    void _putBits(uint32_t value, uint8_t bits);
+    void _putDelta(int16_t prev, int16_t next);
+
+    FlashRegion &_region;
+    TsConfig _config;
+    uint32_t _sectorSize;
+    uint32_t _sectorCount;
+
+    uint32_t _headSector;
+    uint32_t _writeOffset;     // inside the head sector
+    uint32_t _nextSeq;
+    bool _mounted;
+
+    // Open block, built in RAM: header + payload
+    uint8_t _open[MAX_BLOCK_BYTES];
+    bool _hasOpen;
+    uint32_t _openBits;
+    uint32_t _openCapBits;
+    BlockHeader _openHdr;
+
+    TsSample _last;            // last stored values (after dead-band)
+    bool _hasLast;
+
+    uint8_t _scratch[MAX_BLOCK_BYTES];   // only without map()
+
+    uint32_t _blocksSealed;
+    uint32_t _samplesAppended;
+    uint32_t _bitsWritten;
+    uint32_t _lastScanned;
+    uint32_t _lastDecoded;
+};
+
+#endif // TIMESERIES_H
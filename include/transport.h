@@ -0,0 +1,71 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+// ============================================================
+// TELEMETRY / COMMAND TRANSPORT
+// - Where the batched telemetry document and backlog batches go,
+//   and where relay/settings commands come from
+// - Documents are multi-path JSON with paths relative to the
+//   device node ("sensors/temp1", ...), the same for every backend
+// - RtdbTransport: PATCH onto FIREBASE_BASE_PATH through hal.rtdb;
+//   commands keep arriving through the RTDB stream / poll
+// - MqttTransport (mqtt_transport.h): one persistent broker
+//   session, selected with TELEMETRY_TRANSPORT_MQTT
+// - Used from the network task only
+// ============================================================
+
+// Command from the transport: path relative to the device node
+// ("relays/control/heater", "settings/heater_onTemp") + raw value text
+typedef void (*TransportCommandHandler)(const char *path, const char *value);
+
+// Largest command value incl. NUL ("true", "-18.50", ...)
+#define TRANSPORT_COMMAND_VALUE_BYTES 24
+
+// Splits a broker message into the path below root and the value
+// as a C string. Refused: topics outside root, empty payloads (a
+// cleared retained value: keep the current one) and values that do
+// not fit valueSize - truncating "123456789" would apply another number
+bool parseTransportCommand(const char *root, const char *topic, const uint8_t *payload, size_t length,
+                           const char *&path, char *value, size_t valueSize);
+
+class TelemetryTransport {
+public:
+    virtual ~TelemetryTransport() {}
+
+    virtual const char *name() const = 0;
+    // Session up: a publish now has a chance to go through
+    virtual bool ready() = 0;
+    // Keep the session alive, reconnect, deliver commands (every pass)
+    virtual void service() {}
+
+    virtual bool publishTelemetry(const char *json) = 0;
+    virtual bool publishBacklog(const char *json) = 0;
+    virtual const char *lastError() = 0;
+
+    void setCommandHandler(TransportCommandHandler handler) { _commandHandler = handler; }
+
+protected:
+    TelemetryTransport() : _commandHandler(nullptr) {}
+
+    TransportCommandHandler _commandHandler;
+};
+
+class RtdbTransport : public TelemetryTransport {
+public:
+    const char *name() const override { return "rtdb"; }
+    bool ready() override;
+    bool publishTelemetry(const char *json) override;
+    bool publishBacklog(const char *json) override;
+    const char *lastError() override;
+};
+
+extern RtdbTransport rtdbTransport;
+
+// The backend selected at build time
+extern TelemetryTransport *transport;
+
+#endif // TRANSPORT_H
@@ -0,0 +1,370 @@
+// ============================================================
+// RAW DEFLATE INFLATER (RFC 1951), see tinfl.h
+// A coroutine over one switch: every point that can run out of
+// input or output saves its resume index in m_state, so a call
+// may stop after any byte and carry on in the next one
+// ============================================================
+
+#include "tinfl.h"
+
+#if !defined(ARDUINO)   // the ESP32 ROM has its own
+
+#include <string.h>
+
+// Resume points: each index must be unique within tinfl_decompress
+#define TINFL_CR_BEGIN switch (r->m_state) { case 0:
+#define TINFL_CR_RETURN(state_index, result) \
+    do {                                     \
+        status = result;                     \
+        r->m_state = state_index;            \
+        goto common_exit;                    \
+        case state_index:;                   \
+    } while (0)
+#define TINFL_CR_RETURN_FOREVER(state_index, result) \
+    do {                                             \
+        for (;;) {                                   \
+            TINFL_CR_RETURN(state_index, result);    \
+        }                                            \
+    } while (0)
+#define TINFL_CR_FINISH }
+
+#define TINFL_GET_BYTE(state_index, c)                                             \
+    do {                                                                           \
+        while (in >= in_end) {                                                     \
+            if (decomp_flags & TINFL_FLAG_HAS_MORE_INPUT) {                        \
+                TINFL_CR_RETURN(state_index, TINFL_STATUS_NEEDS_MORE_INPUT);       \
+            } else {                                                               \
+                TINFL_CR_RETURN_FOREVER(state_index + 100, TINFL_STATUS_FAILED);   \
+            }                                                                      \
+        }                                                                          \
+        c = *in++;                                                                 \
+    } while (0)
+
+#define TINFL_NEED_BITS(state_index, n)           \
+    do {                                          \
+        while (num_bits < (uint32_t)(n)) {        \
+            TINFL_GET_BYTE(state_index, c);       \
+            bit_buf |= (uint32_t)c << num_bits;   \
+            num_bits += 8;                        \
+        }                                         \
+    } while (0)
+
+#define TINFL_GET_BITS(state_index, b, n)           \
+    do {                                            \
+        TINFL_NEED_BITS(state_index, n);            \
+        b = bit_buf & ((1u << (n)) - 1);            \
+        bit_buf >>= (n);                            \
+        num_bits -= (n);                            \
+    } while (0)
+
+// Peeks until a whole code is buffered; bits are only consumed once
+// the symbol is known, so running dry mid-code just resumes here
+#define TINFL_HUFF_DECODE(state_index, sym, table)                                  \
+    do {                                                                            \
+        for (;;) {                                                                  \
+            const int found = tinfl_try_decode(table, bit_buf, num_bits, &sym, &used); \
+            if (found > 0) break;                                                   \
+            if (found < 0) TINFL_CR_RETURN_FOREVER(state_index + 200, TINFL_STATUS_FAILED); \
+            TINFL_GET_BYTE(state_index, c);                                         \
+            bit_buf |= (uint32_t)c << num_bits;                                     \
+            num_bits += 8;                                                          \
+        }                                                                           \
+        bit_buf >>= used;                                                           \
+        num_bits -= used;                                                           \
+    } while (0)
+
+static const uint16_t LEN_BASE[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                      31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t LEN_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                      2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t DIST_BASE[30] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                       193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                       6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+static const uint8_t CODE_LEN_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// Canonical Huffman table from code lengths; false if over-subscribed.
+// Incomplete sets are allowed (a lone distance code); their unused
+// codes fail in tinfl_try_decode
+static int tinfl_build_table(tinfl_huff_table *t, const uint8_t *lengths, uint32_t n) {
+    uint16_t offs[16];
+    int left = 1;
+    uint32_t i;
+    memset(t->count, 0, sizeof(t->count));
+    for (i = 0; i < n; i++) t->count[lengths[i]]++;
+    t->count[0] = 0;
+    for (i = 1; i < 16; i++) {
+        left = (left << 1) - t->count[i];
+        if (left < 0) return 0;
+    }
+    offs[1] = 0;
+    for (i = 1; i < 15; i++) offs[i + 1] = offs[i] + t->count[i];
+    for (i = 0; i < n; i++) {
+        if (lengths[i]) t->symbol[offs[lengths[i]]++] = (uint16_t)i;
+    }
+    return 1;
+}
+
+// 1: symbol found in *used bits, 0: needs more bits, -1: invalid code
+static int tinfl_try_decode(const tinfl_huff_table *t, uint32_t bits, uint32_t avail, uint32_t *sym,
+                            uint32_t *used) {
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    uint32_t len;
+    for (len = 1; len < 16; len++) {
+        if (len > avail) return 0;
+        code |= (bits >> (len - 1)) & 1;   // codes are packed MSB first
+        const int count = t->count[len];
+        if (code - count < first) {
+            *sym = t->symbol[index + (code - first)];
+            *used = len;
+            return 1;
+        }
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+tinfl_status tinfl_decompress(tinfl_decompressor *r, const uint8_t *pIn_buf_next, size_t *pIn_buf_size,
+                              uint8_t *pOut_buf_start, uint8_t *pOut_buf_next, size_t *pOut_buf_size,
+                              const uint32_t decomp_flags) {
+    tinfl_status status = TINFL_STATUS_FAILED;
+    const uint8_t *in = pIn_buf_next;
+    const uint8_t *const in_end = pIn_buf_next + *pIn_buf_size;
+    uint8_t *out = pOut_buf_next;
+    uint8_t *const out_end = pOut_buf_next + *pOut_buf_size;
+    const size_t out_buf_size_mask = (decomp_flags & TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF)
+                                         ? (size_t)-1
+                                         : (size_t)(pOut_buf_next - pOut_buf_start) + *pOut_buf_size - 1;
+    uint32_t num_bits;
+    uint32_t bit_buf;
+    uint32_t dist;
+    uint32_t counter;
+    uint32_t num_extra;
+    uint32_t sym = 0;
+    uint32_t used = 0;
+    uint32_t c = 0;
+    uint32_t extra = 0;
+
+    // The window must be a power of two and next must lie inside it
+    if (((out_buf_size_mask + 1) & out_buf_size_mask) || pOut_buf_next < pOut_buf_start) {
+        *pIn_buf_size = *pOut_buf_size = 0;
+        return TINFL_STATUS_BAD_PARAM;
+    }
+
+    num_bits = r->m_num_bits;
+    bit_buf = r->m_bit_buf;
+    dist = r->m_dist;
+    counter = r->m_counter;
+    num_extra = r->m_num_extra;
+
+    TINFL_CR_BEGIN
+    bit_buf = num_bits = dist = counter = num_extra = 0;
+    r->m_final = 0;
+    r->m_total_out = 0;
+    if (decomp_flags & TINFL_FLAG_PARSE_ZLIB_HEADER) {
+        TINFL_GET_BYTE(1, r->m_raw_header[0]);
+        TINFL_GET_BYTE(2, r->m_raw_header[1]);
+        if ((r->m_raw_header[0] & 15) != 8 || ((r->m_raw_header[0] << 8) | r->m_raw_header[1]) % 31 ||
+            (r->m_raw_header[1] & 32)) {
+            TINFL_CR_RETURN_FOREVER(3, TINFL_STATUS_FAILED);
+        }
+    }
+
+    do {
+        TINFL_GET_BITS(4, r->m_final, 1);
+        TINFL_GET_BITS(5, r->m_type, 2);
+
+        if (r->m_type == 0) {
+            // Stored block: byte aligned LEN, NLEN, then LEN raw bytes
+            TINFL_GET_BITS(6, extra, num_bits & 7);
+            for (counter = 0; counter < 4; counter++) {
+                if (num_bits) {
+                    TINFL_GET_BITS(7, r->m_raw_header[counter], 8);
+                } else {
+                    TINFL_GET_BYTE(8, r->m_raw_header[counter]);
+                }
+            }
+            counter = r->m_raw_header[0] | (r->m_raw_header[1] << 8);
+            if (counter != (uint32_t)(0xFFFF ^ (r->m_raw_header[2] | (r->m_raw_header[3] << 8)))) {
+                TINFL_CR_RETURN_FOREVER(9, TINFL_STATUS_FAILED);
+            }
+            while (counter && num_bits) {
+                TINFL_GET_BITS(10, dist, 8);
+                while (out >= out_end) {
+                    TINFL_CR_RETURN(11, TINFL_STATUS_HAS_MORE_OUTPUT);
+                }
+                *out++ = (uint8_t)dist;
+                counter--;
+            }
+            while (counter) {
+                size_t n;
+                while (out >= out_end) {
+                    TINFL_CR_RETURN(12, TINFL_STATUS_HAS_MORE_OUTPUT);
+                }
+                while (in >= in_end) {
+                    if (decomp_flags & TINFL_FLAG_HAS_MORE_INPUT) {
+                        TINFL_CR_RETURN(13, TINFL_STATUS_NEEDS_MORE_INPUT);
+                    } else {
+                        TINFL_CR_RETURN_FOREVER(14, TINFL_STATUS_FAILED);
+                    }
+                }
+                n = (size_t)(out_end - out);
+                if (n > (size_t)(in_end - in)) n = (size_t)(in_end - in);
+                if (n > counter) n = counter;
+                memcpy(out, in, n);
+                in += n;
+                out += n;
+                counter -= (uint32_t)n;
+            }
+        } else if (r->m_type == 3) {
+            TINFL_CR_RETURN_FOREVER(15, TINFL_STATUS_FAILED);
+        } else {
+            if (r->m_type == 1) {
+                // Fixed codes
+                memset(r->m_len_codes, 8, 144);
+                memset(r->m_len_codes + 144, 9, 112);
+                memset(r->m_len_codes + 256, 7, 24);
+                memset(r->m_len_codes + 280, 8, 8);
+                memset(r->m_len_codes + 288, 5, 32);
+                r->m_table_sizes[0] = 288;
+                r->m_table_sizes[1] = 32;
+            } else {
+                // Dynamic codes: HLIT, HDIST, HCLEN, then the code length code
+                TINFL_GET_BITS(16, r->m_table_sizes[0], 5);
+                r->m_table_sizes[0] += 257;
+                TINFL_GET_BITS(17, r->m_table_sizes[1], 5);
+                r->m_table_sizes[1] += 1;
+                TINFL_GET_BITS(18, num_extra, 4);
+                num_extra += 4;
+                if (r->m_table_sizes[0] > 286 || r->m_table_sizes[1] > 30) {
+                    TINFL_CR_RETURN_FOREVER(19, TINFL_STATUS_FAILED);
+                }
+                memset(r->m_len_codes, 0, 19);
+                for (counter = 0; counter < num_extra; counter++) {
+                    TINFL_GET_BITS(20, extra, 3);
+                    r->m_len_codes[CODE_LEN_ORDER[counter]] = (uint8_t)extra;
+                }
+                if (!tinfl_build_table(&r->m_tables[2], r->m_len_codes, 19)) {
+                    TINFL_CR_RETURN_FOREVER(21, TINFL_STATUS_FAILED);
+                }
+
+                // Literal/length and distance lengths, one run-length coded list
+                for (counter = 0; counter < r->m_table_sizes[0] + r->m_table_sizes[1];) {
+                    TINFL_HUFF_DECODE(22, sym, &r->m_tables[2]);
+                    if (sym < 16) {
+                        r->m_len_codes[counter++] = (uint8_t)sym;
+                        continue;
+                    }
+                    if (sym == 16 && counter == 0) {
+                        TINFL_CR_RETURN_FOREVER(23, TINFL_STATUS_FAILED);
+                    }
+                    dist = sym;   // the repeat code, kept across the bits read
+                    TINFL_GET_BITS(24, extra, (dist == 16) ? 2 : (dist == 17) ? 3 : 7);
+                    extra += (dist == 18) ? 11 : 3;
+                    if (counter + extra > r->m_table_sizes[0] + r->m_table_sizes[1]) {
+                        TINFL_CR_RETURN_FOREVER(25, TINFL_STATUS_FAILED);
+                    }
+                    memset(r->m_len_codes + counter, (dist == 16) ? r->m_len_codes[counter - 1] : 0, extra);
+                    counter += extra;
+                }
+                if (r->m_len_codes[256] == 0) {
+                    TINFL_CR_RETURN_FOREVER(26, TINFL_STATUS_FAILED);   // no end-of-block code
+                }
+                // Distance lengths follow the literal/length ones
+                memmove(r->m_len_codes + 288, r->m_len_codes + r->m_table_sizes[0], r->m_table_sizes[1]);
+            }
+            if (!tinfl_build_table(&r->m_tables[0], r->m_len_codes, r->m_table_sizes[0]) ||
+                !tinfl_build_table(&r->m_tables[1], r->m_len_codes + 288, r->m_table_sizes[1])) {
+                TINFL_CR_RETURN_FOREVER(27, TINFL_STATUS_FAILED);
+            }
+
+            for (;;) {
+                TINFL_HUFF_DECODE(28, sym, &r->m_tables[0]);
+                if (sym < 256) {
+                    counter = sym;   // locals do not survive a return
+                    while (out >= out_end) {
+                        TINFL_CR_RETURN(29, TINFL_STATUS_HAS_MORE_OUTPUT);
+                    }
+                    *out++ = (uint8_t)counter;
+                    continue;
+                }
+                if (sym == 256) break;
+                sym -= 257;
+                if (sym >= 29) {
+                    TINFL_CR_RETURN_FOREVER(30, TINFL_STATUS_FAILED);
+                }
+                counter = LEN_BASE[sym];
+                num_extra = LEN_EXTRA[sym];
+                if (num_extra) {
+                    TINFL_GET_BITS(31, extra, num_extra);
+                    counter += extra;
+                }
+
+                TINFL_HUFF_DECODE(32, dist, &r->m_tables[1]);
+                if (dist >= 30) {
+                    TINFL_CR_RETURN_FOREVER(33, TINFL_STATUS_FAILED);
+                }
+                num_extra = DIST_EXTRA[dist];
+                dist = DIST_BASE[dist];
+                if (num_extra) {
+                    TINFL_GET_BITS(34, extra, num_extra);
+                    dist += extra;
+                }
+                // Never reach back before the first byte of the stream
+                if (dist > r->m_total_out + (uint64_t)(out - pOut_buf_next) ||
+                    ((decomp_flags & TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF) &&
+                     dist > (uint64_t)(out - pOut_buf_start))) {
+                    TINFL_CR_RETURN_FOREVER(35, TINFL_STATUS_FAILED);
+                }
+                while (counter) {
+                    while (out >= out_end) {
+                        TINFL_CR_RETURN(36, TINFL_STATUS_HAS_MORE_OUTPUT);
+                    }
+                    *out = pOut_buf_start[((size_t)(out - pOut_buf_start) - dist) & out_buf_size_mask];
+                    out++;
+                    counter--;
+                }
+            }
+        }
+    } while (!r->m_final);
+
+    if (decomp_flags & TINFL_FLAG_PARSE_ZLIB_HEADER) {
+        // Adler-32 trailer, read but not checked
+        TINFL_GET_BITS(37, extra, num_bits & 7);
+        for (counter = 0; counter < 4; counter++) {
+            if (num_bits) {
+                TINFL_GET_BITS(38, extra, 8);
+            } else {
+                TINFL_GET_BYTE(39, extra);
+            }
+        }
+    }
+    TINFL_CR_RETURN_FOREVER(40, TINFL_STATUS_DONE);
+    TINFL_CR_FINISH
+
+common_exit:
+    // Whole bytes still in the bit buffer belong to whatever follows
+    // the deflate stream (the gzip trailer): hand them back
+    if (status == TINFL_STATUS_DONE) {
+        while (in > pIn_buf_next && num_bits >= 8) {
+            in--;
+            num_bits -= 8;
+        }
+        bit_buf &= (num_bits < 32) ? ((1u << num_bits) - 1) : 0xFFFFFFFFu;
+    }
+    r->m_num_bits = num_bits;
+    r->m_bit_buf = bit_buf;
+    r->m_dist = dist;
+    r->m_counter = counter;
+    r->m_num_extra = num_extra;
+    r->m_total_out += (uint64_t)(out - pOut_buf_next);
+    *pIn_buf_size = (size_t)(in - pIn_buf_next);
+    *pOut_buf_size = (size_t)(out - pOut_buf_next);
+    return status;
+}
+
+#endif // !ARDUINO
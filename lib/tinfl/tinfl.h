@@ -0,0 +1,79 @@
+#ifndef TINFL_H
+#define TINFL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================
+// RAW DEFLATE INFLATER (native builds)
+// - The subset of the miniz tinfl interface that the ESP32 ROM
+//   exports and ota_decoder.cpp uses: same types, flags,
+//   status codes and resumable tinfl_decompress() contract,
+//   so the native env decodes exactly as the device does
+// - Output goes into a caller-owned power-of-two window that
+//   also serves as the 32 KB back-reference dictionary (unless
+//   TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF)
+// - Device builds use the ROM copy; tinfl.c compiles to
+//   nothing under ARDUINO
+// ============================================================
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    TINFL_STATUS_BAD_PARAM = -3,
+    TINFL_STATUS_ADLER32_MISMATCH = -2,
+    TINFL_STATUS_FAILED = -1,
+    TINFL_STATUS_DONE = 0,
+    TINFL_STATUS_NEEDS_MORE_INPUT = 1,
+    TINFL_STATUS_HAS_MORE_OUTPUT = 2
+} tinfl_status;
+
+enum {
+    TINFL_FLAG_PARSE_ZLIB_HEADER = 1,
+    TINFL_FLAG_HAS_MORE_INPUT = 2,
+    TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF = 4,
+    TINFL_FLAG_COMPUTE_ADLER32 = 8   // accepted, not computed
+};
+
+#define TINFL_MAX_HUFF_SYMBOLS 288
+
+typedef struct {
+    uint16_t count[16];                        // codes per bit length
+    uint16_t symbol[TINFL_MAX_HUFF_SYMBOLS];   // symbols in canonical order
+} tinfl_huff_table;
+
+typedef struct tinfl_decompressor_tag {
+    uint32_t m_state;
+    uint32_t m_num_bits;
+    uint32_t m_bit_buf;
+    uint32_t m_final;
+    uint32_t m_type;
+    uint32_t m_dist;
+    uint32_t m_counter;
+    uint32_t m_num_extra;
+    uint32_t m_table_sizes[2];
+    uint64_t m_total_out;
+    tinfl_huff_table m_tables[3];   // literal/length, distance, code length
+    uint8_t m_len_codes[TINFL_MAX_HUFF_SYMBOLS + 32];
+    uint8_t m_raw_header[4];
+} tinfl_decompressor;
+
+#define tinfl_init(r)        \
+    do {                     \
+        (r)->m_state = 0;    \
+    } while (0)
+
+// in: *pIn_buf_size bytes at pIn_buf_next, set to the bytes consumed.
+// out: room for *pOut_buf_size bytes at pOut_buf_next inside the window
+// starting at pOut_buf_start, set to the bytes produced
+tinfl_status tinfl_decompress(tinfl_decompressor *r, const uint8_t *pIn_buf_next, size_t *pIn_buf_size,
+                              uint8_t *pOut_buf_start, uint8_t *pOut_buf_next, size_t *pOut_buf_size,
+                              const uint32_t decomp_flags);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TINFL_H
@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""
+Build / apply EDL1 delta patches for OTA (see include/ota_decoder.h).
+
+  make_delta.py diff  <base.bin> <target.bin> <out.edl.gz>
+  make_delta.py apply <base.bin> <patch.edl.gz> <out.bin>
+
+The patch is a COPY/INSERT stream against the base image, gzip-compressed
+so the device can inflate and patch in one pass. Matching is greedy on
+32-byte blocks of the base (indexed every 4 bytes), extended both ways.
+"""
+
+import gzip
+import hashlib
+import struct
+import sys
+
+MAGIC = b"EDL1"
+BLOCK = 32
+STRIDE = 4
+OP_END, OP_COPY, OP_INSERT = 0x00, 0x01, 0x02
+
+
+def build_index(base):
+    index = {}
+    for i in range(0, len(base) - BLOCK + 1, STRIDE):
+        index.setdefault(base[i:i + BLOCK], i)
+    return index
+
+
+def match_length(base, j, target, i):
+    n = 0
+    limit = min(len(base) - j, len(target) - i)
+    # Compare in slices first, then finish byte by byte
+    while n + 64 <= limit and base[j + n:j + n + 64] == target[i + n:i + n + 64]:
+        n += 64
+    while n < limit and base[j + n] == target[i + n]:
+        n += 1
+    return n
+
+
+def diff(base, target):
+    index = build_index(base)
+    out = bytearray()
+    out += MAGIC + struct.pack("<I", len(base)) + hashlib.sha256(base).digest()
+    out += struct.pack("<I", len(target))
+
+    literal_start = 0
+    i = 0
+    while i <= len(target) - BLOCK:
+        j = index.get(target[i:i + BLOCK])
+        if j is None:
+            i += 1
+            continue
+
+        n = match_length(base, j, target, i)
+        # Grow the match backwards into pending literals
+        while i > literal_start and j > 0 and base[j - 1] == target[i - 1]:
+            i -= 1
+            j -= 1
+            n += 1
+
+        if i > literal_start:
+            out += struct.pack("<BI", OP_INSERT, i - literal_start) + target[literal_start:i]
+        out += struct.pack("<BII", OP_COPY, j, n)
+        i += n
+        literal_start = i
+
+    if literal_start < len(target):
+        out += struct.pack("<BI", OP_INSERT, len(target) - literal_start) + target[literal_start:]
+    out += bytes([OP_END])
+    return bytes(out)
+
+
+def apply(base, patch):
+    if patch[:4] != MAGIC:
+        raise ValueError("bad magic")
+    base_size, = struct.unpack_from("<I", patch, 4)
+    if base_size != len(base) or patch[8:40] != hashlib.sha256(base).digest():
+        raise ValueError("patch was made against a different base image")
+    target_size, = struct.unpack_from("<I", patch, 40)
+
+    out = bytearray()
+    pos = 44
+    while True:
+        op = patch[pos]
+        pos += 1
+        if op == OP_END:
+            break
+        if op == OP_COPY:
+            src, n = struct.unpack_from("<II", patch, pos)
+            pos += 8
+            out += base[src:src + n]
+        elif op == OP_INSERT:
+            n, = struct.unpack_from("<I", patch, pos)
+            pos += 4
+            out += patch[pos:pos + n]
+            pos += n
+        else:
+            raise ValueError("bad op 0x%02x at %d" % (op, pos - 1))
+    if len(out) != target_size:
+        raise ValueError("size mismatch")
+    return bytes(out)
+
+
+def main(argv):
+    if len(argv) != 5 or argv[1] not in ("diff", "apply"):
+        print(__doc__.strip())
+        return 2
+
+    with open(argv[2], "rb") as f:
+        base = f.read()
+
+    if argv[1] == "diff":
+        with open(argv[3], "rb") as f:
+            target = f.read()
+        patch = diff(base, target)
+        if apply(base, patch) != target:
+            raise SystemExit("[!] Round trip failed")
+        data = gzip.compress(patch, compresslevel=9, mtime=0)
+        with open(argv[4], "wb") as f:
+            f.write(data)
+        print("[OK] %s: %d bytes (target %d, raw patch %d)" % (argv[4], len(data), len(target), len(patch)))
+    else:
+        with open(argv[3], "rb") as f:
+            patch = gzip.decompress(f.read())
+        with open(argv[4], "wb") as f:
+            f.write(apply(base, patch))
+        print("[OK] %s written" % argv[4])
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
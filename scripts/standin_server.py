@@ -0,0 +1,380 @@
+#!/usr/bin/env python3
+"""
+Local stand-in for the Firebase RTDB REST API, for bench tests of a
+device on the LAN without the cloud.
+
+  standin_server.py rtdb [--port 443] [--tls CERT KEY] [--stats 10]
+  standin_server.py ota  [--port 443] [--tls CERT KEY] --root DIR [--cut MIN MAX]
+
+RTDB: GET/PUT/PATCH/DELETE on /<path>.json over an in-memory tree.
+GET with "Accept: text/event-stream" opens a server-sent events stream
+(put/patch/keep-alive events, as the real database sends). Edit the
+tree from a shell to play the app, e.g.
+  curl -k -X PUT -d true https://HOST/devices/ID/relays/control/heater.json
+and every open stream above that path gets the change.
+
+OTA: GET/HEAD of any file under --root (version.json, firmware.bin),
+with "Range: bytes=N-" answered 206 + Content-Range, or 416 past the
+end. Every file carries an ETag and Last-Modified from its size and
+mtime; If-None-Match / If-Modified-Since that still match get a 304,
+so editing (or touching) version.json is what makes the device fetch
+it again. full_responses vs not_modified shows what polling costs. --cut drops the connection after a random MIN..MAX bytes of each
+body, so the device has to resume. The OTA client also only speaks
+TLS: run with --tls, build the device with
+  build_flags = -DVERSION_JSON_URL='"https://HOST/version.json"'
+and give the served version.json a "url" of https://HOST/firmware.bin.
+
+Counters (requests, bytes, connections, stream events) are printed
+every --stats seconds and on Ctrl-C. Point FIREBASE_URL in secrets.h
+at the host; the Firebase client always connects on port 443 over TLS,
+so use --tls with any self-signed pair:
+  openssl req -x509 -newkey rsa:2048 -nodes -days 30 -subj /CN=standin \\
+      -keyout key.pem -out cert.pem
+"""
+
+import argparse
+import email.utils
+import json
+import os
+import random
+import socketserver
+import ssl
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, HTTPServer
+from urllib.parse import urlsplit
+
+KEEPALIVE_S = 30
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.counts = {}
+
+    def add(self, key, n=1):
+        with self.lock:
+            self.counts[key] = self.counts.get(key, 0) + n
+
+    def report(self):
+        with self.lock:
+            items = sorted(self.counts.items())
+        print("[*] " + (", ".join("%s=%d" % kv for kv in items) or "no traffic"), flush=True)
+
+
+STATS = Stats()
+
+
+# ============================================================
+# RTDB TREE + STREAMS
+# ============================================================
+def split_path(path):
+    return [p for p in path.strip("/").split("/") if p]
+
+
+class Tree:
+    def __init__(self):
+        self.root = {}
+        self.cond = threading.Condition()
+        self.streams = []   # [segments, pending events]
+
+    def get(self, segs):
+        node = self.root
+        for s in segs:
+            if not isinstance(node, dict) or s not in node:
+                return None
+            node = node[s]
+        return node
+
+    def _set(self, segs, value):
+        if not segs:
+            self.root = value if isinstance(value, dict) else {}
+            return
+        node = self.root
+        for s in segs[:-1]:
+            if not isinstance(node.get(s), dict):
+                node[s] = {}
+            node = node[s]
+        if value is None:
+            node.pop(segs[-1], None)
+        else:
+            node[segs[-1]] = value
+
+    def put(self, segs, value):
+        with self.cond:
+            self._set(segs, value)
+            self._notify([(segs, value)], "put")
+
+    def patch(self, segs, updates):
+        with self.cond:
+            changes = []
+            for key, value in updates.items():
+                child = segs + split_path(key)
+                self._set(child, value)
+                changes.append((child, value))
+            self._notify(changes, "patch", segs, updates)
+
+    def _notify(self, changes, kind, base=None, updates=None):
+        for stream in self.streams:
+            root, pending = stream
+            if kind == "patch" and base[:len(root)] == root:
+                rel = "/" + "/".join(base[len(root):])
+                pending.append(("patch", {"path": rel, "data": updates}))
+                continue
+            for segs, value in changes:
+                if segs[:len(root)] == root:
+                    rel = "/" + "/".join(segs[len(root):])
+                    pending.append(("put", {"path": rel, "data": value}))
+                elif root[:len(segs)] == segs:
+                    pending.append(("put", {"path": "/", "data": self.get(root)}))
+        self.cond.notify_all()
+
+
+TREE = Tree()
+
+
+class StandinHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"   # keep-alive, like the real endpoints
+
+    def log_message(self, fmt, *args):
+        pass
+
+    def setup(self):
+        super().setup()
+        STATS.add("connections")
+        if isinstance(self.connection, ssl.SSLSocket):
+            STATS.add("tls_resumed" if self.connection.session_reused else "tls_full_handshakes")
+
+    def _body(self):
+        n = int(self.headers.get("Content-Length") or 0)
+        data = self.rfile.read(n) if n else b""
+        STATS.add("bytes_in", n)
+        return data
+
+    def _send(self, code, body=b"", ctype="application/json", headers=()):
+        self.send_response(code)
+        self.send_header("Content-Type", ctype)
+        self.send_header("Content-Length", str(len(body)))
+        for k, v in headers:
+            self.send_header(k, v)
+        self.end_headers()
+        if body and self.command != "HEAD":
+            self.wfile.write(body)
+        STATS.add("bytes_out", len(body))
+
+    def _route(self):
+        url = urlsplit(self.path)
+        STATS.add("requests_" + self.command.lower())
+        return url.path, url.query
+
+    def do_GET(self):
+        path, query = self._route()
+        if not path.endswith(".json"):
+            return self._send(404, b'{"error":"not found"}')
+        segs = split_path(path[:-5])
+        if "text/event-stream" in (self.headers.get("Accept") or ""):
+            return self._stream(segs)
+        self._send(200, json.dumps(TREE.get(segs)).encode())
+
+    def do_PUT(self):
+        path, query = self._route()
+        value = json.loads(self._body() or b"null")
+        TREE.put(split_path(path[:-5]), value)
+        self._reply_write(query, value)
+
+    def do_PATCH(self):
+        path, query = self._route()
+        updates = json.loads(self._body() or b"{}")
+        TREE.patch(split_path(path[:-5]), updates)
+        STATS.add("patch_fields", len(updates))
+        self._reply_write(query, updates)
+
+    def do_DELETE(self):
+        path, query = self._route()
+        TREE.put(split_path(path[:-5]), None)
+        self._reply_write(query, None)
+
+    def _reply_write(self, query, value):
+        if "print=silent" in query:
+            self._send(204)
+        else:
+            self._send(200, json.dumps(value).encode())
+
+    # Server-sent events: initial put of the node, then changes
+    def _stream(self, segs):
+        STATS.add("streams_opened")
+        self.send_response(200)
+        self.send_header("Content-Type", "text/event-stream")
+        self.send_header("Cache-Control", "no-cache")
+        self.end_headers()
+        pending = [("put", {"path": "/", "data": TREE.get(segs)})]
+        stream = [segs, pending]
+        with TREE.cond:
+            TREE.streams.append(stream)
+        try:
+            last = time.monotonic()
+            while True:
+                with TREE.cond:
+                    if not pending:
+                        TREE.cond.wait(timeout=1.0)
+                    events = list(pending)
+                    del pending[:]
+                if not events and time.monotonic() - last >= KEEPALIVE_S:
+                    events = [("keep-alive", None)]
+                for kind, data in events:
+                    frame = ("event: %s\ndata: %s\n\n" % (kind, json.dumps(data))).encode()
+                    self.wfile.write(frame)
+                    STATS.add("bytes_out", len(frame))
+                    STATS.add("stream_events")
+                    last = time.monotonic()
+                self.wfile.flush()
+        except (BrokenPipeError, ConnectionResetError, ssl.SSLError, OSError):
+            pass
+        finally:
+            with TREE.cond:
+                TREE.streams.remove(stream)
+            STATS.add("streams_closed")
+            self.close_connection = True
+
+
+# ============================================================
+# OTA FILES + RANGE
+# ============================================================
+class OtaHandler(StandinHandler):
+    root = "."
+    cut = None   # (min, max) body bytes before the connection drops
+
+    def _file(self):
+        path, _ = self._route()
+        full = os.path.realpath(os.path.join(self.root, path.lstrip("/")))
+        if not full.startswith(os.path.realpath(self.root) + os.sep) or not os.path.isfile(full):
+            return None
+        return full
+
+    def do_GET(self):
+        full = self._file()
+        if full is None:
+            return self._send(404, b'{"error":"not found"}')
+        st = os.stat(full)
+        validators = [("ETag", '"%x-%x"' % (st.st_size, st.st_mtime_ns)),
+                      ("Last-Modified", email.utils.formatdate(st.st_mtime, usegmt=True))]
+        if self._not_modified(validators[0][1], int(st.st_mtime)):
+            STATS.add("not_modified")
+            return self._send(304, headers=validators)
+
+        with open(full, "rb") as f:
+            data = f.read()
+        total = len(data)
+        ctype = "application/json" if full.endswith(".json") else "application/octet-stream"
+
+        rng = self.headers.get("Range")
+        if rng:
+            STATS.add("range_requests")
+            first = self._range_start(rng)
+            if first is None or first >= total:
+                return self._send(416, headers=[("Content-Range", "bytes */%d" % total)])
+            return self._send_body(206, data[first:], ctype,
+                                   [("Content-Range", "bytes %d-%d/%d" % (first, total - 1, total))])
+        STATS.add("full_responses")
+        self._send_body(200, data, ctype, validators)
+
+    def do_HEAD(self):
+        self.do_GET()
+
+    # RFC 9110: If-None-Match wins; If-Modified-Since only without it
+    def _not_modified(self, etag, mtime):
+        inm = self.headers.get("If-None-Match")
+        ims = self.headers.get("If-Modified-Since")
+        if inm or ims:
+            STATS.add("conditional_requests")
+        if inm:
+            return etag in [t.strip() for t in inm.split(",")] or inm.strip() == "*"
+        if ims:
+            try:
+                since = email.utils.parsedate_to_datetime(ims).timestamp()
+            except (TypeError, ValueError):
+                return False
+            return mtime <= since
+        return False
+
+    @staticmethod
+    def _range_start(value):
+        # Only the "bytes=N-" form the device sends
+        if not value.startswith("bytes=") or not value.endswith("-"):
+            return None
+        try:
+            return int(value[6:-1])
+        except ValueError:
+            return None
+
+    def _send_body(self, code, body, ctype, headers=()):
+        if not self.cut or self.command == "HEAD" or len(body) <= self.cut[0]:
+            return self._send(code, body, ctype, headers)
+        # Promise the whole body, send part of it, drop the connection
+        n = random.randint(self.cut[0], min(self.cut[1], len(body) - 1))
+        self.send_response(code)
+        self.send_header("Content-Type", ctype)
+        self.send_header("Content-Length", str(len(body)))
+        for k, v in headers:
+            self.send_header(k, v)
+        self.end_headers()
+        try:
+            self.wfile.write(body[:n])
+            self.wfile.flush()
+        except (BrokenPipeError, ConnectionResetError, ssl.SSLError, OSError):
+            pass
+        STATS.add("bytes_out", n)
+        STATS.add("cuts")
+        self.close_connection = True
+
+
+class StandinServer(socketserver.ThreadingMixIn, HTTPServer):
+    daemon_threads = True
+    allow_reuse_address = True
+
+
+def serve(handler, args):
+    server = StandinServer(("", args.port), handler)
+    if args.tls:
+        ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        ctx.load_cert_chain(args.tls[0], args.tls[1])
+        server.socket = ctx.wrap_socket(server.socket, server_side=True)
+    print("[OK] %s stand-in on port %d%s" % (args.mode, args.port, " (TLS)" if args.tls else ""), flush=True)
+
+    def reporter():
+        while True:
+            time.sleep(args.stats)
+            STATS.report()
+
+    if args.stats > 0:
+        threading.Thread(target=reporter, daemon=True).start()
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    STATS.report()
+    return 0
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("mode", choices=["rtdb", "ota"])
+    parser.add_argument("--port", type=int, default=0, help="default 443 with --tls, else 8080")
+    parser.add_argument("--tls", nargs=2, metavar=("CERT", "KEY"))
+    parser.add_argument("--root", default=".", help="ota: directory to serve")
+    parser.add_argument("--cut", nargs=2, type=int, metavar=("MIN", "MAX"),
+                        help="ota: drop each body after MIN..MAX bytes")
+    parser.add_argument("--stats", type=int, default=10, help="report interval in s (0 = only at exit)")
+    args = parser.parse_args(argv[1:])
+    if not args.port:
+        args.port = 443 if args.tls else 8080
+    if args.mode == "ota":
+        OtaHandler.root = args.root
+        OtaHandler.cut = tuple(args.cut) if args.cut else None
+        return serve(OtaHandler, args)
+    return serve(StandinHandler, args)
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
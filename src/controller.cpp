@@ -0,0 +1,174 @@
+// ============================================================
+// TEMPERATURE CONTROLLER
+// Hysteresis + fan cycle + relay output, see controller.h
+// ============================================================
+
+#include "controller.h"
+#include "cycle_profiler.h"
+#include "hal.h"
+#include "latency_profiler.h"
+#include "logger.h"
+
+// ============================================================
+// STATE (owned by the control task)
+// ============================================================
+float temp1           = -127.0f;
+float temp2           = -127.0f;
+float ambientTemp     = -127.0f;
+float ambientHumidity = 0.0f;
+
+bool heaterOn = false;
+bool refrigOn = false;
+bool fanOn    = false;
+bool autoRelayControl = RELAY_CONTROL_DEFAULT_AUTO_MODE;
+
+uint32_t fanCycleStartMillis = 0;
+bool fanCycleOnPhase = true;
+
+float heaterOnTemp   = DEFAULT_HEATER_ON_TEMP_C;
+float heaterOffTemp  = DEFAULT_HEATER_OFF_TEMP_C;
+float refrigOnTemp   = DEFAULT_REFRIG_ON_TEMP2_C;
+float refrigOffTemp  = DEFAULT_REFRIG_OFF_TEMP2_C;
+
+bool heaterCmd = false, heaterCmdKnown = false;
+bool refrigCmd = false, refrigCmdKnown = false;
+bool fanCmd    = false, fanCmdKnown    = false;
+
+uint32_t bootStartMillis = 0;
+std::atomic<bool> provisioningMode(false);
+
+// ============================================================
+// AUTOMATIC CONTROL LOGIC
+// ============================================================
+bool isValidDs18b20(float value) {
+    return (value > -126.0f && value < 85.0f);
+}
+
+bool isValidAmbientTemp(float value) {
+    return (value > -40.0f && value < 125.0f);
+}
+
+bool shouldHoldRelaysOff() {
+    const bool startupHoldActive = (hal.clock->millis() - bootStartMillis) < RELAY_STARTUP_HOLDOFF_MS;
+    const bool provisioningHoldActive = RELAYS_OFF_DURING_PROVISIONING && provisioningMode;
+    return startupHoldActive || provisioningHoldActive;
+}
+
+void enforceRelaysOff() {
+    heaterOn = false;
+    refrigOn = false;
+    fanOn = false;
+    applyRelayStates();
+}
+
+void updateFanCycle() {
+    const uint32_t now = hal.clock->millis();
+    const uint32_t phaseDuration = fanCycleOnPhase ? FAN_ON_DURATION_MS : FAN_OFF_DURATION_MS;
+
+    if (now - fanCycleStartMillis >= phaseDuration) {
+        fanCycleOnPhase = !fanCycleOnPhase;
+        fanCycleStartMillis = now;
+
+        LOGI(CTRL, "Fan cycle phase -> %s", fanCycleOnPhase ? "ON (2 min)" : "OFF (1 min)");
+    }
+
+    fanOn = fanCycleOnPhase;
+}
+
+void updateAutomaticControl() {
+    ScopedCycles prof(PROF_AUTO_CONTROL);
+    updateFanCycle();
+
+    const bool ambientValid = isValidAmbientTemp(ambientTemp);
+    const bool temp2Valid = isValidDs18b20(temp2);
+    const bool temp1Valid = isValidDs18b20(temp1);
+
+    if (ambientValid && temp2Valid) {
+        float avgTemp = (ambientTemp + temp2) / 2.0f;
+        if (avgTemp >= heaterOffTemp) {
+            heaterOn = false;
+        } else if (avgTemp <= heaterOnTemp) {
+            heaterOn = true;
+        }
+
+        LOGD(CTRL, "Heater Avg(Ambient+temp2) = %.2f°C (ON<=%.1f, OFF>=%.1f)",
+             avgTemp, heaterOnTemp, heaterOffTemp);
+    } else {
+        LOGW(CTRL, "Heater control skipped (invalid ambient temp or temp2)");
+    }
+
+    if (temp1Valid) {
+        if (temp1 <= refrigOffTemp) {
+            refrigOn = false;
+        } else if (temp1 >= refrigOnTemp) {
+            refrigOn = true;
+        }
+
+        LOGD(CTRL, "Refrig temp1 = %.2f°C (OFF<=%.1f, ON>=%.1f)",
+             temp1, refrigOffTemp, refrigOnTemp);
+    } else {
+        LOGW(CTRL, "Refrig control skipped (invalid temp1)");
+    }
+}
+
+// One control decision + relay write (sensor tick or remote change)
+void runControlCycle() {
+    if (autoRelayControl) {
+        updateAutomaticControl();
+    } else {
+        // Manual Mode: follow the last commands received from Firebase
+        if (heaterCmdKnown) heaterOn = heaterCmd;
+        if (refrigCmdKnown) refrigOn = refrigCmd;
+        if (fanCmdKnown)    fanOn    = fanCmd;
+
+        // Manual Mode Safety Override: Force-cutoff if temps exceed set boundaries
+        if (isValidAmbientTemp(ambientTemp) && isValidDs18b20(temp2)) {
+            float avgTemp = (ambientTemp + temp2) / 2.0f;
+            if (heaterOn && avgTemp >= heaterOffTemp) {
+                heaterOn = false;
+                LOGW(CTRL, "Safety override: Heater OFF (Avg >= %.1f°C)", heaterOffTemp);
+            }
+        }
+        if (isValidDs18b20(temp1)) {
+            if (refrigOn && temp1 <= refrigOffTemp) {
+                refrigOn = false;
+                LOGW(CTRL, "Safety override: Refrig OFF (temp1 <= %.1f°C)", refrigOffTemp);
+            }
+        }
+    }
+    applyRelayStates();
+}
+
+// ============================================================
+// RELAY & LED CONTROL
+// ============================================================
+void applyRelayStates() {
+    const uint32_t startUs = hal.clock->micros();
+
+    // Write relay outputs (supports active-low relay modules)
+    writeRelay(PIN_RELAY_HEATER, HEATER_OUTPUT_INVERTED ? !heaterOn : heaterOn, RELAY_HEATER_ACTIVE_LOW);
+    writeRelay(PIN_RELAY_REFRIG, REFRIG_OUTPUT_INVERTED ? !refrigOn : refrigOn, RELAY_REFRIG_ACTIVE_LOW);
+    writeRelay(PIN_RELAY_FAN,    FAN_OUTPUT_INVERTED ? !fanOn : fanOn, RELAY_FAN_ACTIVE_LOW);
+
+    // Set LEDs directly
+    hal.gpio->write(PIN_LED_HEATER, heaterOn);
+    hal.gpio->write(PIN_LED_REFRIG, refrigOn);
+    hal.gpio->write(PIN_LED_FAN,    fanOn);
+    latencyProfiler.record(LAT_APPLY_RELAYS, hal.clock->micros() - startUs);
+
+    LOGD(RELAY, "Heater:%s  Refrig:%s  Fan:%s",
+         heaterOn ? "ON " : "OFF", refrigOn ? "ON " : "OFF", fanOn ? "ON " : "OFF");
+}
+
+void writeRelay(uint8_t pin, bool on, bool activeLow) {
+    ScopedCycles prof(PROF_WRITE_RELAY);
+    const bool level = activeLow ? !on : on;
+    hal.gpio->setOutput(pin);
+    hal.gpio->write(pin, level);
+}
+
+void setAllLedsImmediate(bool on) {
+    hal.gpio->write(PIN_LED_HEATER, on);
+    hal.gpio->write(PIN_LED_REFRIG, on);
+    hal.gpio->write(PIN_LED_FAN,    on);
+}
@@ -0,0 +1,88 @@
+// ============================================================
+// SCOPED CYCLE COUNTERS
+// See cycle_profiler.h
+// ============================================================
+
+#include "cycle_profiler.h"
+#include "logger.h"
+#include <stdio.h>
+#include <string.h>
+
+CycleProfiler cycleProfiler;
+
+static const char *COUNTER_NAMES[PROF_COUNTER_COUNT] = {
+    "push", "payload", "auto_ctrl", "write_relay", "ota_chunk"};
+
+CycleProfiler::CycleProfiler() {
+    memset(_counters, 0, sizeof(_counters));
+#if defined(ARDUINO)
+    portMUX_INITIALIZE(&_mux);
+#else
+    _busy.clear();
+#endif
+}
+
+void CycleProfiler::_lock() {
+#if defined(ARDUINO)
+    portENTER_CRITICAL(&_mux);
+#else
+    while (_busy.test_and_set(std::memory_order_acquire)) {}
+#endif
+}
+
+void CycleProfiler::_unlock() {
+#if defined(ARDUINO)
+    portEXIT_CRITICAL(&_mux);
+#else
+    _busy.clear(std::memory_order_release);
+#endif
+}
+
+uint32_t CycleProfiler::ticksPerUs() {
+#if defined(ARDUINO)
+    return ESP.getCpuFreqMHz();
+#else
+    return 1000;
+#endif
+}
+
+const char *CycleProfiler::counterName(ProfCounter id) {
+    return COUNTER_NAMES[id];
+}
+
+void CycleProfiler::add(ProfCounter id, uint32_t ticks) {
+    _lock();
+    CycleCounter &c = _counters[id];
+    if (c.calls == 0 || ticks < c.minTicks) c.minTicks = ticks;
+    if (ticks > c.maxTicks) c.maxTicks = ticks;
+    c.totalTicks += ticks;
+    c.calls++;
+    _unlock();
+}
+
+void CycleProfiler::snapshot(CycleCounter out[PROF_COUNTER_COUNT], bool reset) {
+    _lock();
+    memcpy(out, _counters, sizeof(_counters));
+    if (reset) memset(_counters, 0, sizeof(_counters));
+    _unlock();
+}
+
+void CycleProfiler::report() {
+#if CYCLE_PROFILE_ENABLED
+    CycleCounter snap[PROF_COUNTER_COUNT];
+    snapshot(snap, true);   // Log I/O happens outside the lock
+
+    const uint32_t perUs = ticksPerUs();
+    for (int i = 0; i < PROF_COUNTER_COUNT; i++) {
+        const CycleCounter &c = snap[i];
+        if (c.calls == 0) continue;
+        char line[128];
+        snprintf(line, sizeof(line),
+                 "[PERF] cycles %-11s calls %lu  avg %lu  min %lu  max %lu  (total %.1f ms)",
+                 COUNTER_NAMES[i], (unsigned long)c.calls, (unsigned long)(c.totalTicks / c.calls),
+                 (unsigned long)c.minTicks, (unsigned long)c.maxTicks,
+                 (double)c.totalTicks / perUs / 1000.0);
+        Log.println(line);
+    }
+#endif
+}
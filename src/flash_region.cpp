@@ -0,0 +1,152 @@
+// ============================================================
+// FLASH REGION
+// esp_partition slice (device) / partition image file (host)
+// ============================================================
+
+#include "flash_region.h"
+#include <string.h>
+#if !defined(ARDUINO)
+#include <sys/mman.h>
+#endif
+
+uint16_t flashCrc16(const uint8_t *data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    while (len--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+#if defined(ARDUINO)
+
+EspPartitionRegion::EspPartitionRegion()
+    : _part(nullptr), _offset(0), _size(0), _mapped(nullptr), _mapHandle(0) {
+}
+
+bool EspPartitionRegion::begin(const esp_partition_t *part, uint32_t offset, uint32_t size) {
+    if (!part || offset % SECTOR_BYTES != 0 || size % SECTOR_BYTES != 0 ||
+        size == 0 || offset + size > part->size) {
+        return false;
+    }
+    _part = part;
+    _offset = offset;
+    _size = size;
+    return true;
+}
+
+bool EspPartitionRegion::read(uint32_t offset, void *dst, size_t len) {
+    if (!_part || offset + len > _size) return false;
+    return esp_partition_read(_part, _offset + offset, dst, len) == ESP_OK;
+}
+
+bool EspPartitionRegion::write(uint32_t offset, const void *src, size_t len) {
+    if (!_part || offset + len > _size) return false;
+    return esp_partition_write(_part, _offset + offset, src, len) == ESP_OK;
+}
+
+bool EspPartitionRegion::eraseSector(uint32_t offset) {
+    if (!_part || offset % SECTOR_BYTES != 0 || offset >= _size) return false;
+    return esp_partition_erase_range(_part, _offset + offset, SECTOR_BYTES) == ESP_OK;
+}
+
+const uint8_t *EspPartitionRegion::map() {
+    if (!_mapped && _part) {
+        if (esp_partition_mmap(_part, _offset, _size, SPI_FLASH_MMAP_DATA, &_mapped, &_mapHandle) != ESP_OK) {
+            _mapped = nullptr;
+        }
+    }
+    return static_cast<const uint8_t *>(_mapped);
+}
+
+#else
+
+FileFlashRegion::FileFlashRegion() : _file(nullptr), _size(0), _sectorSize(0), _mapped(nullptr) {
+}
+
+FileFlashRegion::~FileFlashRegion() {
+    close();
+}
+
+bool FileFlashRegion::open(const char *path, uint32_t size, uint32_t sectorSize) {
+    close();
+    if (sectorSize == 0 || size == 0 || size % sectorSize != 0) return false;
+
+    _file = fopen(path, "r+b");
+    if (!_file) _file = fopen(path, "w+b");
+    if (!_file) return false;
+
+    // Pad a new / short image with erased flash
+    fseek(_file, 0, SEEK_END);
+    const long end = ftell(_file);
+    uint32_t have = (end > 0) ? (uint32_t)end : 0;
+    uint8_t erased[256];
+    memset(erased, 0xFF, sizeof(erased));
+    while (have < size) {
+        const size_t n = (size - have < sizeof(erased)) ? (size_t)(size - have) : sizeof(erased);
+        if (fwrite(erased, 1, n, _file) != n) {
+            close();
+            return false;
+        }
+        have += n;
+    }
+    fflush(_file);
+
+    _size = size;
+    _sectorSize = sectorSize;
+    return true;
+}
+
+void FileFlashRegion::close() {
+    if (_mapped) munmap(_mapped, _size);
+    _mapped = nullptr;
+    if (_file) fclose(_file);
+    _file = nullptr;
+    _size = 0;
+}
+
+bool FileFlashRegion::read(uint32_t offset, void *dst, size_t len) {
+    if (!_file || offset + len > _size) return false;
+    return fseek(_file, offset, SEEK_SET) == 0 && fread(dst, 1, len, _file) == len;
+}
+
+// NOR program: the stored bits become (old & new)
+bool FileFlashRegion::write(uint32_t offset, const void *src, size_t len) {
+    if (!_file || offset + len > _size) return false;
+    const uint8_t *in = static_cast<const uint8_t *>(src);
+    uint8_t chunk[256];
+    while (len > 0) {
+        const size_t n = (len < sizeof(chunk)) ? len : sizeof(chunk);
+        if (!read(offset, chunk, n)) return false;
+        for (size_t i = 0; i < n; i++) chunk[i] &= in[i];
+        if (fseek(_file, offset, SEEK_SET) != 0 || fwrite(chunk, 1, n, _file) != n) return false;
+        offset += n;
+        in += n;
+        len -= n;
+    }
+    return fflush(_file) == 0;
+}
+
+bool FileFlashRegion::eraseSector(uint32_t offset) {
+    if (!_file || offset % _sectorSize != 0 || offset >= _size) return false;
+    uint8_t erased[256];
+    memset(erased, 0xFF, sizeof(erased));
+    if (fseek(_file, offset, SEEK_SET) != 0) return false;
+    for (uint32_t done = 0; done < _sectorSize; done += sizeof(erased)) {
+        const size_t n = (_sectorSize - done < sizeof(erased)) ? (size_t)(_sectorSize - done) : sizeof(erased);
+        if (fwrite(erased, 1, n, _file) != n) return false;
+    }
+    return fflush(_file) == 0;
+}
+
+const uint8_t *FileFlashRegion::map() {
+    if (!_mapped && _file) {
+        void *p = mmap(nullptr, _size, PROT_READ, MAP_SHARED, fileno(_file), 0);
+        _mapped = (p == MAP_FAILED) ? nullptr : p;
+    }
+    return static_cast<const uint8_t *>(_mapped);
+}
+
+#endif
@@ -0,0 +1,233 @@
+// ============================================================
+// FLASH RING LOG
+// Wear-levelled append-only record log, see flash_ring_log.h
+// ============================================================
+
+#include "flash_ring_log.h"
+#include <string.h>
+
+static const uint16_t MAX_RECORD_BYTES = 252;   // slot buffer on the stack stays at 256 B
+
+FlashRingLog::FlashRingLog(FlashRegion &region, uint16_t recordSize)
+    : _region(region),
+      _recordSize(recordSize),
+      _slotSize((4 + recordSize + 3) & ~3u),
+      _sectorSize(0),
+      _sectorCount(0),
+      _slotsPerSector(0),
+      _mounted(false),
+      _hasHead(false),
+      _head{0, 1},
+      _tail{0, 1},
+      _seq(0),
+      _pending(0),
+      _overwritten(0),
+      _corrupt(0) {
+}
+
+// ============================================================
+// MOUNT
+// Head = valid sector with the highest seq; everything else is
+// read back in ring order (oldest first) to find the tail
+// ============================================================
+bool FlashRingLog::begin() {
+    _mounted = false;
+    if (_recordSize == 0 || _recordSize > MAX_RECORD_BYTES) return false;
+
+    _sectorSize = _region.sectorSize();
+    _sectorCount = _sectorSize ? _region.size() / _sectorSize : 0;
+    _slotsPerSector = _sectorSize / _slotSize;
+    if (_sectorCount < 2 || _slotsPerSector < 2) return false;
+
+    _hasHead = false;
+    _seq = 0;
+    for (uint32_t s = 0; s < _sectorCount; s++) {
+        uint32_t seq;
+        if (_readHeader(s, seq) && (!_hasHead || seq > _seq)) {
+            _hasHead = true;
+            _seq = seq;
+            _head.sector = s;
+        }
+    }
+
+    _pending = 0;
+    _overwritten = 0;
+    _corrupt = 0;
+    _mounted = true;
+
+    if (!_hasHead) {
+        _head = {0, 1};
+        _tail = _head;
+        return true;
+    }
+
+    // Append position: first empty slot of the head sector
+    _head.slot = _slotsPerSector;
+    for (uint32_t slot = 1; slot < _slotsPerSector; slot++) {
+        if (_readState({_head.sector, slot}) == STATE_EMPTY) {
+            _head.slot = slot;
+            break;
+        }
+    }
+
+    // Pending records, oldest sector first (the head sector comes last)
+    bool tailFound = false;
+    for (uint32_t i = 1; i <= _sectorCount; i++) {
+        const uint32_t s = (_head.sector + i) % _sectorCount;
+        uint32_t seq;
+        // Only sectors of the current chain: anything else is stale
+        if (!_readHeader(s, seq) || seq > _seq || _seq - seq >= _sectorCount) continue;
+
+        const uint32_t end = (s == _head.sector) ? _head.slot : _slotsPerSector;
+        for (uint32_t slot = 1; slot < end; slot++) {
+            if (_readState({s, slot}) != STATE_WRITTEN) continue;
+            _pending++;
+            if (!tailFound) {
+                _tail = {s, slot};
+                tailFound = true;
+            }
+        }
+    }
+    if (!tailFound) _tail = _head;
+    return true;
+}
+
+bool FlashRingLog::format() {
+    if (_sectorCount == 0) return false;
+    for (uint32_t s = 0; s < _sectorCount; s++) {
+        if (!_region.eraseSector(s * _sectorSize)) return false;
+    }
+    _hasHead = false;
+    _seq = 0;
+    _head = {0, 1};
+    _tail = _head;
+    _pending = 0;
+    return true;
+}
+
+// ============================================================
+// WRITE
+// ============================================================
+bool FlashRingLog::append(const void *record) {
+    if (!_mounted) return false;
+    if (!_hasHead || _head.slot >= _slotsPerSector) {
+        if (!_openNextSector()) return false;
+    }
+
+    uint8_t slot[4 + MAX_RECORD_BYTES];
+    const uint16_t crc = flashCrc16(static_cast<const uint8_t *>(record), _recordSize);
+    slot[0] = STATE_WRITTEN;
+    slot[1] = 0xFF;
+    slot[2] = (uint8_t)(crc & 0xFF);
+    slot[3] = (uint8_t)(crc >> 8);
+    memcpy(slot + 4, record, _recordSize);
+
+    // A failed program still burns the slot: never write over it twice
+    const bool ok = _region.write(_slotOffset(_head), slot, 4 + _recordSize);
+    _head.slot++;
+    if (ok) _pending++;
+    return ok;
+}
+
+// Erase-before-use of the next sector in ring order
+bool FlashRingLog::_openNextSector() {
+    const uint32_t next = _hasHead ? (_head.sector + 1) % _sectorCount : 0;
+
+    if (_pending > 0 && _tail.sector == next) {
+        const uint32_t lost = _countWritten(next);
+        _pending -= (lost < _pending) ? lost : _pending;
+        _overwritten += lost;
+        _tail = {(next + 1) % _sectorCount, 1};
+    }
+
+    if (!_region.eraseSector(next * _sectorSize)) return false;
+    const uint32_t header[2] = {MAGIC, _seq + 1};
+    if (!_region.write(next * _sectorSize, header, sizeof(header))) return false;
+
+    _seq++;
+    _hasHead = true;
+    _head = {next, 1};
+    if (_pending == 0) _tail = _head;
+    return true;
+}
+
+// ============================================================
+// READ BACK
+// ============================================================
+size_t FlashRingLog::peek(void *out, size_t maxRecords) {
+    if (!_mounted) return 0;
+    uint8_t *dst = static_cast<uint8_t *>(out);
+    size_t n = 0;
+    Pos p = _tail;
+
+    while (n < maxRecords && !(p.sector == _head.sector && p.slot == _head.slot)) {
+        uint8_t hdr[4];
+        if (_region.read(_slotOffset(p), hdr, sizeof(hdr)) && hdr[0] == STATE_WRITTEN) {
+            uint8_t *rec = dst + n * _recordSize;
+            if (_region.read(_slotOffset(p) + 4, rec, _recordSize) &&
+                flashCrc16(rec, _recordSize) == (uint16_t)(hdr[2] | (hdr[3] << 8))) {
+                n++;
+            }
+        }
+        _next(p);
+    }
+    return n;
+}
+
+// Walks the same records peek() returned; corrupt ones on the way
+// are retired too, so they are not offered again
+size_t FlashRingLog::consume(size_t count) {
+    if (!_mounted) return 0;
+    size_t done = 0;
+    uint8_t rec[MAX_RECORD_BYTES];
+
+    while (done < count && !(_tail.sector == _head.sector && _tail.slot == _head.slot)) {
+        uint8_t hdr[4];
+        if (_region.read(_slotOffset(_tail), hdr, sizeof(hdr)) && hdr[0] == STATE_WRITTEN) {
+            const bool valid = _region.read(_slotOffset(_tail) + 4, rec, _recordSize) &&
+                               flashCrc16(rec, _recordSize) == (uint16_t)(hdr[2] | (hdr[3] << 8));
+            const uint8_t consumed = STATE_CONSUMED;
+            _region.write(_slotOffset(_tail), &consumed, 1);
+            if (_pending > 0) _pending--;
+            if (valid) done++;
+            else _corrupt++;
+        }
+        _next(_tail);
+    }
+    return done;
+}
+
+// ============================================================
+// HELPERS
+// ============================================================
+bool FlashRingLog::_readHeader(uint32_t sector, uint32_t &seq) {
+    uint32_t header[2];
+    if (!_region.read(sector * _sectorSize, header, sizeof(header))) return false;
+    if (header[0] != MAGIC || header[1] == 0xFFFFFFFF) return false;
+    seq = header[1];
+    return true;
+}
+
+uint8_t FlashRingLog::_readState(const Pos &p) {
+    uint8_t state = STATE_EMPTY;
+    _region.read(_slotOffset(p), &state, 1);
+    return state;
+}
+
+uint32_t FlashRingLog::_countWritten(uint32_t sector) {
+    uint32_t n = 0;
+    for (uint32_t slot = 1; slot < _slotsPerSector; slot++) {
+        if (_readState({sector, slot}) == STATE_WRITTEN) n++;
+    }
+    return n;
+}
+
+// One slot forward; a full head sector keeps its slot == n position
+bool FlashRingLog::_next(Pos &p) const {
+    p.slot++;
+    if (p.slot >= _slotsPerSector && !(_hasHead && p.sector == _head.sector)) {
+        p.sector = (p.sector + 1) % _sectorCount;
+        p.slot = 1;
+    }
+    return !(p.sector == _head.sector && p.slot == _head.slot);
+}
@@ -0,0 +1,239 @@
+// ============================================================
+// HARDWARE ABSTRACTION
+// Board and simulated implementations, see hal.h
+// ============================================================
+
+#include "hal.h"
+#include "config.h"
+#include <string.h>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#include <WiFi.h>
+#include <time.h>
+#include <Firebase_ESP_Client.h>
+#include "https_pool.h"
+#include "secrets.h"
+
+static Esp32Clock    esp32Clock;
+static Esp32Gpio     esp32Gpio;
+static DallasTempBus tempBus1(PIN_TEMP_SENSOR1);
+static DallasTempBus tempBus2(PIN_TEMP_SENSOR2);
+static Sht3xSensor   sht3x(I2C_SENSOR_ADDR);
+static Esp32Network  esp32Network;
+FirebaseRtdb         firebaseRtdb;
+PooledRtdb           pooledRtdb;
+
+#if FIREBASE_PATCH_VIA_POOL
+Hal hal = {&esp32Clock, &esp32Gpio, {&tempBus1, &tempBus2}, &sht3x, &esp32Network, &pooledRtdb};
+#else
+Hal hal = {&esp32Clock, &esp32Gpio, {&tempBus1, &tempBus2}, &sht3x, &esp32Network, &firebaseRtdb};
+#endif
+
+uint32_t Esp32Clock::millis() { return ::millis(); }
+uint32_t Esp32Clock::micros() { return ::micros(); }
+
+uint32_t Esp32Clock::epoch() {
+    time_t now;
+    time(&now);
+    return (uint32_t)now;
+}
+
+void Esp32Gpio::setOutput(uint8_t pin) { pinMode(pin, OUTPUT); }
+void Esp32Gpio::write(uint8_t pin, bool level) { digitalWrite(pin, level ? HIGH : LOW); }
+
+// ============================================================
+// DS18B20 (OneWire + DallasTemperature)
+// ============================================================
+DallasTempBus::DallasTempBus(uint8_t pin) : _wire(pin), _dallas(&_wire) {
+    _dallas.setWaitForConversion(false);   // convertAll() returns immediately
+}
+
+void DallasTempBus::resetSearch() {
+    _wire.reset_search();
+}
+
+bool DallasTempBus::searchNext(uint8_t rom[8]) {
+    while (_wire.search(rom)) {
+        if (OneWire::crc8(rom, 7) == rom[7]) return true;
+    }
+    return false;
+}
+
+uint8_t DallasTempBus::resolution(const uint8_t rom[8]) {
+    return _dallas.getResolution(rom);
+}
+
+void DallasTempBus::setResolution(const uint8_t rom[8], uint8_t bits) {
+    _dallas.setResolution(rom, bits, true);
+}
+
+uint32_t DallasTempBus::conversionMs(uint8_t bits) {
+    return _dallas.millisToWaitForConversion(bits);
+}
+
+void DallasTempBus::convertAll() {
+    _dallas.requestTemperatures();
+}
+
+bool DallasTempBus::readRaw(const uint8_t rom[8], int32_t &raw) {
+    // Match ROM + scratchpad read with CRC check
+    raw = _dallas.getTemp(rom);
+    return raw != DEVICE_DISCONNECTED_RAW;
+}
+
+// ============================================================
+// SHT3x, WIFI, FIREBASE
+// ============================================================
+bool Sht3xSensor::begin() {
+    return _sht.begin(_address);
+}
+
+bool Sht3xSensor::read(float &tempC, float &humidityPct) {
+    return _sht.readBoth(&tempC, &humidityPct);
+}
+
+bool Esp32Network::connected() { return WiFi.status() == WL_CONNECTED; }
+int32_t Esp32Network::rssi() { return WiFi.RSSI(); }
+
+bool FirebaseRtdb::ready() {
+    return _fbdo && Firebase.ready();
+}
+
+bool FirebaseRtdb::update(const char *path, const char *json) {
+    if (!_fbdo) return false;
+    FirebaseJson doc;
+    doc.setJsonData(json);
+    return Firebase.RTDB.updateNodeSilent(_fbdo, path, &doc);
+}
+
+const char *FirebaseRtdb::lastError() {
+    static String reason;   // keeps the returned pointer valid until the next call
+    reason = _fbdo ? _fbdo->errorReason() : String("not attached");
+    return reason.c_str();
+}
+
+bool PooledRtdb::ready() {
+    return WiFi.status() == WL_CONNECTED;
+}
+
+bool PooledRtdb::update(const char *path, const char *json) {
+    // FIREBASE_URL may be a bare host (local stand-in) or a full URL
+    String url = strstr(FIREBASE_URL, "://") ? FIREBASE_URL : "https://" FIREBASE_URL;
+    if (url.endsWith("/")) url.remove(url.length() - 1);
+    url += path;
+    url += ".json?print=silent&auth=" FIREBASE_AUTH;
+
+    HTTPClient *http = httpsPool.acquire(HTTPS_CH_FIREBASE, url);
+    if (!http) {
+        strlcpy(_error, "no free pool connection", sizeof(_error));
+        return false;
+    }
+    http->addHeader("Content-Type", "application/json");
+    const int code = http->PATCH((uint8_t *)json, strlen(json));
+    // print=silent answers 204 with no body; anything else may have one
+    httpsPool.release(http, code == 204);
+    if (code == 200 || code == 204) return true;
+    snprintf(_error, sizeof(_error), "HTTP %d (%s)", code,
+             code < 0 ? HTTPClient::errorToString(code).c_str() : "server");
+    return false;
+}
+
+#else
+
+SimClock         simClock;
+SimGpio          simGpio;
+SimTempBus       simTempBus[HAL_TEMP_BUSES];
+SimAmbientSensor simAmbient;
+SimNetwork       simNetwork;
+SimRtdb          simRtdb;
+
+Hal hal = {&simClock, &simGpio, {&simTempBus[0], &simTempBus[1]}, &simAmbient, &simNetwork, &simRtdb};
+
+// ============================================================
+// SIMULATED DS18B20 BUS
+// ============================================================
+
+// Dallas/Maxim CRC-8 (x^8 + x^5 + x^4 + 1), as OneWire::crc8
+static uint8_t romCrc8(const uint8_t *data, uint8_t len) {
+    uint8_t crc = 0;
+    while (len--) {
+        uint8_t in = *data++;
+        for (uint8_t i = 0; i < 8; i++) {
+            const uint8_t mix = (crc ^ in) & 0x01;
+            crc >>= 1;
+            if (mix) crc ^= 0x8C;
+            in >>= 1;
+        }
+    }
+    return crc;
+}
+
+int SimTempBus::addProbe(uint32_t id, float tempC) {
+    if (_count >= MAX_PROBES) return -1;
+    Probe &p = _probes[_count];
+    p.rom[0] = 0x28;   // DS18B20 family
+    for (int i = 0; i < 4; i++) p.rom[1 + i] = (uint8_t)(id >> (8 * i));
+    p.rom[5] = 0;
+    p.rom[6] = 0;
+    p.rom[7] = romCrc8(p.rom, 7);
+    p.tempC = tempC;
+    p.latchedC = 85.0f;   // power-on scratchpad value
+    p.bits = 12;
+    p.present = true;
+    return _count++;
+}
+
+int SimTempBus::_find(const uint8_t rom[8]) const {
+    for (int i = 0; i < _count; i++) {
+        if (_probes[i].present && memcmp(_probes[i].rom, rom, 8) == 0) return i;
+    }
+    return -1;
+}
+
+bool SimTempBus::searchNext(uint8_t rom[8]) {
+    while (_searchPos < _count) {
+        const Probe &p = _probes[_searchPos++];
+        if (p.present) {
+            memcpy(rom, p.rom, 8);
+            return true;
+        }
+    }
+    return false;
+}
+
+uint8_t SimTempBus::resolution(const uint8_t rom[8]) {
+    const int i = _find(rom);
+    return i < 0 ? 0 : _probes[i].bits;
+}
+
+void SimTempBus::setResolution(const uint8_t rom[8], uint8_t bits) {
+    const int i = _find(rom);
+    if (i >= 0) _probes[i].bits = bits;
+}
+
+void SimTempBus::convertAll() {
+    _conversions++;
+    for (int i = 0; i < _count; i++) _probes[i].latchedC = _probes[i].tempC;
+}
+
+bool SimTempBus::readRaw(const uint8_t rom[8], int32_t &raw) {
+    const int i = _find(rom);
+    if (i < 0) return false;
+    // Quantized like the real sensor: 12 bit = 1/16 °C steps
+    const int32_t step = 128 >> (_probes[i].bits - 8);
+    const float scaled = _probes[i].latchedC * 128.0f;
+    raw = ((int32_t)(scaled >= 0 ? scaled + 0.5f : scaled - 0.5f) / step) * step;
+    return true;
+}
+
+bool SimRtdb::update(const char *path, const char *json) {
+    if (!online) return false;
+    updates++;
+    bytes += strlen(json);
+    lastPath = path;
+    lastJson = json;
+    return true;
+}
+
+#endif
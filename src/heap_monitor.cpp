@@ -0,0 +1,126 @@
+// ============================================================
+// HEAP INSTRUMENTATION
+// Heap watermarks + optional link-time allocation counting
+// ============================================================
+
+#include "heap_monitor.h"
+#include "logger.h"
+
+HeapMonitor heapMonitor;
+
+static const char *CYCLE_NAMES[HEAP_CYCLE_COUNT] = {"control", "fb_push", "fb_poll"};
+
+#if HEAP_COUNT_ALLOCS
+// ============================================================
+// ALLOCATION COUNTERS (-Wl,--wrap=malloc,... builds only)
+// Every task bumps the global counter; tracked tasks also bump
+// their own slot, which only that task ever writes
+// ============================================================
+static volatile uint32_t s_totalAllocs = 0;
+static TaskHandle_t s_trackedTasks[HEAP_TRACKED_TASKS] = {};
+static volatile uint32_t s_taskAllocs[HEAP_TRACKED_TASKS] = {};
+
+static int trackedSlot(TaskHandle_t task) {
+    for (int i = 0; i < HEAP_TRACKED_TASKS; i++) {
+        if (s_trackedTasks[i] == task) return i;
+    }
+    return -1;
+}
+
+static inline void countAlloc() {
+    __atomic_fetch_add(&s_totalAllocs, 1, __ATOMIC_RELAXED);
+    const int slot = trackedSlot(xTaskGetCurrentTaskHandle());
+    if (slot >= 0) s_taskAllocs[slot]++;
+}
+
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    countAlloc();
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+    countAlloc();
+    return __real_calloc(n, size);
+}
+
+// String growth goes through realloc: every resize counts as churn
+void *__wrap_realloc(void *ptr, size_t size) {
+    if (size > 0) countAlloc();
+    return __real_realloc(ptr, size);
+}
+}
+#endif
+
+HeapMonitor::HeapMonitor() {
+    resetCycleStats();
+}
+
+void HeapMonitor::trackCurrentTask() {
+#if HEAP_COUNT_ALLOCS
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    if (trackedSlot(self) >= 0) return;
+    const int slot = trackedSlot(nullptr);
+    if (slot < 0) {
+        Log.println("[!] HEAP_TRACKED_TASKS exhausted - task allocations not counted");
+        return;
+    }
+    s_taskAllocs[slot] = 0;
+    s_trackedTasks[slot] = self;
+#endif
+}
+
+uint32_t HeapMonitor::taskAllocs() const {
+#if HEAP_COUNT_ALLOCS
+    const int slot = trackedSlot(xTaskGetCurrentTaskHandle());
+    return (slot >= 0) ? s_taskAllocs[slot] : 0;
+#else
+    return 0;
+#endif
+}
+
+uint32_t HeapMonitor::totalAllocs() const {
+#if HEAP_COUNT_ALLOCS
+    return s_totalAllocs;
+#else
+    return 0;
+#endif
+}
+
+void HeapMonitor::endCycle(HeapCycle cycle, uint32_t startAllocs) {
+    const uint32_t allocs = taskAllocs() - startAllocs;
+    HeapCycleStats &st = _cycles[cycle];
+    st.cycles++;
+    st.allocs += allocs;
+    if (allocs > st.maxAllocs) st.maxAllocs = allocs;
+}
+
+uint8_t HeapMonitor::fragmentationPct() const {
+    const uint32_t freeNow = freeBytes();
+    if (freeNow == 0) return 100;
+    return (uint8_t)(100 - (uint64_t)largestFreeBlock() * 100 / freeNow);
+}
+
+void HeapMonitor::report() {
+    Log.println("[PERF] heap: free " + String(freeBytes()) + ", min " + String(minFreeBytes()) +
+                ", largest block " + String(largestFreeBlock()) +
+                " (fragmentation " + String(fragmentationPct()) + "%)");
+#if HEAP_COUNT_ALLOCS
+    String line = "[PERF] heap allocs: " + String(totalAllocs()) + " total";
+    for (int c = 0; c < HEAP_CYCLE_COUNT; c++) {
+        const HeapCycleStats &st = _cycles[c];
+        if (st.cycles == 0) continue;
+        line += ", " + String(CYCLE_NAMES[c]) + " avg " + String((float)st.allocs / st.cycles, 1) +
+                " max " + String(st.maxAllocs) + "/cycle";
+    }
+    Log.println(line);
+#endif
+}
+
+void HeapMonitor::resetCycleStats() {
+    memset(_cycles, 0, sizeof(_cycles));
+}
@@ -0,0 +1,148 @@
+// ============================================================
+// HTTPS CONNECTION POOL
+// Shared keep-alive connections for version checks / downloads
+// ============================================================
+
+#include "https_pool.h"
+#include "logger.h"
+
+HttpsPool httpsPool;
+
+static const char *CHANNEL_NAMES[HTTPS_CH_COUNT] = {"ota_check", "ota_download", "firebase"};
+
+HttpsPool::HttpsPool() : _mutex(nullptr) {
+    for (int i = 0; i < HTTPS_POOL_SLOTS; i++) {
+        _slots[i].channel = HTTPS_CH_OTA_CHECK;
+        _slots[i].inUse = false;
+        _slots[i].reused = false;
+        _slots[i].startUs = 0;
+        _slots[i].lastUsedMs = 0;
+    }
+    resetStats();
+}
+
+void HttpsPool::begin() {
+    if (_mutex) return;
+    _mutex = xSemaphoreCreateMutex();
+    for (int i = 0; i < HTTPS_POOL_SLOTS; i++) {
+        // Same trust model as HTTPClient::begin(url) without a CA cert
+        _slots[i].client.setInsecure();
+        _slots[i].client.setHandshakeTimeout(HTTPS_POOL_HANDSHAKE_TIMEOUT_S);
+        _slots[i].http.setReuse(true);
+        _slots[i].http.setFollowRedirects(HTTPC_DISABLE_FOLLOW_REDIRECTS);
+    }
+}
+
+HTTPClient *HttpsPool::acquire(HttpsChannel channel, const String& url) {
+    if (!_mutex) begin();
+    const String host = _hostOf(url);
+
+    // Prefer a live connection to the same host, else the least recently used slot
+    Slot *slot = nullptr;
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    for (int i = 0; i < HTTPS_POOL_SLOTS; i++) {
+        Slot &s = _slots[i];
+        if (s.inUse) continue;
+        if (s.host == host && s.client.connected()) {
+            slot = &s;
+            break;
+        }
+        if (!slot || s.lastUsedMs < slot->lastUsedMs) {
+            slot = &s;
+        }
+    }
+    if (slot) slot->inUse = true;
+    xSemaphoreGive(_mutex);
+
+    if (!slot) {
+        Log.println("[HTTPS] No free connection for " + host);
+        return nullptr;
+    }
+
+    if (slot->host != host && slot->client.connected()) {
+        slot->client.stop();   // evict the other host's connection
+    }
+    slot->host = host;
+    slot->channel = channel;
+    slot->reused = slot->client.connected();
+    slot->startUs = micros();
+
+    if (!slot->http.begin(slot->client, url)) {
+        slot->inUse = false;
+        return nullptr;
+    }
+    return &slot->http;
+}
+
+void HttpsPool::release(HTTPClient *http, bool keepAlive) {
+    for (int i = 0; i < HTTPS_POOL_SLOTS; i++) {
+        Slot &s = _slots[i];
+        if (&s.http != http) continue;
+
+        const uint32_t elapsedUs = micros() - s.startUs;
+        s.http.end();   // keeps the socket if the response allows reuse
+        if (!keepAlive) {
+            s.client.stop();
+        }
+        record(s.channel, elapsedUs, s.reused);
+
+        xSemaphoreTake(_mutex, portMAX_DELAY);
+        s.lastUsedMs = millis();
+        s.inUse = false;
+        xSemaphoreGive(_mutex);
+        return;
+    }
+}
+
+void HttpsPool::record(HttpsChannel channel, uint32_t elapsedUs, bool reused) {
+    if (!_mutex) begin();
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    HttpsChannelStats &st = _stats[channel];
+    st.requests++;
+    if (!reused) st.handshakes++;
+    else st.reusedTotalUs += elapsedUs;
+    st.totalUs += elapsedUs;
+    if (elapsedUs > st.maxUs) st.maxUs = elapsedUs;
+    xSemaphoreGive(_mutex);
+}
+
+void HttpsPool::closeIdle() {
+    if (!_mutex) return;
+    const unsigned long now = millis();
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    for (int i = 0; i < HTTPS_POOL_SLOTS; i++) {
+        Slot &s = _slots[i];
+        // Each open TLS session holds ~40 KB of mbedtls buffers
+        if (!s.inUse && s.client.connected() && now - s.lastUsedMs > HTTPS_POOL_IDLE_TIMEOUT_MS) {
+            s.client.stop();
+        }
+    }
+    xSemaphoreGive(_mutex);
+}
+
+void HttpsPool::report() {
+    for (int c = 0; c < HTTPS_CH_COUNT; c++) {
+        const HttpsChannelStats &st = _stats[c];
+        if (st.requests == 0) continue;
+        const uint32_t reusedCount = st.requests - st.handshakes;
+        const uint32_t newCount = st.handshakes;
+        const uint32_t reusedAvgMs = reusedCount ? (uint32_t)(st.reusedTotalUs / reusedCount / 1000) : 0;
+        const uint32_t newAvgMs = newCount ? (uint32_t)((st.totalUs - st.reusedTotalUs) / newCount / 1000) : 0;
+        Log.println("[PERF] https " + String(CHANNEL_NAMES[c]) + ": " + String(st.requests) +
+                    " req, " + String(st.handshakes) + " handshakes (resumed n/a), " + String(reusedCount) + " reused" +
+                    ", avg new/reused " + String(newAvgMs) + "/" + String(reusedAvgMs) + " ms" +
+                    ", max " + String(st.maxUs / 1000) + " ms");
+    }
+}
+
+void HttpsPool::resetStats() {
+    memset(_stats, 0, sizeof(_stats));
+}
+
+// "https://host[:port]/path" -> "host[:port]"
+String HttpsPool::_hostOf(const String& url) {
+    int start = url.indexOf("://");
+    start = (start < 0) ? 0 : start + 3;
+    int end = url.indexOf('/', start);
+    return (end < 0) ? url.substring(start) : url.substring(start, end);
+}
@@ -0,0 +1,138 @@
+// ============================================================
+// LAN HTTP ENDPOINTS
+// /metrics and /state for local scrapers, see lan_http.h
+// ============================================================
+
+#include "lan_http.h"
+#include "logger.h"
+
+#include <stdio.h>
+#include <string.h>
+
+LanHttpServer lanHttp(LAN_HTTP_PORT);
+
+static const char HEADERS_METRICS[] =
+    "HTTP/1.0 200 OK\r\n"
+    "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+    "Cache-Control: no-store\r\n"
+    "Connection: close\r\n\r\n";
+
+static const char HEADERS_STATE[] =
+    "HTTP/1.0 200 OK\r\n"
+    "Content-Type: application/json\r\n"
+    "Cache-Control: no-store\r\n"
+    "Connection: close\r\n\r\n";
+
+static const char RESPONSE_NOT_FOUND[] =
+    "HTTP/1.0 404 Not Found\r\n"
+    "Content-Type: text/plain\r\n"
+    "Connection: close\r\n\r\n"
+    "try /metrics or /state\n";
+
+static const char RESPONSE_BAD_METHOD[] =
+    "HTTP/1.0 405 Method Not Allowed\r\n"
+    "Allow: GET\r\n"
+    "Connection: close\r\n\r\n";
+
+LanHttpServer::LanHttpServer(uint16_t port)
+    : _server(port),
+      _port(port),
+      _started(false),
+      _provider(nullptr),
+      _requests(0),
+      _failures(0),
+      _maxServeUs(0) {}
+
+void LanHttpServer::poll(bool networkUp) {
+    if (!networkUp) {
+        if (_started) {
+            _server.end();
+            _started = false;
+        }
+        return;
+    }
+    if (!_started) {
+        _server.begin();
+        _server.setNoDelay(true);
+        _started = true;
+        LOGI(HTTP, "LAN endpoints on port %u: /metrics /state", (unsigned)_port);
+    }
+    if (!_server.hasClient()) return;
+
+    WiFiClient client = _server.accept();
+    if (!client) return;
+
+    const uint32_t startUs = micros();
+    char line[96];
+    if (_readRequestLine(client, line, sizeof(line))) {
+        _respond(client, line);
+    } else {
+        _failures++;
+    }
+    client.stop();
+
+    const uint32_t elapsedUs = micros() - startUs;
+    if (elapsedUs > _maxServeUs) _maxServeUs = elapsedUs;
+}
+
+// First line only ("GET /metrics HTTP/1.1"); the headers are not needed
+bool LanHttpServer::_readRequestLine(WiFiClient &client, char *line, size_t cap) {
+    const uint32_t startMs = millis();
+    size_t len = 0;
+    while (millis() - startMs < LAN_HTTP_REQUEST_TIMEOUT_MS) {
+        if (!client.connected()) return false;
+        if (client.available() <= 0) {
+            vTaskDelay(1);
+            continue;
+        }
+        const int c = client.read();
+        if (c == '\n') {
+            line[len] = '\0';
+            return len > 0;
+        }
+        if (c != '\r' && len < cap - 1) line[len++] = (char)c;
+    }
+    return false;
+}
+
+bool LanHttpServer::_sinkThunk(void *client, const char *data, size_t len) {
+    return static_cast<WiFiClient *>(client)->write((const uint8_t *)data, len) == len;
+}
+
+void LanHttpServer::_respond(WiFiClient &client, const char *requestLine) {
+    if (strncmp(requestLine, "GET ", 4) != 0) {
+        client.write((const uint8_t *)RESPONSE_BAD_METHOD, sizeof(RESPONSE_BAD_METHOD) - 1);
+        _failures++;
+        return;
+    }
+
+    // Path up to the first space or query string
+    const char *path = requestLine + 4;
+    const size_t pathLen = strcspn(path, " ?");
+    const bool metrics = pathLen == 8 && strncmp(path, "/metrics", 8) == 0;
+    const bool state = pathLen == 6 && strncmp(path, "/state", 6) == 0;
+    if ((!metrics && !state) || !_provider) {
+        client.write((const uint8_t *)RESPONSE_NOT_FOUND, sizeof(RESPONSE_NOT_FOUND) - 1);
+        _failures++;
+        return;
+    }
+
+    _provider(_status);
+
+    ChunkWriter out(_chunk, sizeof(_chunk), _sinkThunk, &client);
+    out.write(metrics ? HEADERS_METRICS : HEADERS_STATE);
+    const bool ok = metrics ? renderMetrics(_status, out) : renderState(_status, out);
+    if (ok) {
+        _requests++;
+    } else {
+        _failures++;
+    }
+}
+
+void LanHttpServer::report() {
+    char line[96];
+    snprintf(line, sizeof(line), "[PERF] LAN http: %lu served, %lu failed, slowest %.1f ms",
+             (unsigned long)_requests, (unsigned long)_failures, _maxServeUs / 1000.0f);
+    Log.println(line);
+    _maxServeUs = 0;
+}
@@ -0,0 +1,211 @@
+// ============================================================
+// LAN STATUS DOCUMENTS
+// Prometheus /metrics and JSON /state, see lan_status.h
+// ============================================================
+
+#include "lan_status.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+// ============================================================
+// CHUNK WRITER
+// ============================================================
+ChunkWriter::ChunkWriter(char *buf, size_t capacity, ChunkSink sink, void *ctx)
+    : _buf(buf), _cap(capacity), _len(0), _total(0), _sink(sink), _ctx(ctx), _failed(false) {}
+
+bool ChunkWriter::_flush() {
+    if (_len > 0 && !_failed) {
+        _failed = !_sink(_ctx, _buf, _len);
+    }
+    _len = 0;
+    return !_failed;
+}
+
+void ChunkWriter::write(const char *text) {
+    size_t n = strlen(text);
+    while (n > 0 && !_failed) {
+        if (_len == _cap && !_flush()) return;
+        const size_t take = (n < _cap - _len) ? n : _cap - _len;
+        memcpy(_buf + _len, text, take);
+        _len += take;
+        _total += take;
+        text += take;
+        n -= take;
+    }
+}
+
+void ChunkWriter::printf(const char *fmt, ...) {
+    if (_failed) return;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        va_list args;
+        va_start(args, fmt);
+        const int n = vsnprintf(_buf + _len, _cap - _len, fmt, args);
+        va_end(args);
+        if (n < 0) {
+            _failed = true;
+            return;
+        }
+        if ((size_t)n < _cap - _len) {
+            _len += (size_t)n;
+            _total += (size_t)n;
+            return;
+        }
+        // Did not fit: send what is buffered and retry on an empty buffer
+        if (attempt == 0 && (_len == 0 || !_flush())) break;
+    }
+    _failed = true;   // one formatted line longer than the whole buffer
+}
+
+bool ChunkWriter::finish() {
+    return _flush();
+}
+
+// ============================================================
+// /metrics
+// ============================================================
+static const char *RELAY_NAMES[] = {"heater", "refrig", "fan"};
+
+static void metricHeader(ChunkWriter &out, const char *name, const char *type, const char *help) {
+    out.printf("# HELP espota_%s %s\n# TYPE espota_%s %s\n", name, help, name, type);
+}
+
+static void temperatureSample(ChunkWriter &out, const char *sensor, float value, bool valid) {
+    if (valid) out.printf("espota_temperature_celsius{sensor=\"%s\"} %.2f\n", sensor, value);
+}
+
+bool renderMetrics(const LanStatus &s, ChunkWriter &out) {
+    const TelemetrySnapshot &t = s.t;
+
+    metricHeader(out, "build_info", "gauge", "Firmware version");
+    out.printf("espota_build_info{version=\"" FIRMWARE_VERSION "\"} 1\n");
+
+    metricHeader(out, "temperature_celsius", "gauge", "Filtered temperature of each valid sensor");
+    temperatureSample(out, "temp1", t.temp1, t.temp1Valid);
+    temperatureSample(out, "temp2", t.temp2, t.temp2Valid);
+    temperatureSample(out, "ambient", t.ambientTemp, t.ambientValid);
+    for (uint8_t i = 0; i < t.probeCount; i++) {
+        temperatureSample(out, t.probeName[i], t.probeTemp[i], t.probeValid[i]);
+    }
+
+    metricHeader(out, "sensor_valid", "gauge", "1 while the sensor delivers plausible readings");
+    out.printf("espota_sensor_valid{sensor=\"temp1\"} %d\n", t.temp1Valid ? 1 : 0);
+    out.printf("espota_sensor_valid{sensor=\"temp2\"} %d\n", t.temp2Valid ? 1 : 0);
+    out.printf("espota_sensor_valid{sensor=\"ambient\"} %d\n", t.ambientValid ? 1 : 0);
+    for (uint8_t i = 0; i < t.probeCount; i++) {
+        out.printf("espota_sensor_valid{sensor=\"%s\"} %d\n", t.probeName[i], t.probeValid[i] ? 1 : 0);
+    }
+
+    if (t.ambientValid) {
+        metricHeader(out, "humidity_percent", "gauge", "Ambient relative humidity");
+        out.printf("espota_humidity_percent %.2f\n", t.ambientHumidity);
+    }
+
+    metricHeader(out, "relay_on", "gauge", "Relay output state");
+    const bool relays[] = {t.heaterOn, t.refrigOn, t.fanOn};
+    for (int i = 0; i < 3; i++) {
+        out.printf("espota_relay_on{relay=\"%s\"} %d\n", RELAY_NAMES[i], relays[i] ? 1 : 0);
+    }
+
+    metricHeader(out, "auto_mode", "gauge", "1 = automatic control, 0 = manual");
+    out.printf("espota_auto_mode %d\n", t.autoMode ? 1 : 0);
+
+    metricHeader(out, "setpoint_celsius", "gauge", "Control thresholds");
+    out.printf("espota_setpoint_celsius{setpoint=\"heater_on\"} %.2f\n", s.heaterOnTemp);
+    out.printf("espota_setpoint_celsius{setpoint=\"heater_off\"} %.2f\n", s.heaterOffTemp);
+    out.printf("espota_setpoint_celsius{setpoint=\"refrig_on\"} %.2f\n", s.refrigOnTemp);
+    out.printf("espota_setpoint_celsius{setpoint=\"refrig_off\"} %.2f\n", s.refrigOffTemp);
+
+    metricHeader(out, "wifi_rssi_dbm", "gauge", "WiFi signal strength");
+    out.printf("espota_wifi_rssi_dbm %ld\n", (long)t.rssi);
+
+    metricHeader(out, "heap_free_bytes", "gauge", "Free heap");
+    out.printf("espota_heap_free_bytes %lu\n", (unsigned long)t.freeHeap);
+    metricHeader(out, "heap_min_free_bytes", "gauge", "Lowest free heap since boot");
+    out.printf("espota_heap_min_free_bytes %lu\n", (unsigned long)t.minFreeHeap);
+    metricHeader(out, "heap_largest_block_bytes", "gauge", "Largest free heap block");
+    out.printf("espota_heap_largest_block_bytes %lu\n", (unsigned long)t.maxAllocHeap);
+
+    metricHeader(out, "uptime_seconds", "counter", "Time since boot");
+    out.printf("espota_uptime_seconds %lu\n", (unsigned long)t.uptimeS);
+
+    metricHeader(out, "network_loop_iterations_total", "counter", "Network task passes");
+    out.printf("espota_network_loop_iterations_total %lu\n", (unsigned long)s.loopIterations);
+    metricHeader(out, "network_loop_seconds_total", "counter", "Time spent in network task passes");
+    out.printf("espota_network_loop_seconds_total %.6f\n", s.loopTotalUs / 1e6);
+    metricHeader(out, "network_loop_max_seconds", "gauge", "Longest pass in the current stats interval");
+    out.printf("espota_network_loop_max_seconds %.6f\n", s.loopMaxUs / 1e6);
+
+    if (s.hasLatency) {
+        metricHeader(out, "stage_latency_seconds", "summary", "Per-stage latency since boot");
+        for (int i = 0; i < LAT_STAGE_COUNT; i++) {
+            const LatencySummary &l = s.latency[i];
+            if (l.count == 0) continue;
+            const char *stage = LatencyProfiler::stageName((LatencyStage)i);
+            out.printf("espota_stage_latency_seconds{stage=\"%s\",quantile=\"0.5\"} %.6f\n", stage, l.p50Us / 1e6);
+            out.printf("espota_stage_latency_seconds{stage=\"%s\",quantile=\"0.95\"} %.6f\n", stage, l.p95Us / 1e6);
+            out.printf("espota_stage_latency_seconds{stage=\"%s\",quantile=\"0.99\"} %.6f\n", stage, l.p99Us / 1e6);
+            out.printf("espota_stage_latency_seconds{stage=\"%s\",quantile=\"1\"} %.6f\n", stage, l.maxUs / 1e6);
+            out.printf("espota_stage_latency_seconds_count{stage=\"%s\"} %lu\n", stage, (unsigned long)l.count);
+        }
+    }
+    return out.finish();
+}
+
+// ============================================================
+// /state
+// ============================================================
+static void jsonTemperature(ChunkWriter &out, const char *key, float value, bool valid, bool comma) {
+    if (valid) {
+        out.printf("%s\"%s\":%.2f", comma ? "," : "", key, value);
+    } else {
+        out.printf("%s\"%s\":null", comma ? "," : "", key);
+    }
+}
+
+bool renderState(const LanStatus &s, ChunkWriter &out) {
+    const TelemetrySnapshot &t = s.t;
+
+    out.write("{\"sensors\":{");
+    jsonTemperature(out, "temp1", t.temp1, t.temp1Valid, false);
+    jsonTemperature(out, "temp2", t.temp2, t.temp2Valid, true);
+    jsonTemperature(out, "ambient_temp", t.ambientTemp, t.ambientValid, true);
+    jsonTemperature(out, "ambient_humidity", t.ambientHumidity, t.ambientValid, true);
+    for (uint8_t i = 0; i < t.probeCount; i++) {
+        jsonTemperature(out, t.probeName[i], t.probeTemp[i], t.probeValid[i], true);
+    }
+    out.write("},");
+
+    out.printf("\"relays\":{\"heater\":%s,\"refrig\":%s,\"fan\":%s,\"auto_mode\":%s},",
+               t.heaterOn ? "true" : "false", t.refrigOn ? "true" : "false",
+               t.fanOn ? "true" : "false", t.autoMode ? "true" : "false");
+    out.printf("\"settings\":{\"heater_on_temp\":%.2f,\"heater_off_temp\":%.2f,"
+               "\"refrig_on_temp\":%.2f,\"refrig_off_temp\":%.2f},",
+               s.heaterOnTemp, s.heaterOffTemp, s.refrigOnTemp, s.refrigOffTemp);
+    out.printf("\"status\":{\"firmware\":\"" FIRMWARE_VERSION "\",\"rssi\":%ld,\"free_heap\":%lu,"
+               "\"min_free_heap\":%lu,\"largest_free_block\":%lu,\"uptime_s\":%lu,\"epoch\":%lu},",
+               (long)t.rssi, (unsigned long)t.freeHeap, (unsigned long)t.minFreeHeap,
+               (unsigned long)t.maxAllocHeap, (unsigned long)t.uptimeS, (unsigned long)t.epoch);
+    out.printf("\"loop\":{\"iterations\":%lu,\"avg_us\":%lu,\"max_us\":%lu}",
+               (unsigned long)s.loopIterations,
+               (unsigned long)(s.loopIterations ? s.loopTotalUs / s.loopIterations : 0),
+               (unsigned long)s.loopMaxUs);
+
+    if (s.hasLatency) {
+        out.write(",\"latency_ms\":{");
+        bool first = true;
+        for (int i = 0; i < LAT_STAGE_COUNT; i++) {
+            const LatencySummary &l = s.latency[i];
+            if (l.count == 0) continue;
+            out.printf("%s\"%s\":{\"n\":%lu,\"p50\":%.2f,\"p95\":%.2f,\"p99\":%.2f,\"max\":%.2f}",
+                       first ? "" : ",", LatencyProfiler::stageName((LatencyStage)i),
+                       (unsigned long)l.count, l.p50Us / 1000.0, l.p95Us / 1000.0,
+                       l.p99Us / 1000.0, l.maxUs / 1000.0);
+            first = false;
+        }
+        out.write("}");
+    }
+    out.write("}\n");
+    return out.finish();
+}
@@ -0,0 +1,117 @@
+// ============================================================
+// PER-STAGE LATENCY HISTOGRAMS
+// See latency_profiler.h
+// ============================================================
+
+#include "latency_profiler.h"
+#include "logger.h"
+#include "telemetry.h"
+#include <stdio.h>
+#include <string.h>
+
+LatencyProfiler latencyProfiler;
+
+static const char *STAGE_NAMES[LAT_STAGE_COUNT] = {
+    "wifi", "telnet", "net_pass", "sensors", "ds18b20", "fb_pull", "push",
+    "relays", "ota_check", "cmd_relay"};
+
+// ============================================================
+// HISTOGRAM
+// Buckets 0..3 hold 0..3 us exactly; above that every power of
+// two [2^m, 2^(m+1)) is split into 4 equal sub-buckets
+// ============================================================
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+void LatencyHistogram::reset() {
+    memset(_counts, 0, sizeof(_counts));
+    _count = 0;
+    _maxUs = 0;
+}
+
+uint8_t LatencyHistogram::bucketOf(uint32_t us) {
+    if (us < 4) return (uint8_t)us;
+    const uint32_t msb = 31 - __builtin_clz(us);
+    const uint32_t bucket = (msb - 1) * 4 + ((us >> (msb - 2)) & 3);
+    return bucket < LATENCY_BUCKETS ? (uint8_t)bucket : LATENCY_BUCKETS - 1;
+}
+
+uint32_t LatencyHistogram::bucketUpperUs(uint8_t bucket) {
+    if (bucket < 4) return bucket;
+    const uint32_t msb = bucket / 4 + 1;
+    const uint32_t lower = (4u + (bucket & 3)) << (msb - 2);
+    return lower + (1u << (msb - 2)) - 1;
+}
+
+void LatencyHistogram::record(uint32_t us) {
+    _counts[bucketOf(us)]++;
+    _count++;
+    if (us > _maxUs) _maxUs = us;
+}
+
+uint32_t LatencyHistogram::percentileUs(uint8_t pct) const {
+    // Rank from the buckets themselves, consistent even mid-record
+    uint32_t total = 0;
+    for (uint8_t b = 0; b < LATENCY_BUCKETS; b++) total += _counts[b];
+    if (total == 0) return 0;
+
+    const uint32_t rank = (uint32_t)(((uint64_t)total * pct + 99) / 100);
+    uint32_t seen = 0;
+    for (uint8_t b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += _counts[b];
+        if (seen >= rank) {
+            const uint32_t upper = bucketUpperUs(b);
+            return upper < _maxUs ? upper : _maxUs;
+        }
+    }
+    return _maxUs;
+}
+
+// ============================================================
+// PROFILER
+// ============================================================
+LatencySummary LatencyProfiler::summary(LatencyStage stage) const {
+    const LatencyHistogram &h = _stages[stage];
+    LatencySummary s;
+    s.count = h.count();
+    s.p50Us = h.percentileUs(50);
+    s.p95Us = h.percentileUs(95);
+    s.p99Us = h.percentileUs(99);
+    s.maxUs = h.maxUs();
+    return s;
+}
+
+const char *LatencyProfiler::stageName(LatencyStage stage) {
+    return STAGE_NAMES[stage];
+}
+
+void LatencyProfiler::report() const {
+#if LATENCY_BENCH_ENABLED
+    for (int i = 0; i < LAT_STAGE_COUNT; i++) {
+        const LatencySummary s = summary((LatencyStage)i);
+        if (s.count == 0) continue;
+        char line[128];
+        snprintf(line, sizeof(line),
+                 "[PERF] latency %-9s n %lu  p50 %.2f  p95 %.2f  p99 %.2f  max %.2f ms",
+                 STAGE_NAMES[i], (unsigned long)s.count, s.p50Us / 1000.0, s.p95Us / 1000.0,
+                 s.p99Us / 1000.0, s.maxUs / 1000.0);
+        Log.println(line);
+    }
+#endif
+}
+
+bool LatencyProfiler::buildSummary(TelemetryPayload &payload) const {
+    payload.reset();
+    for (int i = 0; i < LAT_STAGE_COUNT; i++) {
+        const LatencySummary s = summary((LatencyStage)i);
+        if (s.count == 0) continue;
+        char path[40];
+        char value[48];
+        snprintf(path, sizeof(path), "status/latency_ms/%s", STAGE_NAMES[i]);
+        snprintf(value, sizeof(value), "%.1f/%.1f/%.1f/%.1f", s.p50Us / 1000.0,
+                 s.p95Us / 1000.0, s.p99Us / 1000.0, s.maxUs / 1000.0);
+        payload.addString(path, value);
+    }
+    return payload.fieldCount() > 0 && payload.finish();
+}
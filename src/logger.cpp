@@ -0,0 +1,176 @@
+// ============================================================
+// SERIAL + TELNET LOGGER
+// Ring buffer + drain task, see logger.h
+// ============================================================
+
+#include "logger.h"
+#include <stdarg.h>
+
+#if defined(ARDUINO)
+
+WiFiSerialLogger Log;
+
+WiFiSerialLogger::WiFiSerialLogger()
+    : droppedWrites_(0), droppedBytes_(0) {
+    portMUX_INITIALIZE(&ringMux_);
+}
+
+void WiFiSerialLogger::attachSerial(HardwareSerial *serial) {
+    if (!lock_) lock_ = xSemaphoreCreateRecursiveMutex();
+    serial_ = serial;
+}
+
+bool WiFiSerialLogger::startDrain() {
+    if (drainTask_) return true;
+    return xTaskCreatePinnedToCore(drainTaskEntry, "log", LOG_DRAIN_TASK_STACK_BYTES, this,
+                                   LOG_DRAIN_TASK_PRIORITY, &drainTask_, LOG_DRAIN_TASK_CORE) == pdPASS;
+}
+
+// ============================================================
+// PRODUCER SIDE (any task)
+// Multiple producers, so space is reserved and filled inside a
+// short spinlock section: a bounded memcpy, never any I/O
+// ============================================================
+// data and suffix go in as one record: both fit or both are dropped
+size_t WiFiSerialLogger::enqueue(const uint8_t *data, size_t len, const uint8_t *suffix, size_t suffixLen) {
+    const size_t size = len + suffixLen;
+    if (!drainTask_) {
+        lock();
+        writeOut(data, len);
+        if (suffixLen) writeOut(suffix, suffixLen);
+        unlock();
+        return size;
+    }
+
+    const uint32_t startCycles = ESP.getCycleCount();
+    uint32_t fill = 0;
+
+    portENTER_CRITICAL(&ringMux_);
+    const bool accepted = ring_.push(data, len, suffix, suffixLen, fill);
+    enqueueCount_++;
+    enqueueCycles_ += ESP.getCycleCount() - startCycles;
+    portEXIT_CRITICAL(&ringMux_);
+
+    if (!accepted) {
+        droppedWrites_.fetch_add(1, std::memory_order_relaxed);
+        droppedBytes_.fetch_add(size, std::memory_order_relaxed);
+        return size;   // reported as written: callers must not retry
+    }
+    if (fill >= LOG_RING_BYTES / 2) {
+        xTaskNotifyGive(drainTask_);   // wake early instead of waiting a full interval
+    }
+    return size;
+}
+
+size_t WiFiSerialLogger::println(const char *line) {
+    return enqueue((const uint8_t *)line, strlen(line), (const uint8_t *)"\r\n", 2);
+}
+
+// ============================================================
+// DRAIN SIDE (drain task, or flush())
+// ============================================================
+void WiFiSerialLogger::drainTaskEntry(void *param) {
+    WiFiSerialLogger *self = static_cast<WiFiSerialLogger *>(param);
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LOG_DRAIN_INTERVAL_MS));
+        while (self->drainOnce() > 0) {
+        }
+    }
+}
+
+// Writes one contiguous run straight from the ring (no copy).
+// Runs under lock(): flush() may consume concurrently with the drain task.
+size_t WiFiSerialLogger::drainOnce() {
+    lock();
+    const uint32_t drops = droppedWrites();
+    if (drops != reportedDrops_) {
+        char note[64];
+        const int n = snprintf(note, sizeof(note), "\r\n[LOG] %u writes dropped (ring full)\r\n",
+                               (unsigned)(drops - reportedDrops_));
+        reportedDrops_ = drops;
+        writeOut((const uint8_t *)note, n);
+    }
+
+    const uint8_t *run = nullptr;
+    const size_t len = ring_.peek(run);
+    if (len > 0) {
+        const uint32_t startCycles = ESP.getCycleCount();
+        writeOut(run, len);
+        drainCycles_ += ESP.getCycleCount() - startCycles;
+        drainedBytes_ += len;
+        ring_.consume(len);
+    }
+    unlock();
+    return len;
+}
+
+void WiFiSerialLogger::writeOut(const uint8_t *data, size_t len) {
+    if (serial_) {
+        serial_->write(data, len);
+    }
+    if (client_ && client_->connected()) {
+        client_->write(data, len);
+    }
+}
+
+// ============================================================
+// FORMATTED LINES (LOGx macros)
+// ============================================================
+void WiFiSerialLogger::logf(uint8_t level, const char *tag, const char *fmt, ...) {
+    char line[LOG_LINE_MAX];
+    const size_t room = sizeof(line) - 2;   // keep space for "\r\n"
+
+    int n = snprintf(line, room, (level <= LOG_WARN) ? "[%s] [!] " : "[%s] ", tag);
+    if (n < 0) return;
+    if ((size_t)n >= room) n = room - 1;
+
+    va_list args;
+    va_start(args, fmt);
+    const int m = vsnprintf(line + n, room - n, fmt, args);
+    va_end(args);
+    if (m > 0) n += min((size_t)m, room - n - 1);   // truncated lines keep their CRLF
+
+    line[n++] = '\r';
+    line[n++] = '\n';
+    write((const uint8_t *)line, n);
+}
+
+void WiFiSerialLogger::flush() {
+    if (drainTask_) {
+        while (drainOnce() > 0) {
+        }
+    }
+    if (serial_) serial_->flush();
+}
+
+void WiFiSerialLogger::report() {
+    portENTER_CRITICAL(&ringMux_);
+    const uint32_t count = enqueueCount_;
+    const uint64_t cycles = enqueueCycles_;
+    portEXIT_CRITICAL(&ringMux_);
+
+    const uint32_t avgEnqueue = count ? (uint32_t)(cycles / count) : 0;
+    const uint32_t avgDrainPerKB = drainedBytes_ ? (uint32_t)(drainCycles_ * 1024 / drainedBytes_) : 0;
+    println("[PERF] log: " + String(count) + " writes, enqueue avg " + String(avgEnqueue) +
+            " cycles, direct I/O avg " + String(avgDrainPerKB) + " cycles/KB" +
+            ", dropped " + String(droppedWrites()) + " writes / " + String(droppedBytes()) + " bytes");
+}
+
+#else
+#include <stdio.h>
+
+HostLogger Log;
+
+void HostLogger::logf(uint8_t level, const char *tag, const char *fmt, ...) {
+    printf((level <= LOG_WARN) ? "[%s] [!] " : "[%s] ", tag);
+    va_list args;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+    putchar('\n');
+}
+
+void HostLogger::println(const char *line) {
+    puts(line);
+}
+#endif
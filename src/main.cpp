@@ -7,17 +7,33 @@
 #include <WiFi.h>
 #include <WiFiManager.h>
 #include <HTTPClient.h>
-#include <Update.h>
 #include <ArduinoJson.h>
 #include <Wire.h>
-#include <OneWire.h>
-#include <DallasTemperature.h>
-#include <Adafruit_SHT31.h>
 #include <Firebase_ESP_Client.h>
 #include "addons/TokenHelper.h"   // Firebase token callback
 #include "addons/RTDBHelper.h"    // Firebase RTDB utility
 #include <time.h>                 // NTP time sync
 #include "config.h"
+#include "telemetry.h"
+#include "task_scheduler.h"
+#include "spsc_queue.h"
+#include "state_snapshot.h"
+#include "logger.h"
+#include "ota_manager.h"
+#include "https_pool.h"
+#include "heap_monitor.h"
+#include "telemetry_backlog.h"
+#include "timeseries.h"
+#include "sensor_filter.h"
+#include "sensor_registry.h"
+#include "controller.h"
+#include "hal.h"
+#include "latency_profiler.h"
+#include "cycle_profiler.h"
+#include "lan_http.h"
+#include "transport.h"
+#include "mqtt_transport.h"
+#include <atomic>
 
 // ============================================================
 // WIRELESS SERIAL MONITOR (TELNET)
@@ -29,102 +45,165 @@ WiFiServer telnetServer(TELNET_LOG_PORT);
 WiFiClient telnetClient;
 bool telnetServerStarted = false;
 
-class WiFiSerialLogger : public Print {
-public:
-    WiFiSerialLogger() = default;
-
-    void attachSerial(HardwareSerial *serial) { serial_ = serial; }
-    void setClient(WiFiClient *client) { client_ = client; }
-
-    size_t write(uint8_t b) override {
-        if (serial_) {
-            serial_->write(b);
-        }
-        if (client_ && client_->connected()) {
-            client_->write(b);
-        }
-        return 1;
-    }
-
-    size_t write(const uint8_t *buffer, size_t size) override {
-        if (serial_) {
-            serial_->write(buffer, size);
-        }
-        if (client_ && client_->connected()) {
-            client_->write(buffer, size);
-        }
-        return size;
-    }
-
-private:
-    HardwareSerial *serial_ = nullptr;
-    WiFiClient *client_ = nullptr;
-};
-
-WiFiSerialLogger Log;
 
 // NTP Configuration
 #define NTP_SERVER      "pool.ntp.org"
 #define GMT_OFFSET_SEC  19800       // IST = GMT+5:30 = 5.5*3600
 #define DAYLIGHT_OFFSET 0
 
-// ============================================================
-// HARDWARE OBJECTS
-// ============================================================
-OneWire         oneWire1(PIN_TEMP_SENSOR1);
-OneWire         oneWire2(PIN_TEMP_SENSOR2);
-DallasTemperature tempSensor1(&oneWire1);
-DallasTemperature tempSensor2(&oneWire2);
-Adafruit_SHT31  sht30;  // Library works for both SHT30/SHT31
-
 // ============================================================
 // FIREBASE OBJECTS
 // ============================================================
+// fbdo carries telemetry unless batched PATCHes go through the pool;
+// otherwise it only needs a session for boot writes and polling
+#define FBDO_CARRIES_PUSHES (!FIREBASE_BATCHED_PUSH || !FIREBASE_PATCH_VIA_POOL)
+
 FirebaseData    fbdo;
 FirebaseAuth    fbAuth;
 FirebaseConfig  fbConfig;
 bool            firebaseReady = false;
+TelemetryTracker telemetryTracker;   // last published values for delta pushes
 
 // ============================================================
 // WIFI
 // ============================================================
 WiFiManager wifiManager;
-bool        provisioningMode = false;
 
 // ============================================================
-// TIMERS
+// TIMERS / SCHEDULER
 // ============================================================
-unsigned long lastOTACheck      = 0;
-unsigned long lastFirebaseUpdate = 0;
-unsigned long lastSensorRead    = 0;
-unsigned long bootStartMillis   = 0;
-unsigned long lastRelayControlRead = 0;
+static uint32_t schedulerClock() { return millis(); }
+TaskScheduler controlScheduler(schedulerClock);   // runs in controlTask
+TaskScheduler networkScheduler(schedulerClock);   // runs in networkTask
 
 // ============================================================
-// SENSOR READINGS
+// SENSOR READINGS (owned by the control task)
 // ============================================================
-float temp1           = -127.0f;   // DS18B20 sensor 1
-float temp2           = -127.0f;   // DS18B20 sensor 2
-float ambientTemp     = -127.0f;   // SHT30 temperature
-float ambientHumidity = 0.0f;      // SHT30 humidity
+// Filtered channels, 1/100 units; temp1/temp2/ambientTemp/ambientHumidity
+// (controller.h) are their output
+// (DS18B20 probes are filtered in sensorRegistry)
+static const SensorChannelConfig AMBIENT_FILTER = {
+    -3999, 12499, AMBIENT_MAX_RATE_CENTI_PER_S, SENSOR_FILTER_MIN_STEP_CENTI, SENSOR_STALE_MS};
+static const SensorChannelConfig HUMIDITY_FILTER = {
+    0, 10000, HUMIDITY_MAX_RATE_CENTI_PER_S, SENSOR_FILTER_MIN_STEP_CENTI, SENSOR_STALE_MS};
+SensorChannel<> ambientFilter(AMBIENT_FILTER);
+SensorChannel<> humidityFilter(HUMIDITY_FILTER);
+
+// DS18B20 asynchronous conversion (all probes on both buses convert in parallel)
+bool          dsConversionPending     = false;
+unsigned long dsConversionStartMillis = 0;
+unsigned long dsConversionTimeMs      = 750;   // set from resolution at init
 
 // ============================================================
-// RELAY / LED STATES
+// LOOP LATENCY
 // ============================================================
-bool heaterOn = false;
-bool refrigOn = false;
-bool fanOn    = false;
-bool autoRelayControl = RELAY_CONTROL_DEFAULT_AUTO_MODE;
+uint32_t      loopStatsCount       = 0;
+uint64_t      loopStatsTotalUs     = 0;
+uint32_t      loopStatsMaxUs       = 0;
+uint32_t      loopLifetimeCount    = 0;   // since boot, for /metrics counters
+uint64_t      loopLifetimeUs       = 0;
 
-// Fan cycle state (2 min ON / 1 min OFF)
-unsigned long fanCycleStartMillis = 0;
-bool fanCycleOnPhase = true;
+// ============================================================
+// REMOTE CONTROL FIELDS
+// - Produced by the stream callback (Firebase stream task) or the
+//   poll fallback / MQTT subscriptions (network task), consumed by
+//   the control task
+//   through applyRemoteUpdates()
+// ============================================================
+enum RemoteField : uint8_t {
+    RF_AUTO_MODE = 0,
+    RF_HEATER_CMD,
+    RF_REFRIG_CMD,
+    RF_FAN_CMD,
+    RF_HEATER_ON_TEMP,
+    RF_HEATER_OFF_TEMP,
+    RF_REFRIG_ON_TEMP,
+    RF_REFRIG_OFF_TEMP,
+    RF_COUNT
+};
+
+static const size_t FB_BASE_PATH_LEN = sizeof(FIREBASE_BASE_PATH) - 1;
+
+// Absolute paths, indexed by RemoteField; "+ FB_BASE_PATH_LEN" gives the
+// child path relative to FIREBASE_BASE_PATH (stream events)
+static const char *const REMOTE_FIELD_PATHS[RF_COUNT] = {
+    FB_PATH("/relays/auto_mode"),
+    FB_PATH("/relays/control/heater"),
+    FB_PATH("/relays/control/refrig"),
+    FB_PATH("/relays/control/fan"),
+    FB_PATH("/settings/heater_onTemp"),
+    FB_PATH("/settings/heater_offTemp"),
+    FB_PATH("/settings/refrig_onTemp"),
+    FB_PATH("/settings/refrig_offTemp"),
+};
 
-// Dynamic Setpoints
-float heaterOnTemp   = DEFAULT_HEATER_ON_TEMP_C;
-float heaterOffTemp  = DEFAULT_HEATER_OFF_TEMP_C;
-float refrigOnTemp   = DEFAULT_REFRIG_ON_TEMP2_C;
-float refrigOffTemp  = DEFAULT_REFRIG_OFF_TEMP2_C;
+// Server-sent events subscription on the device node. relays/ and
+// settings/ have no closer common parent, and a stream per subtree
+// would hold another ~40 KB TLS session, so events for telemetry
+// and status writes are filtered out by path in the callback
+FirebaseData      fbStream;
+bool              fbStreamStarted = false;
+std::atomic<bool> fbStreamTimedOut(false);
+unsigned long     lastStreamBeginAttempt = 0;
+
+// ============================================================
+// TASKS & INTER-TASK EXCHANGE
+// - controlTask (CONTROL_TASK_CORE, high priority): sensors,
+//   control decisions, relay outputs, safety overrides
+// - networkTask (NETWORK_TASK_CORE): WiFi, telnet, Firebase, OTA
+// - Commands flow in through lock-free SPSC queues (one per
+//   producer task), state flows out through a seqlock
+//   (StateSnapshot: whole copies, readers retry on a torn read)
+// ============================================================
+struct RemoteCommand {
+    RemoteField field;
+    float       value;      // bools stored as 0/1
+    uint32_t    queuedUs;   // micros() when it reached the device
+};
+
+typedef SpscQueue<RemoteCommand, REMOTE_COMMAND_QUEUE_SIZE> RemoteCommandQueue;
+
+RemoteCommandQueue streamCommandQueue;   // Firebase stream task -> control
+RemoteCommandQueue pollCommandQueue;     // network task (poll, MQTT) -> control
+
+struct ControlSnapshot {
+    float    temp1;
+    float    temp2;
+    float    ambientTemp;
+    float    ambientHumidity;
+    bool     heaterOn;
+    bool     refrigOn;
+    bool     fanOn;
+    bool     autoMode;
+    float    heaterOnTemp;
+    float    heaterOffTemp;
+    float    refrigOnTemp;
+    float    refrigOffTemp;
+    uint8_t  probeCount;                      // DS18B20 probes besides temp1/temp2
+    const char *probeName[SENSOR_PROBES_MAX]; // registry storage, fixed once named
+    float    probeTemp[SENSOR_PROBES_MAX];    // -127 = no recent good sample
+    uint32_t updatedMillis;
+};
+
+StateSnapshot<ControlSnapshot> controlSnapshot;   // control -> network
+
+// ============================================================
+// LOCAL HISTORY (written by the network task only)
+// ============================================================
+static_assert(HISTORY_PARTITION_OFFSET >= TELEMETRY_BACKLOG_PARTITION_OFFSET + TELEMETRY_BACKLOG_BYTES,
+              "history slice overlaps the telemetry backlog");
+static const TsConfig HISTORY_CONFIG = {
+    HISTORY_SAMPLE_PERIOD_S,
+    HISTORY_SEAL_INTERVAL_S,
+    HISTORY_BLOCK_MAX_BYTES,
+    {HISTORY_DEADBAND_TEMP_DECI, HISTORY_DEADBAND_TEMP_DECI, HISTORY_DEADBAND_TEMP_DECI, HISTORY_DEADBAND_RH_DECI},
+};
+EspPartitionRegion historyRegion;
+TimeSeriesStore    history(historyRegion, HISTORY_CONFIG);
+bool               historyReady = false;
+
+TaskHandle_t controlTaskHandle = nullptr;
+TaskHandle_t networkTaskHandle = nullptr;
 
 // ============================================================
 // FUNCTION DECLARATIONS
@@ -132,26 +211,51 @@ float refrigOffTemp  = DEFAULT_REFRIG_OFF_TEMP2_C;
 void initializePins();
 void initializeSensors();
 void initializeFirebase();
+void initializeTransport();
+bool telemetryOnline();
+void onTransportCommand(const char *path, const char *value);
 void initializeWiFi();
 void setupWiFiCallbacks();
 bool hasValidAPPassword();
 bool startProvisioningPortal();
 void handleTelnetLogger();
-bool shouldHoldRelaysOff();
-void enforceRelaysOff();
 void readSensors();
-void updateAutomaticControl();
-void updateFanCycle();
-void applyRelayStates();
-void setAllLedsImmediate(bool on);
-void writeRelay(uint8_t pin, bool on, bool activeLow);
-bool isValidDs18b20(float value);
-bool isValidAmbientTemp(float value);
-void pushToFirebase();
-void updateRelayControlModeFromFirebase();
+void startTemperatureConversion();
+bool serviceTemperatureConversion();
+void sampleAmbientTask();
+float filteredOrInvalid(const SensorChannel<> *filter);
+void reportSensorFilters();
+void recordLoopLatency(uint32_t elapsedUs);
+void reportLoopLatency();
+void controlTask();
+void remoteControlPollTask();
+void wifiWatchdogTask();
+void firebasePushTask();
+void otaCheckTask();
+void otaMonitorTask();
+void httpsPoolTask();
+void statsReportTask();
+bool pushToFirebase();
+void fillTelemetrySnapshot(const ControlSnapshot &cs, TelemetrySnapshot &snap);
+void recordBacklogSample();
+void backlogUploadTask();
+void latencyPushTask();
+void fillLanStatus(LanStatus &status);
+void initializeHistory();
+void historyTask();
+void reportHistory();
+bool updateRelayControlModeFromFirebase();
 void readRelayCommandsFromFirebase();
-void checkForUpdates();
-void performOTAUpdate(String firmwareUrl, String expectedSha256);
+void beginRemoteControlStream();
+bool isRemoteControlStreamHealthy();
+void queueRemoteField(RemoteCommandQueue &queue, RemoteField field, float value);
+bool applyRemoteUpdates(uint32_t &oldestQueuedUs);
+void publishControlSnapshot();
+void controlTaskMain(void *param);
+void networkTaskMain(void *param);
+void registerControlTasks();
+void registerNetworkTasks();
+void controlStatsTask();
 
 // ============================================================
 // SETUP
@@ -164,6 +268,7 @@ void setup() {
 
     Log.attachSerial(&Serial);
     Log.setClient(&telnetClient);
+    Log.startDrain();
 
     Log.println("\n\n================================");
     Log.println("ESP32 TEMP CONTROL v" FIRMWARE_VERSION);
@@ -173,6 +278,17 @@ void setup() {
     initializePins();
     initializeSensors();
 
+    // Start fan cycle in ON phase
+    fanCycleStartMillis = millis();
+    fanCycleOnPhase = true;
+    enforceRelaysOff();
+    publishControlSnapshot();
+
+    // Control runs from here on, even while the provisioning portal blocks
+    registerControlTasks();
+    xTaskCreatePinnedToCore(controlTaskMain, "control", CONTROL_TASK_STACK_BYTES, nullptr,
+                            CONTROL_TASK_PRIORITY, &controlTaskHandle, CONTROL_TASK_CORE);
+
     Log.println("[*] Initializing WiFi provisioning...");
     initializeWiFi();
 
@@ -186,113 +302,369 @@ void setup() {
         } else {
             Log.println("[!] NTP sync failed - timestamps may be inaccurate");
         }
-        initializeFirebase();
+        initializeTransport();
     }
 
-    lastOTACheck      = millis();
-    lastFirebaseUpdate = millis();
-    lastSensorRead    = millis();
-    lastRelayControlRead = millis();
+    httpsPool.begin();
+    transport->setCommandHandler(onTransportCommand);
+    lanHttp.setStatusProvider(fillLanStatus);
+#if TELEMETRY_BACKLOG_ENABLED
+    telemetryBacklog.begin();
+#endif
+#if HISTORY_ENABLED
+    initializeHistory();
+#endif
+    otaManager.begin();
 
-    // Start fan cycle in ON phase
-    fanCycleStartMillis = millis();
-    fanCycleOnPhase = true;
-    enforceRelaysOff();
+    registerNetworkTasks();
+    xTaskCreatePinnedToCore(networkTaskMain, "network", NETWORK_TASK_STACK_BYTES, nullptr,
+                            NETWORK_TASK_PRIORITY, &networkTaskHandle, NETWORK_TASK_CORE);
 
-    Log.println("[OK] Setup complete - entering main loop");
+    Log.println("[OK] Setup complete - control + network tasks running");
     Log.println("================================\n");
 }
 
 // ============================================================
 // MAIN LOOP
+// - All work runs in controlTask / networkTask; the Arduino
+//   loop task is not needed after setup()
 // ============================================================
 void loop() {
-    wifiManager.process();
-    handleTelnetLogger();
-
-    // ----- WiFi watchdog: reconnect every 5 s if lost ------
-    static unsigned long lastWiFiCheck = 0;
-    if (millis() - lastWiFiCheck > 5000) {
-        lastWiFiCheck = millis();
-        if (WiFi.status() != WL_CONNECTED && !provisioningMode) {
-            Log.println("[!] WiFi lost - attempting reconnect...");
-
-            bool reconnected = false;
-            if (hasValidAPPassword()) {
-                reconnected = wifiManager.autoConnect(AP_SSID, AP_PASSWORD);
-            } else {
-                reconnected = wifiManager.autoConnect(AP_SSID);
-            }
+    vTaskDelete(nullptr);
+}
 
-            if (reconnected && WiFi.status() == WL_CONNECTED) {
-                Log.println("[OK] WiFi reconnected: " + WiFi.localIP().toString());
-                if (!firebaseReady) initializeFirebase();
-            } else {
-                Log.println("[!] Saved WiFi unavailable - starting visible provisioning hotspot");
-                if (startProvisioningPortal() && !firebaseReady) {
-                    initializeFirebase();
-                }
+// ============================================================
+// CONTROL TASK
+// ============================================================
+void controlTaskMain(void *param) {
+    (void)param;
+    heapMonitor.trackCurrentTask();
+    controlScheduler.start();
+
+    for (;;) {
+        bool worked = false;
+
+        // Remote changes are applied as soon as they are queued
+        uint32_t queuedUs = 0;
+        if (applyRemoteUpdates(queuedUs)) {
+            if (!shouldHoldRelaysOff()) {
+                runControlCycle();
+                latencyProfiler.record(LAT_COMMAND_TO_RELAY, micros() - queuedUs);
             }
+            worked = true;
         }
-    }
 
-    // ----- Read sensors every 2 s --------------------------
-    if (millis() - lastSensorRead > 2000) {
-        lastSensorRead = millis();
-        readSensors();
+        // Collect DS18B20 results once conversion time passed
+        worked |= serviceTemperatureConversion();
 
-        if (shouldHoldRelaysOff()) {
-            enforceRelaysOff();
-        } else {
-            const bool canReadRemoteControl = (WiFi.status() == WL_CONNECTED && firebaseReady);
-            if (canReadRemoteControl && (millis() - lastRelayControlRead >= RELAY_CONTROL_PULL_INTERVAL_MS)) {
-                lastRelayControlRead = millis();
-                updateRelayControlModeFromFirebase();
-                if (!autoRelayControl) {
-                    readRelayCommandsFromFirebase();
-                }
-            }
+        // Sensor/control tick (+ stats)
+        worked |= controlScheduler.runNext();
 
-            if (autoRelayControl) {
-                updateAutomaticControl();
-            } else {
-                // Manual Mode Safety Override: Force-cutoff if temps exceed set boundaries
-                if (isValidAmbientTemp(ambientTemp) && isValidDs18b20(temp2)) {
-                    float avgTemp = (ambientTemp + temp2) / 2.0f;
-                    if (heaterOn && avgTemp >= heaterOffTemp) {
-                        heaterOn = false;
-                        Serial.println("[SAFE] Manual override: Heater OFF (Avg >= " + String(heaterOffTemp, 1) + "°C)");
-                    }
-                }
-                if (isValidDs18b20(temp1)) {
-                    if (refrigOn && temp1 <= refrigOffTemp) {
-                        refrigOn = false;
-                        Serial.println("[SAFE] Manual override: Refrig OFF (temp1 <= " + String(refrigOffTemp, 1) + "°C)");
-                    }
-                }
-            }
-            applyRelayStates();
+        if (worked) {
+            publishControlSnapshot();
+            continue;   // more may be due; sleep only when idle
         }
-    }
 
-    // ----- Firebase: push sensor data -----------------------
-    if (WiFi.status() == WL_CONNECTED && firebaseReady) {
-        if (millis() - lastFirebaseUpdate > FIREBASE_UPDATE_INTERVAL_MS) {
-            lastFirebaseUpdate = millis();
-            pushToFirebase();
+        // Sleep until the next tick, the DS18B20 result, or a queued command
+        uint32_t waitMs = controlScheduler.msUntilNextDue();
+        if (dsConversionPending) {
+            const uint32_t elapsed = millis() - dsConversionStartMillis;
+            const uint32_t remaining = (elapsed < dsConversionTimeMs) ? (dsConversionTimeMs - elapsed) : 0;
+            if (remaining < waitMs) waitMs = remaining;
         }
+        if (waitMs > CONTROL_TASK_MAX_SLEEP_MS) waitMs = CONTROL_TASK_MAX_SLEEP_MS;
+        if (waitMs == 0) waitMs = 1;
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
+    }
+}
+
+void publishControlSnapshot() {
+    ControlSnapshot cs;
+    cs.temp1           = temp1;
+    cs.temp2           = temp2;
+    cs.ambientTemp     = ambientTemp;
+    cs.ambientHumidity = ambientHumidity;
+    cs.heaterOn        = heaterOn;
+    cs.refrigOn        = refrigOn;
+    cs.fanOn           = fanOn;
+    cs.autoMode        = autoRelayControl;
+    cs.heaterOnTemp    = heaterOnTemp;
+    cs.heaterOffTemp   = heaterOffTemp;
+    cs.refrigOnTemp    = refrigOnTemp;
+    cs.refrigOffTemp   = refrigOffTemp;
+    cs.probeCount      = 0;
+    const SensorProbe *probe1 = sensorRegistry.primary(0);
+    const SensorProbe *probe2 = sensorRegistry.primary(1);
+    for (size_t i = 0; i < sensorRegistry.count(); i++) {
+        const SensorProbe &p = sensorRegistry.probe(i);
+        if (&p == probe1 || &p == probe2) continue;
+        cs.probeName[cs.probeCount] = p.name;
+        cs.probeTemp[cs.probeCount] = filteredOrInvalid(&p.filter);
+        cs.probeCount++;
+    }
+    cs.updatedMillis   = millis();
+    controlSnapshot.publish(cs);
+}
+
+// ============================================================
+// NETWORK TASK
+// ============================================================
+void networkTaskMain(void *param) {
+    (void)param;
+    heapMonitor.trackCurrentTask();
+    networkScheduler.start();
+
+    for (;;) {
+        const uint32_t loopStartUs = micros();
+
+        wifiManager.process();
+        const uint32_t telnetStartUs = micros();
+        latencyProfiler.record(LAT_WIFI_PROCESS, telnetStartUs - loopStartUs);
+        handleTelnetLogger();
+        latencyProfiler.record(LAT_TELNET, micros() - telnetStartUs);
+        transport->service();
+#if LAN_HTTP_ENABLED
+        lanHttp.poll(WiFi.status() == WL_CONNECTED && !provisioningMode);
+#endif
+
+        // One due network task per pass
+        networkScheduler.runNext();
+
+        const uint32_t loopUs = micros() - loopStartUs;
+        recordLoopLatency(loopUs);
+        latencyProfiler.record(LAT_NETWORK_PASS, loopUs);
+        vTaskDelay(pdMS_TO_TICKS(NETWORK_TASK_POLL_MS));
+    }
+}
+
+// ============================================================
+// SCHEDULED TASKS
+// ============================================================
+
+// Sensor read + control decision + relay write
+void controlTask() {
+    const uint32_t allocsBefore = heapMonitor.taskAllocs();
+    const uint32_t startUs = micros();
+    readSensors();
+    latencyProfiler.record(LAT_READ_SENSORS, micros() - startUs);
+
+    if (shouldHoldRelaysOff()) {
+        enforceRelaysOff();
+    } else {
+        runControlCycle();
+    }
+    heapMonitor.endCycle(HEAP_CYCLE_CONTROL, allocsBefore);
+}
+
+// Poll relays/settings only as a fallback while the stream is down;
+// results are queued to the control task
+void remoteControlPollTask() {
+    if (WiFi.status() != WL_CONNECTED || !firebaseReady) return;
+
+#if RELAY_CONTROL_USE_STREAM
+    if (!fbStreamStarted && millis() - lastStreamBeginAttempt >= RELAY_CONTROL_STREAM_RETRY_MS) {
+        beginRemoteControlStream();
+    }
+#endif
+    if (shouldHoldRelaysOff()) return;
+    if (isRemoteControlStreamHealthy()) {
+#if !FBDO_CARRIES_PUSHES
+        if (fbdo.httpConnected()) fbdo.stopWiFiClient();   // stream is back: drop the poll session
+#endif
+        return;
+    }
+
+    const uint32_t allocsBefore = heapMonitor.taskAllocs();
+    const uint32_t startUs = micros();
+    if (!updateRelayControlModeFromFirebase()) {
+        readRelayCommandsFromFirebase();
+    }
+    latencyProfiler.record(LAT_FB_PULL, micros() - startUs);
+    heapMonitor.endCycle(HEAP_CYCLE_FB_POLL, allocsBefore);
+}
+
+// WiFi watchdog: reconnect if lost
+void wifiWatchdogTask() {
+    if (WiFi.status() == WL_CONNECTED || provisioningMode) return;
+
+    Log.println("[!] WiFi lost - attempting reconnect...");
+
+    bool reconnected = false;
+    if (hasValidAPPassword()) {
+        reconnected = wifiManager.autoConnect(AP_SSID, AP_PASSWORD);
+    } else {
+        reconnected = wifiManager.autoConnect(AP_SSID);
     }
 
-    // ----- OTA check ----------------------------------------
-    if (millis() - lastOTACheck > (OTA_CHECK_INTERVAL_SECONDS * 1000UL)) {
-        lastOTACheck = millis();
-        if (WiFi.status() == WL_CONNECTED) {
-            Log.println("\n[*] Checking for firmware updates...");
-            checkForUpdates();
+    if (reconnected && WiFi.status() == WL_CONNECTED) {
+        Log.println("[OK] WiFi reconnected: " + WiFi.localIP().toString());
+        initializeTransport();
+    } else {
+        Log.println("[!] Saved WiFi unavailable - starting visible provisioning hotspot");
+        if (startProvisioningPortal()) {
+            initializeTransport();
         }
     }
 }
 
+// Telemetry push (RTDB or MQTT)
+void firebasePushTask() {
+    if (telemetryOnline()) {
+        const uint32_t allocsBefore = heapMonitor.taskAllocs();
+        const uint32_t startUs = micros();
+        const bool pushed = pushToFirebase();
+        latencyProfiler.record(LAT_PUSH, micros() - startUs);
+        heapMonitor.endCycle(HEAP_CYCLE_FB_PUSH, allocsBefore);
+        if (pushed) return;
+    }
+    recordBacklogSample();   // offline or push failed: keep the sample
+}
+
+// OTA check; the download itself runs as a background job
+void otaCheckTask() {
+    if (WiFi.status() == WL_CONNECTED && !otaManager.isBusy() && otaManager.checkDue()) {
+        Log.println("\n[*] Checking for firmware updates...");
+        const uint32_t startUs = micros();
+        otaManager.checkForUpdates();
+        latencyProfiler.record(LAT_OTA_CHECK, micros() - startUs);
+    }
+}
+
+// OTA job monitor: signal + restart once the new image is in place
+void otaMonitorTask() {
+    if (otaManager.getState() != OTA_SUCCESS) return;
+
+    for (int i = 0; i < 5; i++) {
+        setAllLedsImmediate(true);
+        delay(100);
+        setAllLedsImmediate(false);
+        delay(100);
+    }
+    Log.println("[OK] OTA complete (" + String(otaManager.getBytesWritten()) + " bytes @ " +
+                String(otaManager.getThroughputBps() / 1024.0f, 1) + " KB/s) - restarting...");
+    if (historyReady) history.flush();   // keep the open block
+    Log.flush();
+    delay(3000);
+    ESP.restart();
+}
+
+// Close pooled HTTPS connections nobody has used for a while
+void httpsPoolTask() {
+    httpsPool.closeIdle();
+}
+
+// Per-task run time / lateness report for one scheduler
+static void reportSchedulerStats(TaskScheduler &sched) {
+    for (size_t i = 0; i < sched.taskCount(); i++) {
+        const ScheduledTask *t = sched.task((int)i);
+        const TaskStats &st = t->stats;
+        const uint32_t avgMs = st.runs ? (uint32_t)(st.totalRunMs / st.runs) : 0;
+        Log.println("[PERF] task " + String(t->name) + ": runs " + String(st.runs) +
+                    ", run avg/max " + String(avgMs) + "/" + String(st.maxRunMs) + " ms" +
+                    ", late max " + String(st.maxLatenessMs) + " ms" +
+                    ", missed " + String(st.deadlineMisses) +
+                    ", skipped " + String(st.skippedPeriods));
+    }
+    sched.resetStats();
+}
+
+// Network loop latency + network task stats (runs in networkTask)
+void statsReportTask() {
+#if LOOP_STATS_ENABLED
+    reportLoopLatency();
+    latencyProfiler.report();
+    cycleProfiler.report();
+#if LAN_HTTP_ENABLED
+    lanHttp.report();
+#endif
+#if TELEMETRY_TRANSPORT_MQTT
+    mqttTransport.report();
+#endif
+    reportSchedulerStats(networkScheduler);
+    httpsPool.report();
+    heapMonitor.report();
+    telemetryBacklog.report();
+    reportHistory();
+    Log.report();
+    Log.println("[PERF] command queues dropped: stream " + String(streamCommandQueue.dropped()) +
+                ", poll " + String(pollCommandQueue.dropped()));
+#endif
+}
+
+// Control task stats; lateness here is the control-loop jitter (runs in controlTask)
+void controlStatsTask() {
+#if LOOP_STATS_ENABLED
+    reportSchedulerStats(controlScheduler);
+    reportSensorFilters();
+#endif
+}
+
+void registerControlTasks() {
+    // name, callback, period, phase, priority, deadline
+    controlScheduler.addTask("control", controlTask, SENSOR_SAMPLE_PERIOD_MS,
+                             SENSOR_SAMPLE_PERIOD_MS, 4, CONTROL_TASK_DEADLINE_MS);
+    controlScheduler.addTask("sample", sampleAmbientTask, SENSOR_FAST_SAMPLE_MS,
+                             SENSOR_FAST_SAMPLE_MS, 3);
+    controlScheduler.addTask("ctl_stats", controlStatsTask, LOOP_STATS_INTERVAL_MS,
+                             LOOP_STATS_INTERVAL_MS, 0);
+}
+
+void registerNetworkTasks() {
+    // name, callback, period, phase, priority, deadline
+#if !TELEMETRY_TRANSPORT_MQTT
+    // MQTT delivers commands on its subscriptions (transport->service())
+    networkScheduler.addTask("rc_poll", remoteControlPollTask, RELAY_CONTROL_PULL_INTERVAL_MS,
+                             RELAY_CONTROL_PULL_INTERVAL_MS + 250, 3);
+#endif
+    networkScheduler.addTask("wifi", wifiWatchdogTask, WIFI_CHECK_INTERVAL_MS,
+                             WIFI_CHECK_INTERVAL_MS, 2);
+    networkScheduler.addTask("fb_push", firebasePushTask, FIREBASE_UPDATE_INTERVAL_MS,
+                             FIREBASE_UPDATE_INTERVAL_MS + 1000, 1);
+#if TELEMETRY_BACKLOG_ENABLED
+    networkScheduler.addTask("backlog", backlogUploadTask, TELEMETRY_BACKLOG_DRAIN_INTERVAL_MS,
+                             TELEMETRY_BACKLOG_DRAIN_INTERVAL_MS + 1500, 0);
+#endif
+#if HISTORY_ENABLED
+    networkScheduler.addTask("history", historyTask, SENSOR_SAMPLE_PERIOD_MS,
+                             SENSOR_SAMPLE_PERIOD_MS + 500, 1);
+#endif
+    // Short period: otaManager decides when the (jittered) check is due
+    networkScheduler.addTask("ota", otaCheckTask, OTA_CHECK_POLL_MS, OTA_CHECK_POLL_MS, 0);
+    networkScheduler.addTask("ota_mon", otaMonitorTask, OTA_MONITOR_INTERVAL_MS, 0, 0);
+    networkScheduler.addTask("https", httpsPoolTask, HTTPS_POOL_SWEEP_INTERVAL_MS,
+                             HTTPS_POOL_SWEEP_INTERVAL_MS, 0);
+#if LATENCY_BENCH_ENABLED
+    networkScheduler.addTask("latency", latencyPushTask, LATENCY_BENCH_PUSH_INTERVAL_MS,
+                             LATENCY_BENCH_PUSH_INTERVAL_MS + 2500, 0);
+#endif
+    networkScheduler.addTask("stats", statsReportTask, LOOP_STATS_INTERVAL_MS,
+                             LOOP_STATS_INTERVAL_MS, 0);
+}
+
+// ============================================================
+// LOOP LATENCY STATS
+// ============================================================
+void recordLoopLatency(uint32_t elapsedUs) {
+#if LOOP_STATS_ENABLED
+    loopStatsCount++;
+    loopStatsTotalUs += elapsedUs;
+    if (elapsedUs > loopStatsMaxUs) loopStatsMaxUs = elapsedUs;
+    loopLifetimeCount++;
+    loopLifetimeUs += elapsedUs;
+#else
+    (void)elapsedUs;
+#endif
+}
+
+void reportLoopLatency() {
+    const uint32_t avgUs = loopStatsCount ? (uint32_t)(loopStatsTotalUs / loopStatsCount) : 0;
+    Log.println("[PERF] network loop: " + String(loopStatsCount) + " iterations, avg " +
+                String(avgUs) + " us, max " + String(loopStatsMaxUs / 1000.0f, 1) + " ms");
+    loopStatsCount = 0;
+    loopStatsTotalUs = 0;
+    loopStatsMaxUs = 0;
+}
+
 // ============================================================
 // TELNET LOGGER
 // ============================================================
@@ -302,9 +674,11 @@ void handleTelnetLogger() {
     const bool anyNetworkUp = staConnected || apActive;
 
     if (!anyNetworkUp) {
+        Log.lock();
         if (telnetClient && telnetClient.connected()) {
             telnetClient.stop();
         }
+        Log.unlock();
         telnetServerStarted = false;
         return;
     }
@@ -313,13 +687,14 @@ void handleTelnetLogger() {
         telnetServer.begin();
         telnetServer.setNoDelay(true);
         telnetServerStarted = true;
-        Log.println("[TELNET] Log server started on port " + String(TELNET_LOG_PORT));
+        LOGI(TELNET, "Log server started on port %d", TELNET_LOG_PORT);
     }
 
 #if defined(ARDUINO_ARCH_ESP32)
     if (telnetServer.hasClient()) {
         WiFiClient newClient = telnetServer.available();
         if (newClient) {
+            Log.lock();   // control task may be mid-write to the old client
             if (telnetClient && telnetClient.connected()) {
                 telnetClient.stop();
             }
@@ -332,22 +707,27 @@ void handleTelnetLogger() {
             if (apActive) {
                 telnetClient.println("[TELNET]  AP IP: " + WiFi.softAPIP().toString());
             }
+            Log.unlock();
         }
     }
 #else
     if (!telnetClient || !telnetClient.connected()) {
         WiFiClient newClient = telnetServer.available();
         if (newClient) {
+            Log.lock();
             telnetClient = newClient;
+            Log.unlock();
         }
     }
 #endif
 
     if (telnetClient && telnetClient.connected()) {
-        // Drain any incoming bytes (we don't accept commands here)
+        // Drain incoming bytes; the only command is 'l' (latency dump)
+        bool dumpLatency = false;
         while (telnetClient.available() > 0) {
-            (void)telnetClient.read();
+            dumpLatency |= telnetClient.read() == 'l';
         }
+        if (LATENCY_BENCH_ENABLED && dumpLatency) latencyProfiler.report();
     }
 }
 
@@ -388,17 +768,18 @@ void initializePins() {
 // SENSOR INITIALIZATION
 // ============================================================
 void initializeSensors() {
-    // DS18B20 sensors
-    tempSensor1.begin();
-    tempSensor2.begin();
-    Serial.print("[OK] DS18B20 Sensor1 devices found: ");
-    Serial.println(tempSensor1.getDeviceCount());
-    Serial.print("[OK] DS18B20 Sensor2 devices found: ");
-    Serial.println(tempSensor2.getDeviceCount());
+    // DS18B20 probes: both buses enumerated once, read by cached address
+    sensorRegistry.addBus(*hal.tempBus[0]);   // pin 27: temp1, temp1_2...
+    sensorRegistry.addBus(*hal.tempBus[1]);   // pin 14: temp2, temp2_2...
+    sensorRegistry.begin(DS18B20_RESOLUTION_BITS);
+    dsConversionTimeMs = sensorRegistry.conversionMs();
+
+    // First results are ready before the first sensor tick
+    startTemperatureConversion();
 
     // I2C (SHT30) sensor
     Wire.begin(PIN_I2C_SDA, PIN_I2C_SCL);
-    if (sht30.begin(I2C_SENSOR_ADDR)) {
+    if (hal.ambient->begin()) {
         Serial.println("[OK] SHT30 I2C sensor ready at address 0x" +
                        String(I2C_SENSOR_ADDR, HEX));
     } else {
@@ -411,9 +792,7 @@ void initializeSensors() {
 // ============================================================
 // Helper: Get current epoch timestamp
 unsigned long getEpochTime() {
-    time_t now;
-    time(&now);
-    return (unsigned long)now;
+    return hal.clock->epoch();
 }
 
 void initializeFirebase() {
@@ -425,27 +804,34 @@ void initializeFirebase() {
 
     Firebase.begin(&fbConfig, &fbAuth);
     Firebase.reconnectWiFi(true);
+#if FIREBASE_TCP_KEEPALIVE && FBDO_CARRIES_PUSHES
+    // idle s, interval s, probes: keeps the TLS session alive across pushes
+    fbdo.keepAlive(5, 5, 1);
+#endif
+    firebaseRtdb.attach(&fbdo);   // hal.rtdb PATCHes share it unless FIREBASE_PATCH_VIA_POOL
 
     if (Firebase.ready()) {
         firebaseReady = true;
         Serial.println("[OK] Firebase connected!");
 
-        String base = String(FIREBASE_BASE_PATH);
-
         // Set online status with timestamp
-        Firebase.RTDB.setString(&fbdo, base + "/status/state", "online");
-        Firebase.RTDB.setString(&fbdo, base + "/status/firmware", FIRMWARE_VERSION);
-        Firebase.RTDB.setInt(&fbdo, base + "/status/last_seen", getEpochTime());
-        Firebase.RTDB.setInt(&fbdo, base + "/status/heartbeat_interval_s", FIREBASE_UPDATE_INTERVAL_MS / 1000);
+        Firebase.RTDB.setString(&fbdo, FB_PATH("/status/state"), "online");
+        Firebase.RTDB.setString(&fbdo, FB_PATH("/status/firmware"), FIRMWARE_VERSION);
+        Firebase.RTDB.setInt(&fbdo, FB_PATH("/status/last_seen"), getEpochTime());
+#if FIREBASE_BATCHED_PUSH && FIREBASE_DELTA_PUSH
+        Firebase.RTDB.setInt(&fbdo, FB_PATH("/status/heartbeat_interval_s"), FIREBASE_HEARTBEAT_INTERVAL_MS / 1000);
+        telemetryTracker.invalidate();   // fresh session: publish every field once
+#else
+        Firebase.RTDB.setInt(&fbdo, FB_PATH("/status/heartbeat_interval_s"), FIREBASE_UPDATE_INTERVAL_MS / 1000);
+#endif
 
         bool remoteAutoMode = RELAY_CONTROL_DEFAULT_AUTO_MODE;
-        const String modePath = base + "/relays/auto_mode";
-        if (Firebase.RTDB.getBool(&fbdo, modePath, &remoteAutoMode)) {
-            autoRelayControl = remoteAutoMode;
-        } else {
-            autoRelayControl = RELAY_CONTROL_DEFAULT_AUTO_MODE;
-            Firebase.RTDB.setBool(&fbdo, modePath, autoRelayControl);
+        const char *modePath = REMOTE_FIELD_PATHS[RF_AUTO_MODE];
+        if (!Firebase.RTDB.getBool(&fbdo, modePath, &remoteAutoMode)) {
+            remoteAutoMode = RELAY_CONTROL_DEFAULT_AUTO_MODE;
+            Firebase.RTDB.setBool(&fbdo, modePath, remoteAutoMode);
         }
+        queueRemoteField(pollCommandQueue, RF_AUTO_MODE, remoteAutoMode ? 1.0f : 0.0f);
         
         // NOTE: For automatic offline detection, your app should check:
         // if (current_time - last_seen > heartbeat_interval_s * 2) then device is OFFLINE
@@ -453,269 +839,629 @@ void initializeFirebase() {
         
         // Push fallback defaults to Firebase on first boot if they don't exist
         float dummyTemp;
-        if (!Firebase.RTDB.getFloat(&fbdo, base + "/settings/heater_onTemp", &dummyTemp)) {
-            Firebase.RTDB.setFloat(&fbdo, base + "/settings/heater_onTemp", DEFAULT_HEATER_ON_TEMP_C);
-            Firebase.RTDB.setFloat(&fbdo, base + "/settings/heater_offTemp", DEFAULT_HEATER_OFF_TEMP_C);
-            Firebase.RTDB.setFloat(&fbdo, base + "/settings/refrig_onTemp", DEFAULT_REFRIG_ON_TEMP2_C);
-            Firebase.RTDB.setFloat(&fbdo, base + "/settings/refrig_offTemp", DEFAULT_REFRIG_OFF_TEMP2_C);
+        if (!Firebase.RTDB.getFloat(&fbdo, REMOTE_FIELD_PATHS[RF_HEATER_ON_TEMP], &dummyTemp)) {
+            Firebase.RTDB.setFloat(&fbdo, REMOTE_FIELD_PATHS[RF_HEATER_ON_TEMP], DEFAULT_HEATER_ON_TEMP_C);
+            Firebase.RTDB.setFloat(&fbdo, REMOTE_FIELD_PATHS[RF_HEATER_OFF_TEMP], DEFAULT_HEATER_OFF_TEMP_C);
+            Firebase.RTDB.setFloat(&fbdo, REMOTE_FIELD_PATHS[RF_REFRIG_ON_TEMP], DEFAULT_REFRIG_ON_TEMP2_C);
+            Firebase.RTDB.setFloat(&fbdo, REMOTE_FIELD_PATHS[RF_REFRIG_OFF_TEMP], DEFAULT_REFRIG_OFF_TEMP2_C);
         }
 
         Serial.println("[OK] Presence timestamps enabled - app should check last_seen");
+#if !FBDO_CARRIES_PUSHES
+        fbdo.stopWiFiClient();   // boot writes done, pushes use the pool (TLS budget, config.h)
+#endif
+
+#if RELAY_CONTROL_USE_STREAM
+        beginRemoteControlStream();
+#endif
     } else {
         Serial.println("[!] Firebase connection failed - will retry");
     }
 }
 
-// ============================================================
-// READ SENSORS
-// ============================================================
-void readSensors() {
-    // DS18B20 Sensor 1 (pin 27)
-    tempSensor1.requestTemperatures();
-    temp1 = tempSensor1.getTempCByIndex(0);
-
-    // DS18B20 Sensor 2 (pin 12)
-    tempSensor2.requestTemperatures();
-    temp2 = tempSensor2.getTempCByIndex(0);
-
-    // SHT30 I2C Sensor (pins 21, 22)
-    float t = sht30.readTemperature();
-    float h = sht30.readHumidity();
-    if (!isnan(t)) ambientTemp     = t;
-    if (!isnan(h)) ambientHumidity = h;
+// Bring up the selected telemetry transport once WiFi is up. MQTT
+// connects (and reconnects) from transport->service() instead
+void initializeTransport() {
+#if TELEMETRY_TRANSPORT_MQTT
+    Log.println("[*] Telemetry over MQTT (" MQTT_BROKER_HOST ") - Firebase not used");
+#else
+    if (!firebaseReady) initializeFirebase();
+#endif
+}
 
-    Serial.println("[SENSOR] Temp1: " + String(temp1,1) + "°C  |  " +
-                   "Temp2: " + String(temp2,1) + "°C  |  " +
-                   "Ambient: " + String(ambientTemp,1) + "°C  " +
-                   String(ambientHumidity,1) + "%RH");
+// A push now has a chance to go through
+bool telemetryOnline() {
+    if (WiFi.status() != WL_CONNECTED) return false;
+#if TELEMETRY_TRANSPORT_MQTT
+    return transport->ready();
+#else
+    return firebaseReady;
+#endif
 }
 
 // ============================================================
-// AUTOMATIC CONTROL LOGIC
+// READ SENSORS
 // ============================================================
-bool isValidDs18b20(float value) {
-    return (value > -126.0f && value < 85.0f);
+// Start a conversion on both DS18B20 buses at once (returns immediately)
+void startTemperatureConversion() {
+    sensorRegistry.requestConversion();
+    dsConversionStartMillis = millis();
+    dsConversionPending = true;
 }
 
-bool isValidAmbientTemp(float value) {
-    return (value > -40.0f && value < 125.0f);
+static int32_t toCenti(float value) {
+    if (isnan(value)) return INT32_MIN;   // out of every filter range
+    return (int32_t)lroundf(value * 100.0f);
 }
 
-bool shouldHoldRelaysOff() {
-    const bool startupHoldActive = (millis() - bootStartMillis) < RELAY_STARTUP_HOLDOFF_MS;
-    const bool provisioningHoldActive = RELAYS_OFF_DURING_PROVISIONING && provisioningMode;
-    return startupHoldActive || provisioningHoldActive;
+// Collect results once the conversion time for the resolution has passed,
+// feed the filters and start the next conversion right away
+bool serviceTemperatureConversion() {
+    if (!dsConversionPending) return false;
+    if (millis() - dsConversionStartMillis < dsConversionTimeMs) return false;
+
+    const uint32_t startUs = micros();
+    sensorRegistry.collect(millis());
+    latencyProfiler.record(LAT_DS18B20_COLLECT, micros() - startUs);
+    startTemperatureConversion();
+    return true;
 }
 
-void enforceRelaysOff() {
-    heaterOn = false;
-    refrigOn = false;
-    fanOn = false;
-    applyRelayStates();
-}
-
-void updateFanCycle() {
-    const unsigned long now = millis();
-    const unsigned long phaseDuration = fanCycleOnPhase ? FAN_ON_DURATION_MS : FAN_OFF_DURATION_MS;
-
-    if (now - fanCycleStartMillis >= phaseDuration) {
-        fanCycleOnPhase = !fanCycleOnPhase;
-        fanCycleStartMillis = now;
-
-        Serial.println("[CTRL] Fan cycle phase -> " + String(fanCycleOnPhase ? "ON (2 min)" : "OFF (1 min)"));
+// SHT30 I2C Sensor (pins 21, 22): one measurement for both values
+void sampleAmbientTask() {
+    const uint32_t now = millis();
+    float t = NAN;
+    float h = NAN;
+    if (!hal.ambient->read(t, h)) {
+        ambientFilter.expire(now);
+        humidityFilter.expire(now);
+        return;
     }
-
-    fanOn = fanCycleOnPhase;
+    ambientFilter.update(toCenti(t), now);
+    humidityFilter.update(toCenti(h), now);
 }
 
-void updateAutomaticControl() {
-    updateFanCycle();
-
-    const bool ambientValid = isValidAmbientTemp(ambientTemp);
-    const bool temp2Valid = isValidDs18b20(temp2);
-    const bool temp1Valid = isValidDs18b20(temp1);
-
-    if (ambientValid && temp2Valid) {
-        float avgTemp = (ambientTemp + temp2) / 2.0f;
-        if (avgTemp >= heaterOffTemp) {
-            heaterOn = false;
-        } else if (avgTemp <= heaterOnTemp) {
-            heaterOn = true;
-        }
-
-        Serial.println("[CTRL] Heater Avg(Ambient+temp2) = " + String(avgTemp, 2) +
-                       "°C (ON<=" + String(heaterOnTemp, 1) +
-                       ", OFF>=" + String(heaterOffTemp, 1) + ")");
-    } else {
-        Serial.println("[CTRL] Heater control skipped (invalid ambient temp or temp2)");
-    }
-
-    if (temp1Valid) {
-        if (temp1 <= refrigOffTemp) {
-            refrigOn = false;
-        } else if (temp1 >= refrigOnTemp) {
-            refrigOn = true;
-        }
-
-        Serial.println("[CTRL] Refrig temp1 = " + String(temp1, 2) +
-                       "°C (OFF<=" + String(refrigOffTemp, 1) +
-                       ", ON>=" + String(refrigOnTemp, 1) + ")");
-    } else {
-        Serial.println("[CTRL] Refrig control skipped (invalid temp1)");
-    }
+float filteredOrInvalid(const SensorChannel<> *filter) {
+    return (filter && filter->valid()) ? filter->value() / 100.0f : -127.0f;
 }
 
-// ============================================================
-// RELAY & LED CONTROL
-// ============================================================
-void applyRelayStates() {
-    // Write relay outputs (supports active-low relay modules)
-    writeRelay(PIN_RELAY_HEATER, HEATER_OUTPUT_INVERTED ? !heaterOn : heaterOn, RELAY_HEATER_ACTIVE_LOW);
-    writeRelay(PIN_RELAY_REFRIG, REFRIG_OUTPUT_INVERTED ? !refrigOn : refrigOn, RELAY_REFRIG_ACTIVE_LOW);
-    writeRelay(PIN_RELAY_FAN,    FAN_OUTPUT_INVERTED ? !fanOn : fanOn, RELAY_FAN_ACTIVE_LOW);
-
-    // Set LEDs directly
-    digitalWrite(PIN_LED_HEATER, heaterOn ? HIGH : LOW);
-    digitalWrite(PIN_LED_REFRIG, refrigOn ? HIGH : LOW);
-    digitalWrite(PIN_LED_FAN,    fanOn    ? HIGH : LOW);
-
-    Serial.println("[RELAY] Heater:" + String(heaterOn ? "ON ":"OFF") +
-                   "  Refrig:" + String(refrigOn ? "ON ":"OFF") +
-                   "  Fan:"    + String(fanOn    ? "ON ":"OFF"));
+// Control tick input: the filtered values (-127 = no recent good sample)
+void readSensors() {
+    const uint32_t now = millis();
+    for (size_t i = 0; i < sensorRegistry.count(); i++) {
+        sensorRegistry.probe(i).filter.expire(now);
+    }
+    ambientFilter.expire(now);
+    humidityFilter.expire(now);
+
+    const SensorProbe *probe1 = sensorRegistry.primary(0);
+    const SensorProbe *probe2 = sensorRegistry.primary(1);
+    temp1       = filteredOrInvalid(probe1 ? &probe1->filter : nullptr);
+    temp2       = filteredOrInvalid(probe2 ? &probe2->filter : nullptr);
+    ambientTemp = filteredOrInvalid(&ambientFilter);
+    if (humidityFilter.valid()) ambientHumidity = humidityFilter.value() / 100.0f;
+
+    LOGI(SENSOR, "Temp1: %.1f°C  |  Temp2: %.1f°C  |  Ambient: %.1f°C  %.1f%%RH",
+         temp1, temp2, ambientTemp, ambientHumidity);
 }
 
-void writeRelay(uint8_t pin, bool on, bool activeLow) {
-    const bool level = activeLow ? !on : on;
-    pinMode(pin, OUTPUT);
-    digitalWrite(pin, level ? HIGH : LOW);
+static void reportSensorFilter(const char *name, SensorChannel<> &filter) {
+    const SensorChannelStats &st = filter.stats();
+    Log.println("[PERF] filter " + String(name) + ": " + String(st.samples) + " samples, " +
+                String(st.outOfRange) + " out of range, " + String(st.outliers) + " outliers, " +
+                String(st.steps) + " steps" + (filter.valid() ? "" : " (invalid)"));
+    filter.resetStats();
 }
 
-void setAllLedsImmediate(bool on) {
-    digitalWrite(PIN_LED_HEATER, on ? HIGH : LOW);
-    digitalWrite(PIN_LED_REFRIG, on ? HIGH : LOW);
-    digitalWrite(PIN_LED_FAN,    on ? HIGH : LOW);
+void reportSensorFilters() {
+    sensorRegistry.report();
+    for (size_t i = 0; i < sensorRegistry.count(); i++) {
+        SensorProbe &p = sensorRegistry.probe(i);
+        reportSensorFilter(p.name, p.filter);
+    }
+    reportSensorFilter("ambient", ambientFilter);
+    reportSensorFilter("humidity", humidityFilter);
 }
 
 // ============================================================
 // PUSH SENSOR DATA TO FIREBASE
 // ============================================================
-void pushToFirebase() {
+void fillTelemetrySnapshot(const ControlSnapshot &cs, TelemetrySnapshot &snap) {
+    // Check sensor validity (DS18B20 returns -127 when disconnected)
+    snap.temp1           = cs.temp1;
+    snap.temp2           = cs.temp2;
+    snap.ambientTemp     = cs.ambientTemp;
+    snap.ambientHumidity = cs.ambientHumidity;
+    snap.temp1Valid      = (cs.temp1 > -126.0f && cs.temp1 < 85.0f);
+    snap.temp2Valid      = (cs.temp2 > -126.0f && cs.temp2 < 85.0f);
+    snap.ambientValid    = (cs.ambientTemp > -40.0f && cs.ambientTemp < 125.0f);
+    snap.probeCount      = cs.probeCount;
+    for (uint8_t i = 0; i < cs.probeCount; i++) {
+        snap.probeName[i]  = cs.probeName[i];
+        snap.probeTemp[i]  = cs.probeTemp[i];
+        snap.probeValid[i] = isValidDs18b20(cs.probeTemp[i]);
+    }
+    snap.heaterOn        = cs.heaterOn;
+    snap.refrigOn        = cs.refrigOn;
+    snap.fanOn           = cs.fanOn;
+    snap.autoMode        = cs.autoMode;
+    snap.rssi            = hal.network->rssi();
+    snap.freeHeap        = heapMonitor.freeBytes();
+    snap.minFreeHeap     = heapMonitor.minFreeBytes();
+    snap.maxAllocHeap    = heapMonitor.largestFreeBlock();
+    snap.uptimeS         = millis() / 1000;
+    snap.epoch           = getEpochTime();
+}
+
+// Returns false when the sample did not reach Firebase / the broker
+bool pushToFirebase() {
+    ScopedCycles prof(PROF_PUSH);
+#if TELEMETRY_TRANSPORT_MQTT
+    if (!transport->ready()) return false;
+    static uint32_t mqttSession = 0;
+    if (mqttTransport.sessions() != mqttSession) {
+        mqttSession = mqttTransport.sessions();
+        telemetryTracker.invalidate();   // fresh session: publish every field once
+    }
+#else
     if (!Firebase.ready()) {
         firebaseReady = Firebase.ready();
-        return;
+        return false;
     }
+#endif
+
+    // Consistent copy of the control task's state
+    ControlSnapshot cs;
+    controlSnapshot.read(cs);
+
+    TelemetrySnapshot snap;
+    fillTelemetrySnapshot(cs, snap);
 
-    String base = String(FIREBASE_BASE_PATH);
     bool ok = true;
-    unsigned long now = getEpochTime();
+    const bool temp1Valid = snap.temp1Valid;
+    const bool temp2Valid = snap.temp2Valid;
+    const bool ambientValid = snap.ambientValid;
+    const bool anySensorValid = temp1Valid || temp2Valid || ambientValid;
+
+#if FIREBASE_BATCHED_PUSH
+    // Single multi-path PATCH: one HTTPS round-trip for the whole cycle
+#if FIREBASE_DELTA_PUSH
+    const uint32_t fields = telemetryTracker.select(snap, millis());
+    if (fields == 0) {
+        return true;   // nothing moved past its dead-band and heartbeat not due
+    }
+#else
+    const uint32_t fields = TF_ALL;
+#endif
 
-    // Check sensor validity (DS18B20 returns -127 when disconnected)
-    bool temp1Valid = (temp1 > -126.0f && temp1 < 85.0f);
-    bool temp2Valid = (temp2 > -126.0f && temp2 < 85.0f);
-    bool ambientValid = (ambientTemp > -40.0f && ambientTemp < 125.0f);
-    bool anySensorValid = temp1Valid || temp2Valid || ambientValid;
+    static TelemetryPayload payload;   // static: keeps the 1 KB buffer off the loop stack
+    bool built;
+    {
+        ScopedCycles buildProf(PROF_PAYLOAD);
+        built = buildTelemetryPayload(snap, fields, payload);
+    }
+    if (!built) {
+        LOGW(FB, "Push skipped - payload exceeds TELEMETRY_PAYLOAD_MAX_BYTES");
+        return true;
+    }
+
+#if TELEMETRY_TRANSPORT_MQTT
+    ok = transport->publishTelemetry(payload.c_str());
+#elif FIREBASE_PATCH_VIA_POOL
+    ok = transport->publishTelemetry(payload.c_str());   // the pool records the request
+#else
+    const bool fbReused = fbdo.httpConnected();
+    const uint32_t fbStartUs = micros();
+    ok = transport->publishTelemetry(payload.c_str());
+    httpsPool.record(HTTPS_CH_FIREBASE, micros() - fbStartUs, fbReused);
+#endif
+
+    if (ok) {
+#if FIREBASE_DELTA_PUSH
+        telemetryTracker.commit(snap, fields, millis());
+#endif
+        LOGD(FB, "Data pushed (sensors valid: %s, %u fields, %u bytes, 1 request)",
+             anySensorValid ? "yes" : "no", (unsigned)payload.fieldCount(), (unsigned)payload.length());
+    } else {
+        LOGW(FB, "Push error (%s): %s", transport->name(), transport->lastError());
+    }
+#else
+    const unsigned long now = snap.epoch;
 
     // Explicit unit marker for all temperature readings
-    ok &= Firebase.RTDB.setString(&fbdo, base + "/sensors/temperature_unit", TEMPERATURE_UNIT_LABEL);
+    ok &= Firebase.RTDB.setString(&fbdo, FB_PATH("/sensors/temperature_unit"), TEMPERATURE_UNIT_LABEL);
 
     // Sensor data (only push valid readings)
     if (temp1Valid) {
-        ok &= Firebase.RTDB.setFloat(&fbdo, base + "/sensors/temp1", temp1);
+        ok &= Firebase.RTDB.setFloat(&fbdo, FB_PATH("/sensors/temp1"), cs.temp1);
     } else {
-        ok &= Firebase.RTDB.setString(&fbdo, base + "/sensors/temp1", "disconnected");
+        ok &= Firebase.RTDB.setString(&fbdo, FB_PATH("/sensors/temp1"), "disconnected");
     }
 
     if (temp2Valid) {
-        ok &= Firebase.RTDB.setFloat(&fbdo, base + "/sensors/temp2", temp2);
+        ok &= Firebase.RTDB.setFloat(&fbdo, FB_PATH("/sensors/temp2"), cs.temp2);
     } else {
-        ok &= Firebase.RTDB.setString(&fbdo, base + "/sensors/temp2", "disconnected");
+        ok &= Firebase.RTDB.setString(&fbdo, FB_PATH("/sensors/temp2"), "disconnected");
+    }
+
+    for (uint8_t i = 0; i < snap.probeCount; i++) {
+        const String path = String(FB_PATH("/sensors/")) + snap.probeName[i];
+        if (snap.probeValid[i]) {
+            ok &= Firebase.RTDB.setFloat(&fbdo, path, snap.probeTemp[i]);
+        } else {
+            ok &= Firebase.RTDB.setString(&fbdo, path, "disconnected");
+        }
     }
 
     if (ambientValid) {
-        ok &= Firebase.RTDB.setFloat(&fbdo, base + "/sensors/ambient_temp", ambientTemp);
-        ok &= Firebase.RTDB.setFloat(&fbdo, base + "/sensors/ambient_humidity", ambientHumidity);
+        ok &= Firebase.RTDB.setFloat(&fbdo, FB_PATH("/sensors/ambient_temp"), cs.ambientTemp);
+        ok &= Firebase.RTDB.setFloat(&fbdo, FB_PATH("/sensors/ambient_humidity"), cs.ambientHumidity);
     } else {
-        ok &= Firebase.RTDB.setString(&fbdo, base + "/sensors/ambient_temp", "disconnected");
-        ok &= Firebase.RTDB.setString(&fbdo, base + "/sensors/ambient_humidity", "disconnected");
+        ok &= Firebase.RTDB.setString(&fbdo, FB_PATH("/sensors/ambient_temp"), "disconnected");
+        ok &= Firebase.RTDB.setString(&fbdo, FB_PATH("/sensors/ambient_humidity"), "disconnected");
     }
 
     // Sensor validity flag and timestamp
-    ok &= Firebase.RTDB.setBool(&fbdo, base + "/sensors/valid", anySensorValid);
-    ok &= Firebase.RTDB.setInt(&fbdo,  base + "/sensors/last_update", now);
+    ok &= Firebase.RTDB.setBool(&fbdo, FB_PATH("/sensors/valid"), anySensorValid);
+    ok &= Firebase.RTDB.setInt(&fbdo,  FB_PATH("/sensors/last_update"), now);
 
     // Relay states (actual hardware state)
-    ok &= Firebase.RTDB.setBool(&fbdo, base + "/relays/heater_state", heaterOn);
-    ok &= Firebase.RTDB.setBool(&fbdo, base + "/relays/refrig_state", refrigOn);
-    ok &= Firebase.RTDB.setBool(&fbdo, base + "/relays/fan_state",    fanOn);
-    ok &= Firebase.RTDB.setBool(&fbdo, base + "/relays/auto_mode_state", autoRelayControl);
+    ok &= Firebase.RTDB.setBool(&fbdo, FB_PATH("/relays/heater_state"), cs.heaterOn);
+    ok &= Firebase.RTDB.setBool(&fbdo, FB_PATH("/relays/refrig_state"), cs.refrigOn);
+    ok &= Firebase.RTDB.setBool(&fbdo, FB_PATH("/relays/fan_state"),    cs.fanOn);
+    ok &= Firebase.RTDB.setBool(&fbdo, FB_PATH("/relays/auto_mode_state"), cs.autoMode);
 
     // Device diagnostics with timestamp
-    ok &= Firebase.RTDB.setString(&fbdo, base + "/status/state", "online");
-    ok &= Firebase.RTDB.setInt(&fbdo,    base + "/status/last_seen", now);
-    ok &= Firebase.RTDB.setInt(&fbdo,    base + "/status/rssi",     WiFi.RSSI());
-    ok &= Firebase.RTDB.setInt(&fbdo,    base + "/status/free_heap", ESP.getFreeHeap());
-    ok &= Firebase.RTDB.setInt(&fbdo,    base + "/status/uptime_s",  millis() / 1000);
+    ok &= Firebase.RTDB.setString(&fbdo, FB_PATH("/status/state"), "online");
+    ok &= Firebase.RTDB.setInt(&fbdo,    FB_PATH("/status/last_seen"), now);
+    ok &= Firebase.RTDB.setInt(&fbdo,    FB_PATH("/status/rssi"),     WiFi.RSSI());
+    ok &= Firebase.RTDB.setInt(&fbdo,    FB_PATH("/status/free_heap"), heapMonitor.freeBytes());
+    ok &= Firebase.RTDB.setInt(&fbdo,    FB_PATH("/status/min_free_heap"), heapMonitor.minFreeBytes());
+    ok &= Firebase.RTDB.setInt(&fbdo,    FB_PATH("/status/largest_free_block"), heapMonitor.largestFreeBlock());
+    ok &= Firebase.RTDB.setInt(&fbdo,    FB_PATH("/status/uptime_s"),  millis() / 1000);
 
     if (ok) {
-        Serial.println("[FB] Data pushed (sensors valid: " + String(anySensorValid ? "yes" : "no") + ")");
+        LOGD(FB, "Data pushed (sensors valid: %s)", anySensorValid ? "yes" : "no");
     } else {
-        Serial.println("[FB] Push error: " + fbdo.errorReason());
+        LOGW(FB, "Push error: %s", fbdo.errorReason().c_str());
     }
+#endif
+    return ok;
 }
 
 // ============================================================
-// READ RELAY CONTROL MODE FROM FIREBASE
+// OFFLINE BACKLOG (store-and-forward)
 // ============================================================
-void updateRelayControlModeFromFirebase() {
-    if (!Firebase.ready()) return;
+void recordBacklogSample() {
+#if TELEMETRY_BACKLOG_ENABLED
+    ControlSnapshot cs;
+    controlSnapshot.read(cs);
+    TelemetrySnapshot snap;
+    fillTelemetrySnapshot(cs, snap);
+    telemetryBacklog.record(snap, millis());
+#endif
+}
 
-    const String basePath = String(FIREBASE_BASE_PATH);
-    const String modePath = basePath + "/relays/auto_mode";
-    
-    // Auto Mode Check
-    bool remoteAutoMode = autoRelayControl;
-    if (Firebase.RTDB.getBool(&fbdo, modePath, &remoteAutoMode)) {
+// /metrics and /state source (network task): control snapshot + network side stats
+void fillLanStatus(LanStatus &status) {
+    ControlSnapshot cs;
+    controlSnapshot.read(cs);
+    fillTelemetrySnapshot(cs, status.t);
+    status.heaterOnTemp   = cs.heaterOnTemp;
+    status.heaterOffTemp  = cs.heaterOffTemp;
+    status.refrigOnTemp   = cs.refrigOnTemp;
+    status.refrigOffTemp  = cs.refrigOffTemp;
+    status.loopIterations = loopLifetimeCount;
+    status.loopTotalUs    = loopLifetimeUs;
+    status.loopMaxUs      = loopStatsMaxUs;
+    status.hasLatency     = LATENCY_BENCH_ENABLED;
+    for (int i = 0; i < LAT_STAGE_COUNT && status.hasLatency; i++) {
+        status.latency[i] = latencyProfiler.summary((LatencyStage)i);
+    }
+}
+
+// Compact p50/p95/p99/max per stage under status/latency_ms
+void latencyPushTask() {
+    if (!telemetryOnline() || !transport->ready()) return;
+
+    static TelemetryPayload payload;   // static: off the network task stack
+    if (!latencyProfiler.buildSummary(payload)) return;
+    if (!transport->publishTelemetry(payload.c_str())) {
+        LOGW(FB, "Latency summary push error: %s", transport->lastError());
+    }
+}
+
+// One batch per run: the backlog drains over several intervals
+// instead of holding the network task through one long burst
+void backlogUploadTask() {
+#if TELEMETRY_BACKLOG_ENABLED
+    if (!telemetryOnline() || !transport->ready()) return;
+    if (telemetryBacklog.pending() == 0) return;
+
+    static char batch[TELEMETRY_BACKLOG_UPLOAD_BYTES];   // static: off the network task stack
+    size_t len = 0;
+    const size_t samples = telemetryBacklog.buildBatch(batch, sizeof(batch), len);
+    if (samples == 0) return;
+
+    if (transport->publishBacklog(batch)) {
+        telemetryBacklog.commitBatch(samples);
+        LOGI(FB, "Backlog: uploaded %u samples (%u bytes), %u pending",
+             (unsigned)samples, (unsigned)len, (unsigned)telemetryBacklog.pending());
+    } else {
+        LOGW(FB, "Backlog upload error: %s", transport->lastError());
+    }
+#endif
+}
+
+// ============================================================
+// LOCAL HISTORY (time-series store)
+// ============================================================
+void initializeHistory() {
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_DATA_SPIFFS, nullptr);
+    if (!part || !historyRegion.begin(part, HISTORY_PARTITION_OFFSET, HISTORY_BYTES) || !history.begin()) {
+        Log.println("[!] History: no room in the spiffs partition - local history disabled");
+        return;
+    }
+    historyReady = true;
+    Log.println("[OK] History: " + String(history.bytesUsed() / 1024) + "/" + String(HISTORY_BYTES / 1024) +
+                " KB used, newest " + String(history.newestEpoch()));
+}
+
+static int16_t toDeci(float value, bool valid) {
+    if (!valid) return TS_INVALID;
+    const float scaled = value * 10.0f;
+    if (scaled > 32767.0f) return 32767;
+    if (scaled < -32767.0f) return -32767;
+    return (int16_t)lroundf(scaled);
+}
+
+// One sample per control tick, keyed by wall-clock time
+void historyTask() {
+    if (!historyReady) return;
+    const uint32_t epoch = getEpochTime();
+    if (epoch < TELEMETRY_BACKLOG_MIN_EPOCH) return;
+
+    ControlSnapshot cs;
+    controlSnapshot.read(cs);
+    TsSample s;
+    s.epoch = epoch;
+    s.value[TS_CH_TEMP1]    = toDeci(cs.temp1, isValidDs18b20(cs.temp1));
+    s.value[TS_CH_TEMP2]    = toDeci(cs.temp2, isValidDs18b20(cs.temp2));
+    s.value[TS_CH_AMBIENT]  = toDeci(cs.ambientTemp, isValidAmbientTemp(cs.ambientTemp));
+    s.value[TS_CH_HUMIDITY] = toDeci(cs.ambientHumidity, isValidAmbientTemp(cs.ambientTemp));
+    s.relays = (cs.heaterOn ? TS_RELAY_HEATER : 0) | (cs.refrigOn ? TS_RELAY_REFRIG : 0) |
+               (cs.fanOn ? TS_RELAY_FAN : 0) | (cs.autoMode ? TS_RELAY_AUTO : 0);
+
+    if (!history.append(s)) {
+        LOGW(SENSOR, "History: append failed");
+    }
+}
+
+void reportHistory() {
+    if (!historyReady) return;
+    const uint32_t samples = history.samplesAppended();
+    const uint32_t bitsPerSample = samples ? history.bitsWritten() / samples : 0;
+    Log.println("[PERF] history: " + String(history.bytesUsed() / 1024) + " KB, " + String(samples) +
+                " samples / " + String(history.blocksSealed()) + " blocks sealed (~" + String(bitsPerSample) +
+                " bits/sample), " + String(history.oldestEpoch()) + ".." + String(history.newestEpoch()));
+}
+
+// ============================================================
+// REMOTE CONTROL UPDATES (shared by stream and poll paths)
+// ============================================================
+// Producer side: each queue has exactly one producer task
+void queueRemoteField(RemoteCommandQueue &queue, RemoteField field, float value) {
+    RemoteCommand cmd;
+    cmd.field = field;
+    cmd.value = value;
+    cmd.queuedUs = micros();
+    queue.push(cmd);   // a full queue counts the drop (reported with [PERF] stats)
+    if (controlTaskHandle) {
+        xTaskNotifyGive(controlTaskHandle);   // wake the control task now
+    }
+}
+
+// Transport commands (MQTT subscriptions, network task): path relative
+// to the device node, value as text ("true", "false" or a number)
+void onTransportCommand(const char *path, const char *value) {
+    for (uint8_t i = 0; i < RF_COUNT; i++) {
+        if (strcmp(path, REMOTE_FIELD_PATHS[i] + FB_BASE_PATH_LEN + 1) != 0) continue;
+        float parsed;
+        if (strcmp(value, "true") == 0) {
+            parsed = 1.0f;
+        } else if (strcmp(value, "false") == 0) {
+            parsed = 0.0f;
+        } else {
+            char *end = nullptr;
+            parsed = strtof(value, &end);
+            if (end == value) {
+                LOGW(FB, "Ignoring %s = '%s' (not a bool or number)", path, value);
+                return;
+            }
+        }
+        queueRemoteField(pollCommandQueue, (RemoteField)i, parsed);
+        return;
+    }
+}
+
+// Consumer side (control task): apply queued changes;
+// returns true if anything affecting relays changed
+bool applyRemoteUpdates(uint32_t &oldestQueuedUs) {
+    float values[RF_COUNT] = {0};
+    uint32_t dirty = 0;
+    const uint32_t nowUs = micros();
+    uint32_t oldestAgeUs = 0;
+
+    // Latest value per field wins; the stream is drained last (newest source)
+    RemoteCommand cmd;
+    while (pollCommandQueue.pop(cmd)) {
+        values[cmd.field] = cmd.value;
+        dirty |= (1u << cmd.field);
+        if (nowUs - cmd.queuedUs > oldestAgeUs) oldestAgeUs = nowUs - cmd.queuedUs;
+    }
+    while (streamCommandQueue.pop(cmd)) {
+        values[cmd.field] = cmd.value;
+        dirty |= (1u << cmd.field);
+        if (nowUs - cmd.queuedUs > oldestAgeUs) oldestAgeUs = nowUs - cmd.queuedUs;
+    }
+    oldestQueuedUs = nowUs - oldestAgeUs;
+
+    if (dirty == 0) return false;
+
+    bool changed = false;
+
+    if (dirty & (1u << RF_AUTO_MODE)) {
+        const bool remoteAutoMode = values[RF_AUTO_MODE] != 0.0f;
         if (remoteAutoMode != autoRelayControl) {
             autoRelayControl = remoteAutoMode;
             if (autoRelayControl) {
                 fanCycleStartMillis = millis();
                 fanCycleOnPhase = true;
             }
-            Serial.println("[FB] Relay mode -> " + String(autoRelayControl ? "AUTO" : "MANUAL"));
+            changed = true;
+            LOGI(FB, "Relay mode -> %s", autoRelayControl ? "AUTO" : "MANUAL");
         }
     }
-    
-    // Setpoints Check
-    float t;
-    if (Firebase.RTDB.getFloat(&fbdo, basePath + "/settings/heater_onTemp", &t))  heaterOnTemp = t;
-    if (Firebase.RTDB.getFloat(&fbdo, basePath + "/settings/heater_offTemp", &t)) heaterOffTemp = t;
-    if (Firebase.RTDB.getFloat(&fbdo, basePath + "/settings/refrig_onTemp", &t))  refrigOnTemp = t;
-    if (Firebase.RTDB.getFloat(&fbdo, basePath + "/settings/refrig_offTemp", &t)) refrigOffTemp = t;
+
+    bool commandsChanged = false;
+    if (dirty & (1u << RF_HEATER_CMD)) {
+        const bool cmd = values[RF_HEATER_CMD] != 0.0f;
+        commandsChanged |= !heaterCmdKnown || cmd != heaterCmd;
+        heaterCmd = cmd; heaterCmdKnown = true;
+    }
+    if (dirty & (1u << RF_REFRIG_CMD)) {
+        const bool cmd = values[RF_REFRIG_CMD] != 0.0f;
+        commandsChanged |= !refrigCmdKnown || cmd != refrigCmd;
+        refrigCmd = cmd; refrigCmdKnown = true;
+    }
+    if (dirty & (1u << RF_FAN_CMD)) {
+        const bool cmd = values[RF_FAN_CMD] != 0.0f;
+        commandsChanged |= !fanCmdKnown || cmd != fanCmd;
+        fanCmd = cmd; fanCmdKnown = true;
+    }
+    if (commandsChanged) {
+        LOGI(FB, "Commands read - Heater:%s Refrig:%s Fan:%s",
+             heaterCmd ? "ON" : "OFF", refrigCmd ? "ON" : "OFF", fanCmd ? "ON" : "OFF");
+        changed |= !autoRelayControl;
+    }
+
+    if (dirty & (1u << RF_HEATER_ON_TEMP))  { changed |= heaterOnTemp  != values[RF_HEATER_ON_TEMP];  heaterOnTemp  = values[RF_HEATER_ON_TEMP]; }
+    if (dirty & (1u << RF_HEATER_OFF_TEMP)) { changed |= heaterOffTemp != values[RF_HEATER_OFF_TEMP]; heaterOffTemp = values[RF_HEATER_OFF_TEMP]; }
+    if (dirty & (1u << RF_REFRIG_ON_TEMP))  { changed |= refrigOnTemp  != values[RF_REFRIG_ON_TEMP];  refrigOnTemp  = values[RF_REFRIG_ON_TEMP]; }
+    if (dirty & (1u << RF_REFRIG_OFF_TEMP)) { changed |= refrigOffTemp != values[RF_REFRIG_OFF_TEMP]; refrigOffTemp = values[RF_REFRIG_OFF_TEMP]; }
+
+    return changed;
 }
 
 // ============================================================
-// READ RELAY COMMANDS FROM FIREBASE (remote control)
+// REMOTE CONTROL STREAM (server-sent events)
+// - One multi-path stream on the device node; the library runs it
+//   in its own task, so callbacks only queue values for the
+//   control task
 // ============================================================
-void readRelayCommandsFromFirebase() {
-    if (!Firebase.ready()) return;
+static bool parseStreamValue(const MultiPathStream &stream, float &out) {
+    if (stream.type == "boolean") {
+        out = (stream.value == "true") ? 1.0f : 0.0f;
+        return true;
+    }
+    if (stream.type == "int" || stream.type == "float" || stream.type == "double") {
+        out = stream.value.toFloat();
+        return true;
+    }
+    return false;   // null (deleted) or unexpected type: keep current value
+}
 
-    String base = String(FIREBASE_BASE_PATH) + "/relays/control";
+// True if an event at dataPath can touch relays/ or settings/: the
+// root (initial put, multi-path PATCHes) or a path inside them
+static bool isCommandPath(const char *dataPath) {
+    static const char *const COMMAND_SUBTREES[] = {"/relays", "/settings"};
+    if (strcmp(dataPath, "/") == 0) return true;
+    for (const char *subtree : COMMAND_SUBTREES) {
+        const size_t len = strlen(subtree);
+        if (strncmp(dataPath, subtree, len) == 0 && (dataPath[len] == '\0' || dataPath[len] == '/')) return true;
+    }
+    return false;
+}
 
-    bool cmd;
+void remoteControlStreamCallback(MultiPathStream stream) {
+    fbStreamTimedOut = false;
+    if (!isCommandPath(stream.dataPath.c_str())) return;   // sensors/, status/, history/ writes
+    for (uint8_t i = 0; i < RF_COUNT; i++) {
+        if (!stream.get(REMOTE_FIELD_PATHS[i] + FB_BASE_PATH_LEN)) continue;
+        float value;
+        if (parseStreamValue(stream, value)) {
+            queueRemoteField(streamCommandQueue, (RemoteField)i, value);
+        }
+    }
+}
 
-    if (Firebase.RTDB.getBool(&fbdo, base + "/heater", &cmd)) {
-        heaterOn = cmd;
+void remoteControlStreamTimeoutCallback(bool timeout) {
+    if (timeout) {
+        // Keep-alive missed: poll until the library reconnects the stream
+        fbStreamTimedOut = true;
     }
-    if (Firebase.RTDB.getBool(&fbdo, base + "/refrig", &cmd)) {
-        refrigOn = cmd;
+}
+
+void beginRemoteControlStream() {
+    lastStreamBeginAttempt = millis();
+    if (!Firebase.RTDB.beginMultiPathStream(&fbStream, FIREBASE_BASE_PATH)) {
+        LOGW(FB, "Control stream failed: %s - polling", fbStream.errorReason().c_str());
+        return;
     }
-    if (Firebase.RTDB.getBool(&fbdo, base + "/fan",    &cmd)) {
-        fanOn = cmd;
+    Firebase.RTDB.setMultiPathStreamCallback(&fbStream, remoteControlStreamCallback,
+                                             remoteControlStreamTimeoutCallback);
+    fbStreamStarted = true;
+    fbStreamTimedOut = false;
+    LOGI(FB, "Control stream started on " FIREBASE_BASE_PATH);
+}
+
+bool isRemoteControlStreamHealthy() {
+#if RELAY_CONTROL_USE_STREAM
+    return fbStreamStarted && !fbStreamTimedOut && fbStream.httpConnected();
+#else
+    return false;
+#endif
+}
+
+// ============================================================
+// READ RELAY CONTROL MODE FROM FIREBASE (poll fallback)
+// - Returns the effective auto mode (remote value if read)
+// ============================================================
+bool updateRelayControlModeFromFirebase() {
+    ControlSnapshot cs;
+    controlSnapshot.read(cs);
+    if (!Firebase.ready()) return cs.autoMode;
+
+    // Auto Mode Check
+    bool remoteAutoMode = cs.autoMode;
+    if (Firebase.RTDB.getBool(&fbdo, REMOTE_FIELD_PATHS[RF_AUTO_MODE], &remoteAutoMode)) {
+        queueRemoteField(pollCommandQueue, RF_AUTO_MODE, remoteAutoMode ? 1.0f : 0.0f);
     }
 
-    Serial.println("[FB] Commands read - Heater:" + String(heaterOn ? "ON":"OFF") +
-                   " Refrig:" + String(refrigOn ? "ON":"OFF") +
-                   " Fan:"    + String(fanOn    ? "ON":"OFF"));
+    // Setpoints Check
+    float t;
+    for (uint8_t i = RF_HEATER_ON_TEMP; i <= RF_REFRIG_OFF_TEMP; i++) {
+        if (Firebase.RTDB.getFloat(&fbdo, REMOTE_FIELD_PATHS[i], &t)) {
+            queueRemoteField(pollCommandQueue, (RemoteField)i, t);
+        }
+    }
+
+    return remoteAutoMode;
+}
+
+// ============================================================
+// READ RELAY COMMANDS FROM FIREBASE (poll fallback)
+// ============================================================
+void readRelayCommandsFromFirebase() {
+    if (!Firebase.ready()) return;
+
+    bool cmd;
+    for (uint8_t i = RF_HEATER_CMD; i <= RF_FAN_CMD; i++) {
+        if (Firebase.RTDB.getBool(&fbdo, REMOTE_FIELD_PATHS[i], &cmd)) {
+            queueRemoteField(pollCommandQueue, (RemoteField)i, cmd ? 1.0f : 0.0f);
+        }
+    }
 }
 
 // ============================================================
@@ -790,148 +1536,8 @@ void setupWiFiCallbacks() {
             digitalWrite(PIN_LED_FAN, HIGH); delay(150);
             digitalWrite(PIN_LED_FAN, LOW);  delay(150);
         }
-        digitalWrite(PIN_LED_FAN, fanOn ? HIGH : LOW);
+        ControlSnapshot cs;
+        controlSnapshot.read(cs);
+        digitalWrite(PIN_LED_FAN, cs.fanOn ? HIGH : LOW);
     });
 }
-
-// ============================================================
-// OTA UPDATE CHECKING & INSTALLATION
-// ============================================================
-void checkForUpdates() {
-    if (WiFi.status() != WL_CONNECTED) {
-        Serial.println("[!] WiFi not connected, skipping OTA check");
-        return;
-    }
-
-    HTTPClient http;
-    http.setConnectTimeout(10000);
-    Serial.println("[*] Fetching version info from: " VERSION_JSON_URL);
-
-    if (!http.begin(VERSION_JSON_URL)) {
-        Serial.println("[!] Failed to begin HTTP request");
-        return;
-    }
-
-    int httpCode = http.GET();
-    if (httpCode != HTTP_CODE_OK) {
-        Serial.println("[!] HTTP Error: " + String(httpCode));
-        http.end();
-        return;
-    }
-
-    String payload = http.getString();
-    http.end();
-
-    JsonDocument doc;
-    if (deserializeJson(doc, payload)) {
-        Serial.println("[!] JSON parse error");
-        return;
-    }
-
-    String latestVersion = doc["version"]      | "0.0.0";
-    String downloadUrl   = doc["download_url"] | "";
-    String sha256        = doc["sha256"]        | "";
-
-    Serial.println("[*] Latest: " + latestVersion + "  Current: " FIRMWARE_VERSION);
-
-    if (latestVersion != FIRMWARE_VERSION && !downloadUrl.isEmpty()) {
-        Serial.println("[!] New firmware available - starting OTA...");
-        performOTAUpdate(downloadUrl, sha256);
-    } else {
-        Serial.println("[OK] Firmware is up to date");
-    }
-}
-
-void performOTAUpdate(String firmwareUrl, String expectedSha256) {
-    Serial.println("[*] Starting OTA update process...");
-
-    HTTPClient http;
-    http.setConnectTimeout(30000);
-    http.setTimeout(30000);
-
-    for (int redirectCount = 0; redirectCount < 3; redirectCount++) {
-        Serial.println("[*] Attempt " + String(redirectCount + 1) +
-                       ": Connecting to " + firmwareUrl);
-
-        if (!http.begin(firmwareUrl)) {
-            Serial.println("[!] Failed to connect to firmware URL");
-            http.end();
-            return;
-        }
-
-        http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
-        int httpCode = http.GET();
-        Serial.println("[*] HTTP Response: " + String(httpCode));
-
-        if (httpCode == 301 || httpCode == 302 || httpCode == 307) {
-            String loc = http.header("Location");
-            http.end();
-            if (loc.length() > 0) { firmwareUrl = loc; continue; }
-        }
-
-        if (httpCode == HTTP_CODE_OK) break;
-
-        http.end();
-        if (redirectCount < 2) { delay(2000); } else { return; }
-    }
-
-    int contentLength = http.getSize();
-    if (contentLength <= 0) {
-        Serial.println("[!] Invalid content length");
-        http.end();
-        return;
-    }
-
-    Serial.println("[*] Firmware size: " + String(contentLength) + " bytes");
-
-    if (!Update.begin(contentLength)) {
-        Serial.println("[!] Not enough space for OTA (free: " +
-                       String(ESP.getFreeSketchSpace()) + " bytes)");
-        http.end();
-        return;
-    }
-
-    WiFiClient *stream = http.getStreamPtr();
-    if (!stream) { Serial.println("[!] Stream error"); http.end(); return; }
-
-    size_t written = 0;
-    uint8_t buff[512] = {0};
-    unsigned long lastProgress = millis();
-
-    while (http.connected() && written < (size_t)contentLength) {
-        size_t avail = stream->available();
-        if (avail) {
-            int r = stream->readBytes(buff, min(avail, sizeof(buff)));
-            if (r > 0) { Update.write(buff, r); written += r; }
-        }
-        if (millis() - lastProgress > 2000) {
-            lastProgress = millis();
-            Serial.println("[*] Progress: " + String((written * 100) / contentLength) +
-                           "% (" + String(written) + "/" + String(contentLength) + ")");
-        }
-        delay(10);
-    }
-    http.end();
-
-    if (written != (size_t)contentLength) {
-        Serial.println("[!] Download incomplete - aborting");
-        Update.abort();
-        return;
-    }
-
-    if (Update.end() && Update.isFinished()) {
-        // Signal all LEDs before reboot
-        for (int i = 0; i < 5; i++) {
-            setAllLedsImmediate(true);
-            delay(100);
-            setAllLedsImmediate(false);
-            delay(100);
-        }
-        Serial.println("[OK] OTA complete - restarting...");
-        delay(3000);
-        ESP.restart();
-    } else {
-        Serial.println("[!] OTA failed: " + String(Update.getError()));
-        Update.abort();
-    }
-}
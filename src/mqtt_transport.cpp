@@ -0,0 +1,152 @@
+// ============================================================
+// MQTT TRANSPORT
+// Persistent broker session, telemetry publish, command topics,
+// see mqtt_transport.h
+// ============================================================
+
+#include "mqtt_transport.h"
+
+#if TELEMETRY_TRANSPORT_MQTT
+#include "logger.h"
+#include "secrets.h"
+
+#include <stdio.h>
+#include <string.h>
+
+MqttTransport mqttTransport;
+
+#define MQTT_TOPIC(child) MQTT_TOPIC_ROOT child
+
+static const char TOPIC_TELEMETRY[] = MQTT_TOPIC("/telemetry");
+static const char TOPIC_BACKLOG[]   = MQTT_TOPIC("/backlog");
+static const char TOPIC_STATE[]     = MQTT_TOPIC("/status/state");
+
+// Command topics: the same children the RTDB stream watches
+static const char *const TOPIC_SUBSCRIPTIONS[] = {
+    MQTT_TOPIC("/relays/auto_mode"),
+    MQTT_TOPIC("/relays/control/#"),
+    MQTT_TOPIC("/settings/#"),
+};
+
+// Topic + fixed header on top of the largest document
+static const uint16_t MQTT_BUFFER_BYTES =
+    (TELEMETRY_BACKLOG_UPLOAD_BYTES > TELEMETRY_PAYLOAD_MAX_BYTES
+         ? TELEMETRY_BACKLOG_UPLOAD_BYTES : TELEMETRY_PAYLOAD_MAX_BYTES) + 128;
+
+MqttTransport::MqttTransport()
+    : _client(_net),
+      _lastConnectAttempt(0),
+      _everAttempted(false),
+      _configured(false),
+      _connects(0),
+      _published(0),
+      _publishFailures(0),
+      _commands(0) {
+    strcpy(_error, "not connected");
+}
+
+bool MqttTransport::ready() {
+    return _client.connected();
+}
+
+void MqttTransport::service() {
+    if (WiFi.status() != WL_CONNECTED) return;
+
+    if (_client.connected()) {
+        _client.loop();   // keepalive ping + inbound commands
+        return;
+    }
+    if (_everAttempted && millis() - _lastConnectAttempt < MQTT_RECONNECT_INTERVAL_MS) return;
+    _connect();
+}
+
+bool MqttTransport::_connect() {
+    _everAttempted = true;
+    _lastConnectAttempt = millis();
+
+    if (!_configured) {
+        _client.setServer(MQTT_BROKER_HOST, MQTT_BROKER_PORT);
+        _client.setCallback(_onMessageThunk);
+        _client.setKeepAlive(MQTT_KEEPALIVE_S);
+        _client.setSocketTimeout(MQTT_SOCKET_TIMEOUT_S);
+        if (!_client.setBufferSize(MQTT_BUFFER_BYTES)) {
+            LOGE(FB, "MQTT: no heap for a %u byte session buffer", (unsigned)MQTT_BUFFER_BYTES);
+            snprintf(_error, sizeof(_error), "buffer alloc failed");
+            return false;
+        }
+        _configured = true;
+    }
+
+    const char *user = MQTT_USER[0] ? MQTT_USER : nullptr;
+    const char *pass = MQTT_PASS[0] ? MQTT_PASS : nullptr;
+    // Last will: the broker publishes "offline" (retained) when the session dies
+    if (!_client.connect(MQTT_CLIENT_ID, user, pass, TOPIC_STATE, 1, true, "offline", true)) {
+        snprintf(_error, sizeof(_error), "connect failed, state %d", _client.state());
+        LOGW(FB, "MQTT: %s:%u %s", MQTT_BROKER_HOST, (unsigned)MQTT_BROKER_PORT, _error);
+        return false;
+    }
+
+    _connects++;
+    _client.publish(TOPIC_STATE, "online", true);
+    _client.publish(MQTT_TOPIC("/status/firmware"), FIRMWARE_VERSION, true);
+    for (size_t i = 0; i < sizeof(TOPIC_SUBSCRIPTIONS) / sizeof(TOPIC_SUBSCRIPTIONS[0]); i++) {
+        _client.subscribe(TOPIC_SUBSCRIPTIONS[i], 1);   // retained settings arrive right away
+    }
+    LOGI(FB, "MQTT: connected to %s:%u as %s", MQTT_BROKER_HOST, (unsigned)MQTT_BROKER_PORT, MQTT_CLIENT_ID);
+    return true;
+}
+
+bool MqttTransport::_publish(const char *topic, const char *json, bool retained) {
+    if (!_client.connected()) {
+        snprintf(_error, sizeof(_error), "not connected");
+        _publishFailures++;
+        return false;
+    }
+    if (!_client.publish(topic, json, retained)) {
+        // Too large for the session buffer or the socket write failed
+        snprintf(_error, sizeof(_error), "publish failed, state %d", _client.state());
+        _publishFailures++;
+        return false;
+    }
+    _published++;
+    return true;
+}
+
+bool MqttTransport::publishTelemetry(const char *json) {
+    return _publish(TOPIC_TELEMETRY, json, false);
+}
+
+bool MqttTransport::publishBacklog(const char *json) {
+    return _publish(TOPIC_BACKLOG, json, false);
+}
+
+const char *MqttTransport::lastError() {
+    return _error;
+}
+
+void MqttTransport::_onMessageThunk(char *topic, uint8_t *payload, unsigned int length) {
+    mqttTransport._onMessage(topic, payload, length);
+}
+
+// Runs inside _client.loop() on the network task
+void MqttTransport::_onMessage(char *topic, uint8_t *payload, unsigned int length) {
+    const char *path = nullptr;
+    char value[TRANSPORT_COMMAND_VALUE_BYTES];
+    if (!parseTransportCommand(MQTT_TOPIC_ROOT, topic, payload, length, path, value, sizeof(value))) {
+        if (length >= sizeof(value)) LOGW(FB, "MQTT: ignoring %s (%u byte value)", topic, length);
+        return;
+    }
+
+    _commands++;
+    if (_commandHandler) _commandHandler(path, value);
+}
+
+void MqttTransport::report() {
+    char line[112];
+    snprintf(line, sizeof(line), "[PERF] mqtt: %s, %lu sessions, %lu published, %lu failed, %lu commands",
+             _client.connected() ? "up" : "down", (unsigned long)_connects,
+             (unsigned long)_published, (unsigned long)_publishFailures, (unsigned long)_commands);
+    Log.println(line);
+}
+
+#endif // TELEMETRY_TRANSPORT_MQTT
@@ -0,0 +1,327 @@
+// ============================================================
+// OTA STREAM DECODERS
+// gzip (ROM tinfl) and EDL1 delta patches, see ota_decoder.h
+// ============================================================
+
+#include "ota_decoder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(ARDUINO)
+#include "tinfl.h"   // lib/tinfl: the ROM's interface, built for the host
+#elif __has_include("esp32/rom/miniz.h")
+#include "esp32/rom/miniz.h"
+#else
+#include "rom/miniz.h"
+#endif
+
+static inline size_t minSize(size_t a, size_t b) {
+    return a < b ? a : b;
+}
+
+// gzip FLG bits
+#define GZ_FLAG_HCRC    0x02
+#define GZ_FLAG_EXTRA   0x04
+#define GZ_FLAG_NAME    0x08
+#define GZ_FLAG_COMMENT 0x10
+
+// ============================================================
+// GZIP INFLATER
+// ============================================================
+GzipInflater::GzipInflater()
+    : _sink(nullptr),
+      _ctx(nullptr),
+      _inflator(nullptr),
+      _window(nullptr),
+      _windowPos(0),
+      _hdrState(GZ_FIXED),
+      _flags(0),
+      _hdrCount(10),
+      _extraLen(0),
+      _done(false),
+      _error(false) {}
+
+GzipInflater::~GzipInflater() {
+    end();
+}
+
+bool GzipInflater::begin(OtaSinkFn sink, void *ctx) {
+    end();
+    _inflator = malloc(sizeof(tinfl_decompressor));
+    _window = (uint8_t *)malloc(OTA_INFLATE_WINDOW_BYTES);
+    if (!_inflator || !_window) {
+        end();
+        return false;
+    }
+    tinfl_init((tinfl_decompressor *)_inflator);
+
+    _sink = sink;
+    _ctx = ctx;
+    _windowPos = 0;
+    _hdrState = GZ_FIXED;
+    _flags = 0;
+    _hdrCount = 10;
+    _extraLen = 0;
+    _done = false;
+    _error = false;
+    return true;
+}
+
+void GzipInflater::end() {
+    free(_inflator);
+    free(_window);
+    _inflator = nullptr;
+    _window = nullptr;
+}
+
+bool GzipInflater::feed(const uint8_t *data, size_t len) {
+    if (_error || !_inflator) return false;
+    if (_done) return true;   // CRC32/ISIZE trailer
+
+    if (_hdrState != GZ_BODY) {
+        const size_t used = _parseHeader(data, len);
+        if (_error) return false;
+        data += used;
+        len -= used;
+        if (_hdrState != GZ_BODY) return true;
+    }
+
+    tinfl_decompressor *inf = (tinfl_decompressor *)_inflator;
+    for (;;) {
+        size_t inBytes = len;
+        size_t outBytes = OTA_INFLATE_WINDOW_BYTES - _windowPos;
+        const tinfl_status status = tinfl_decompress(inf, data, &inBytes, _window, _window + _windowPos,
+                                                     &outBytes, TINFL_FLAG_HAS_MORE_INPUT);
+        data += inBytes;
+        len -= inBytes;
+
+        if (outBytes > 0) {
+            if (!_sink(_ctx, _window + _windowPos, outBytes)) {
+                _error = true;
+                return false;
+            }
+            _windowPos = (_windowPos + outBytes) & (OTA_INFLATE_WINDOW_BYTES - 1);
+        }
+
+        if (status == TINFL_STATUS_DONE) {
+            _done = true;
+            return true;
+        }
+        if (status < 0) {
+            _error = true;
+            return false;
+        }
+        if (status == TINFL_STATUS_NEEDS_MORE_INPUT && len == 0) {
+            return true;
+        }
+        // TINFL_STATUS_HAS_MORE_OUTPUT: window wrapped, keep going
+    }
+}
+
+// RFC 1952: ID1 ID2 CM FLG MTIME(4) XFL OS [EXTRA] [NAME] [COMMENT] [HCRC]
+size_t GzipInflater::_parseHeader(const uint8_t *data, size_t len) {
+    size_t i = 0;
+    while (i < len && _hdrState != GZ_BODY) {
+        const uint8_t b = data[i++];
+        switch (_hdrState) {
+            case GZ_FIXED: {
+                const uint16_t pos = 10 - _hdrCount;
+                if ((pos == 0 && b != 0x1F) || (pos == 1 && b != 0x8B) || (pos == 2 && b != 8)) {
+                    _error = true;
+                    return i;
+                }
+                if (pos == 3) _flags = b;
+                if (--_hdrCount == 0) _nextHeaderField(GZ_FIXED);
+                break;
+            }
+            case GZ_EXTRA_LEN:
+                _extraLen |= (uint16_t)b << (_hdrCount == 2 ? 0 : 8);
+                if (--_hdrCount == 0) {
+                    if (_extraLen == 0) {
+                        _nextHeaderField(GZ_EXTRA);
+                    } else {
+                        _hdrState = GZ_EXTRA;
+                        _hdrCount = _extraLen;
+                    }
+                }
+                break;
+            case GZ_EXTRA:
+                if (--_hdrCount == 0) _nextHeaderField(GZ_EXTRA);
+                break;
+            case GZ_NAME:
+            case GZ_COMMENT:
+                if (b == 0) _nextHeaderField(_hdrState);
+                break;
+            case GZ_HCRC:
+                if (--_hdrCount == 0) _nextHeaderField(GZ_HCRC);
+                break;
+            case GZ_BODY:
+                break;
+        }
+    }
+    return i;
+}
+
+void GzipInflater::_nextHeaderField(HeaderState done) {
+    if (done < GZ_EXTRA_LEN && (_flags & GZ_FLAG_EXTRA)) {
+        _hdrState = GZ_EXTRA_LEN;
+        _hdrCount = 2;
+        _extraLen = 0;
+    } else if (done < GZ_NAME && (_flags & GZ_FLAG_NAME)) {
+        _hdrState = GZ_NAME;
+    } else if (done < GZ_COMMENT && (_flags & GZ_FLAG_COMMENT)) {
+        _hdrState = GZ_COMMENT;
+    } else if (done < GZ_HCRC && (_flags & GZ_FLAG_HCRC)) {
+        _hdrState = GZ_HCRC;
+        _hdrCount = 2;
+    } else {
+        _hdrState = GZ_BODY;
+    }
+}
+
+// ============================================================
+// DELTA PATCHER
+// ============================================================
+DeltaPatcher::DeltaPatcher()
+    : _sink(nullptr),
+      _sinkCtx(nullptr),
+      _baseRead(nullptr),
+      _baseCtx(nullptr),
+      _baseSize(0),
+      _baseSha256(nullptr),
+      _scratch(nullptr),
+      _scratchLen(0),
+      _state(DP_ERROR),
+      _have(0),
+      _remaining(0),
+      _targetSize(0),
+      _produced(0) {}
+
+void DeltaPatcher::begin(OtaSinkFn sink, void *sinkCtx, OtaBaseReadFn baseRead, void *baseCtx,
+                         uint32_t baseSize, const uint8_t *baseSha256,
+                         uint8_t *scratch, size_t scratchLen) {
+    _sink = sink;
+    _sinkCtx = sinkCtx;
+    _baseRead = baseRead;
+    _baseCtx = baseCtx;
+    _baseSize = baseSize;
+    _baseSha256 = baseSha256;
+    _scratch = scratch;
+    _scratchLen = scratchLen;
+    _state = DP_HEADER;
+    _have = 0;
+    _remaining = 0;
+    _targetSize = 0;
+    _produced = 0;
+}
+
+bool DeltaPatcher::feedThunk(void *self, const uint8_t *data, size_t len) {
+    return static_cast<DeltaPatcher *>(self)->feed(data, len);
+}
+
+bool DeltaPatcher::feed(const uint8_t *data, size_t len) {
+    while (len > 0) {
+        switch (_state) {
+            case DP_HEADER: {
+                const size_t n = minSize(sizeof(_header) - _have, len);
+                memcpy(_header + _have, data, n);
+                _have += n;
+                data += n;
+                len -= n;
+                if (_have < sizeof(_header)) break;
+
+                if (memcmp(_header, OTA_DELTA_MAGIC, 4) != 0 || _u32(_header + 4) != _baseSize ||
+                    memcmp(_header + 8, _baseSha256, 32) != 0) {
+                    _state = DP_ERROR;   // patch was made against another image
+                    return false;
+                }
+                _targetSize = _u32(_header + 40);
+                _have = 0;
+                _state = DP_OP;
+                break;
+            }
+            case DP_OP: {
+                const uint8_t op = *data++;
+                len--;
+                _have = 0;
+                if (op == 0x01) {
+                    _state = DP_COPY_ARGS;
+                } else if (op == 0x02) {
+                    _state = DP_INSERT_LEN;
+                } else if (op == 0x00 && _produced == _targetSize) {
+                    _state = DP_DONE;
+                } else {
+                    _state = DP_ERROR;
+                }
+                break;
+            }
+            case DP_COPY_ARGS:
+            case DP_INSERT_LEN: {
+                const size_t want = (_state == DP_COPY_ARGS) ? 8 : 4;
+                const size_t n = minSize(want - _have, len);
+                memcpy(_args + _have, data, n);
+                _have += n;
+                data += n;
+                len -= n;
+                if (_have < want) break;
+
+                const uint32_t a = _u32(_args);
+                if (_state == DP_COPY_ARGS) {
+                    const uint32_t count = _u32(_args + 4);
+                    if (count > _targetSize - _produced || !_copyFromBase(a, count)) {
+                        _state = DP_ERROR;
+                        return false;
+                    }
+                    _state = DP_OP;
+                } else {
+                    if (a > _targetSize - _produced) {
+                        _state = DP_ERROR;
+                        return false;
+                    }
+                    _remaining = a;
+                    _state = (a > 0) ? DP_INSERT_DATA : DP_OP;
+                }
+                break;
+            }
+            case DP_INSERT_DATA: {
+                const size_t n = minSize(_remaining, len);
+                if (!_sink(_sinkCtx, data, n)) {
+                    _state = DP_ERROR;
+                    return false;
+                }
+                _produced += n;
+                _remaining -= n;
+                data += n;
+                len -= n;
+                if (_remaining == 0) _state = DP_OP;
+                break;
+            }
+            case DP_DONE:
+                return true;   // padding after END
+            case DP_ERROR:
+                return false;
+        }
+    }
+    return _state != DP_ERROR;
+}
+
+bool DeltaPatcher::_copyFromBase(uint32_t offset, uint32_t len) {
+    if (offset > _baseSize || len > _baseSize - offset) {
+        return false;
+    }
+    while (len > 0) {
+        const size_t n = minSize(len, _scratchLen);
+        if (!_baseRead(_baseCtx, offset, _scratch, n) || !_sink(_sinkCtx, _scratch, n)) {
+            return false;
+        }
+        offset += n;
+        len -= n;
+        _produced += n;
+    }
+    return true;
+}
+
+uint32_t DeltaPatcher::_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
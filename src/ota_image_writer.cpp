@@ -0,0 +1,66 @@
+// ============================================================
+// OTA IMAGE WRITER
+// Flash write + running SHA-256, see ota_image_writer.h
+// ============================================================
+
+#include "ota_image_writer.h"
+#include <ctype.h>
+#include <string.h>
+
+OtaImageWriter::OtaImageWriter(FlashRegion &region)
+    : _region(region), _offset(0), _erasedEnd(0) {
+}
+
+void OtaImageWriter::restart() {
+    _sha.reset();
+    _offset = 0;
+    _erasedEnd = 0;
+}
+
+bool OtaImageWriter::resume(uint32_t offset, uint8_t *scratch, size_t scratchLen) {
+    restart();
+    const uint32_t sector = _region.sectorSize();
+    if (offset == 0) return true;
+    if (!sector || offset % sector != 0 || offset > _region.size() || !scratch || !scratchLen) return false;
+
+    for (uint32_t pos = 0; pos < offset; ) {
+        const size_t n = (offset - pos < scratchLen) ? (size_t)(offset - pos) : scratchLen;
+        if (!_region.read(pos, scratch, n)) {
+            restart();
+            return false;
+        }
+        _sha.update(scratch, n);
+        pos += n;
+    }
+    _offset = offset;
+    _erasedEnd = offset;
+    return true;
+}
+
+bool OtaImageWriter::write(const uint8_t *data, size_t len) {
+    const uint32_t end = _offset + len;
+    if (end > _region.size()) return false;
+
+    const uint32_t sector = _region.sectorSize();
+    while (_erasedEnd < end) {
+        if (!_region.eraseSector(_erasedEnd)) return false;
+        _erasedEnd += sector;
+    }
+    if (!_region.write(_offset, data, len)) return false;
+
+    _sha.update(data, len);
+    _offset = end;
+    return true;
+}
+
+bool OtaImageWriter::verify(const char *expectedHex, char actualHex[2 * Sha256::DIGEST_BYTES + 1]) {
+    uint8_t digest[Sha256::DIGEST_BYTES];
+    _sha.finish(digest);
+    Sha256::toHex(digest, actualHex);
+
+    if (strlen(expectedHex) != 2 * Sha256::DIGEST_BYTES) return false;
+    for (size_t i = 0; i < 2 * Sha256::DIGEST_BYTES; i++) {
+        if (tolower((unsigned char)expectedHex[i]) != actualHex[i]) return false;
+    }
+    return true;
+}
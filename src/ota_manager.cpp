@@ -0,0 +1,863 @@
+// ============================================================
+// OTA MANAGER
+// Version check against GitHub + background firmware download
+// ============================================================
+
+#include "ota_manager.h"
+#include "logger.h"
+#include "https_pool.h"
+#include "cycle_profiler.h"
+#include "hal.h"
+
+#include <WiFi.h>
+#include <Preferences.h>
+
+OTAManager otaManager;
+
+OTAManager::OTAManager()
+    : _state(OTA_IDLE),
+      _progress(0),
+      _bytesWritten(0),
+      _totalBytes(0),
+      _throughputBps(0),
+      _nextCheckMs(0),
+      _checkFailures(0),
+      _deviceId(0),
+      _jitterState(1),
+      _rolloutSeenEpoch(0),
+      _validatorsLoaded(false),
+      _jobEncoding(OTA_ENC_RAW),
+      _jobSize(0),
+      _task(nullptr),
+      _buffer(nullptr),
+      _checkpointed(0),
+      _part(nullptr),
+      _writer(_partRegion),
+      _writeFailed(false),
+      _runningSize(0),
+      _runningShaValid(false),
+      _imageFailedLoaded(false) {
+    _latest.fileSize = 0;
+    _latest.isValid = false;
+}
+
+bool OTAManager::begin() {
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    const esp_partition_t *next = _getNextOtaPartition();
+    LOGI(OTA, "Running from %s, updates go to %s", running ? running->label : "?", next ? next->label : "?");
+
+    _deviceId = ESP.getEfuseMac();
+    _jitterState = otaJitterSeed(_deviceId);
+    const uint32_t firstCheckMs = otaFirstCheckMs(_jitterState);
+    _nextCheckMs = millis() + firstCheckMs;
+    const uint16_t cohort = otaCohort(_deviceId);
+    LOGI(OTA, "Rollout cohort %u.%02u%%, first check in %lu s",
+         (unsigned)(cohort / 100), (unsigned)(cohort % 100), (unsigned long)(firstCheckMs / 1000));
+    return next != nullptr;
+}
+
+// ============================================================
+// BOOT VALIDATION / ROLLBACK
+// ============================================================
+bool OTAManager::validateCurrentFirmware() {
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    esp_ota_img_states_t imgState;
+    if (!running || esp_ota_get_state_partition(running, &imgState) != ESP_OK) {
+        return true;   // factory image or no otadata: nothing to validate
+    }
+    return imgState != ESP_OTA_IMG_INVALID && imgState != ESP_OTA_IMG_ABORTED;
+}
+
+bool OTAManager::markCurrentFirmwareValid() {
+    return esp_ota_mark_app_valid_cancel_rollback() == ESP_OK;
+}
+
+bool OTAManager::forcedRollback() {
+    if (isBusy()) return false;
+    _state = OTA_ROLLEDBACK;
+    // Only returns on failure (no valid previous image)
+    esp_ota_mark_app_invalid_rollback_and_reboot();
+    _state = OTA_FAILED;
+    _lastError = "No previous firmware to roll back to";
+    return false;
+}
+
+// ============================================================
+// VERSION CHECK
+// ============================================================
+bool OTAManager::checkForUpdates() {
+    if (isBusy()) {
+        LOGI(OTA, "Update in progress (%d%%) - skipping check", getProgress());
+        return false;
+    }
+    if (WiFi.status() != WL_CONNECTED) {
+        LOGW(OTA, "WiFi not connected, skipping OTA check");
+        return false;
+    }
+
+    // Jittered interval, or the backoff after failed checks
+    if (!checkDue()) {
+        return false;
+    }
+
+    _state = OTA_CHECKING;
+    _loadVersionValidators();
+
+    LOGI(OTA, "Fetching version info from: " VERSION_JSON_URL);
+
+    HTTPClient *http = httpsPool.acquire(HTTPS_CH_OTA_CHECK, VERSION_JSON_URL);
+    if (!http) {
+        _checkFailed("Failed to begin HTTP request");
+        return false;
+    }
+    http->setConnectTimeout(10000);
+
+    // Conditional GET: a 304 costs no body and no JSON parse
+    const char *headerKeys[] = {"ETag", "Last-Modified"};
+    http->collectHeaders(headerKeys, 2);
+    if (!_versionEtag.isEmpty()) {
+        http->addHeader("If-None-Match", _versionEtag);
+    }
+    if (!_versionLastModified.isEmpty()) {
+        http->addHeader("If-Modified-Since", _versionLastModified);
+    }
+
+    int httpCode = http->GET();
+    if (httpCode == HTTP_CODE_NOT_MODIFIED) {
+        httpsPool.release(http);
+        _checkSucceeded();
+        LOGI(OTA, "version.json not modified - firmware is up to date");
+        _state = OTA_IDLE;
+        return false;
+    }
+    if (httpCode != HTTP_CODE_OK) {
+        httpsPool.release(http, false);
+        _checkFailed("HTTP Error: " + String(httpCode));
+        return false;
+    }
+
+    const String etag = http->header("ETag");
+    const String lastModified = http->header("Last-Modified");
+    String payload = http->getString();
+    httpsPool.release(http);
+
+    JsonDocument doc;
+    if (deserializeJson(doc, payload)) {
+        _checkFailed("JSON parse error");
+        return false;
+    }
+    _checkSucceeded();
+
+    _latest.version     = doc["version"]      | "0.0.0";
+    _latest.downloadUrl = doc["download_url"] | "";
+    _latest.sha256      = doc["sha256"]       | "";
+    _latest.fileSize    = doc["size"]         | 0L;
+    _latest.isValid     = !_latest.downloadUrl.isEmpty();
+    _latest.gzipUrl     = doc["gzip_url"]     | "";
+    _latest.deltaUrl    = "";
+#if OTA_ALLOW_DELTA
+    // deltas: [{ "from_sha256": ..., "url": ... }, ...]
+    JsonArray deltas = doc["deltas"].as<JsonArray>();
+    if (!deltas.isNull() && deltas.size() > 0 && _hashRunningImage()) {
+        for (JsonObject d : deltas) {
+            if (_runningShaMatches(d["from_sha256"] | "")) {
+                _latest.deltaUrl = d["url"] | "";
+                break;
+            }
+        }
+    }
+#endif
+
+    LOGI(OTA, "Latest: %s  Current: " FIRMWARE_VERSION, _latest.version.c_str());
+
+    OtaOffer offer;
+    offer.version             = _latest.version.c_str();
+    offer.sha256              = _latest.sha256.c_str();
+    offer.fileSize            = _latest.fileSize > 0 ? (uint32_t)_latest.fileSize : 0;
+    offer.hasDownloadUrl      = _latest.isValid;
+    offer.hasGzipUrl          = !_latest.gzipUrl.isEmpty();
+    offer.hasDeltaUrl         = !_latest.deltaUrl.isEmpty();
+    offer.encodedFailedBefore = _latest.sha256 == _encodedFailedSha;
+    offer.imageFailedBefore   = _imageFailedBefore(_latest.sha256);
+
+    // Staged rollout fields, all optional
+    const int percent = doc["rollout_percent"] | 100;
+    OtaRollout rollout;
+    rollout.percent       = percent < 0 ? 0 : (percent > 100 ? 100 : (uint8_t)percent);
+    rollout.notBefore     = (uint32_t)(doc["not_before"]    | 0L);
+    rollout.maxConcurrent = (uint16_t)(doc["max_concurrent"] | 0L);
+    rollout.fleetSize     = (uint32_t)(doc["fleet_size"]    | 0L);
+    rollout.waveS         = (uint32_t)(doc["wave_s"]        | (long)OTA_ROLLOUT_WAVE_S);
+    const char *minVersion = doc["min_version"].as<const char *>();
+    rollout.minVersion    = minVersion ? minVersion : "";
+    rollout.forceUpdate   = doc["force_update"]    | false;
+
+    OtaEncoding encoding;
+    OtaAction action = otaDecide(offer, FIRMWARE_VERSION, encoding);
+    if (action == OTA_ACT_INSTALL) {
+        action = _rolloutGate(rollout);
+    }
+    if (action == OTA_ACT_BLOCKED) {
+        // Nothing to do until version.json changes: let the validators skip it
+        LOGW(OTA, "%s failed verification before - waiting for a new release", _latest.version.c_str());
+        _saveVersionValidators(etag, lastModified);
+        _state = OTA_IDLE;
+        return false;
+    }
+    if (action != OTA_ACT_NONE) {
+        // Validators only cover "up to date": a pending update is re-read every time
+        _saveVersionValidators("", "");
+        if (action == OTA_ACT_REJECT) {
+            _fail("Missing or malformed sha256 in version.json");
+            return false;
+        }
+        if (action != OTA_ACT_INSTALL) {
+            _state = OTA_IDLE;   // not this device's turn yet
+            return false;
+        }
+        _state = OTA_UPDATE_AVAILABLE;
+        LOGI(OTA, "New firmware available - starting background OTA...");
+
+        switch (encoding) {
+        case OTA_ENC_DELTA:
+            return _startJob(_latest.downloadUrl, _latest.sha256, _latest.deltaUrl,
+                             OTA_ENC_DELTA, _latest.fileSize);
+        case OTA_ENC_GZIP:
+            return _startJob(_latest.downloadUrl, _latest.sha256, _latest.gzipUrl,
+                             OTA_ENC_GZIP, _latest.fileSize);
+        default:
+            return downloadAndInstall(_latest.downloadUrl, _latest.sha256);
+        }
+    }
+
+    LOGI(OTA, "Firmware is up to date");
+    _saveVersionValidators(etag, lastModified);
+    _state = OTA_IDLE;
+    return false;
+}
+
+// ============================================================
+// CONDITIONAL POLLING / BACKOFF
+// - ETag + Last-Modified kept in NVS_NAMESPACE_OTA, tagged with
+//   the firmware version they were stored under, so a freshly
+//   flashed image always does one full fetch
+// ============================================================
+void OTAManager::_loadVersionValidators() {
+    if (_validatorsLoaded) return;
+    _validatorsLoaded = true;
+
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE_OTA, true)) return;
+    if (prefs.getString("vj_fw", "") == FIRMWARE_VERSION) {
+        _versionEtag = prefs.getString("vj_etag", "");
+        _versionLastModified = prefs.getString("vj_lastmod", "");
+    }
+    prefs.end();
+}
+
+void OTAManager::_saveVersionValidators(const String& etag, const String& lastModified) {
+    if (etag == _versionEtag && lastModified == _versionLastModified) return;   // spare NVS writes
+    _versionEtag = etag;
+    _versionLastModified = lastModified;
+
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE_OTA, false)) return;
+    prefs.putString("vj_fw", FIRMWARE_VERSION);
+    prefs.putString("vj_etag", etag);
+    prefs.putString("vj_lastmod", lastModified);
+    prefs.end();
+}
+
+// A published image whose sha256 did not match what was downloaded
+// would fail the same way on every attempt: remembered across reboots
+bool OTAManager::_imageFailedBefore(const String& sha256) {
+    if (!_imageFailedLoaded) {
+        _imageFailedLoaded = true;
+        Preferences prefs;
+        if (prefs.begin(NVS_NAMESPACE_OTA, true)) {
+            _imageFailedSha = prefs.getString("bad_sha", "");
+            prefs.end();
+        }
+    }
+    return !sha256.isEmpty() && sha256.equalsIgnoreCase(_imageFailedSha);
+}
+
+void OTAManager::_saveImageFailedSha(const String& sha256) {
+    _imageFailedSha = sha256;
+    _imageFailedLoaded = true;
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE_OTA, false)) return;
+    prefs.putString("bad_sha", sha256);
+    prefs.end();
+}
+
+bool OTAManager::checkDue() {
+    return (int32_t)(millis() - _nextCheckMs) >= 0;
+}
+
+void OTAManager::_checkSucceeded() {
+    _checkFailures = 0;
+    _nextCheckMs = millis() + otaNextCheckMs(0, _jitterState);
+}
+
+void OTAManager::_checkFailed(const String& error) {
+    if (_checkFailures < 16) _checkFailures++;
+    const uint32_t waitMs = otaNextCheckMs(_checkFailures, _jitterState);
+    _nextCheckMs = millis() + waitMs;
+    _fail(error + " (next check in " + String(waitMs / 1000) + " s)");
+}
+
+// ============================================================
+// STAGED ROLLOUT
+// - The first sighting is kept in RAM only: after a reboot the
+//   device simply waits its wave again
+// ============================================================
+OtaAction OTAManager::_rolloutGate(const OtaRollout& rollout) {
+    if (_latest.sha256 != _rolloutSha) {
+        _rolloutSha = _latest.sha256;
+        _rolloutSeenEpoch = 0;
+    }
+
+    const uint32_t now = hal.clock->epoch();
+    uint32_t startEpoch = 0;
+    const OtaAction action = otaRolloutDecide(rollout, FIRMWARE_VERSION, _deviceId, now,
+                                              _rolloutSeenEpoch, startEpoch);
+    switch (action) {
+    case OTA_ACT_NOT_SELECTED:
+        LOGI(OTA, "%s is rolled out to %u%% - not this device yet",
+             _latest.version.c_str(), (unsigned)rollout.percent);
+        break;
+    case OTA_ACT_DEFER:
+        // Only a synced clock counts as the first sighting
+        if (_rolloutSeenEpoch < OTA_EPOCH_SYNCED_MIN && now >= OTA_EPOCH_SYNCED_MIN) {
+            _rolloutSeenEpoch = now;
+        }
+        if (startEpoch == 0) {
+            LOGI(OTA, "%s selected - waiting for the clock to pick the rollout wave",
+                 _latest.version.c_str());
+        } else {
+            LOGI(OTA, "%s selected - install in %lu s (rollout wave)",
+                 _latest.version.c_str(), (unsigned long)(startEpoch - now));
+        }
+        break;
+    case OTA_ACT_INSTALL:
+        if (rollout.forceUpdate || (rollout.minVersion[0] &&
+                                    otaVersionCompare(FIRMWARE_VERSION, rollout.minVersion) < 0)) {
+            LOGI(OTA, "Mandatory update (force_update / min_version %s)", rollout.minVersion);
+        }
+        break;
+    default:
+        break;
+    }
+    return action;
+}
+
+FirmwareVersion OTAManager::getLatestVersion() {
+    return _latest;
+}
+
+// ============================================================
+// BACKGROUND DOWNLOAD JOB
+// ============================================================
+bool OTAManager::downloadAndInstall(const String& downloadUrl, const String& expectedSha256) {
+    return _startJob(downloadUrl, expectedSha256, downloadUrl, OTA_ENC_RAW, 0);
+}
+
+bool OTAManager::_startJob(const String& url, const String& sha256, const String& sourceUrl,
+                           OtaEncoding encoding, uint32_t size) {
+    if (_task != nullptr) {
+        return false;   // one job at a time
+    }
+
+    _buffer = (uint8_t *)malloc(OTA_BUFFER_BYTES);
+    if (!_buffer) {
+        _fail("No memory for OTA buffer");
+        return false;
+    }
+
+    _jobUrl = url;
+    _jobSha256 = sha256;
+    _jobSourceUrl = sourceUrl;
+    _jobEncoding = encoding;
+    _jobSize = size;
+    _progress = 0;
+    _bytesWritten = 0;
+    _totalBytes = 0;
+    _throughputBps = 0;
+    _state = OTA_DOWNLOADING;
+
+    if (xTaskCreatePinnedToCore(_downloadTaskEntry, "ota", OTA_TASK_STACK_BYTES, this,
+                                OTA_TASK_PRIORITY, &_task, OTA_TASK_CORE) != pdPASS) {
+        free(_buffer);
+        _buffer = nullptr;
+        _task = nullptr;
+        _fail("Failed to start OTA task");
+        return false;
+    }
+    return true;
+}
+
+void OTAManager::_downloadTaskEntry(void *param) {
+    OTAManager *self = static_cast<OTAManager *>(param);
+    self->_runDownloadJob();
+
+    free(self->_buffer);
+    self->_buffer = nullptr;
+    self->_task = nullptr;
+    vTaskDelete(nullptr);
+}
+
+void OTAManager::_runDownloadJob() {
+    LOGI(OTA, "Starting OTA update process...");
+
+    _part = _getNextOtaPartition();
+    if (!_part) {
+        _fail("No OTA partition available");
+        return;
+    }
+    const OtaEncoding startEncoding = _jobEncoding;
+
+    // Pick up where an earlier attempt (or boot) left off
+    if (!_partRegion.begin(_part, 0, _part->size)) {
+        _fail("OTA partition is not sector aligned");
+        return;
+    }
+    const uint32_t resumeAt = _loadCheckpoint(_part);
+    if (resumeAt > 0) {
+        if (_writer.resume(resumeAt, _buffer, OTA_BUFFER_BYTES)) {
+            LOGI(OTA, "Resuming OTA at %u/%u bytes", (unsigned)resumeAt, (unsigned)getTotalBytes());
+            _jobEncoding = OTA_ENC_RAW;   // decoder state is not resumable
+        } else {
+            LOGW(OTA, "Could not re-read partial image - starting over");
+        }
+    } else {
+        _writer.restart();
+    }
+    _checkpointed = _writer.offset();
+    if (_writer.offset() == 0) {
+        _totalBytes = 0;
+        _saveCheckpoint(0);
+    }
+
+    DownloadResult result = DL_INTERRUPTED;
+    for (int attempt = 1; attempt <= OTA_RESUME_MAX_ATTEMPTS; attempt++) {
+        result = _downloadFrom();
+        if (result != DL_INTERRUPTED) break;
+
+        _saveCheckpoint(_writer.offset() & ~(OTA_SECTOR_BYTES - 1));
+        LOGW(OTA, "Download interrupted at %u/%u bytes (attempt %d/%d)",
+             (unsigned)_writer.offset(), (unsigned)getTotalBytes(), attempt, (int)OTA_RESUME_MAX_ATTEMPTS);
+        vTaskDelay(pdMS_TO_TICKS(OTA_RESUME_RETRY_DELAY_MS * attempt));
+    }
+
+    if (result != DL_COMPLETE) {
+        if (result == DL_INTERRUPTED) {
+            _fail("Download incomplete - will resume from " + String(_checkpointed) + " bytes");
+        } else {
+            _clearCheckpoint();
+        }
+        return;
+    }
+
+    // Verify before the boot partition is switched
+    const bool hashOk = _verifyDownloadHash(_jobSha256);
+    _clearCheckpoint();
+    if (!hashOk) {
+        if (startEncoding != OTA_ENC_RAW) {
+            _encodedFailedSha = _jobSha256;   // next attempt fetches the full image
+        } else {
+            _saveImageFailedSha(_jobSha256);  // the published image itself is bad
+        }
+        return;   // _verifyDownloadHash recorded the error
+    }
+
+    _state = OTA_INSTALLING;
+    // Validates the image header/checksum before updating otadata
+    esp_err_t err = esp_ota_set_boot_partition(_part);
+    if (err == ESP_OK) {
+        _progress = 100;
+        _state = OTA_SUCCESS;   // owner signals LEDs and restarts
+        LOGI(OTA, "OTA image written (%u bytes, %.1f KB/s on the wire)",
+             (unsigned)_writer.offset(), getThroughputBps() / 1024.0f);
+    } else {
+        _fail("OTA failed: image rejected (" + String(err) + ")");
+    }
+}
+
+// One HTTP session. Raw images are fetched (or Range-resumed) from the
+// writer's offset; gzip/delta sources always start at 0 and are decoded
+// on the fly.
+OTAManager::DownloadResult OTAManager::_downloadFrom() {
+    const uint32_t startOffset = _writer.offset();
+    const OtaEncoding encoding = (startOffset == 0) ? _jobEncoding : OTA_ENC_RAW;
+    _writeFailed = false;
+    String firmwareUrl = (encoding == OTA_ENC_RAW) ? _jobUrl : _jobSourceUrl;
+    const char *headerKeys[] = {"Location", "Content-Range"};
+
+    // Redirects are followed here (not in HTTPClient) so each hop gets
+    // a pooled connection to the right host
+    HTTPClient *http = nullptr;
+    int httpCode = 0;
+    for (int redirectCount = 0; redirectCount < 3; redirectCount++) {
+        if (startOffset > 0) {
+            LOGI(OTA, "Connecting to %s (from byte %u)", firmwareUrl.c_str(), (unsigned)startOffset);
+        } else {
+            LOGI(OTA, "Connecting to %s", firmwareUrl.c_str());
+        }
+
+        http = httpsPool.acquire(HTTPS_CH_OTA_DOWNLOAD, firmwareUrl);
+        if (!http) {
+            return DL_INTERRUPTED;
+        }
+        http->setConnectTimeout(30000);
+        http->setTimeout(30000);
+        http->collectHeaders(headerKeys, 2);
+        if (startOffset > 0) {
+            http->addHeader("Range", "bytes=" + String(startOffset) + "-");
+        }
+        httpCode = http->GET();
+        LOGD(OTA, "HTTP Response: %d", httpCode);
+
+        if (httpCode == 301 || httpCode == 302 || httpCode == 307) {
+            String loc = http->header("Location");
+            if (loc.length() > 0) {
+                httpsPool.release(http, false);
+                http = nullptr;
+                firmwareUrl = loc;
+                continue;
+            }
+        }
+        break;
+    }
+    if (!http) {
+        return DL_INTERRUPTED;   // too many redirects
+    }
+
+    uint32_t total = 0;
+    if (httpCode == HTTP_CODE_PARTIAL_CONTENT) {
+        const String range = http->header("Content-Range");
+        uint32_t first = 0;
+        if (!otaParseContentRange(range.c_str(), first, total)) {
+            httpsPool.release(http, false);
+            return DL_INTERRUPTED;   // retry; a proxy may have mangled it
+        }
+        if (first != startOffset) {
+            httpsPool.release(http, false);
+            _fail("Server resumed at byte " + String(first) + ", expected " + String(startOffset));
+            return DL_FATAL;
+        }
+    } else if (httpCode == HTTP_CODE_OK) {
+        if (startOffset > 0) {
+            LOGW(OTA, "Server ignored Range - restarting download from 0");
+            _writer.restart();
+            _saveCheckpoint(0);
+        }
+        if (encoding == OTA_ENC_RAW) {
+            total = (http->getSize() > 0) ? (uint32_t)http->getSize() : 0;
+        } else {
+            total = _jobSize;   // decoded size from version.json
+        }
+    } else {
+        // 416 means our checkpoint no longer matches the file
+        httpsPool.release(http, false);
+        if (httpCode == 416) {
+            _fail("Range not satisfiable - discarding partial image");
+            return DL_FATAL;
+        }
+        return DL_INTERRUPTED;
+    }
+
+    if (total == 0) {
+        httpsPool.release(http, false);
+        _fail("Invalid content length");
+        return DL_FATAL;
+    }
+    if (getTotalBytes() != 0 && total != getTotalBytes()) {
+        httpsPool.release(http, false);
+        _fail("Image size changed (" + String(getTotalBytes()) + " -> " + String(total) + ")");
+        return DL_FATAL;
+    }
+    if (total > _part->size) {
+        httpsPool.release(http, false);
+        _fail("Not enough space for OTA (partition: " + String(_part->size) + " bytes)");
+        return DL_FATAL;
+    }
+    if (getTotalBytes() == 0) {
+        _totalBytes = total;
+        _saveCheckpoint(0);   // records the image size
+        LOGI(OTA, "Firmware size: %u bytes", (unsigned)total);
+    }
+
+    // Decoder chain: socket -> [inflate] -> [patch] -> _emit()
+    GzipInflater inflater;
+    DeltaPatcher patcher;
+    uint8_t *scratch = nullptr;
+    if (encoding != OTA_ENC_RAW) {
+        bool ready;
+        if (encoding == OTA_ENC_DELTA) {
+            scratch = (uint8_t *)malloc(OTA_BUFFER_BYTES);
+            ready = scratch && inflater.begin(DeltaPatcher::feedThunk, &patcher);
+            patcher.begin(_emitThunk, this, _readBaseThunk, (void *)esp_ota_get_running_partition(),
+                          _runningSize, _runningSha, scratch, OTA_BUFFER_BYTES);
+        } else {
+            ready = inflater.begin(_emitThunk, this);
+        }
+        if (!ready) {
+            free(scratch);
+            httpsPool.release(http, false);
+            LOGW(OTA, "No memory for decoder - using full image");
+            _jobEncoding = OTA_ENC_RAW;
+            return DL_INTERRUPTED;
+        }
+        LOGI(OTA, "Streaming %s image (%d bytes on the wire)",
+             encoding == OTA_ENC_DELTA ? "delta" : "gzip", http->getSize());
+    }
+
+    WiFiClient *stream = http->getStreamPtr();
+    uint32_t sessionBytes = 0;
+    bool decodeError = false;
+    const unsigned long startMillis = millis();
+    unsigned long lastProgress = startMillis;
+    unsigned long lastData = startMillis;
+
+    while (stream && http->connected() && _writer.offset() < total) {
+        size_t avail = stream->available();
+        if (avail == 0) {
+            if (millis() - lastData > OTA_STALL_TIMEOUT_MS) break;
+            vTaskDelay(1);   // yield; other tasks keep running
+            continue;
+        }
+
+        size_t want = min(avail, (size_t)OTA_BUFFER_BYTES);
+        if (encoding == OTA_ENC_RAW) {
+            want = min(want, (size_t)(total - _writer.offset()));
+        }
+        int r = stream->readBytes(_buffer, want);
+        if (r <= 0) continue;
+
+        bool ok;
+        {
+            ScopedCycles prof(PROF_OTA_CHUNK);
+            if (encoding == OTA_ENC_RAW) {
+                ok = _emit(_buffer, r);
+            } else {
+                ok = inflater.feed(_buffer, r) && !patcher.hasError();
+                decodeError = !ok && !_writeFailed;
+            }
+        }
+        if (!ok) break;
+
+        sessionBytes += r;
+        lastData = millis();
+        const unsigned long elapsed = lastData - startMillis;
+        _throughputBps = elapsed ? (uint32_t)(((uint64_t)sessionBytes * 1000) / elapsed) : 0;
+
+        if (lastData - lastProgress > 2000) {
+            lastProgress = lastData;
+            LOGI(OTA, "Progress: %d%% (%u/%u, %.1f KB/s)", getProgress(),
+                 (unsigned)_writer.offset(), (unsigned)total, getThroughputBps() / 1024.0f);
+        }
+    }
+    // Keep the connection only if the body was consumed completely
+    // (a gzip trailer may still be in flight)
+    httpsPool.release(http, encoding == OTA_ENC_RAW && _writer.offset() == total);
+    inflater.end();
+    free(scratch);
+
+    if (_writeFailed) {
+        _fail("Flash write failed at offset " + String(_writer.offset()));
+        return DL_FATAL;
+    }
+    if (decodeError || (encoding != OTA_ENC_RAW && _writer.offset() > total)) {
+        // Bytes already written may be wrong: start over with the full image
+        LOGW(OTA, "Compressed/delta image could not be decoded - using full image");
+        _encodedFailedSha = _jobSha256;
+        _jobEncoding = OTA_ENC_RAW;
+        _writer.restart();
+        _saveCheckpoint(0);
+        return DL_INTERRUPTED;
+    }
+    if (encoding != OTA_ENC_RAW && _writer.offset() < total) {
+        _jobEncoding = OTA_ENC_RAW;   // resume the rest from the full image
+    }
+    return (_writer.offset() == total) ? DL_COMPLETE : DL_INTERRUPTED;
+}
+
+// Final image bytes, in order: flash + hash + checkpoint
+bool OTAManager::_emit(const uint8_t *data, size_t len) {
+    const bool fits = _writer.offset() + len <= getTotalBytes();
+    if (!fits || !_writer.write(data, len)) {
+        _writeFailed = fits;
+        return false;
+    }
+
+    const uint32_t offset = _writer.offset();
+    _bytesWritten = offset;
+    _progress = (int)(((uint64_t)offset * 100) / getTotalBytes());
+    if (offset - _checkpointed >= OTA_CHECKPOINT_BYTES) {
+        _saveCheckpoint(offset & ~(OTA_SECTOR_BYTES - 1));
+    }
+    return true;
+}
+
+bool OTAManager::_emitThunk(void *self, const uint8_t *data, size_t len) {
+    return static_cast<OTAManager *>(self)->_emit(data, len);
+}
+
+bool OTAManager::_readBaseThunk(void *part, uint32_t offset, uint8_t *out, size_t len) {
+    return esp_partition_read((const esp_partition_t *)part, offset, out, len) == ESP_OK;
+}
+
+// ============================================================
+// RESUME CHECKPOINT (NVS)
+// - Identity (url + sha256 + size) and a sector-aligned offset
+// - The hash is rebuilt by re-reading the written prefix from
+//   flash: the SHA peripheral state cannot be saved portably and
+//   a flash read is far cheaper than re-downloading
+// ============================================================
+uint32_t OTAManager::_loadCheckpoint(const esp_partition_t *part) {
+    if (_jobSha256.isEmpty()) return 0;   // no way to prove the prefix belongs to this image
+
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE_OTA, true)) return 0;
+    const String url = prefs.getString("dl_url", "");
+    const String sha = prefs.getString("dl_sha", "");
+    const uint32_t total = prefs.getUInt("dl_total", 0);
+    uint32_t offset = prefs.getUInt("dl_off", 0);
+    prefs.end();
+
+    if (url != _jobUrl || !sha.equalsIgnoreCase(_jobSha256) ||
+        total == 0 || total > part->size || offset >= total) {
+        return 0;
+    }
+    _totalBytes = total;
+    _bytesWritten = offset;
+    _progress = (int)(((uint64_t)offset * 100) / total);
+    return offset & ~(OTA_SECTOR_BYTES - 1);
+}
+
+void OTAManager::_saveCheckpoint(uint32_t offset) {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE_OTA, false)) return;
+    if (offset == 0) {
+        prefs.putString("dl_url", _jobUrl);
+        prefs.putString("dl_sha", _jobSha256);
+        prefs.putUInt("dl_total", getTotalBytes());
+    }
+    prefs.putUInt("dl_off", offset);
+    prefs.end();
+    _checkpointed = offset;
+}
+
+void OTAManager::_clearCheckpoint() {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE_OTA, false)) return;
+    prefs.remove("dl_url");
+    prefs.remove("dl_sha");
+    prefs.remove("dl_total");
+    prefs.remove("dl_off");
+    prefs.end();
+}
+
+bool OTAManager::_verifyDownloadHash(const String& expectedHash) {
+    if (expectedHash.isEmpty()) {
+        LOGW(OTA, "No sha256 published - image not verified");
+        return true;   // only reachable with OTA_REQUIRE_SHA256 false
+    }
+
+    char actual[2 * Sha256::DIGEST_BYTES + 1];
+    if (!_writer.verify(expectedHash.c_str(), actual)) {
+        _fail("SHA-256 mismatch - expected " + expectedHash + ", got " + String(actual));
+        return false;
+    }
+    LOGI(OTA, "SHA-256 verified");
+    return true;
+}
+
+void OTAManager::_fail(const String& error) {
+    _lastError = error;
+    _state = OTA_FAILED;
+    LOGE(OTA, "%s", error.c_str());
+}
+
+// ============================================================
+// STATUS ACCESSORS (any task)
+// ============================================================
+OTAState OTAManager::getState() {
+    return (OTAState)_state.load();
+}
+
+int OTAManager::getProgress() {
+    return _progress.load();
+}
+
+bool OTAManager::isBusy() {
+    const OTAState s = getState();
+    return _task != nullptr || s == OTA_CHECKING || s == OTA_DOWNLOADING || s == OTA_INSTALLING;
+}
+
+uint32_t OTAManager::getBytesWritten() {
+    return _bytesWritten.load();
+}
+
+uint32_t OTAManager::getTotalBytes() {
+    return _totalBytes.load();
+}
+
+uint32_t OTAManager::getThroughputBps() {
+    return _throughputBps.load();
+}
+
+String OTAManager::getLastError() {
+    return _lastError;
+}
+
+// ============================================================
+// HELPERS
+// ============================================================
+bool OTAManager::_validateSHA256(const String& hash) {
+    return otaSha256WellFormed(hash.c_str());
+}
+
+// SHA-256 of the running image as built (same as sha256sum firmware.bin).
+// Computed once; esp_partition_get_sha256() returns the image's own
+// appended digest instead, which CI does not know.
+bool OTAManager::_hashRunningImage() {
+    if (_runningShaValid) return true;
+
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    const uint32_t size = ESP.getSketchSize();
+    uint8_t *buf = (uint8_t *)malloc(OTA_BUFFER_BYTES);
+    if (!running || size == 0 || !buf) {
+        free(buf);
+        return false;
+    }
+
+    Sha256 sha;
+    bool ok = true;
+    for (uint32_t pos = 0; pos < size && ok; ) {
+        const uint32_t n = min((uint32_t)OTA_BUFFER_BYTES, size - pos);
+        ok = esp_partition_read(running, pos, buf, n) == ESP_OK;
+        sha.update(buf, n);
+        pos += n;
+    }
+    sha.finish(_runningSha);
+    free(buf);
+
+    _runningSize = size;
+    _runningShaValid = ok;
+    return ok;
+}
+
+bool OTAManager::_runningShaMatches(const String& hex) {
+    if (!_runningShaValid || !_validateSHA256(hex)) return false;
+    for (int i = 0; i < 32; i++) {
+        const uint8_t b = (uint8_t)strtoul(hex.substring(i * 2, i * 2 + 2).c_str(), nullptr, 16);
+        if (b != _runningSha[i]) return false;
+    }
+    return true;
+}
+
+const esp_partition_t* OTAManager::_getNextOtaPartition() {
+    return esp_ota_get_next_update_partition(nullptr);
+}
@@ -0,0 +1,169 @@
+// ============================================================
+// OTA UPDATE DECISION
+// See ota_policy.h
+// ============================================================
+
+#include "ota_policy.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+OtaAction otaDecide(const OtaOffer &offer, const char *currentVersion, OtaEncoding &encoding) {
+    encoding = OTA_ENC_RAW;
+    if (!offer.hasDownloadUrl || strcmp(offer.version, currentVersion) == 0) {
+        return OTA_ACT_NONE;
+    }
+
+    const bool hasSha = offer.sha256[0] != '\0';
+    if (hasSha ? !otaSha256WellFormed(offer.sha256) : OTA_REQUIRE_SHA256) {
+        return OTA_ACT_REJECT;
+    }
+    if (offer.imageFailedBefore) {
+        return OTA_ACT_BLOCKED;
+    }
+
+    // Encoded sources need the decoded size and must not have failed before
+    const bool encodedOk = offer.fileSize > 0 && !offer.encodedFailedBefore;
+    if (encodedOk && offer.hasDeltaUrl) {
+        encoding = OTA_ENC_DELTA;
+    }
+#if OTA_ALLOW_COMPRESSED
+    else if (encodedOk && offer.hasGzipUrl) {
+        encoding = OTA_ENC_GZIP;
+    }
+#endif
+    return OTA_ACT_INSTALL;
+}
+
+bool otaSha256WellFormed(const char *hex) {
+    if (strlen(hex) != 64) return false;
+    for (size_t i = 0; i < 64; i++) {
+        if (!isxdigit((unsigned char)hex[i])) return false;
+    }
+    return true;
+}
+
+uint32_t otaCheckBackoffMs(uint8_t failures) {
+    if (failures == 0) return 0;
+    uint32_t backoff = OTA_CHECK_INTERVAL_SECONDS * 1000UL;
+    for (uint8_t i = 1; i < failures && backoff < OTA_CHECK_BACKOFF_MAX_MS; i++) {
+        backoff *= 2;
+    }
+    return backoff < OTA_CHECK_BACKOFF_MAX_MS ? backoff : (uint32_t)OTA_CHECK_BACKOFF_MAX_MS;
+}
+
+static bool parseU32(const char *&p, uint32_t &out) {
+    if (!isdigit((unsigned char)*p)) return false;
+    uint64_t v = 0;
+    while (isdigit((unsigned char)*p)) {
+        v = v * 10 + (uint32_t)(*p++ - '0');
+        if (v > UINT32_MAX) return false;
+    }
+    out = (uint32_t)v;
+    return true;
+}
+
+bool otaParseContentRange(const char *header, uint32_t &first, uint32_t &total) {
+    const char *p = header;
+    if (strncmp(p, "bytes", 5) != 0) return false;
+    p += 5;
+    while (*p == ' ') p++;
+    uint32_t last;
+    if (!parseU32(p, first) || *p++ != '-' || !parseU32(p, last) || *p++ != '/' || !parseU32(p, total)) {
+        return false;
+    }
+    return *p == '\0' && first <= last && last < total;
+}
+
+// ============================================================
+// STAGED ROLLOUT
+// ============================================================
+
+// splitmix64 finalizer: sequential MACs land on unrelated cohorts
+static uint64_t mixDeviceId(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+
+uint16_t otaCohort(uint64_t deviceId) {
+    return (uint16_t)(mixDeviceId(deviceId) % OTA_COHORT_SPAN);
+}
+
+int otaVersionCompare(const char *a, const char *b) {
+    if (*a == 'v' || *a == 'V') a++;
+    if (*b == 'v' || *b == 'V') b++;
+    while (*a || *b) {
+        char *endA;
+        char *endB;
+        const unsigned long partA = strtoul(a, &endA, 10);
+        const unsigned long partB = strtoul(b, &endB, 10);
+        if (partA != partB) return partA < partB ? -1 : 1;
+        // Next dotted part; anything else ("-rc1") ends the compare
+        a = (*endA == '.') ? endA + 1 : "";
+        b = (*endB == '.') ? endB + 1 : "";
+    }
+    return 0;
+}
+
+OtaAction otaRolloutDecide(const OtaRollout &rollout, const char *currentVersion, uint64_t deviceId,
+                           uint32_t nowEpoch, uint32_t firstSeenEpoch, uint32_t &startEpoch) {
+    startEpoch = 0;
+    const bool mandatory = rollout.forceUpdate ||
+                           (rollout.minVersion[0] && otaVersionCompare(currentVersion, rollout.minVersion) < 0);
+
+    const uint8_t percent = rollout.percent > 100 ? 100 : rollout.percent;
+    const uint32_t span = mandatory ? OTA_COHORT_SPAN : (uint32_t)percent * (OTA_COHORT_SPAN / 100);
+    const uint16_t cohort = otaCohort(deviceId);
+    if (cohort >= span) return OTA_ACT_NOT_SELECTED;
+
+    // Wave = position inside the selected span, ~maxConcurrent devices each
+    uint32_t wave = 0;
+    if (rollout.maxConcurrent > 0 && rollout.fleetSize > 0) {
+        const uint32_t selected = (uint32_t)((uint64_t)rollout.fleetSize * span / OTA_COHORT_SPAN);
+        const uint32_t waves = (selected + rollout.maxConcurrent - 1) / rollout.maxConcurrent;
+        if (waves > 1) wave = (uint32_t)((uint64_t)cohort * waves / span);
+    }
+
+    // Later waves count from the first sighting too: devices added by a
+    // raised rollout_percent start from wave 0's time, not all at once
+    uint32_t base = mandatory ? 0 : rollout.notBefore;
+    // A sighting recorded before NTP sync is not a time
+    const uint32_t seenEpoch = firstSeenEpoch >= OTA_EPOCH_SYNCED_MIN ? firstSeenEpoch : nowEpoch;
+    if (wave > 0 && seenEpoch > base) base = seenEpoch;
+    if (base == 0 && wave == 0) return OTA_ACT_INSTALL;
+    if (nowEpoch < OTA_EPOCH_SYNCED_MIN || base < OTA_EPOCH_SYNCED_MIN) return OTA_ACT_DEFER;   // no clock yet
+
+    startEpoch = base + wave * rollout.waveS;
+    return nowEpoch >= startEpoch ? OTA_ACT_INSTALL : OTA_ACT_DEFER;
+}
+
+// ============================================================
+// JITTERED POLLING
+// ============================================================
+uint32_t otaJitterSeed(uint64_t deviceId) {
+    const uint32_t seed = (uint32_t)(mixDeviceId(deviceId) >> 32);
+    return seed ? seed : 0x9E3779B9u;   // xorshift32 must not start at 0
+}
+
+static uint32_t jitterNext(uint32_t &state) {
+    uint32_t x = state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    state = x;
+    return x;
+}
+
+uint32_t otaFirstCheckMs(uint32_t &jitterState) {
+    return jitterNext(jitterState) % (OTA_CHECK_INTERVAL_SECONDS * 1000UL);
+}
+
+uint32_t otaNextCheckMs(uint8_t failures, uint32_t &jitterState) {
+    const uint32_t base = failures ? otaCheckBackoffMs(failures) : OTA_CHECK_INTERVAL_SECONDS * 1000UL;
+    const uint32_t spread = (uint32_t)((uint64_t)base * OTA_CHECK_JITTER_PCT / 100);
+    return base + (spread ? jitterNext(jitterState) % (spread + 1) : 0);
+}
@@ -0,0 +1,242 @@
+// ============================================================
+// DS18B20 SENSOR REGISTRY
+// Cached ROM addresses + broadcast conversions, see sensor_registry.h
+// ============================================================
+
+#include "sensor_registry.h"
+#include "logger.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+SensorRegistry sensorRegistry;
+
+// 1/100 °C; -127 = disconnected, 85.00 = power-on reset value
+static const SensorChannelConfig DS18B20_FILTER = {
+    -5500, 8499, DS18B20_MAX_RATE_CENTI_PER_S, SENSOR_FILTER_MIN_STEP_CENTI, SENSOR_STALE_MS};
+
+struct SensorProbeName {
+    const char *rom;    // 16 hex digits, family code first
+    const char *name;
+};
+static const SensorProbeName PROBE_NAMES[] = {SENSOR_PROBE_NAMES{nullptr, nullptr}};
+
+static const uint8_t DS18B20_FAMILY = 0x28;
+
+static void romToHex(const uint8_t *rom, char *out) {
+    static const char HEX_DIGITS[] = "0123456789ABCDEF";
+    for (int i = 0; i < 8; i++) {
+        out[i * 2] = HEX_DIGITS[rom[i] >> 4];
+        out[i * 2 + 1] = HEX_DIGITS[rom[i] & 0x0F];
+    }
+    out[16] = '\0';
+}
+
+SensorProbe::SensorProbe() : rom(), bus(0), present(false), failures(0), name(), filter(DS18B20_FILTER) {}
+
+SensorRegistry::SensorRegistry()
+    : _buses(),
+      _busCount(0),
+      _count(0),
+      _resolutionBits(12),
+      _conversionMs(750),
+      _scans(0),
+      _readFailures(0) {
+}
+
+bool SensorRegistry::addBus(HalTempBus &bus) {
+    if (_busCount >= SENSOR_BUSES_MAX) return false;
+    _buses[_busCount] = {&bus, 0, 0, -1};
+    _busCount++;
+    return true;
+}
+
+void SensorRegistry::begin(uint8_t resolutionBits) {
+    _resolutionBits = resolutionBits;
+    for (uint8_t b = 0; b < _busCount; b++) {
+        _scan(b, hal.clock->millis());
+    }
+    _conversionMs = _busCount ? _buses[0].io->conversionMs(resolutionBits) : 750;
+
+    for (size_t i = 0; i < _count; i++) {
+        char hex[17];
+        romToHex(_probes[i].rom, hex);
+        LOGI(SENSOR, "DS18B20 bus %u: %s = %s", (unsigned)(_probes[i].bus + 1), _probes[i].name, hex);
+    }
+    LOGI(SENSOR, "DS18B20: %u probes on %u buses, %u-bit, %u ms conversion", (unsigned)_count,
+         (unsigned)_busCount, (unsigned)resolutionBits, (unsigned)_conversionMs);
+}
+
+// ============================================================
+// ENUMERATION
+// ============================================================
+void SensorRegistry::_scan(uint8_t b, uint32_t nowMs) {
+    Bus &bus = _buses[b];
+    bus.lastScanMs = nowMs;
+    bus.found = 0;
+    _scans++;
+
+    // Whole search first: whether the primary answered decides what a new ROM is
+    uint8_t roms[SENSOR_PROBES_MAX][8];
+    uint8_t romCount = 0;
+    bool primarySeen = false;
+    uint8_t rom[8];
+    bus.io->resetSearch();
+    while (bus.io->searchNext(rom)) {
+        if (rom[0] != DS18B20_FAMILY) continue;
+        bus.found++;
+        if (bus.primary >= 0 && memcmp(rom, _probes[bus.primary].rom, sizeof(rom)) == 0) {
+            primarySeen = true;
+        }
+        if (romCount < SENSOR_PROBES_MAX) {
+            memcpy(roms[romCount++], rom, sizeof(rom));
+        }
+    }
+
+    bool primaryLost = bus.primary >= 0 && !primarySeen;
+    bool seen[SENSOR_PROBES_MAX] = {};
+    for (uint8_t r = 0; r < romCount; r++) {
+        int idx = _indexOf(roms[r]);
+        if (idx < 0 && primaryLost) {
+            // First new probe on a bus whose primary is gone takes its slot
+            // (and its name, unless the ROM has one in SENSOR_PROBE_NAMES)
+            idx = bus.primary;
+            SensorProbe &p = _probes[idx];
+            char hex[17];
+            romToHex(roms[r], hex);
+            LOGW(SENSOR, "%s replaced on bus %u by %s", p.name, (unsigned)(b + 1), hex);
+            memcpy(p.rom, roms[r], sizeof(p.rom));
+            p.filter = SensorChannel<>(DS18B20_FILTER);
+            _configuredName(p.rom, p.name, sizeof(p.name));
+            primaryLost = false;
+        } else if (idx < 0) {
+            if (_count >= SENSOR_PROBES_MAX) {
+                LOGW(SENSOR, "Registry full (%u probes) - ignoring a probe on bus %u",
+                     (unsigned)SENSOR_PROBES_MAX, (unsigned)(b + 1));
+                continue;
+            }
+            idx = (int)_count;
+            SensorProbe &p = _probes[idx];
+            memcpy(p.rom, roms[r], sizeof(p.rom));
+            p.bus = b;
+            _name(p);
+            _count++;
+            if (bus.primary < 0) bus.primary = (int8_t)idx;
+        }
+        SensorProbe &p = _probes[idx];
+        seen[idx] = true;
+        p.bus = b;
+        p.present = true;
+        p.failures = 0;
+        // Only write the scratchpad when needed: setResolution may copy it to EEPROM
+        if (bus.io->resolution(p.rom) != _resolutionBits) {
+            bus.io->setResolution(p.rom, _resolutionBits);
+        }
+    }
+
+    for (size_t i = 0; i < _count; i++) {
+        if (_probes[i].bus == b && !seen[i] && _probes[i].present) {
+            _probes[i].present = false;
+            LOGW(SENSOR, "%s no longer answers on bus %u", _probes[i].name, (unsigned)(b + 1));
+        }
+    }
+}
+
+bool SensorRegistry::_needsRescan(uint8_t b) const {
+    if (_buses[b].found == 0) return true;
+    for (size_t i = 0; i < _count; i++) {
+        const SensorProbe &p = _probes[i];
+        if (p.bus == b && (!p.present || p.failures >= SENSOR_RESCAN_FAILURES)) return true;
+    }
+    return false;
+}
+
+int SensorRegistry::_indexOf(const uint8_t *rom) const {
+    for (size_t i = 0; i < _count; i++) {
+        if (memcmp(_probes[i].rom, rom, sizeof(_probes[i].rom)) == 0) return (int)i;
+    }
+    return -1;
+}
+
+bool SensorRegistry::_configuredName(const uint8_t *rom, char *name, size_t size) {
+    char hex[17];
+    romToHex(rom, hex);
+    for (const SensorProbeName *n = PROBE_NAMES; n->rom; n++) {
+        if (strcasecmp(n->rom, hex) == 0) {
+            memset(name, 0, size);
+            strncpy(name, n->name, size - 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void SensorRegistry::_name(SensorProbe &p) {
+    if (_configuredName(p.rom, p.name, sizeof(p.name))) return;
+
+    char base[8];
+    snprintf(base, sizeof(base), "temp%u", (unsigned)(p.bus + 1));
+    if (!find(base)) {
+        strncpy(p.name, base, sizeof(p.name) - 1);
+        return;
+    }
+    unsigned onBus = 1;   // p itself
+    for (size_t i = 0; i < _count; i++) {
+        if (_probes[i].bus == p.bus) onBus++;
+    }
+    snprintf(p.name, sizeof(p.name), "%s_%u", base, onBus);
+}
+
+// ============================================================
+// READING
+// ============================================================
+void SensorRegistry::requestConversion() {
+    for (uint8_t b = 0; b < _busCount; b++) {
+        _buses[b].io->convertAll();   // skip ROM + convert: all probes at once
+    }
+}
+
+void SensorRegistry::collect(uint32_t nowMs) {
+    for (size_t i = 0; i < _count; i++) {
+        SensorProbe &p = _probes[i];
+        if (!p.present) {
+            p.filter.expire(nowMs);
+            continue;
+        }
+        int32_t raw;   // 1/128 °C
+        if (!_buses[p.bus].io->readRaw(p.rom, raw)) {
+            if (p.failures < 255) p.failures++;
+            _readFailures++;
+            p.filter.expire(nowMs);
+            continue;
+        }
+        p.failures = 0;
+        p.filter.update((raw * 100 + (raw >= 0 ? 64 : -64)) / 128, nowMs);
+    }
+
+    for (uint8_t b = 0; b < _busCount; b++) {
+        if (nowMs - _buses[b].lastScanMs >= SENSOR_RESCAN_INTERVAL_MS && _needsRescan(b)) {
+            _scan(b, nowMs);
+            LOGI(SENSOR, "Bus %u rescanned: %u probes", (unsigned)(b + 1), (unsigned)_buses[b].found);
+        }
+    }
+}
+
+SensorProbe *SensorRegistry::find(const char *name) {
+    for (size_t i = 0; i < _count; i++) {
+        if (strcmp(_probes[i].name, name) == 0) return &_probes[i];
+    }
+    return nullptr;
+}
+
+SensorProbe *SensorRegistry::primary(uint8_t bus) {
+    if (bus >= _busCount || _buses[bus].primary < 0) return nullptr;
+    return &_probes[_buses[bus].primary];
+}
+
+void SensorRegistry::report() {
+    char line[96];
+    snprintf(line, sizeof(line), "[PERF] ds18b20: %u probes, %lu bus scans, %lu failed reads",
+             (unsigned)_count, (unsigned long)_scans, (unsigned long)_readFailures);
+    Log.println(line);
+}
@@ -0,0 +1,417 @@
+// ============================================================
+// NATIVE SIMULATOR (pio run -e native && .pio/build/native/program)
+// - Runs the controller, sensor registry + filters, telemetry
+//   payload/delta tracker and OTA decision against the Sim* HAL
+// - Plant: a cold zone (temp1, refrig) and a warm zone (temp2 +
+//   ambient, heater), each leaking towards the room
+// - Prints relay switching and per-stage cost, optionally the
+//   LAN /metrics or /state document; not part of the ESP32 build
+//   or of the unit tests (pio test -e native)
+// - "rollout [devices]" runs the OTA cohort / wave / poll jitter
+//   logic for a virtual fleet instead
+// ============================================================
+
+#if !defined(ARDUINO) && !defined(PIO_UNIT_TESTING)
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "controller.h"
+#include "cycle_profiler.h"
+#include "hal.h"
+#include "lan_status.h"
+#include "logger.h"
+#include "ota_policy.h"
+#include "sensor_filter.h"
+#include "sensor_registry.h"
+#include "telemetry.h"
+#include "transport.h"
+
+static const float SIM_ROOM_C          = 25.0f;
+static const float SIM_LEAK_PER_S      = 0.002f;   // fraction of the gap closed per second
+static const float SIM_HEATER_C_PER_S  = 0.03f;
+static const float SIM_REFRIG_C_PER_S  = 0.10f;
+static const float SIM_NOISE_C         = 0.05f;
+static const uint32_t SIM_STEP_MS      = SENSOR_FAST_SAMPLE_MS;
+
+static const SensorChannelConfig AMBIENT_FILTER = {
+    -3999, 12499, AMBIENT_MAX_RATE_CENTI_PER_S, SENSOR_FILTER_MIN_STEP_CENTI, SENSOR_STALE_MS};
+static const SensorChannelConfig HUMIDITY_FILTER = {
+    0, 10000, HUMIDITY_MAX_RATE_CENTI_PER_S, SENSOR_FILTER_MIN_STEP_CENTI, SENSOR_STALE_MS};
+static SensorChannel<> ambientFilter(AMBIENT_FILTER);
+static SensorChannel<> humidityFilter(HUMIDITY_FILTER);
+
+static TelemetryTracker telemetryTracker;
+static TelemetryPayload payload;
+
+struct SimStats {
+    uint32_t controlCycles;
+    uint32_t heaterSwitches;
+    uint32_t refrigSwitches;
+    uint32_t pushes;
+    uint64_t controlNs;
+    uint64_t sensorNs;
+    uint64_t telemetryNs;
+};
+
+static float noise() {
+    return SIM_NOISE_C * ((float)rand() / RAND_MAX * 2.0f - 1.0f);
+}
+
+static int32_t toCenti(float value) {
+    return (int32_t)(value >= 0 ? value * 100.0f + 0.5f : value * 100.0f - 0.5f);
+}
+
+static float filteredOrInvalid(const SensorChannel<> *filter) {
+    return (filter && filter->valid()) ? filter->value() / 100.0f : -127.0f;
+}
+
+static uint64_t elapsedNs(std::chrono::steady_clock::time_point start) {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+// Same steps as the firmware's control tick: collect, filter, decide
+static void controlTick(SimStats &stats) {
+    const uint32_t now = hal.clock->millis();
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    sensorRegistry.collect(now);
+    for (size_t i = 0; i < sensorRegistry.count(); i++) {
+        sensorRegistry.probe(i).filter.expire(now);
+    }
+    ambientFilter.expire(now);
+    humidityFilter.expire(now);
+    const SensorProbe *probe1 = sensorRegistry.primary(0);
+    const SensorProbe *probe2 = sensorRegistry.primary(1);
+    temp1       = filteredOrInvalid(probe1 ? &probe1->filter : nullptr);
+    temp2       = filteredOrInvalid(probe2 ? &probe2->filter : nullptr);
+    ambientTemp = filteredOrInvalid(&ambientFilter);
+    if (humidityFilter.valid()) ambientHumidity = humidityFilter.value() / 100.0f;
+    sensorRegistry.requestConversion();
+    stats.sensorNs += elapsedNs(t0);
+
+    const bool wasHeater = heaterOn;
+    const bool wasRefrig = refrigOn;
+    t0 = std::chrono::steady_clock::now();
+    if (shouldHoldRelaysOff()) {
+        enforceRelaysOff();
+    } else {
+        runControlCycle();
+    }
+    stats.controlNs += elapsedNs(t0);
+    stats.controlCycles++;
+    if (heaterOn != wasHeater) stats.heaterSwitches++;
+    if (refrigOn != wasRefrig) stats.refrigSwitches++;
+}
+
+static void fillSnapshot(TelemetrySnapshot &snap) {
+    snap.temp1           = temp1;
+    snap.temp2           = temp2;
+    snap.ambientTemp     = ambientTemp;
+    snap.ambientHumidity = ambientHumidity;
+    snap.temp1Valid      = isValidDs18b20(temp1);
+    snap.temp2Valid      = isValidDs18b20(temp2);
+    snap.ambientValid    = isValidAmbientTemp(ambientTemp);
+    snap.probeCount      = 0;
+    const SensorProbe *probe1 = sensorRegistry.primary(0);
+    const SensorProbe *probe2 = sensorRegistry.primary(1);
+    for (size_t i = 0; i < sensorRegistry.count(); i++) {
+        const SensorProbe &p = sensorRegistry.probe(i);
+        if (&p == probe1 || &p == probe2) continue;
+        snap.probeName[snap.probeCount]  = p.name;
+        snap.probeTemp[snap.probeCount]  = filteredOrInvalid(&p.filter);
+        snap.probeValid[snap.probeCount] = isValidDs18b20(snap.probeTemp[snap.probeCount]);
+        snap.probeCount++;
+    }
+    snap.heaterOn        = heaterOn;
+    snap.refrigOn        = refrigOn;
+    snap.fanOn           = fanOn;
+    snap.autoMode        = autoRelayControl;
+    snap.rssi            = hal.network->rssi();
+    snap.freeHeap        = 0;
+    snap.minFreeHeap     = 0;
+    snap.maxAllocHeap    = 0;
+    snap.uptimeS         = hal.clock->millis() / 1000;
+    snap.epoch           = hal.clock->epoch();
+}
+
+static void telemetryTick(SimStats &stats) {
+    TelemetrySnapshot snap;
+    fillSnapshot(snap);
+
+    const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    const uint32_t fields = telemetryTracker.select(snap, hal.clock->millis());
+    if (fields != 0 && buildTelemetryPayload(snap, fields, payload) &&
+        transport->publishTelemetry(payload.c_str())) {
+        telemetryTracker.commit(snap, fields, hal.clock->millis());
+        stats.pushes++;
+    }
+    stats.telemetryNs += elapsedNs(t0);
+}
+
+static bool stdoutSink(void *ctx, const char *data, size_t len) {
+    (void)ctx;
+    return fwrite(data, 1, len, stdout) == len;
+}
+
+// Same documents the device serves on LAN_HTTP_PORT
+static void renderLanDocument(const char *which, const SimStats &stats) {
+    static LanStatus status;
+    fillSnapshot(status.t);
+    status.heaterOnTemp   = heaterOnTemp;
+    status.heaterOffTemp  = heaterOffTemp;
+    status.refrigOnTemp   = refrigOnTemp;
+    status.refrigOffTemp  = refrigOffTemp;
+    status.loopIterations = stats.controlCycles;
+    status.loopTotalUs    = (stats.sensorNs + stats.controlNs) / 1000;
+    status.loopMaxUs      = 0;
+    status.hasLatency     = false;
+
+    char chunk[256];   // small on purpose: exercises the chunked flush
+    ChunkWriter out(chunk, sizeof(chunk), stdoutSink, nullptr);
+    const bool ok = strcmp(which, "state") == 0 ? renderState(status, out) : renderMetrics(status, out);
+    printf("[%s] /%s: %u bytes\n", ok ? "OK" : "!", which, (unsigned)out.bytes());
+}
+
+static void runOtaDecisions() {
+    static const char SHA[] = "9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08";
+    struct Case {
+        const char *label;
+        OtaOffer offer;
+    };
+    const Case cases[] = {
+        {"same version",      {FIRMWARE_VERSION, SHA, 900000, true, true, true, false, false}},
+        {"newer, full image", {"99.0.0", SHA, 0, true, true, true, false, false}},
+        {"newer, delta",      {"99.0.0", SHA, 900000, true, true, true, false, false}},
+        {"newer, gzip",       {"99.0.0", SHA, 900000, true, true, false, false, false}},
+        {"encoded failed",    {"99.0.0", SHA, 900000, true, true, true, true, false}},
+        {"image failed",      {"99.0.0", SHA, 900000, true, true, true, true, true}},
+        {"bad sha256",        {"99.0.0", "abc", 900000, true, false, false, false, false}},
+        {"no download url",   {"99.0.0", SHA, 900000, false, false, false, false, false}},
+    };
+    static const char *ACTIONS[] = {"none", "reject", "install", "defer", "not selected", "blocked"};
+    static const char *ENCODINGS[] = {"raw", "gzip", "delta"};
+
+    printf("[*] OTA decisions (current " FIRMWARE_VERSION ")\n");
+    for (const Case &c : cases) {
+        OtaEncoding encoding;
+        const OtaAction action = otaDecide(c.offer, FIRMWARE_VERSION, encoding);
+        printf("     %-18s -> %s%s%s\n", c.label, ACTIONS[action],
+               action == OTA_ACT_INSTALL ? " " : "",
+               action == OTA_ACT_INSTALL ? ENCODINGS[encoding] : "");
+    }
+    printf("     check backoff after 1/4/12 failures: %u / %u / %u s\n",
+           (unsigned)(otaCheckBackoffMs(1) / 1000), (unsigned)(otaCheckBackoffMs(4) / 1000),
+           (unsigned)(otaCheckBackoffMs(12) / 1000));
+}
+
+// ============================================================
+// OTA ROLLOUT ACROSS A VIRTUAL FLEET
+// ============================================================
+static const uint64_t SIM_MAC_BASE = 0x240AC4000000ULL;   // consecutive MACs, as a production batch
+
+static uint32_t waveOf(const OtaRollout &rollout, uint64_t id, uint32_t nowEpoch, uint32_t seenEpoch,
+                       uint32_t baseEpoch) {
+    uint32_t startEpoch = 0;
+    otaRolloutDecide(rollout, "1.0.0", id, nowEpoch, seenEpoch, startEpoch);
+    return startEpoch > baseEpoch ? (startEpoch - baseEpoch) / rollout.waveS : 0;
+}
+
+static int runRolloutSimulation(uint32_t devices) {
+    static const uint32_t T0 = 1760000000;
+    OtaRollout rollout = {100, 0, 0, 0, OTA_ROLLOUT_WAVE_S, "", false};
+    uint32_t startEpoch;
+
+    printf("[*] OTA rollout, %u virtual devices\n", (unsigned)devices);
+
+    // Cohort selection: close to P %, and raising P only adds devices
+    static const uint8_t PERCENTS[] = {1, 10, 50, 100};
+    uint32_t dropped = 0;
+    for (uint8_t p : PERCENTS) {
+        rollout.percent = p;
+        uint32_t selected = 0;
+        for (uint32_t i = 0; i < devices; i++) {
+            const uint64_t id = SIM_MAC_BASE + i;
+            if (otaRolloutDecide(rollout, "1.0.0", id, T0, 0, startEpoch) == OTA_ACT_NOT_SELECTED) continue;
+            selected++;
+            if (p < 100) {
+                OtaRollout wider = rollout;
+                wider.percent = 100;
+                if (otaRolloutDecide(wider, "1.0.0", id, T0, 0, startEpoch) == OTA_ACT_NOT_SELECTED) dropped++;
+            }
+        }
+        printf("     rollout_percent %3u -> %5u selected (%.2f%%)\n", (unsigned)p, (unsigned)selected,
+               100.0 * selected / devices);
+    }
+    printf("     devices lost when the percentage grows: %u\n", (unsigned)dropped);
+
+    // Waves: max_concurrent 5 % of the fleet
+    rollout.percent = 100;
+    rollout.notBefore = T0;
+    rollout.fleetSize = devices;
+    rollout.maxConcurrent = (uint16_t)(devices / 20 ? devices / 20 : 1);
+    static uint32_t perWave[256];
+    memset(perWave, 0, sizeof(perWave));
+    uint32_t waves = 0;
+    for (uint32_t i = 0; i < devices; i++) {
+        const uint32_t w = waveOf(rollout, SIM_MAC_BASE + i, T0, 0, T0);
+        if (w < 256) perWave[w]++;
+        if (w + 1 > waves) waves = w + 1;
+    }
+    uint32_t peak = 0;
+    for (uint32_t w = 0; w < waves && w < 256; w++) if (perWave[w] > peak) peak = perWave[w];
+    printf("     max_concurrent %u -> %u waves %u s apart, busiest wave %u devices\n",
+           (unsigned)rollout.maxConcurrent, (unsigned)waves, (unsigned)rollout.waveS, (unsigned)peak);
+
+    // 10 % for a day, then 50 %: the newly selected devices start their
+    // waves from when they first see themselves selected, not at once
+    const uint32_t T1 = T0 + 86400;
+    rollout.percent = 50;
+    memset(perWave, 0, sizeof(perWave));
+    uint32_t added = 0;
+    uint32_t addedNow = 0;
+    peak = 0;
+    for (uint32_t i = 0; i < devices; i++) {
+        const uint64_t id = SIM_MAC_BASE + i;
+        if (otaCohort(id) < 10 * (OTA_COHORT_SPAN / 100)) continue;   // updated on day 1
+        const OtaAction a = otaRolloutDecide(rollout, "1.0.0", id, T1, T1, startEpoch);
+        if (a == OTA_ACT_NOT_SELECTED) continue;
+        added++;
+        if (a == OTA_ACT_INSTALL) addedNow++;
+        const uint32_t w = waveOf(rollout, id, T1, T1, T1);
+        if (w < 256 && ++perWave[w] > peak) peak = perWave[w];
+    }
+    printf("     10%% -> 50%% a day later: %u devices added, %u start at once, busiest wave %u\n",
+           (unsigned)added, (unsigned)addedNow, (unsigned)peak);
+
+    // Mandatory: below min_version ignores rollout_percent 0 and not_before
+    rollout.percent = 0;
+    rollout.notBefore = T0 + 7 * 86400;
+    rollout.minVersion = "1.2.0";
+    uint32_t mandatory = 0;
+    for (uint32_t i = 0; i < devices; i++) {
+        if (otaRolloutDecide(rollout, "1.0.0", SIM_MAC_BASE + i, T0, T0, startEpoch) != OTA_ACT_NOT_SELECTED) {
+            mandatory++;
+        }
+    }
+    printf("     min_version 1.2.0 at rollout_percent 0: %u of %u still update (version cmp 1.10.0 vs 1.9.2: %d)\n",
+           (unsigned)mandatory, (unsigned)devices, otaVersionCompare("1.10.0", "1.9.2"));
+
+    // Version checks per second over the first hour after a fleet-wide
+    // power cut: without jitter every device would check in the same second
+    static const uint32_t HOUR_S = 3600;
+    static uint32_t perSecond[HOUR_S];
+    memset(perSecond, 0, sizeof(perSecond));
+    uint32_t checks = 0;
+    for (uint32_t i = 0; i < devices; i++) {
+        uint32_t state = otaJitterSeed(SIM_MAC_BASE + i);
+        uint64_t atMs = otaFirstCheckMs(state);
+        while (atMs < HOUR_S * 1000ULL) {
+            perSecond[atMs / 1000]++;
+            checks++;
+            atMs += otaNextCheckMs(0, state);
+        }
+    }
+    uint32_t busiest = 0;
+    for (uint32_t sec = 0; sec < HOUR_S; sec++) if (perSecond[sec] > busiest) busiest = perSecond[sec];
+    printf("     version checks in the first hour: %u, busiest second %u (avg %.1f, no jitter %u)\n",
+           (unsigned)checks, (unsigned)busiest, (double)checks / HOUR_S, (unsigned)devices);
+    printf("     check wait after 0/1/4 failures: %u / %u / %u s (+ up to %u%%)\n",
+           (unsigned)(OTA_CHECK_INTERVAL_SECONDS), (unsigned)(otaCheckBackoffMs(1) / 1000),
+           (unsigned)(otaCheckBackoffMs(4) / 1000), (unsigned)OTA_CHECK_JITTER_PCT);
+    return 0;
+}
+
+// program [hours] [metrics|state]
+// program rollout [devices]
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "rollout") == 0) {
+        const long devices = argc > 2 ? atol(argv[2]) : 5000;
+        return runRolloutSimulation(devices > 0 ? (uint32_t)devices : 5000);
+    }
+    const uint32_t hours = argc > 1 ? (uint32_t)atoi(argv[1]) : 24;
+    srand(1);
+
+    // Plant starts at room temperature; two probes in the cold zone
+    float coldC = SIM_ROOM_C;
+    float warmC = SIM_ROOM_C;
+    const int cold1 = simTempBus[0].addProbe(0x1001, coldC);
+    const int cold2 = simTempBus[0].addProbe(0x1002, coldC);
+    const int warm  = simTempBus[1].addProbe(0x2001, warmC);
+    simClock.setEpoch(1760000000);
+
+    sensorRegistry.addBus(*hal.tempBus[0]);
+    sensorRegistry.addBus(*hal.tempBus[1]);
+    sensorRegistry.begin(DS18B20_RESOLUTION_BITS);
+    hal.ambient->begin();
+    sensorRegistry.requestConversion();
+
+    // Firmware boots in MANUAL until the app selects a mode; simulate AUTO
+    autoRelayControl = true;
+    bootStartMillis = hal.clock->millis();
+    fanCycleStartMillis = hal.clock->millis();
+    enforceRelaysOff();
+
+    SimStats stats = {};
+    const uint32_t endMs = hours * 3600000UL;
+    uint32_t nextControl = SENSOR_SAMPLE_PERIOD_MS;
+    uint32_t nextPush = FIREBASE_UPDATE_INTERVAL_MS;
+    uint32_t heaterOnMs = 0;
+    uint32_t refrigOnMs = 0;
+
+    while (hal.clock->millis() < endMs) {
+        simClock.advanceMs(SIM_STEP_MS);
+        const uint32_t now = hal.clock->millis();
+        const float dt = SIM_STEP_MS / 1000.0f;
+
+        coldC += (SIM_ROOM_C - coldC) * SIM_LEAK_PER_S * dt;
+        warmC += (SIM_ROOM_C - warmC) * SIM_LEAK_PER_S * dt;
+        if (refrigOn) { coldC -= SIM_REFRIG_C_PER_S * dt; refrigOnMs += SIM_STEP_MS; }
+        if (heaterOn) { warmC += SIM_HEATER_C_PER_S * dt; heaterOnMs += SIM_STEP_MS; }
+        simTempBus[0].setTemp(cold1, coldC + noise());
+        simTempBus[0].setTemp(cold2, coldC + 0.5f + noise());
+        simTempBus[1].setTemp(warm, warmC + noise());
+        simAmbient.tempC = warmC - 0.3f + noise();
+        simAmbient.humidityPct = 55.0f + 10.0f * noise();
+
+        // Fast ambient sampling, as sampleAmbientTask
+        float t, h;
+        if (hal.ambient->read(t, h)) {
+            ambientFilter.update(toCenti(t), now);
+            humidityFilter.update(toCenti(h), now);
+        }
+
+        if (now >= nextControl) {
+            nextControl += SENSOR_SAMPLE_PERIOD_MS;
+            controlTick(stats);
+        }
+        if (now >= nextPush) {
+            nextPush += FIREBASE_UPDATE_INTERVAL_MS;
+            telemetryTick(stats);
+        }
+    }
+
+    printf("[OK] Simulated %u h: %u control cycles, %u pushes (%u bytes)\n",
+           (unsigned)hours, (unsigned)stats.controlCycles, (unsigned)stats.pushes,
+           (unsigned)simRtdb.bytes);
+    printf("     final temp1 %.2f C  temp2 %.2f C  ambient %.2f C\n", temp1, temp2, ambientTemp);
+    printf("     heater: %u switches, on %.0f%%   refrig: %u switches, on %.0f%%\n",
+           (unsigned)stats.heaterSwitches, 100.0 * heaterOnMs / endMs,
+           (unsigned)stats.refrigSwitches, 100.0 * refrigOnMs / endMs);
+    sensorRegistry.report();
+    if (stats.controlCycles > 0) {
+        printf("[PERF] sensors %.0f ns  control %.0f ns per cycle, telemetry %.0f ns per push\n",
+               (double)stats.sensorNs / stats.controlCycles,
+               (double)stats.controlNs / stats.controlCycles,
+               stats.pushes ? (double)stats.telemetryNs / stats.pushes : 0.0);
+    }
+    cycleProfiler.report();   // ns per call with -DCYCLE_PROFILE_ENABLED=1
+    runOtaDecisions();
+    if (argc > 2) renderLanDocument(argv[2], stats);
+    return 0;
+}
+
+#endif // !ARDUINO
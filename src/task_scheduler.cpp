@@ -0,0 +1,118 @@
+// ============================================================
+// COOPERATIVE PERIODIC TASK SCHEDULER
+// ============================================================
+
+#include "task_scheduler.h"
+
+#include <string.h>
+
+TaskScheduler::TaskScheduler(SchedulerClock clock)
+    : _count(0),
+      _clock(clock) {
+    memset(_tasks, 0, sizeof(_tasks));
+}
+
+int TaskScheduler::addTask(const char *name, SchedulerCallback callback, uint32_t periodMs,
+                           uint32_t phaseMs, uint8_t priority, uint32_t deadlineMs) {
+    if (_count >= SCHEDULER_MAX_TASKS || !callback || periodMs == 0) {
+        return -1;
+    }
+
+    ScheduledTask &t = _tasks[_count];
+    memset(&t, 0, sizeof(t));
+    t.name       = name;
+    t.callback   = callback;
+    t.periodMs   = periodMs;
+    t.phaseMs    = phaseMs;
+    t.deadlineMs = deadlineMs ? deadlineMs : periodMs;
+    t.priority   = priority;
+    t.enabled    = true;
+    t.nextDueMs  = _clock() + phaseMs;
+
+    return (int)_count++;
+}
+
+void TaskScheduler::start() {
+    const uint32_t now = _clock();
+    for (size_t i = 0; i < _count; i++) {
+        _tasks[i].nextDueMs = now + _tasks[i].phaseMs;
+    }
+}
+
+bool TaskScheduler::runNext() {
+    const uint32_t now = _clock();
+
+    // Pick the highest-priority due task; ties go to the longest overdue
+    ScheduledTask *pick = nullptr;
+    for (size_t i = 0; i < _count; i++) {
+        ScheduledTask &t = _tasks[i];
+        if (!t.enabled || !_isDue(t, now)) continue;
+        if (!pick ||
+            t.priority > pick->priority ||
+            (t.priority == pick->priority && (int32_t)(t.nextDueMs - pick->nextDueMs) < 0)) {
+            pick = &t;
+        }
+    }
+    if (!pick) return false;
+
+    const uint32_t dueMs = pick->nextDueMs;
+    const uint32_t lateness = now - dueMs;
+
+    pick->callback();
+
+    const uint32_t end = _clock();
+    const uint32_t runMs = end - now;
+
+    TaskStats &st = pick->stats;
+    st.runs++;
+    st.lastRunMs = runMs;
+    st.totalRunMs += runMs;
+    if (runMs > st.maxRunMs) st.maxRunMs = runMs;
+    st.lastLatenessMs = lateness;
+    if (lateness > st.maxLatenessMs) st.maxLatenessMs = lateness;
+    if (end - dueMs > pick->deadlineMs) st.deadlineMisses++;
+
+    // Advance on the fixed grid; if we fell a whole period or more behind,
+    // drop the missed slots instead of bursting to catch up
+    pick->nextDueMs = dueMs + pick->periodMs;
+    if (_isDue(*pick, end)) {
+        const uint32_t missed = (end - pick->nextDueMs) / pick->periodMs + 1;
+        pick->nextDueMs += missed * pick->periodMs;
+        st.skippedPeriods += missed;
+    }
+
+    return true;
+}
+
+uint32_t TaskScheduler::msUntilNextDue() const {
+    const uint32_t now = _clock();
+    uint32_t best = UINT32_MAX;
+    for (size_t i = 0; i < _count; i++) {
+        const ScheduledTask &t = _tasks[i];
+        if (!t.enabled) continue;
+        if (_isDue(t, now)) return 0;
+        const uint32_t wait = t.nextDueMs - now;
+        if (wait < best) best = wait;
+    }
+    return best;
+}
+
+void TaskScheduler::setEnabled(int id, bool enabled) {
+    if (id < 0 || (size_t)id >= _count) return;
+    ScheduledTask &t = _tasks[id];
+    if (enabled && !t.enabled) {
+        t.nextDueMs = _clock() + t.phaseMs;   // re-anchor, no burst of stale runs
+    }
+    t.enabled = enabled;
+}
+
+void TaskScheduler::resetStats() {
+    for (size_t i = 0; i < _count; i++) {
+        memset(&_tasks[i].stats, 0, sizeof(TaskStats));
+    }
+}
+
+const ScheduledTask *TaskScheduler::task(int id) const {
+    if (id < 0 || (size_t)id >= _count) return nullptr;
+    return &_tasks[id];
+}
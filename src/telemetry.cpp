@@ -0,0 +1,293 @@
+// ============================================================
+// TELEMETRY PAYLOAD BUILDER
+// Builds the multi-path RTDB update document without heap use
+// ============================================================
+
+#include "telemetry.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+TelemetryPayload::TelemetryPayload() {
+    reset();
+}
+
+void TelemetryPayload::reset() {
+    _buf[0] = '{';
+    _buf[1] = '\0';
+    _len = 1;
+    _fields = 0;
+    _overflow = false;
+    _closed = false;
+}
+
+void TelemetryPayload::_appendRaw(const char *text, size_t n) {
+    if (_overflow) return;
+    // Keep one byte for the closing brace and one for the terminator
+    if (_len + n + 2 > sizeof(_buf)) {
+        _overflow = true;
+        return;
+    }
+    memcpy(_buf + _len, text, n);
+    _len += n;
+    _buf[_len] = '\0';
+}
+
+void TelemetryPayload::_appendKey(const char *path) {
+    if (_fields > 0) _appendRaw(",", 1);
+    _appendRaw("\"", 1);
+    _appendRaw(path, strlen(path));
+    _appendRaw("\":", 2);
+    _fields++;
+}
+
+void TelemetryPayload::addFloat(const char *path, float value, uint8_t decimals) {
+    if (!isfinite(value)) {
+        // "nan"/"inf" are not JSON - report like a missing sensor
+        addString(path, "disconnected");
+        return;
+    }
+    char num[24];
+    int n = snprintf(num, sizeof(num), "%.*f", (int)decimals, (double)value);
+    if (n <= 0 || n >= (int)sizeof(num)) { _overflow = true; return; }
+    _appendKey(path);
+    _appendRaw(num, (size_t)n);
+}
+
+void TelemetryPayload::addInt(const char *path, int32_t value) {
+    char num[16];
+    int n = snprintf(num, sizeof(num), "%ld", (long)value);
+    _appendKey(path);
+    _appendRaw(num, (size_t)n);
+}
+
+void TelemetryPayload::addUInt(const char *path, uint32_t value) {
+    char num[16];
+    int n = snprintf(num, sizeof(num), "%lu", (unsigned long)value);
+    _appendKey(path);
+    _appendRaw(num, (size_t)n);
+}
+
+void TelemetryPayload::addBool(const char *path, bool value) {
+    _appendKey(path);
+    if (value) _appendRaw("true", 4);
+    else       _appendRaw("false", 5);
+}
+
+void TelemetryPayload::addString(const char *path, const char *value) {
+    // Values are fixed identifiers ("online", "celsius"...) - no escaping needed
+    _appendKey(path);
+    _appendRaw("\"", 1);
+    _appendRaw(value, strlen(value));
+    _appendRaw("\"", 1);
+}
+
+bool TelemetryPayload::finish() {
+    if (!_closed && !_overflow) {
+        _buf[_len++] = '}';
+        _buf[_len] = '\0';
+        _closed = true;
+    }
+    return !_overflow;
+}
+
+// ============================================================
+// DOCUMENT BUILDER
+// - Same fields and "disconnected" semantics as the per-path pushes
+// ============================================================
+bool buildTelemetryPayload(const TelemetrySnapshot &snap, TelemetryPayload &payload) {
+    return buildTelemetryPayload(snap, TF_ALL, payload);
+}
+
+bool buildTelemetryPayload(const TelemetrySnapshot &snap, uint32_t fields, TelemetryPayload &payload) {
+    payload.reset();
+
+    if (fields & TF_TEMPERATURE_UNIT) {
+        payload.addString("sensors/temperature_unit", TEMPERATURE_UNIT_LABEL);
+    }
+
+    if (fields & TF_TEMP1) {
+        if (snap.temp1Valid) payload.addFloat("sensors/temp1", snap.temp1);
+        else                 payload.addString("sensors/temp1", "disconnected");
+    }
+
+    if (fields & TF_TEMP2) {
+        if (snap.temp2Valid) payload.addFloat("sensors/temp2", snap.temp2);
+        else                 payload.addString("sensors/temp2", "disconnected");
+    }
+
+    if (fields & TF_AMBIENT_TEMP) {
+        if (snap.ambientValid) payload.addFloat("sensors/ambient_temp", snap.ambientTemp);
+        else                   payload.addString("sensors/ambient_temp", "disconnected");
+    }
+
+    if (fields & TF_AMBIENT_HUMIDITY) {
+        if (snap.ambientValid) payload.addFloat("sensors/ambient_humidity", snap.ambientHumidity);
+        else                   payload.addString("sensors/ambient_humidity", "disconnected");
+    }
+
+    if (fields & TF_PROBES) {
+        for (uint8_t i = 0; i < snap.probeCount; i++) {
+            char path[8 + SENSOR_PROBE_NAME_MAX];
+            snprintf(path, sizeof(path), "sensors/%s", snap.probeName[i]);
+            if (snap.probeValid[i]) payload.addFloat(path, snap.probeTemp[i]);
+            else                    payload.addString(path, "disconnected");
+        }
+    }
+
+    if (fields & TF_SENSORS_VALID) {
+        payload.addBool("sensors/valid", snap.temp1Valid || snap.temp2Valid || snap.ambientValid);
+    }
+    if (fields & TF_LAST_UPDATE) payload.addUInt("sensors/last_update", snap.epoch);
+
+    if (fields & TF_HEATER_STATE)    payload.addBool("relays/heater_state",    snap.heaterOn);
+    if (fields & TF_REFRIG_STATE)    payload.addBool("relays/refrig_state",    snap.refrigOn);
+    if (fields & TF_FAN_STATE)       payload.addBool("relays/fan_state",       snap.fanOn);
+    if (fields & TF_AUTO_MODE_STATE) payload.addBool("relays/auto_mode_state", snap.autoMode);
+
+    if (fields & TF_STATUS_STATE) payload.addString("status/state", "online");
+    if (fields & TF_LAST_SEEN)    payload.addUInt("status/last_seen", snap.epoch);
+    if (fields & TF_RSSI)         payload.addInt("status/rssi", snap.rssi);
+    if (fields & TF_FREE_HEAP)    payload.addUInt("status/free_heap", snap.freeHeap);
+    if (fields & TF_UPTIME)       payload.addUInt("status/uptime_s", snap.uptimeS);
+    if (fields & TF_MIN_FREE_HEAP)  payload.addUInt("status/min_free_heap", snap.minFreeHeap);
+    if (fields & TF_MAX_ALLOC_HEAP) payload.addUInt("status/largest_free_block", snap.maxAllocHeap);
+
+    return payload.finish();
+}
+
+// ============================================================
+// DELTA TRACKER
+// ============================================================
+static bool movedPast(float now, float last, float deadband) {
+    return fabsf(now - last) >= deadband;
+}
+
+static bool heapMoved(uint32_t now, uint32_t last) {
+    const uint32_t delta = (now > last) ? (now - last) : (last - now);
+    return delta >= TELEMETRY_DEADBAND_FREE_HEAP_BYTES;
+}
+
+static bool readingChanged(bool nowValid, float now, bool lastValid, float last, float deadband) {
+    if (nowValid != lastValid) return true;          // connect/disconnect always counts
+    return nowValid && movedPast(now, last, deadband);
+}
+
+TelemetryTracker::TelemetryTracker()
+    : _published(),
+      _hasBaseline(false),
+      _lastHeartbeatMs(0),
+      _lastFullSyncMs(0) {
+}
+
+uint32_t TelemetryTracker::select(const TelemetrySnapshot &snap, uint32_t nowMs) const {
+    if (!_hasBaseline || (nowMs - _lastFullSyncMs) >= FIREBASE_FULL_SYNC_INTERVAL_MS) {
+        return TF_ALL;
+    }
+
+    const TelemetrySnapshot &last = _published;
+    uint32_t fields = 0;
+
+    if (readingChanged(snap.temp1Valid, snap.temp1, last.temp1Valid, last.temp1,
+                       TELEMETRY_DEADBAND_TEMP_C)) {
+        fields |= TF_TEMP1;
+    }
+    if (readingChanged(snap.temp2Valid, snap.temp2, last.temp2Valid, last.temp2,
+                       TELEMETRY_DEADBAND_TEMP_C)) {
+        fields |= TF_TEMP2;
+    }
+    if (readingChanged(snap.ambientValid, snap.ambientTemp, last.ambientValid, last.ambientTemp,
+                       TELEMETRY_DEADBAND_TEMP_C)) {
+        fields |= TF_AMBIENT_TEMP;
+    }
+    if (readingChanged(snap.ambientValid, snap.ambientHumidity, last.ambientValid, last.ambientHumidity,
+                       TELEMETRY_DEADBAND_HUMIDITY_PCT)) {
+        fields |= TF_AMBIENT_HUMIDITY;
+    }
+
+    if (snap.probeCount != last.probeCount) {
+        fields |= TF_PROBES;
+    } else {
+        for (uint8_t i = 0; i < snap.probeCount; i++) {
+            if (snap.probeName[i] != last.probeName[i] ||
+                readingChanged(snap.probeValid[i], snap.probeTemp[i], last.probeValid[i], last.probeTemp[i],
+                               TELEMETRY_DEADBAND_TEMP_C)) {
+                fields |= TF_PROBES;
+                break;
+            }
+        }
+    }
+
+    const bool anyValid = snap.temp1Valid || snap.temp2Valid || snap.ambientValid;
+    const bool lastAnyValid = last.temp1Valid || last.temp2Valid || last.ambientValid;
+    if (anyValid != lastAnyValid) fields |= TF_SENSORS_VALID;
+
+    // Timestamp the sensor block whenever any reading is rewritten
+    if (fields) fields |= TF_LAST_UPDATE;
+
+    if (snap.heaterOn != last.heaterOn) fields |= TF_HEATER_STATE;
+    if (snap.refrigOn != last.refrigOn) fields |= TF_REFRIG_STATE;
+    if (snap.fanOn    != last.fanOn)    fields |= TF_FAN_STATE;
+    if (snap.autoMode != last.autoMode) fields |= TF_AUTO_MODE_STATE;
+
+    if (abs((int)(snap.rssi - last.rssi)) >= TELEMETRY_DEADBAND_RSSI_DBM) {
+        fields |= TF_RSSI;
+    }
+    if (heapMoved(snap.freeHeap, last.freeHeap))         fields |= TF_FREE_HEAP;
+    if (heapMoved(snap.minFreeHeap, last.minFreeHeap))   fields |= TF_MIN_FREE_HEAP;
+    if (heapMoved(snap.maxAllocHeap, last.maxAllocHeap)) fields |= TF_MAX_ALLOC_HEAP;
+
+    if ((nowMs - _lastHeartbeatMs) >= FIREBASE_HEARTBEAT_INTERVAL_MS) {
+        fields |= TF_LAST_SEEN | TF_UPTIME;
+    }
+
+    return fields;
+}
+
+void TelemetryTracker::commit(const TelemetrySnapshot &snap, uint32_t fields, uint32_t nowMs) {
+    // Only fields that actually went out become the new reference,
+    // so slow drifts below the dead-band still accumulate and get sent
+    if (fields & TF_TEMP1) {
+        _published.temp1Valid = snap.temp1Valid;
+        _published.temp1 = snap.temp1;
+    }
+    if (fields & TF_TEMP2) {
+        _published.temp2Valid = snap.temp2Valid;
+        _published.temp2 = snap.temp2;
+    }
+    if (fields & TF_AMBIENT_TEMP) {
+        _published.ambientValid = snap.ambientValid;
+        _published.ambientTemp = snap.ambientTemp;
+    }
+    if (fields & TF_AMBIENT_HUMIDITY) {
+        _published.ambientValid = snap.ambientValid;
+        _published.ambientHumidity = snap.ambientHumidity;
+    }
+    if (fields & TF_PROBES) {
+        _published.probeCount = snap.probeCount;
+        for (uint8_t i = 0; i < snap.probeCount; i++) {
+            _published.probeName[i] = snap.probeName[i];
+            _published.probeTemp[i] = snap.probeTemp[i];
+            _published.probeValid[i] = snap.probeValid[i];
+        }
+    }
+    if (fields & TF_HEATER_STATE)    _published.heaterOn = snap.heaterOn;
+    if (fields & TF_REFRIG_STATE)    _published.refrigOn = snap.refrigOn;
+    if (fields & TF_FAN_STATE)       _published.fanOn = snap.fanOn;
+    if (fields & TF_AUTO_MODE_STATE) _published.autoMode = snap.autoMode;
+    if (fields & TF_RSSI)            _published.rssi = snap.rssi;
+    if (fields & TF_FREE_HEAP)       _published.freeHeap = snap.freeHeap;
+    if (fields & TF_MIN_FREE_HEAP)   _published.minFreeHeap = snap.minFreeHeap;
+    if (fields & TF_MAX_ALLOC_HEAP)  _published.maxAllocHeap = snap.maxAllocHeap;
+    if (fields & (TF_LAST_SEEN | TF_LAST_UPDATE)) _published.epoch = snap.epoch;
+    if (fields & TF_UPTIME)          _published.uptimeS = snap.uptimeS;
+
+    if (fields & TF_LAST_SEEN) _lastHeartbeatMs = nowMs;
+
+    if (fields == TF_ALL) {
+        _hasBaseline = true;
+        _lastFullSyncMs = nowMs;
+    }
+}
@@ -0,0 +1,146 @@
+// ============================================================
+// OFFLINE TELEMETRY BACKLOG
+// Store-and-forward of samples through the spiffs partition
+// ============================================================
+
+#include "telemetry_backlog.h"
+#include "logger.h"
+#include <esp_partition.h>
+
+static_assert(sizeof(BacklogSample) == 16, "BacklogSample is stored in flash: keep it 16 bytes");
+
+TelemetryBacklog telemetryBacklog;
+
+TelemetryBacklog::TelemetryBacklog()
+    : _log(_region, sizeof(BacklogSample)),
+      _ready(false),
+      _hasRecorded(false),
+      _lastRecordMs(0),
+      _stored(0),
+      _uploaded(0) {
+}
+
+bool TelemetryBacklog::begin() {
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_DATA_SPIFFS, nullptr);
+    if (!part) {
+        Log.println("[!] Backlog: no spiffs partition - offline samples will be lost");
+        return false;
+    }
+    if (!_region.begin(part, TELEMETRY_BACKLOG_PARTITION_OFFSET, TELEMETRY_BACKLOG_BYTES) || !_log.begin()) {
+        Log.println("[!] Backlog: partition slice does not fit - disabled");
+        return false;
+    }
+    _ready = true;
+    Log.println("[OK] Backlog: " + String(_log.pending()) + "/" + String(_log.capacity()) +
+                " samples pending in " + String(part->label));
+    return true;
+}
+
+// ============================================================
+// STORE (offline)
+// ============================================================
+static int16_t toCenti(float value) {
+    const float scaled = value * 100.0f;
+    if (scaled > 32767.0f) return 32767;
+    if (scaled < -32768.0f) return -32768;
+    return (int16_t)lroundf(scaled);
+}
+
+void TelemetryBacklog::record(const TelemetrySnapshot &snap, uint32_t nowMs) {
+    if (!_ready || snap.epoch < TELEMETRY_BACKLOG_MIN_EPOCH) return;
+    if (_hasRecorded && nowMs - _lastRecordMs < TELEMETRY_BACKLOG_SAMPLE_MS) return;
+
+    BacklogSample s;
+    memset(&s, 0xFF, sizeof(s));   // reserved bytes stay erased
+    s.epoch           = snap.epoch;
+    s.temp1           = toCenti(snap.temp1);
+    s.temp2           = toCenti(snap.temp2);
+    s.ambientTemp     = toCenti(snap.ambientTemp);
+    const long humidity = lroundf(snap.ambientHumidity * 100.0f);
+    s.ambientHumidity = (uint16_t)(humidity < 0 ? 0 : (humidity > 65535 ? 65535 : humidity));
+    s.flags = (snap.temp1Valid   ? BACKLOG_TEMP1_VALID   : 0) |
+              (snap.temp2Valid   ? BACKLOG_TEMP2_VALID   : 0) |
+              (snap.ambientValid ? BACKLOG_AMBIENT_VALID : 0) |
+              (snap.heaterOn     ? BACKLOG_HEATER_ON     : 0) |
+              (snap.refrigOn     ? BACKLOG_REFRIG_ON     : 0) |
+              (snap.fanOn        ? BACKLOG_FAN_ON        : 0) |
+              (snap.autoMode     ? BACKLOG_AUTO_MODE     : 0);
+
+    _hasRecorded = true;
+    _lastRecordMs = nowMs;
+    if (_log.append(&s)) {
+        _stored++;
+    }
+}
+
+// ============================================================
+// FORWARD (online)
+// ============================================================
+
+// "-12.34" from 1/100 units, no float formatting
+static int formatCenti(char *out, size_t cap, int32_t centi) {
+    const char *sign = (centi < 0) ? "-" : "";
+    const uint32_t mag = (centi < 0) ? (uint32_t)(-centi) : (uint32_t)centi;
+    return snprintf(out, cap, "%s%u.%02u", sign, (unsigned)(mag / 100), (unsigned)(mag % 100));
+}
+
+// One "history/<epoch>":{...} member, at most ~150 bytes.
+// Invalid readings are omitted: the app shows a gap, not -127.
+static size_t formatSample(const BacklogSample &s, char *out, size_t cap) {
+    int n = snprintf(out, cap, "\"history/%lu\":{", (unsigned long)s.epoch);
+    if (s.flags & BACKLOG_TEMP1_VALID) {
+        n += snprintf(out + n, cap - n, "\"temp1\":");
+        n += formatCenti(out + n, cap - n, s.temp1);
+        out[n++] = ',';
+    }
+    if (s.flags & BACKLOG_TEMP2_VALID) {
+        n += snprintf(out + n, cap - n, "\"temp2\":");
+        n += formatCenti(out + n, cap - n, s.temp2);
+        out[n++] = ',';
+    }
+    if (s.flags & BACKLOG_AMBIENT_VALID) {
+        n += snprintf(out + n, cap - n, "\"ambient_temp\":");
+        n += formatCenti(out + n, cap - n, s.ambientTemp);
+        n += snprintf(out + n, cap - n, ",\"ambient_humidity\":");
+        n += formatCenti(out + n, cap - n, s.ambientHumidity);
+        out[n++] = ',';
+    }
+    n += snprintf(out + n, cap - n, "\"heater\":%d,\"refrig\":%d,\"fan\":%d,\"auto_mode\":%d}",
+                  (s.flags & BACKLOG_HEATER_ON) ? 1 : 0, (s.flags & BACKLOG_REFRIG_ON) ? 1 : 0,
+                  (s.flags & BACKLOG_FAN_ON) ? 1 : 0, (s.flags & BACKLOG_AUTO_MODE) ? 1 : 0);
+    return (size_t)n;
+}
+
+size_t TelemetryBacklog::buildBatch(char *buf, size_t cap, size_t &len) {
+    len = 0;
+    if (!_ready || cap < 3) return 0;
+
+    const size_t available = _log.peek(_batch, TELEMETRY_BACKLOG_BATCH);
+    char member[192];
+    size_t used = 0;
+    buf[len++] = '{';
+    for (; used < available; used++) {
+        const size_t n = formatSample(_batch[used], member, sizeof(member));
+        const size_t sep = used ? 1 : 0;
+        if (len + sep + n + 2 > cap) break;   // keep room for '}' and the terminator
+        if (sep) buf[len++] = ',';
+        memcpy(buf + len, member, n);
+        len += n;
+    }
+    buf[len++] = '}';
+    buf[len] = '\0';
+    return used;
+}
+
+void TelemetryBacklog::commitBatch(size_t samples) {
+    if (!_ready || samples == 0) return;
+    _uploaded += _log.consume(samples);
+}
+
+void TelemetryBacklog::report() {
+    if (!_ready) return;
+    Log.println("[PERF] backlog: " + String(_log.pending()) + " pending / " + String(_log.capacity()) +
+                ", stored " + String(_stored) + ", uploaded " + String(_uploaded) +
+                ", overwritten " + String(_log.overwritten()) + ", corrupt " + String(_log.corrupt()));
+}
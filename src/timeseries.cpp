@@ -0,0 +1,423 @@
+// ============================================================
+// TIME-SERIES STORE
+// Delta / bit-packed sample blocks on flash, see timeseries.h
+// ============================================================
+
+#include "timeseries.h"
+#include <string.h>
+
+static inline uint32_t align4(uint32_t n) { return (n + 3) & ~3u; }
+
+static inline uint32_t zigzag(int32_t d) { return ((uint32_t)d << 1) ^ (uint32_t)(d >> 31); }
+static inline int32_t unzigzag(uint32_t z) { return (int32_t)(z >> 1) ^ -(int32_t)(z & 1); }
+
+// LSB-first reader over one block payload; reads past the end return 0
+class TsBitReader {
+public:
+    TsBitReader(const uint8_t *data, uint32_t bits) : _data(data), _bits(bits), _pos(0) {}
+
+    uint32_t get(uint8_t n) {
+        uint32_t v = 0;
+        for (uint8_t i = 0; i < n; i++, _pos++) {
+            if (_pos < _bits && (_data[_pos >> 3] >> (_pos & 7)) & 1) v |= 1u << i;
+        }
+        return v;
+    }
+
+    int16_t delta(int16_t prev) {
+        uint32_t z;
+        if (!get(1)) {
+            z = get(2) + 1;
+        } else if (!get(1)) {
+            z = get(5) + 5;
+        } else if (!get(1)) {
+            z = get(8) + 37;
+        } else {
+            return (int16_t)get(16);
+        }
+        return (int16_t)(prev + unzigzag(z));
+    }
+
+private:
+    const uint8_t *_data;
+    uint32_t _bits;
+    uint32_t _pos;
+};
+
+TimeSeriesStore::TimeSeriesStore(FlashRegion &region, const TsConfig &config)
+    : _region(region),
+      _config(config),
+      _sectorSize(0),
+      _sectorCount(0),
+      _headSector(0),
+      _writeOffset(0),
+      _nextSeq(0),
+      _mounted(false),
+      _hasOpen(false),
+      _openBits(0),
+      _openCapBits(0),
+      _openHdr(),
+      _last(),
+      _hasLast(false),
+      _blocksSealed(0),
+      _samplesAppended(0),
+      _bitsWritten(0),
+      _lastScanned(0),
+      _lastDecoded(0) {
+    if (_config.blockMaxBytes > MAX_BLOCK_BYTES) _config.blockMaxBytes = MAX_BLOCK_BYTES;
+    if (_config.periodS == 0) _config.periodS = 1;
+}
+
+// ============================================================
+// MOUNT
+// Each sector holds a chain of blocks from offset 0; the block
+// with the highest seq marks the head sector and append point
+// ============================================================
+static bool keepLast(void *ctx, const TsSample &sample) {
+    *static_cast<TsSample *>(ctx) = sample;
+    return true;
+}
+
+bool TimeSeriesStore::begin() {
+    _mounted = false;
+    _sectorSize = _region.sectorSize();
+    _sectorCount = _sectorSize ? _region.size() / _sectorSize : 0;
+    if (_sectorCount < 2 || _sectorSize < _config.blockMaxBytes ||
+        _config.blockMaxBytes < sizeof(BlockHeader) + 16) {
+        return false;
+    }
+
+    bool found = false;
+    uint32_t maxSeq = 0;
+    uint32_t newestOffset = 0;
+    BlockHeader newest = {};
+    for (uint32_t s = 0; s < _sectorCount; s++) {
+        uint32_t off = 0;
+        BlockHeader hdr;
+        while (off + sizeof(BlockHeader) <= _sectorSize) {
+            _blockAt(s * _sectorSize + off, hdr);
+            if (!_validHeader(hdr, off)) break;
+            if (!found || hdr.seq > maxSeq) {
+                found = true;
+                maxSeq = hdr.seq;
+                _headSector = s;
+                newest = hdr;
+                newestOffset = s * _sectorSize + off;
+                _writeOffset = off + align4(sizeof(BlockHeader) + hdr.bytes);
+            }
+            off += align4(sizeof(BlockHeader) + hdr.bytes);
+        }
+    }
+
+    _hasOpen = false;
+    _hasLast = false;
+    _mounted = true;
+
+    if (!found) {
+        // Nothing stored yet: the first block erases and opens sector 0
+        _headSector = _sectorCount - 1;
+        _writeOffset = _sectorSize;
+        _nextSeq = 1;
+        return true;
+    }
+    _nextSeq = maxSeq + 1;
+
+    // A torn header after the chain means the rest of the sector is not
+    // erased: continue in the next sector instead of writing over it
+    if (_writeOffset + sizeof(BlockHeader) <= _sectorSize) {
+        BlockHeader after;
+        _blockAt(_headSector * _sectorSize + _writeOffset, after);
+        const uint8_t *raw = reinterpret_cast<const uint8_t *>(&after);
+        for (size_t i = 0; i < sizeof(after); i++) {
+            if (raw[i] != 0xFF) {
+                _writeOffset = _sectorSize;
+                break;
+            }
+        }
+    }
+
+    // Restore the last stored sample: dead-band and newestEpoch() continue from it
+    const uint8_t *payload = _blockAt(newestOffset, newest);
+    if (!payload && _region.read(newestOffset + sizeof(BlockHeader), _scratch, newest.bytes)) {
+        payload = _scratch;
+    }
+    if (payload && flashCrc16(payload, newest.bytes) == newest.crc) {
+        size_t visited = 0;
+        TsSample last;
+        _decodeBlock(newest, payload, 0, UINT32_MAX, keepLast, &last, visited);
+        if (visited) {
+            _last = last;
+            _hasLast = true;
+        }
+    }
+    return true;
+}
+
+bool TimeSeriesStore::format() {
+    for (uint32_t s = 0; s < _sectorCount; s++) {
+        if (!_region.eraseSector(s * _sectorSize)) return false;
+    }
+    _headSector = _sectorCount - 1;
+    _writeOffset = _sectorSize;
+    _nextSeq = 1;
+    _hasOpen = false;
+    _hasLast = false;
+    return true;
+}
+
+// ============================================================
+// APPEND
+// ============================================================
+bool TimeSeriesStore::append(const TsSample &sample) {
+    if (!_mounted) return false;
+
+    // Dead-band: small moves keep the stored value, so sensor noise
+    // does not cost a delta on every sample
+    TsSample s = sample;
+    if (_hasLast) {
+        for (int ch = 0; ch < TS_NUMERIC_CHANNELS; ch++) {
+            if (s.value[ch] == TS_INVALID || _last.value[ch] == TS_INVALID) continue;
+            const int32_t d = (int32_t)s.value[ch] - _last.value[ch];
+            if (d > -_config.deadband[ch] && d < _config.deadband[ch]) s.value[ch] = _last.value[ch];
+        }
+    }
+
+    if (_hasOpen) {
+        const uint32_t period = _openHdr.periodS;
+        if (s.epoch < _openHdr.startEpoch) {
+            if (!_seal()) return false;   // clock stepped back: new block
+        } else {
+            const uint32_t slot = (s.epoch - _openHdr.startEpoch + period / 2) / period;
+            if (slot < _openHdr.count) return true;   // same slot again: keep the first
+            if (slot > _openHdr.count ||                                   // gap
+                s.epoch - _openHdr.startEpoch >= _config.sealIntervalS ||  // bound RAM-only data
+                _openBits + MAX_SAMPLE_BITS > _openCapBits) {              // full
+                if (!_seal()) return false;
+            }
+        }
+    }
+    if (!_hasOpen) return _startBlock(s);
+
+    uint8_t mask = 0;
+    for (int ch = 0; ch < TS_NUMERIC_CHANNELS; ch++) {
+        if (s.value[ch] != _last.value[ch]) mask |= 1 << ch;
+    }
+    if (s.relays != _last.relays) mask |= 1 << TS_NUMERIC_CHANNELS;
+
+    if (mask == 0) {
+        _putBits(0, 1);
+    } else {
+        _putBits(1, 1);
+        _putBits(mask, 5);
+        for (int ch = 0; ch < TS_NUMERIC_CHANNELS; ch++) {
+            if (mask & (1 << ch)) _putDelta(_last.value[ch], s.value[ch]);
+        }
+        if (mask & (1 << TS_NUMERIC_CHANNELS)) _putBits(s.relays & 0x0F, 4);
+    }
+
+    _openHdr.count++;
+    _last = s;
+    _last.epoch = _openHdr.startEpoch + (_openHdr.count - 1) * _openHdr.periodS;
+    _samplesAppended++;
+    return true;
+}
+
+bool TimeSeriesStore::flush() {
+    return _seal();
+}
+
+// New block with s as its keyframe; decides where the block will go
+bool TimeSeriesStore::_startBlock(const TsSample &s) {
+    if (_writeOffset + sizeof(BlockHeader) + 16 > _sectorSize) {
+        if (!_advanceSector()) return false;
+    }
+    uint32_t capBytes = _sectorSize - _writeOffset;
+    if (capBytes > _config.blockMaxBytes) capBytes = _config.blockMaxBytes;
+
+    memset(_open, 0, sizeof(_open));
+    _openHdr.magic = MAGIC;
+    _openHdr.count = 1;
+    _openHdr.startEpoch = s.epoch;
+    _openHdr.seq = _nextSeq;
+    _openHdr.bytes = 0;
+    _openHdr.crc = 0;
+    _openHdr.periodS = _config.periodS;
+    _openHdr.relays = s.relays;
+    _openHdr.reserved = 0xFFFF;
+    memcpy(_openHdr.key, s.value, sizeof(_openHdr.key));
+
+    _openBits = 0;
+    _openCapBits = (capBytes - sizeof(BlockHeader)) * 8;
+    _hasOpen = true;
+    _last = s;
+    _hasLast = true;
+    _samplesAppended++;
+    return true;
+}
+
+bool TimeSeriesStore::_seal() {
+    if (!_hasOpen) return true;
+    _hasOpen = false;
+
+    uint8_t *payload = _open + sizeof(BlockHeader);
+    _openHdr.bytes = (uint16_t)((_openBits + 7) / 8);
+    _openHdr.crc = flashCrc16(payload, _openHdr.bytes);
+    memcpy(_open, &_openHdr, sizeof(BlockHeader));
+
+    const uint32_t total = sizeof(BlockHeader) + _openHdr.bytes;
+    const bool ok = _region.write(_headSector * _sectorSize + _writeOffset, _open, total);
+    // Even a failed program may have touched the flash: never reuse the range
+    _writeOffset += align4(total);
+    _nextSeq++;
+    if (ok) {
+        _blocksSealed++;
+        _bitsWritten += _openBits;
+    }
+    return ok;
+}
+
+// Erase-before-use; drops the oldest blocks
+bool TimeSeriesStore::_advanceSector() {
+    const uint32_t next = (_headSector + 1) % _sectorCount;
+    if (!_region.eraseSector(next * _sectorSize)) return false;
+    _headSector = next;
+    _writeOffset = 0;
+    return true;
+}
+
+void TimeSeriesStore::_putBits(uint32_t value, uint8_t bits) {
+    uint8_t *payload = _open + sizeof(BlockHeader);
+    for (uint8_t i = 0; i < bits; i++, _openBits++) {
+        if ((value >> i) & 1) payload[_openBits >> 3] |= 1 << (_openBits & 7);
+    }
+}
+
+void TimeSeriesStore::_putDelta(int16_t prev, int16_t next) {
+    if (prev != TS_INVALID && next != TS_INVALID) {
+        const uint32_t z = zigzag((int32_t)next - prev);
+        if (z <= 4)   { _putBits(0b0, 1);   _putBits(z - 1, 2);  return; }
+        if (z <= 36)  { _putBits(0b01, 2);  _putBits(z - 5, 5);  return; }
+        if (z <= 292) { _putBits(0b011, 3); _putBits(z - 37, 8); return; }
+    }
+    _putBits(0b111, 3);
+    _putBits((uint16_t)next, 16);
+}
+
+// ============================================================
+// QUERY
+// ============================================================
+size_t TimeSeriesStore::query(uint32_t from, uint32_t to, TsVisitFn fn, void *ctx) {
+    _lastScanned = 0;
+    _lastDecoded = 0;
+    if (!_mounted || from > to) return 0;
+
+    size_t visited = 0;
+    // Oldest sector first: the one after the head
+    for (uint32_t i = 1; i <= _sectorCount; i++) {
+        const uint32_t s = (_headSector + i) % _sectorCount;
+        uint32_t off = 0;
+        BlockHeader hdr;
+        while (off + sizeof(BlockHeader) <= _sectorSize) {
+            const uint32_t blockOffset = s * _sectorSize + off;
+            const uint8_t *payload = _blockAt(blockOffset, hdr);
+            if (!_validHeader(hdr, off)) break;
+            off += align4(sizeof(BlockHeader) + hdr.bytes);
+            _lastScanned++;
+
+            const uint32_t end = hdr.startEpoch + (uint32_t)(hdr.count - 1) * hdr.periodS;
+            if (end < from || hdr.startEpoch > to) continue;   // header only
+
+            if (!payload) {
+                // No mapping: copy this one block
+                if (!_region.read(blockOffset + sizeof(BlockHeader), _scratch, hdr.bytes)) continue;
+                payload = _scratch;
+            }
+            if (flashCrc16(payload, hdr.bytes) != hdr.crc) continue;
+            _lastDecoded++;
+            if (!_decodeBlock(hdr, payload, from, to, fn, ctx, visited)) return visited;
+        }
+    }
+
+    // Newest samples are still in RAM
+    if (_hasOpen) {
+        BlockHeader open = _openHdr;
+        open.bytes = (uint16_t)((_openBits + 7) / 8);
+        _lastDecoded++;
+        _decodeBlock(open, _open + sizeof(BlockHeader), from, to, fn, ctx, visited);
+    }
+    return visited;
+}
+
+bool TimeSeriesStore::_decodeBlock(const BlockHeader &hdr, const uint8_t *payload, uint32_t from, uint32_t to,
+                                   TsVisitFn fn, void *ctx, size_t &visited) {
+    TsBitReader in(payload, (uint32_t)hdr.bytes * 8);
+    TsSample s;
+    s.epoch = hdr.startEpoch;
+    memcpy(s.value, hdr.key, sizeof(s.value));
+    s.relays = hdr.relays;
+
+    for (uint32_t i = 0; i < hdr.count; i++) {
+        if (i > 0) {
+            s.epoch += hdr.periodS;
+            if (in.get(1)) {
+                const uint8_t mask = (uint8_t)in.get(5);
+                for (int ch = 0; ch < TS_NUMERIC_CHANNELS; ch++) {
+                    if (mask & (1 << ch)) s.value[ch] = in.delta(s.value[ch]);
+                }
+                if (mask & (1 << TS_NUMERIC_CHANNELS)) s.relays = (uint8_t)in.get(4);
+            }
+        }
+        if (s.epoch > to) break;
+        if (s.epoch >= from) {
+            visited++;
+            if (!fn(ctx, s)) return false;
+        }
+    }
+    return true;
+}
+
+uint32_t TimeSeriesStore::oldestEpoch() {
+    for (uint32_t i = 1; i <= _sectorCount; i++) {
+        const uint32_t s = (_headSector + i) % _sectorCount;
+        BlockHeader hdr;
+        _blockAt(s * _sectorSize, hdr);
+        if (_validHeader(hdr, 0)) return hdr.startEpoch;
+    }
+    return _hasOpen ? _openHdr.startEpoch : 0;
+}
+
+uint32_t TimeSeriesStore::bytesUsed() {
+    uint32_t used = 0;
+    for (uint32_t s = 0; s < _sectorCount; s++) {
+        uint32_t off = 0;
+        BlockHeader hdr;
+        while (off + sizeof(BlockHeader) <= _sectorSize) {
+            _blockAt(s * _sectorSize + off, hdr);
+            if (!_validHeader(hdr, off)) break;
+            off += align4(sizeof(BlockHeader) + hdr.bytes);
+        }
+        used += off;
+    }
+    return used;
+}
+
+// ============================================================
+// BLOCK ACCESS
+// ============================================================
+
+// Fills hdr; returns the mapped payload, or nullptr without a mapping
+const uint8_t *TimeSeriesStore::_blockAt(uint32_t offset, BlockHeader &hdr) {
+    const uint8_t *base = _region.map();
+    if (base) {
+        memcpy(&hdr, base + offset, sizeof(hdr));
+        return base + offset + sizeof(hdr);
+    }
+    if (!_region.read(offset, &hdr, sizeof(hdr))) memset(&hdr, 0xFF, sizeof(hdr));
+    return nullptr;
+}
+
+bool TimeSeriesStore::_validHeader(const BlockHeader &hdr, uint32_t offsetInSector) const {
+    return hdr.magic == MAGIC && hdr.count > 0 && hdr.periodS != 0 && hdr.periodS != 0xFF &&
+           hdr.bytes <= _config.blockMaxBytes - sizeof(BlockHeader) &&
+           offsetInSector + sizeof(BlockHeader) + hdr.bytes <= _sectorSize;
+}
@@ -0,0 +1,49 @@
+// ============================================================
+// TELEMETRY / COMMAND TRANSPORT
+// RTDB backend and the build-time selection, see transport.h
+// ============================================================
+
+#include "transport.h"
+#include "hal.h"
+
+#include <string.h>
+
+#if TELEMETRY_TRANSPORT_MQTT
+#include "mqtt_transport.h"
+#endif
+
+RtdbTransport rtdbTransport;
+
+#if TELEMETRY_TRANSPORT_MQTT
+TelemetryTransport *transport = &mqttTransport;
+#else
+TelemetryTransport *transport = &rtdbTransport;
+#endif
+
+bool RtdbTransport::ready() {
+    return hal.rtdb->ready();
+}
+
+bool RtdbTransport::publishTelemetry(const char *json) {
+    return hal.rtdb->update(FIREBASE_BASE_PATH, json);
+}
+
+bool RtdbTransport::publishBacklog(const char *json) {
+    return hal.rtdb->update(FIREBASE_BASE_PATH, json);
+}
+
+const char *RtdbTransport::lastError() {
+    return hal.rtdb->lastError();
+}
+
+bool parseTransportCommand(const char *root, const char *topic, const uint8_t *payload, size_t length,
+                           const char *&path, char *value, size_t valueSize) {
+    const size_t rootLen = strlen(root);
+    if (strncmp(topic, root, rootLen) != 0 || topic[rootLen] != '/') return false;
+    if (length == 0 || length >= valueSize) return false;
+
+    memcpy(value, payload, length);
+    value[length] = '\0';
+    path = topic + rootLen + 1;
+    return true;
+}
@@ -0,0 +1,188 @@
+// ============================================================
+// CONTROLLER TESTS (pio test -e native)
+// Hysteresis, relay hold, fan cycle and manual-mode overrides
+// against the simulated clock / GPIO (hal.h Sim*)
+// ============================================================
+
+#include <unity.h>
+
+#include "config.h"
+#include "controller.h"
+#include "hal.h"
+
+// SimClock only moves forward; every test starts from "now"
+static void resetController() {
+    temp1 = -127.0f;
+    temp2 = -127.0f;
+    ambientTemp = -127.0f;
+    ambientHumidity = 0.0f;
+    heaterOn = refrigOn = fanOn = false;
+    autoRelayControl = true;
+    heaterOnTemp  = DEFAULT_HEATER_ON_TEMP_C;
+    heaterOffTemp = DEFAULT_HEATER_OFF_TEMP_C;
+    refrigOnTemp  = DEFAULT_REFRIG_ON_TEMP2_C;
+    refrigOffTemp = DEFAULT_REFRIG_OFF_TEMP2_C;
+    heaterCmd = refrigCmd = fanCmd = false;
+    heaterCmdKnown = refrigCmdKnown = fanCmdKnown = false;
+    fanCycleStartMillis = simClock.millis();
+    fanCycleOnPhase = true;
+    bootStartMillis = simClock.millis();
+    provisioningMode = false;
+}
+
+void setUp() {
+    resetController();
+}
+
+void tearDown() {}
+
+// ============================================================
+// AUTOMATIC CONTROL
+// ============================================================
+static void test_heater_follows_average_with_hysteresis() {
+    ambientTemp = 28.0f;
+    temp2 = 30.0f;                     // avg 29 <= ON 30
+    updateAutomaticControl();
+    TEST_ASSERT_TRUE(heaterOn);
+
+    temp2 = 36.0f;                     // avg 32: inside the band, stays on
+    updateAutomaticControl();
+    TEST_ASSERT_TRUE(heaterOn);
+
+    ambientTemp = 34.0f;               // avg 35 >= OFF 35
+    updateAutomaticControl();
+    TEST_ASSERT_FALSE(heaterOn);
+
+    ambientTemp = 30.0f;               // avg 33: inside the band, stays off
+    updateAutomaticControl();
+    TEST_ASSERT_FALSE(heaterOn);
+}
+
+static void test_heater_untouched_when_inputs_invalid() {
+    heaterOn = true;
+    ambientTemp = 40.0f;
+    temp2 = -127.0f;                   // disconnected probe
+    updateAutomaticControl();
+    TEST_ASSERT_TRUE(heaterOn);
+
+    temp2 = 40.0f;
+    ambientTemp = -127.0f;             // SHT30 missing
+    updateAutomaticControl();
+    TEST_ASSERT_TRUE(heaterOn);
+}
+
+static void test_refrig_follows_temp1_with_hysteresis() {
+    temp1 = 2.5f;                      // >= ON 2
+    updateAutomaticControl();
+    TEST_ASSERT_TRUE(refrigOn);
+
+    temp1 = 1.0f;                      // inside the band
+    updateAutomaticControl();
+    TEST_ASSERT_TRUE(refrigOn);
+
+    temp1 = -0.1f;                     // <= OFF 0
+    updateAutomaticControl();
+    TEST_ASSERT_FALSE(refrigOn);
+
+    temp1 = 1.9f;
+    updateAutomaticControl();
+    TEST_ASSERT_FALSE(refrigOn);
+
+    refrigOn = true;
+    temp1 = -127.0f;                   // invalid: keep the last decision
+    updateAutomaticControl();
+    TEST_ASSERT_TRUE(refrigOn);
+}
+
+// ============================================================
+// RELAY HOLD
+// ============================================================
+static void test_relays_held_off_during_startup() {
+    TEST_ASSERT_TRUE(shouldHoldRelaysOff());
+    simClock.advanceMs(RELAY_STARTUP_HOLDOFF_MS - 1);
+    TEST_ASSERT_TRUE(shouldHoldRelaysOff());
+    simClock.advanceMs(1);
+    TEST_ASSERT_FALSE(shouldHoldRelaysOff());
+}
+
+static void test_relays_held_off_while_provisioning() {
+    simClock.advanceMs(RELAY_STARTUP_HOLDOFF_MS);
+    TEST_ASSERT_FALSE(shouldHoldRelaysOff());
+    provisioningMode = true;
+    TEST_ASSERT_EQUAL(RELAYS_OFF_DURING_PROVISIONING, shouldHoldRelaysOff());
+    provisioningMode = false;
+    TEST_ASSERT_FALSE(shouldHoldRelaysOff());
+}
+
+static void test_enforce_relays_off_drives_outputs() {
+    heaterOn = refrigOn = fanOn = true;
+    enforceRelaysOff();
+    TEST_ASSERT_FALSE(heaterOn || refrigOn || fanOn);
+    TEST_ASSERT_TRUE(simGpio.isOutput(PIN_RELAY_HEATER));
+    TEST_ASSERT_EQUAL(RELAY_HEATER_ACTIVE_LOW, simGpio.level(PIN_RELAY_HEATER));
+    TEST_ASSERT_EQUAL(RELAY_REFRIG_ACTIVE_LOW, simGpio.level(PIN_RELAY_REFRIG));
+    TEST_ASSERT_EQUAL(RELAY_FAN_ACTIVE_LOW, simGpio.level(PIN_RELAY_FAN));
+    TEST_ASSERT_FALSE(simGpio.level(PIN_LED_FAN));
+}
+
+// ============================================================
+// FAN CYCLE
+// ============================================================
+static void test_fan_cycle_phases() {
+    updateFanCycle();
+    TEST_ASSERT_TRUE(fanOn);
+
+    simClock.advanceMs(FAN_ON_DURATION_MS - 1);
+    updateFanCycle();
+    TEST_ASSERT_TRUE(fanOn);
+
+    simClock.advanceMs(1);
+    updateFanCycle();
+    TEST_ASSERT_FALSE(fanOn);
+
+    simClock.advanceMs(FAN_OFF_DURATION_MS - 1);
+    updateFanCycle();
+    TEST_ASSERT_FALSE(fanOn);
+
+    simClock.advanceMs(1);
+    updateFanCycle();
+    TEST_ASSERT_TRUE(fanOn);
+}
+
+// ============================================================
+// MANUAL MODE
+// ============================================================
+static void test_manual_mode_applies_commands_with_safety_cutoffs() {
+    autoRelayControl = false;
+    heaterCmd = refrigCmd = fanCmd = true;
+    heaterCmdKnown = refrigCmdKnown = fanCmdKnown = true;
+    ambientTemp = 20.0f;
+    temp2 = 20.0f;
+    temp1 = 5.0f;
+    runControlCycle();
+    TEST_ASSERT_TRUE(heaterOn && refrigOn && fanOn);
+    TEST_ASSERT_EQUAL(!RELAY_FAN_ACTIVE_LOW, simGpio.level(PIN_RELAY_FAN));
+
+    ambientTemp = 40.0f;               // avg 30: below OFF, command wins
+    runControlCycle();
+    TEST_ASSERT_TRUE(heaterOn);
+    temp2 = 30.0f;                     // avg 35 >= OFF
+    temp1 = 0.0f;                      // <= refrig OFF
+    runControlCycle();
+    TEST_ASSERT_FALSE(heaterOn);
+    TEST_ASSERT_FALSE(refrigOn);
+    TEST_ASSERT_TRUE(fanOn);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_heater_follows_average_with_hysteresis);
+    RUN_TEST(test_heater_untouched_when_inputs_invalid);
+    RUN_TEST(test_refrig_follows_temp1_with_hysteresis);
+    RUN_TEST(test_relays_held_off_during_startup);
+    RUN_TEST(test_relays_held_off_while_provisioning);
+    RUN_TEST(test_enforce_relays_off_drives_outputs);
+    RUN_TEST(test_fan_cycle_phases);
+    RUN_TEST(test_manual_mode_applies_commands_with_safety_cutoffs);
+    return UNITY_END();
+}
@@ -0,0 +1,204 @@
+// ============================================================
+// FLASH RING LOG TESTS (pio test -e native)
+// FileFlashRegion image with NOR semantics; a remount is a
+// close + reopen + begin(), as after a reset
+// ============================================================
+
+#include <unity.h>
+
+#include <deque>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "flash_region.h"
+#include "flash_ring_log.h"
+
+static const char *IMAGE = "test_flash_ring_log.img";
+static const uint32_t SECTOR = 256;
+static const uint32_t SECTORS = 4;
+static const uint16_t RECORD = 12;              // 16-byte slots, 15 records per sector
+static const uint32_t PER_SECTOR = SECTOR / 16 - 1;
+
+struct Rec {
+    uint32_t id;
+    uint32_t a;
+    uint32_t b;
+};
+
+static FileFlashRegion region;
+
+static Rec makeRec(uint32_t id) {
+    Rec r = {id, id * 2654435761u, ~id};
+    return r;
+}
+
+static void mountFresh() {
+    remove(IMAGE);
+    TEST_ASSERT_TRUE(region.open(IMAGE, SECTOR * SECTORS, SECTOR));
+}
+
+static void remount(FlashRingLog &log) {
+    region.close();
+    TEST_ASSERT_TRUE(region.open(IMAGE, SECTOR * SECTORS, SECTOR));
+    TEST_ASSERT_TRUE(log.begin());
+}
+
+// Expects the log to hold exactly the ids in want, oldest first
+static void expectPending(FlashRingLog &log, const std::deque<uint32_t> &want) {
+    TEST_ASSERT_EQUAL_UINT32(want.size(), log.pending());
+    Rec out[SECTORS * PER_SECTOR];
+    const size_t n = log.peek(out, SECTORS * PER_SECTOR);
+    TEST_ASSERT_EQUAL_UINT32(want.size(), n);
+    for (size_t i = 0; i < n; i++) {
+        const Rec r = makeRec(want[i]);
+        TEST_ASSERT_EQUAL_MEMORY(&r, &out[i], sizeof(Rec));
+    }
+}
+
+void setUp() {
+    mountFresh();
+}
+
+void tearDown() {
+    region.close();
+    remove(IMAGE);
+}
+
+static void test_append_peek_consume_remount() {
+    FlashRingLog log(region, RECORD);
+    TEST_ASSERT_TRUE(log.begin());
+    TEST_ASSERT_EQUAL_UINT32(SECTORS * PER_SECTOR, log.capacity());
+
+    std::deque<uint32_t> want;
+    for (uint32_t id = 1; id <= 20; id++) {
+        const Rec r = makeRec(id);
+        TEST_ASSERT_TRUE(log.append(&r));
+        want.push_back(id);
+    }
+    expectPending(log, want);
+
+    TEST_ASSERT_EQUAL_UINT32(7, log.consume(7));
+    want.erase(want.begin(), want.begin() + 7);
+    remount(log);
+    expectPending(log, want);
+
+    // Appends continue after the last record written before the reset
+    const Rec r = makeRec(21);
+    TEST_ASSERT_TRUE(log.append(&r));
+    want.push_back(21);
+    remount(log);
+    expectPending(log, want);
+}
+
+static void test_wrap_drops_oldest_sector() {
+    FlashRingLog log(region, RECORD);
+    TEST_ASSERT_TRUE(log.begin());
+
+    const uint32_t total = SECTORS * PER_SECTOR + 5;   // opens a fifth sector: wraps once
+    for (uint32_t id = 1; id <= total; id++) {
+        const Rec r = makeRec(id);
+        TEST_ASSERT_TRUE(log.append(&r));
+    }
+    TEST_ASSERT_EQUAL_UINT32(PER_SECTOR, log.overwritten());
+
+    std::deque<uint32_t> want;
+    for (uint32_t id = PER_SECTOR + 1; id <= total; id++) want.push_back(id);
+    expectPending(log, want);
+    remount(log);
+    expectPending(log, want);
+}
+
+// A reset mid-program leaves the state byte set but the record
+// (and so its CRC) incomplete
+static void test_torn_record_is_skipped_and_retired() {
+    FlashRingLog log(region, RECORD);
+    TEST_ASSERT_TRUE(log.begin());
+    for (uint32_t id = 1; id <= 3; id++) {
+        const Rec r = makeRec(id);
+        TEST_ASSERT_TRUE(log.append(&r));
+    }
+    // Slot 4 of sector 0: state byte only, the rest never programmed
+    const uint8_t written = 0xFE;
+    TEST_ASSERT_TRUE(region.write(4 * 16, &written, 1));
+    // Record 2 with a bit cleared in its payload
+    const uint8_t flipped = 0x00;
+    TEST_ASSERT_TRUE(region.write(2 * 16 + 4, &flipped, 1));
+
+    remount(log);
+    TEST_ASSERT_EQUAL_UINT32(4, log.pending());   // counted until retired
+    Rec out[8];
+    TEST_ASSERT_EQUAL_UINT32(2, log.peek(out, 8));
+    TEST_ASSERT_EQUAL_UINT32(1, out[0].id);
+    TEST_ASSERT_EQUAL_UINT32(3, out[1].id);
+
+    TEST_ASSERT_EQUAL_UINT32(2, log.consume(2));
+    TEST_ASSERT_EQUAL_UINT32(1, log.corrupt());
+    // The torn slot burns its position: the next append goes after it
+    const Rec r = makeRec(5);
+    TEST_ASSERT_TRUE(log.append(&r));
+    TEST_ASSERT_EQUAL_UINT32(1, log.consume(8));
+    TEST_ASSERT_EQUAL_UINT32(2, log.corrupt());
+    TEST_ASSERT_EQUAL_UINT32(0, log.pending());
+}
+
+// A reset between the erase and the header write of the next sector
+static void test_torn_sector_open_keeps_backlog() {
+    FlashRingLog log(region, RECORD);
+    TEST_ASSERT_TRUE(log.begin());
+    std::deque<uint32_t> want;
+    for (uint32_t id = 1; id <= PER_SECTOR; id++) {
+        const Rec r = makeRec(id);
+        TEST_ASSERT_TRUE(log.append(&r));
+        want.push_back(id);
+    }
+    TEST_ASSERT_TRUE(region.eraseSector(1 * SECTOR));
+    remount(log);
+    expectPending(log, want);
+}
+
+// Random appends / consumes / remounts against a deque model
+static void test_random_ops_match_model() {
+    FlashRingLog log(region, RECORD);
+    TEST_ASSERT_TRUE(log.begin());
+    std::deque<uint32_t> model;
+    uint32_t nextId = 1;
+    uint32_t lostBase = 0;
+    uint32_t lost = 0;
+    srand(12345);
+
+    for (int step = 0; step < 4000; step++) {
+        const int op = rand() % 100;
+        if (op < 70) {
+            const Rec r = makeRec(nextId);
+            TEST_ASSERT_TRUE(log.append(&r));
+            model.push_back(nextId++);
+            // Wrap recycled a sector: its pending records are gone
+            for (; lostBase < log.overwritten(); lostBase++, lost++) model.pop_front();
+        } else if (op < 90) {
+            // Alternate filling phases (wrap-around) and draining phases
+            const size_t k = rand() % ((step / 500) % 2 ? 4 : 24);
+            const size_t done = log.consume(k);
+            TEST_ASSERT_EQUAL_UINT32(k < model.size() ? k : model.size(), done);
+            model.erase(model.begin(), model.begin() + done);
+        } else {
+            remount(log);
+            lostBase = 0;
+        }
+        TEST_ASSERT_EQUAL_UINT32(model.size(), log.pending());
+        if (step % 50 == 0) expectPending(log, model);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, log.corrupt());
+    TEST_ASSERT_GREATER_THAN(0, lost);   // the run did wrap over a backlog
+    remount(log);
+    expectPending(log, model);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_append_peek_consume_remount);
+    RUN_TEST(test_wrap_drops_oldest_sector);
+    RUN_TEST(test_torn_record_is_skipped_and_retired);
+    RUN_TEST(test_torn_sector_open_keeps_backlog);
+    RUN_TEST(test_random_ops_match_model);
+    return UNITY_END();
+}
@@ -0,0 +1,150 @@
+// ============================================================
+// HEAP CHURN TESTS (pio test -e native)
+// Allocations per Firebase push / poll cycle: compile-time
+// FB_PATH() literals and the fixed telemetry buffer, against the
+// String(FIREBASE_BASE_PATH) + "..." builders they replaced
+// ============================================================
+
+#include <unity.h>
+
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include "config.h"
+#include "hal.h"
+#include "telemetry.h"
+#include "transport.h"
+
+// ============================================================
+// ALLOCATION COUNTER (every operator new in the process)
+// ============================================================
+static volatile uint32_t allocCount = 0;
+
+void *operator new(size_t size) {
+    allocCount++;
+    void *p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+static const int CYCLES = 200;
+
+static TelemetrySnapshot snap;
+static TelemetryPayload payload;
+static size_t pathChars;   // keeps the path work from being optimized out
+
+void setUp() {
+    memset(&snap, 0, sizeof(snap));
+    snap.temp1 = 1.5f;
+    snap.temp2 = 31.0f;
+    snap.ambientTemp = 24.0f;
+    snap.ambientHumidity = 50.0f;
+    snap.temp1Valid = snap.temp2Valid = snap.ambientValid = true;
+    snap.autoMode = true;
+    snap.rssi = -61;
+    snap.freeHeap = 180000;
+    snap.epoch = 1760000000;
+    simRtdb.online = true;
+    pathChars = 0;
+}
+
+void tearDown() {}
+
+// Stand-in for Arduino String on the host: heap-backed once past
+// the small-string buffer, as every absolute RTDB path is
+typedef std::string String;
+
+static void use(const String &path) { pathChars += path.size(); }
+static void use(const char *path) { pathChars += strlen(path); }
+
+// The original pushToFirebase() paths: one String per field per cycle
+static void legacyPushPaths() {
+    String base = String(FIREBASE_BASE_PATH);
+    static const char *const CHILDREN[] = {
+        "/sensors/temperature_unit", "/sensors/temp1", "/sensors/temp2", "/sensors/ambient_temp",
+        "/sensors/ambient_humidity", "/sensors/valid", "/sensors/last_update", "/relays/heater_state",
+        "/relays/refrig_state", "/relays/fan_state", "/relays/auto_mode_state", "/status/state",
+        "/status/last_seen", "/status/rssi", "/status/free_heap", "/status/uptime_s",
+    };
+    for (const char *child : CHILDREN) use(base + child);
+}
+
+// The original updateRelayControlModeFromFirebase() and
+// readRelayCommandsFromFirebase() paths
+static void legacyPollPaths() {
+    const String basePath = String(FIREBASE_BASE_PATH);
+    use(basePath + "/relays/auto_mode");
+    use(basePath + "/settings/heater_onTemp");
+    use(basePath + "/settings/heater_offTemp");
+    use(basePath + "/settings/refrig_onTemp");
+    use(basePath + "/settings/refrig_offTemp");
+    String base = String(FIREBASE_BASE_PATH) + "/relays/control";
+    use(base + "/heater");
+    use(base + "/refrig");
+    use(base + "/fan");
+}
+
+// Same reads with the compile-time table
+static const char *const POLL_PATHS[] = {
+    FB_PATH("/relays/auto_mode"),        FB_PATH("/settings/heater_onTemp"),
+    FB_PATH("/settings/heater_offTemp"), FB_PATH("/settings/refrig_onTemp"),
+    FB_PATH("/settings/refrig_offTemp"), FB_PATH("/relays/control/heater"),
+    FB_PATH("/relays/control/refrig"),   FB_PATH("/relays/control/fan"),
+};
+
+static void test_fb_path_is_a_literal() {
+    static_assert(sizeof(FB_PATH("/relays")) == sizeof(FIREBASE_BASE_PATH) + sizeof("/relays") - 1,
+                  "FB_PATH joins at compile time");
+    TEST_ASSERT_EQUAL_STRING("/devices/" FIREBASE_DEVICE_ID "/relays/control/fan", POLL_PATHS[7]);
+}
+
+static void test_push_and_poll_allocations_before_and_after() {
+    TelemetryTracker tracker;
+    // Warm up: first full push sizes SimRtdb's copy of the last document
+    TEST_ASSERT_TRUE(buildTelemetryPayload(snap, TF_ALL, payload));
+    TEST_ASSERT_TRUE(transport->publishTelemetry(payload.c_str()));
+
+    uint32_t start = allocCount;
+    for (int i = 0; i < CYCLES; i++) {
+        legacyPushPaths();
+        legacyPollPaths();
+    }
+    const uint32_t before = allocCount - start;
+
+    start = allocCount;
+    for (int i = 0; i < CYCLES; i++) {
+        snap.temp1 = 1.5f + (i % 10) * 0.1f;
+        snap.epoch++;
+        const uint32_t nowMs = i * FIREBASE_UPDATE_INTERVAL_MS;
+        const uint32_t fields = tracker.select(snap, nowMs);
+        if (fields) {
+            TEST_ASSERT_TRUE(buildTelemetryPayload(snap, fields, payload));
+            TEST_ASSERT_TRUE(transport->publishTelemetry(payload.c_str()));
+            tracker.commit(snap, fields, nowMs);
+        }
+        for (const char *path : POLL_PATHS) use(path);
+    }
+    const uint32_t after = allocCount - start;
+
+    char line[96];
+    snprintf(line, sizeof(line), "allocations per push+poll cycle: %.1f before, %.1f after",
+             (double)before / CYCLES, (double)after / CYCLES);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(before >= CYCLES * 24u);   // one String per path at least
+    TEST_ASSERT_EQUAL_UINT32(0, after);
+    TEST_ASSERT_TRUE(pathChars > 0);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_fb_path_is_a_literal);
+    RUN_TEST(test_push_and_poll_allocations_before_and_after);
+    return UNITY_END();
+}
@@ -0,0 +1,202 @@
+// ============================================================
+// LOG RING TESTS (pio test -e native)
+// All-or-nothing records, wrap order, lines from concurrent
+// producers never interleaving, and enqueue cost against a
+// direct write() per line (what Log did before the ring)
+// ============================================================
+
+#include <unity.h>
+
+#include <chrono>
+#include <deque>
+#include <fcntl.h>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "log_ring.h"
+
+static const uint8_t CRLF[] = {'\r', '\n'};
+
+void setUp() {}
+void tearDown() {}
+
+// Drains everything the consumer side can see, in order
+template <uint32_t N>
+static std::string drain(LogRing<N> &ring) {
+    std::string out;
+    const uint8_t *run = nullptr;
+    size_t len;
+    while ((len = ring.peek(run)) > 0) {
+        out.append((const char *)run, len);
+        ring.consume(len);
+    }
+    return out;
+}
+
+static void test_record_fits_whole_or_is_refused() {
+    static LogRing<64> ring;
+    uint32_t fill = 0;
+    const std::string text(60, 'a');
+    TEST_ASSERT_TRUE(ring.push((const uint8_t *)text.data(), 60, CRLF, 2, fill));
+    TEST_ASSERT_EQUAL_UINT32(62, fill);
+    // 2 bytes free: the text alone would fit, text + CRLF does not
+    TEST_ASSERT_FALSE(ring.push((const uint8_t *)"xy", 2, CRLF, 2, fill));
+    TEST_ASSERT_EQUAL_UINT32(62, ring.used());
+    TEST_ASSERT_TRUE(ring.push((const uint8_t *)"xy", 2, nullptr, 0, fill));
+    TEST_ASSERT_EQUAL_UINT32(64, fill);
+    TEST_ASSERT_EQUAL_STRING((text + "\r\nxy").c_str(), drain(ring).c_str());
+    TEST_ASSERT_EQUAL_UINT32(0, ring.used());
+}
+
+static void test_wrap_keeps_bytes_in_order() {
+    // Random pushes and partial drains against a byte-queue model
+    static LogRing<256> ring;
+    std::deque<char> model;
+    srand(3);
+    uint32_t refused = 0;
+    for (int step = 0; step < 20000; step++) {
+        if (rand() % 3) {
+            char text[80];
+            const size_t len = 1 + rand() % 70;
+            for (size_t i = 0; i < len; i++) text[i] = 'A' + (step + i) % 26;
+            const bool crlf = rand() & 1;
+            const size_t size = len + (crlf ? 2 : 0);
+            uint32_t fill = 0;
+            const bool fits = model.size() + size <= 256;
+            TEST_ASSERT_EQUAL(fits, ring.push((const uint8_t *)text, len, CRLF, crlf ? 2 : 0, fill));
+            if (!fits) {
+                refused++;
+                continue;
+            }
+            model.insert(model.end(), text, text + len);
+            if (crlf) model.insert(model.end(), CRLF, CRLF + 2);
+            TEST_ASSERT_EQUAL_UINT32(model.size(), fill);
+        } else {
+            const uint8_t *run = nullptr;
+            const size_t avail = ring.peek(run);
+            const size_t take = avail ? 1 + rand() % avail : 0;
+            for (size_t i = 0; i < take; i++) {
+                TEST_ASSERT_EQUAL_UINT8((uint8_t)model.front(), run[i]);
+                model.pop_front();
+            }
+            ring.consume(take);
+        }
+        TEST_ASSERT_EQUAL_UINT32(model.size(), ring.used());
+    }
+    TEST_ASSERT_TRUE(refused > 0);
+}
+
+static void test_concurrent_lines_never_interleave() {
+    // Producers serialised by a mutex (the logger's spinlock),
+    // one drain thread; every drained line must come out whole
+    static LogRing<1024> ring;
+    static const int PRODUCERS = 4;
+    static const int LINES = 20000;
+    std::mutex ringMux;
+    std::atomic<int> running(PRODUCERS);
+    std::atomic<uint32_t> dropped(0);
+    std::string out;
+
+    std::thread drainer([&]() {
+        const uint8_t *run = nullptr;
+        for (;;) {
+            const bool last = running.load() == 0;
+            size_t len;
+            while ((len = ring.peek(run)) > 0) {
+                out.append((const char *)run, len);
+                ring.consume(len);
+            }
+            if (last) break;
+            std::this_thread::yield();
+        }
+    });
+    std::thread producers[PRODUCERS];
+    for (int p = 0; p < PRODUCERS; p++) {
+        producers[p] = std::thread([&, p]() {
+            char line[64];
+            for (int i = 0; i < LINES; i++) {
+                const int n = snprintf(line, sizeof(line), "[T%d] line %d %.*s", p, i, i % 23,
+                                       "=======================");
+                uint32_t fill = 0;
+                std::lock_guard<std::mutex> guard(ringMux);
+                if (!ring.push((const uint8_t *)line, n, CRLF, 2, fill)) dropped++;
+            }
+            running--;
+        });
+    }
+    for (std::thread &t : producers) t.join();
+    drainer.join();
+
+    // Each producer's surviving lines are well formed and in order
+    int lastSeen[PRODUCERS];
+    for (int &l : lastSeen) l = -1;
+    uint32_t lines = 0;
+    size_t start = 0;
+    size_t end;
+    while ((end = out.find("\r\n", start)) != std::string::npos) {
+        int p = -1;
+        int i = -1;
+        TEST_ASSERT_EQUAL(2, sscanf(out.c_str() + start, "[T%d] line %d", &p, &i));
+        const std::string text = out.substr(start, end - start);
+        const int pad = (int)(text.size() - text.rfind(' ') - 1);
+        TEST_ASSERT_TRUE(p >= 0 && p < PRODUCERS);
+        TEST_ASSERT_TRUE(i > lastSeen[p]);
+        TEST_ASSERT_EQUAL(i % 23, pad);
+        lastSeen[p] = i;
+        lines++;
+        start = end + 2;
+    }
+    TEST_ASSERT_EQUAL_UINT32(out.size(), start);   // nothing after the last CRLF
+    TEST_ASSERT_EQUAL_UINT32(PRODUCERS * LINES, lines + dropped.load());
+}
+
+static void test_bench_enqueue_vs_direct_write() {
+    static LogRing<8192> ring;
+    static const int N = 200000;
+    const char line[] = "[CTRL] T1=1.25 T2=31.50 amb=27.0 hum=48 heater=OFF fan=ON";
+    const size_t len = sizeof(line) - 1;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; i++) {
+        uint32_t fill = 0;
+        if (!ring.push((const uint8_t *)line, len, CRLF, 2, fill)) {
+            const uint8_t *run = nullptr;
+            size_t n;
+            while ((n = ring.peek(run)) > 0) ring.consume(n);   // free drain: cost the caller only
+            ring.push((const uint8_t *)line, len, CRLF, 2, fill);
+        }
+    }
+    const double ringNs =
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / N;
+
+    // Before the ring every line was a synchronous write to the
+    // sinks; /dev/null is the cheapest possible sink
+    const int fd = open("/dev/null", O_WRONLY);
+    TEST_ASSERT_TRUE(fd >= 0);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; i++) {
+        TEST_ASSERT_EQUAL((ssize_t)len, write(fd, line, len));
+        TEST_ASSERT_EQUAL(2, write(fd, CRLF, 2));
+    }
+    const double directNs =
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / N;
+    close(fd);
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%u-byte line: ring enqueue %.1f ns, direct write() %.1f ns on host",
+             (unsigned)(len + 2), ringNs, directNs);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_TRUE(ringNs < directNs);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_record_fits_whole_or_is_refused);
+    RUN_TEST(test_wrap_keeps_bytes_in_order);
+    RUN_TEST(test_concurrent_lines_never_interleave);
+    RUN_TEST(test_bench_enqueue_vs_direct_write);
+    return UNITY_END();
+}
@@ -0,0 +1,158 @@
+// ============================================================
+// LOGGING TESTS (pio test -e native)
+// LOGx() level gating and heap allocations per control cycle,
+// against the String-concatenating log lines they replaced
+// ============================================================
+
+#include <unity.h>
+
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include "config.h"
+#include "controller.h"
+#include "hal.h"
+#include "logger.h"
+
+// Tags local to this test: one below and one above the build level
+#define LOG_LEVEL_QUIET LOG_WARN
+#define LOG_LEVEL_LOUD  LOG_TRACE
+
+// ============================================================
+// ALLOCATION COUNTER (every operator new in the process)
+// ============================================================
+static volatile uint32_t allocCount = 0;
+
+void *operator new(size_t size) {
+    allocCount++;
+    void *p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+void setUp() {
+    temp1 = 1.25f;
+    temp2 = 31.5f;
+    ambientTemp = 27.0f;
+    ambientHumidity = 48.0f;
+    autoRelayControl = true;
+    bootStartMillis = simClock.millis();
+}
+
+void tearDown() {}
+
+// ============================================================
+// LEVEL GATING
+// ============================================================
+static int evaluated = 0;
+
+static int sideEffect() {
+    return ++evaluated;
+}
+
+static void test_disabled_levels_do_not_evaluate_arguments() {
+    evaluated = 0;
+    LOGI(QUIET, "%d", sideEffect());
+    LOGD(QUIET, "%d", sideEffect());
+    LOGT(CTRL, "%d", sideEffect());
+    TEST_ASSERT_EQUAL(0, evaluated);
+    LOGW(QUIET, "%d", sideEffect());
+    TEST_ASSERT_EQUAL(1, evaluated);
+}
+
+static void test_tag_level_above_build_level_is_enabled() {
+    TEST_ASSERT_TRUE(LOG_LEVEL_LOUD > CURRENT_LOG_LEVEL);
+    evaluated = 0;
+    LOGD(LOUD, "%d", sideEffect());
+    LOGT(LOUD, "%d", sideEffect());
+    TEST_ASSERT_EQUAL(2, evaluated);
+}
+
+// ============================================================
+// ALLOCATIONS PER CONTROL CYCLE
+// ============================================================
+
+// Stand-in for Arduino String(value, decimals) on the host
+static std::string fixed(float value, int decimals) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%.*f", decimals, (double)value);
+    return std::string(buf);
+}
+
+static void emit(const std::string &line) {
+    Log.println(line.c_str());
+}
+
+// The per-cycle log lines of the original readSensors(),
+// updateAutomaticControl() and applyRelayStates()
+static void legacyCycleLogging() {
+    const float avgTemp = (ambientTemp + temp2) / 2.0f;
+    emit("[SENSOR] Temp1: " + fixed(temp1, 1) + "°C  |  " +
+         "Temp2: " + fixed(temp2, 1) + "°C  |  " +
+         "Ambient: " + fixed(ambientTemp, 1) + "°C  " +
+         fixed(ambientHumidity, 1) + "%RH");
+    emit("[CTRL] Heater Avg(Ambient+temp2) = " + fixed(avgTemp, 2) +
+         "°C (ON<=" + fixed(heaterOnTemp, 1) +
+         ", OFF>=" + fixed(heaterOffTemp, 1) + ")");
+    emit("[CTRL] Refrig temp1 = " + fixed(temp1, 2) +
+         "°C (OFF<=" + fixed(refrigOffTemp, 1) +
+         ", ON>=" + fixed(refrigOnTemp, 1) + ")");
+    emit("[RELAY] Heater:" + std::string(heaterOn ? "ON " : "OFF") +
+         "  Refrig:" + std::string(refrigOn ? "ON " : "OFF") +
+         "  Fan:" + std::string(fanOn ? "ON " : "OFF"));
+}
+
+// The same lines through LOGx(), all enabled
+static void leveledCycleLogging() {
+    const float avgTemp = (ambientTemp + temp2) / 2.0f;
+    LOGI(LOUD, "Temp1: %.1f°C  |  Temp2: %.1f°C  |  Ambient: %.1f°C  %.1f%%RH",
+         temp1, temp2, ambientTemp, ambientHumidity);
+    LOGD(LOUD, "Heater Avg(Ambient+temp2) = %.2f°C (ON<=%.1f, OFF>=%.1f)",
+         avgTemp, heaterOnTemp, heaterOffTemp);
+    LOGD(LOUD, "Refrig temp1 = %.2f°C (OFF<=%.1f, ON>=%.1f)",
+         temp1, refrigOffTemp, refrigOnTemp);
+    LOGD(LOUD, "Heater:%s  Refrig:%s  Fan:%s",
+         heaterOn ? "ON " : "OFF", refrigOn ? "ON " : "OFF", fanOn ? "ON " : "OFF");
+}
+
+static void test_control_cycle_allocations_before_and_after() {
+    static const int CYCLES = 50;
+    runControlCycle();           // warm up stdout buffers
+    legacyCycleLogging();
+    leveledCycleLogging();
+
+    uint32_t start = allocCount;
+    for (int i = 0; i < CYCLES; i++) {
+        runControlCycle();
+        legacyCycleLogging();
+    }
+    const uint32_t before = allocCount - start;
+
+    start = allocCount;
+    for (int i = 0; i < CYCLES; i++) {
+        runControlCycle();
+        leveledCycleLogging();
+    }
+    const uint32_t after = allocCount - start;
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "allocations per control cycle: before %.1f, after %.1f",
+             (double)before / CYCLES, (double)after / CYCLES);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_GREATER_THAN(0, before);
+    TEST_ASSERT_EQUAL_UINT32(0, after);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_disabled_levels_do_not_evaluate_arguments);
+    RUN_TEST(test_tag_level_above_build_level_is_enabled);
+    RUN_TEST(test_control_cycle_allocations_before_and_after);
+    return UNITY_END();
+}
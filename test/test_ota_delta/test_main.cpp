@@ -0,0 +1,257 @@
+// ============================================================
+// OTA DELTA PATCHER TESTS (pio test -e native)
+// EDL1 patches built from known random edits, fed in random
+// and single-byte chunks; rejection of foreign bases, bad ops
+// and truncated streams; patch throughput on the host.
+// The gzip inflater is covered by test_ota_gzip.
+// ============================================================
+
+#include <unity.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "ota_decoder.h"
+#include "sha256.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+struct Delta {
+    Bytes base;
+    Bytes target;
+    Bytes patch;
+    uint8_t baseSha[Sha256::DIGEST_BYTES];
+};
+
+static void putU32(Bytes &out, uint32_t v) {
+    for (int i = 0; i < 4; i++) out.push_back((uint8_t)(v >> (8 * i)));
+}
+
+static void putCopy(Delta &d, uint32_t offset, uint32_t len) {
+    d.patch.push_back(0x01);
+    putU32(d.patch, offset);
+    putU32(d.patch, len);
+    d.target.insert(d.target.end(), d.base.begin() + offset, d.base.begin() + offset + len);
+}
+
+static void putInsert(Delta &d, uint32_t len) {
+    d.patch.push_back(0x02);
+    putU32(d.patch, len);
+    for (uint32_t i = 0; i < len; i++) {
+        const uint8_t b = (uint8_t)rand();
+        d.patch.push_back(b);
+        d.target.push_back(b);
+    }
+}
+
+// Firmware-like base (runs of repeats among noise), then a
+// target that mostly copies it in order with small inserts,
+// the way a rebuild shifts code around
+static Delta makeDelta(unsigned seed, uint32_t baseSize) {
+    srand(seed);
+    Delta d;
+    d.base.resize(baseSize);
+    for (uint32_t i = 0; i < baseSize; i++) {
+        d.base[i] = (i % 64 < 24) ? (uint8_t)(i >> 6) : (uint8_t)rand();
+    }
+    Sha256 sha;
+    sha.update(d.base.data(), d.base.size());
+    sha.finish(d.baseSha);
+
+    d.patch.insert(d.patch.end(), OTA_DELTA_MAGIC, OTA_DELTA_MAGIC + 4);
+    putU32(d.patch, baseSize);
+    d.patch.insert(d.patch.end(), d.baseSha, d.baseSha + sizeof(d.baseSha));
+    const size_t targetSizeAt = d.patch.size();
+    putU32(d.patch, 0);   // patched in below
+
+    uint32_t pos = 0;
+    while (pos < baseSize) {
+        const uint32_t run = 1 + rand() % 20000;
+        const uint32_t len = (run < baseSize - pos) ? run : baseSize - pos;
+        putCopy(d, pos, len);
+        pos += len;
+        if (rand() % 4 == 0) putInsert(d, rand() % 300);
+        if (rand() % 8 == 0 && pos < baseSize) pos += rand() % 400;              // dropped code
+        if (rand() % 16 == 0) putCopy(d, rand() % (baseSize / 2), 1 + rand() % 256);   // moved code
+        if (pos > baseSize) pos = baseSize;
+    }
+    d.patch.push_back(0x00);
+    const uint32_t targetSize = d.target.size();
+    memcpy(&d.patch[targetSizeAt], &targetSize, 4);   // little endian host
+    return d;
+}
+
+// ============================================================
+// PATCH RUNNER
+// ============================================================
+struct Run {
+    const Delta *delta;
+    Bytes out;
+    size_t sinkLimit;   // sink refuses output past this
+};
+
+static bool readBase(void *ctx, uint32_t offset, uint8_t *out, size_t len) {
+    const Run *run = static_cast<const Run *>(ctx);
+    if (offset + len > run->delta->base.size()) return false;
+    memcpy(out, &run->delta->base[offset], len);
+    return true;
+}
+
+static bool sink(void *ctx, const uint8_t *data, size_t len) {
+    Run *run = static_cast<Run *>(ctx);
+    if (run->out.size() + len > run->sinkLimit) return false;
+    run->out.insert(run->out.end(), data, data + len);
+    return true;
+}
+
+static uint8_t scratch[1024];
+
+// Feeds patch in chunks of 1..maxChunk bytes; returns the last feed() result
+static bool applyPatch(DeltaPatcher &patcher, Run &run, const Bytes &patch, size_t maxChunk,
+                       const uint8_t *baseSha = nullptr, uint32_t baseSize = 0) {
+    const Delta &d = *run.delta;
+    patcher.begin(sink, &run, readBase, &run, baseSize ? baseSize : (uint32_t)d.base.size(),
+                  baseSha ? baseSha : d.baseSha, scratch, sizeof(scratch));
+    size_t at = 0;
+    bool ok = true;
+    while (ok && at < patch.size()) {
+        size_t n = 1 + rand() % maxChunk;
+        if (n > patch.size() - at) n = patch.size() - at;
+        ok = patcher.feed(&patch[at], n);
+        at += n;
+    }
+    return ok;
+}
+
+void setUp() {}
+void tearDown() {}
+
+// ============================================================
+// CORRECTNESS
+// ============================================================
+static void test_random_edits_patch_to_target() {
+    for (unsigned seed = 1; seed <= 5; seed++) {
+        const Delta d = makeDelta(seed, 300000);
+        Run run = {&d, {}, SIZE_MAX};
+        DeltaPatcher patcher;
+        TEST_ASSERT_TRUE(applyPatch(patcher, run, d.patch, 4000));
+        TEST_ASSERT_TRUE(patcher.isDone());
+        TEST_ASSERT_EQUAL_UINT32(d.target.size(), patcher.targetSize());
+        TEST_ASSERT_EQUAL_UINT32(d.target.size(), run.out.size());
+        TEST_ASSERT_EQUAL_MEMORY(d.target.data(), run.out.data(), d.target.size());
+    }
+}
+
+static void test_single_byte_feeds() {
+    const Delta d = makeDelta(9, 60000);
+    Run run = {&d, {}, SIZE_MAX};
+    DeltaPatcher patcher;
+    TEST_ASSERT_TRUE(applyPatch(patcher, run, d.patch, 1));
+    TEST_ASSERT_TRUE(patcher.isDone());
+    TEST_ASSERT_EQUAL_MEMORY(d.target.data(), run.out.data(), d.target.size());
+}
+
+static void test_rejects_patch_for_another_base() {
+    const Delta d = makeDelta(2, 20000);
+    DeltaPatcher patcher;
+
+    uint8_t otherSha[Sha256::DIGEST_BYTES];
+    memcpy(otherSha, d.baseSha, sizeof(otherSha));
+    otherSha[31] ^= 1;
+    Run run = {&d, {}, SIZE_MAX};
+    TEST_ASSERT_FALSE(applyPatch(patcher, run, d.patch, 64, otherSha));
+    TEST_ASSERT_TRUE(patcher.hasError());
+    TEST_ASSERT_EQUAL_UINT32(0, run.out.size());
+
+    run.out.clear();
+    TEST_ASSERT_FALSE(applyPatch(patcher, run, d.patch, 64, nullptr, d.base.size() - 1));
+    TEST_ASSERT_TRUE(patcher.hasError());
+}
+
+static void test_rejects_bad_ops() {
+    const Delta d = makeDelta(3, 20000);
+    const size_t header = 44;
+    DeltaPatcher patcher;
+    Run run = {&d, {}, SIZE_MAX};
+
+    // COPY reaching past the end of the base
+    Bytes patch(d.patch.begin(), d.patch.begin() + header);
+    patch.push_back(0x01);
+    putU32(patch, d.base.size() - 10);
+    putU32(patch, 11);
+    TEST_ASSERT_FALSE(applyPatch(patcher, run, patch, 64));
+
+    // INSERT longer than the declared target
+    patch.resize(header);
+    patch.push_back(0x02);
+    putU32(patch, d.target.size() + 1);
+    TEST_ASSERT_FALSE(applyPatch(patcher, run, patch, 64));
+
+    // Unknown opcode
+    patch.resize(header);
+    patch.push_back(0x07);
+    TEST_ASSERT_FALSE(applyPatch(patcher, run, patch, 64));
+
+    // END before the target is complete
+    patch.resize(header);
+    patch.push_back(0x00);
+    TEST_ASSERT_FALSE(applyPatch(patcher, run, patch, 64));
+    TEST_ASSERT_TRUE(patcher.hasError());
+}
+
+static void test_truncated_patch_is_not_done() {
+    const Delta d = makeDelta(4, 50000);
+    const Bytes cut(d.patch.begin(), d.patch.end() - 1);   // no END
+    Run run = {&d, {}, SIZE_MAX};
+    DeltaPatcher patcher;
+    TEST_ASSERT_TRUE(applyPatch(patcher, run, cut, 512));
+    TEST_ASSERT_FALSE(patcher.isDone());
+    TEST_ASSERT_FALSE(patcher.hasError());
+}
+
+static void test_sink_failure_stops_the_patch() {
+    const Delta d = makeDelta(5, 50000);
+    Run run = {&d, {}, 10000};   // flash write fails after 10 KB
+    DeltaPatcher patcher;
+    TEST_ASSERT_FALSE(applyPatch(patcher, run, d.patch, 2048));
+    TEST_ASSERT_TRUE(patcher.hasError());
+    TEST_ASSERT_TRUE(run.out.size() <= 10000);
+}
+
+// ============================================================
+// BENCHMARK
+// ============================================================
+static void test_bench_patch_throughput() {
+    // About the size of the app image, fed in TCP-sized chunks
+    const Delta d = makeDelta(11, 1700000);
+    Run run = {&d, {}, SIZE_MAX};
+    run.out.reserve(d.target.size());
+    DeltaPatcher patcher;
+
+    const auto start = std::chrono::steady_clock::now();
+    TEST_ASSERT_TRUE(applyPatch(patcher, run, d.patch, 1460));
+    const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    TEST_ASSERT_TRUE(patcher.isDone());
+    TEST_ASSERT_EQUAL_MEMORY(d.target.data(), run.out.data(), d.target.size());
+
+    char line[160];
+    snprintf(line, sizeof(line), "%u-byte target from a %u-byte patch (%.1f%%): %.0f MB/s on host",
+             (unsigned)d.target.size(), (unsigned)d.patch.size(), 100.0 * d.patch.size() / d.target.size(),
+             d.target.size() / s / 1e6);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(d.patch.size() * 10 < d.target.size());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_random_edits_patch_to_target);
+    RUN_TEST(test_single_byte_feeds);
+    RUN_TEST(test_rejects_patch_for_another_base);
+    RUN_TEST(test_rejects_bad_ops);
+    RUN_TEST(test_truncated_patch_is_not_done);
+    RUN_TEST(test_sink_failure_stops_the_patch);
+    RUN_TEST(test_bench_patch_throughput);
+    return UNITY_END();
+}
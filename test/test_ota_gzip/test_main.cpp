@@ -0,0 +1,468 @@
+// ============================================================
+// OTA GZIP INFLATER TESTS (pio test -e native)
+// RFC 1952 headers with every optional field split across
+// single-byte feeds, bad magic/method, output past the 32 KB
+// window, truncated streams, sink failure, gzip -> delta
+// patcher, and inflate throughput on the host (lib/tinfl)
+// ============================================================
+
+#include <unity.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "ota_decoder.h"
+#include "sha256.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+// ============================================================
+// ENCODER
+// Just enough deflate to drive the inflater: greedy LZ77 over
+// the full 32 KB window with fixed Huffman codes, optionally
+// interleaved with stored blocks
+// ============================================================
+static const uint16_t LEN_BASE[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                      31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t LEN_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                      2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t DIST_BASE[30] = {1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+                                       33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+                                       1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                       6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+struct BitWriter {
+    Bytes out;
+    uint32_t buf = 0;
+    uint32_t bits = 0;
+
+    void put(uint32_t value, uint32_t n) {   // LSB first
+        buf |= value << bits;
+        bits += n;
+        while (bits >= 8) {
+            out.push_back((uint8_t)buf);
+            buf >>= 8;
+            bits -= 8;
+        }
+    }
+    void putCode(uint32_t code, uint32_t n) {   // Huffman codes go MSB first
+        uint32_t rev = 0;
+        for (uint32_t i = 0; i < n; i++) rev |= ((code >> i) & 1) << (n - 1 - i);
+        put(rev, n);
+    }
+    void align() {
+        if (bits) put(0, 8 - bits);
+    }
+};
+
+static void putFixedSymbol(BitWriter &bw, uint32_t sym) {
+    if (sym < 144) bw.putCode(0x30 + sym, 8);
+    else if (sym < 256) bw.putCode(0x190 + sym - 144, 9);
+    else if (sym < 280) bw.putCode(sym - 256, 7);
+    else bw.putCode(0xC0 + sym - 280, 8);
+}
+
+static void putMatch(BitWriter &bw, uint32_t len, uint32_t dist) {
+    int l = 28;
+    while (LEN_BASE[l] > len) l--;
+    putFixedSymbol(bw, 257 + l);
+    bw.put(len - LEN_BASE[l], LEN_EXTRA[l]);
+    int d = 29;
+    while (DIST_BASE[d] > dist) d--;
+    bw.putCode(d, 5);
+    bw.put(dist - DIST_BASE[d], DIST_EXTRA[d]);
+}
+
+// Raw deflate of data in blocks of blockSize; every storedEvery-th
+// block (if non-zero) goes out stored
+static Bytes deflateFixed(const Bytes &data, size_t blockSize = 16384, int storedEvery = 0) {
+    static const uint32_t HASH_BITS = 15;
+    std::vector<int32_t> head(1u << HASH_BITS, -1);
+    BitWriter bw;
+    size_t pos = 0;
+    int block = 0;
+    auto hashAt = [&](size_t i) {
+        return ((data[i] << 10) ^ (data[i + 1] << 5) ^ data[i + 2]) & ((1u << HASH_BITS) - 1);
+    };
+    do {
+        const size_t end = (data.size() - pos < blockSize) ? data.size() : pos + blockSize;
+        const bool final = end == data.size();
+        if (storedEvery && ++block % storedEvery == 0) {
+            bw.put(final, 1);
+            bw.put(0, 2);
+            bw.align();
+            const uint16_t len = (uint16_t)(end - pos);
+            bw.put(len, 16);
+            bw.put((uint16_t)~len, 16);
+            bw.out.insert(bw.out.end(), data.begin() + pos, data.begin() + end);
+            for (; pos < end; pos++) {
+                if (pos + 3 <= data.size()) head[hashAt(pos)] = (int32_t)pos;
+            }
+            continue;
+        }
+        bw.put(final, 1);
+        bw.put(1, 2);
+        while (pos < end) {
+            uint32_t len = 0;
+            uint32_t dist = 0;
+            if (pos + 3 <= end) {
+                const uint32_t h = hashAt(pos);
+                const int32_t cand = head[h];
+                head[h] = (int32_t)pos;
+                if (cand >= 0 && pos - cand <= 32768) {
+                    const size_t max = (end - pos < 258) ? end - pos : 258;
+                    while (len < max && data[cand + len] == data[pos + len]) len++;
+                    dist = (uint32_t)(pos - cand);
+                }
+            }
+            if (len >= 3) {
+                putMatch(bw, len, dist);
+                for (size_t i = 1; i < len && pos + i + 3 <= data.size(); i++) head[hashAt(pos + i)] = (int32_t)(pos + i);
+                pos += len;
+            } else {
+                putFixedSymbol(bw, data[pos++]);
+            }
+        }
+        putFixedSymbol(bw, 256);
+    } while (pos < data.size());
+    bw.align();
+    return bw.out;
+}
+
+static uint32_t crc32(const uint8_t *data, size_t len, uint32_t crc = 0) {
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
+
+static void putLe(Bytes &out, uint32_t v, int n) {
+    for (int i = 0; i < n; i++) out.push_back((uint8_t)(v >> (8 * i)));
+}
+
+#define GZ_FHCRC    0x02
+#define GZ_FEXTRA   0x04
+#define GZ_FNAME    0x08
+#define GZ_FCOMMENT 0x10
+
+static Bytes gzipWrap(const Bytes &data, const Bytes &body, uint8_t flags = 0) {
+    Bytes gz = {0x1F, 0x8B, 8, flags, 0x78, 0x56, 0x34, 0x12, 0, 3};
+    if (flags & GZ_FEXTRA) {
+        const char extra[] = "AP\x04\x00" "abcd" "XY\x00\x00";
+        putLe(gz, sizeof(extra) - 1, 2);
+        gz.insert(gz.end(), extra, extra + sizeof(extra) - 1);
+    }
+    if (flags & GZ_FNAME) {
+        const char name[] = "firmware.bin";
+        gz.insert(gz.end(), name, name + sizeof(name));
+    }
+    if (flags & GZ_FCOMMENT) {
+        const char comment[] = "build 1.4.2";
+        gz.insert(gz.end(), comment, comment + sizeof(comment));
+    }
+    if (flags & GZ_FHCRC) putLe(gz, crc32(gz.data(), gz.size()) & 0xFFFF, 2);
+    gz.insert(gz.end(), body.begin(), body.end());
+    putLe(gz, crc32(data.data(), data.size()), 4);
+    putLe(gz, (uint32_t)data.size(), 4);
+    return gz;
+}
+
+// Firmware-like: runs of repeats, noise, and code blocks that
+// recur from 1 KB up to ~31 KB back so matches reach across the
+// window as it wraps
+static Bytes firmwareLike(unsigned seed, size_t size) {
+    srand(seed);
+    Bytes d;
+    d.reserve(size);
+    while (d.size() < size) {
+        const int kind = rand() % 4;
+        if (kind == 0 && d.size() > 32768) {
+            const size_t back = 1024 + rand() % 30720;
+            const size_t len = 16 + rand() % 600;
+            const size_t from = d.size() - back;
+            for (size_t i = 0; i < len; i++) d.push_back(d[from + i]);
+        } else if (kind == 1) {
+            d.insert(d.end(), 8 + rand() % 64, (uint8_t)rand());
+        } else {
+            const size_t len = 8 + rand() % 200;
+            for (size_t i = 0; i < len; i++) d.push_back((uint8_t)(rand() % 24));   // low-entropy "opcodes"
+        }
+    }
+    d.resize(size);
+    return d;
+}
+
+// ============================================================
+// INFLATE RUNNER
+// ============================================================
+struct Run {
+    Bytes out;
+    size_t sinkLimit;   // sink refuses output past this
+};
+
+static bool sink(void *ctx, const uint8_t *data, size_t len) {
+    Run *run = static_cast<Run *>(ctx);
+    if (run->out.size() + len > run->sinkLimit) return false;
+    run->out.insert(run->out.end(), data, data + len);
+    return true;
+}
+
+// Feeds gz in chunks of 1..maxChunk bytes; returns the last feed() result
+static bool inflate(GzipInflater &gz, Run &run, const Bytes &stream, size_t maxChunk) {
+    TEST_ASSERT_TRUE(gz.begin(sink, &run));
+    size_t at = 0;
+    bool ok = true;
+    while (ok && at < stream.size()) {
+        size_t n = 1 + rand() % maxChunk;
+        if (n > stream.size() - at) n = stream.size() - at;
+        ok = gz.feed(&stream[at], n);
+        at += n;
+    }
+    return ok;
+}
+
+// zlib -9 output (dynamic Huffman block) for 1000 bytes of the
+// ACGT sequence from acgt() below
+static const uint8_t DYNAMIC_GZ[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x3d, 0x93, 0xdb, 0x71, 0x03, 0x41,
+    0x08, 0x04, 0x63, 0x9b, 0xe2, 0x83, 0x04, 0xc8, 0x3f, 0x16, 0xd1, 0xcd, 0x9e, 0x4a, 0xb6, 0x6f,
+    0xbd, 0x07, 0xc3, 0x3c, 0x50, 0x77, 0xcd, 0x4c, 0x4f, 0xf6, 0x99, 0xd4, 0xec, 0xa7, 0xbb, 0xbd,
+    0xaa, 0xde, 0x0b, 0xce, 0x5d, 0x15, 0xde, 0xed, 0x61, 0xba, 0xf7, 0x3c, 0x94, 0x94, 0x8d, 0xdb,
+    0x59, 0x74, 0x74, 0xf6, 0x67, 0x4f, 0xe3, 0xfb, 0xa9, 0xec, 0xa7, 0xb2, 0x18, 0xfb, 0x9e, 0x4b,
+    0x7f, 0xfd, 0x67, 0x61, 0xb7, 0x72, 0xcb, 0xa9, 0x06, 0xbb, 0x99, 0xb3, 0x4d, 0x4c, 0xb7, 0x7e,
+    0x40, 0x2e, 0x00, 0x98, 0x41, 0x1b, 0x25, 0x0d, 0x53, 0xc1, 0x5b, 0x32, 0x8b, 0xde, 0xcc, 0x81,
+    0x31, 0x67, 0x04, 0x1c, 0x19, 0x0a, 0x16, 0x3a, 0x8c, 0xda, 0x2b, 0x4a, 0xbd, 0x5b, 0xf0, 0xed,
+    0x0b, 0x10, 0x81, 0xcb, 0xc8, 0xdc, 0x81, 0xc8, 0x42, 0x51, 0xc3, 0x94, 0x4a, 0x48, 0xe0, 0xc9,
+    0x28, 0xeb, 0x98, 0x9e, 0x25, 0x5b, 0xbe, 0x74, 0x47, 0x5c, 0x7d, 0xab, 0xfa, 0x24, 0xd7, 0x3c,
+    0xe9, 0xb1, 0x7a, 0x4a, 0xa3, 0x22, 0x11, 0x64, 0x2e, 0x6c, 0xcd, 0x07, 0xba, 0x2e, 0x28, 0x47,
+    0xf7, 0x5a, 0xbf, 0xa8, 0x03, 0x18, 0xfd, 0x2a, 0x09, 0x17, 0x05, 0xff, 0xb2, 0x53, 0xcf, 0x0d,
+    0x02, 0xd9, 0x12, 0x59, 0x37, 0x97, 0x84, 0x0a, 0x0c, 0x2b, 0x17, 0x65, 0x49, 0x3f, 0x58, 0x7d,
+    0xa1, 0x01, 0x26, 0x95, 0x81, 0xef, 0xf8, 0x89, 0x30, 0x66, 0x09, 0xe5, 0x53, 0x7f, 0xde, 0x18,
+    0x72, 0x19, 0x6b, 0x5d, 0x17, 0xfd, 0x10, 0xe9, 0x8b, 0x69, 0xcc, 0x40, 0xf3, 0x1d, 0x2c, 0xbd,
+    0x9c, 0x30, 0xe0, 0x18, 0xf6, 0x32, 0x28, 0xe3, 0xee, 0xa8, 0xfe, 0x9a, 0x4e, 0x05, 0x96, 0x6b,
+    0xdf, 0xb4, 0x05, 0x17, 0xf5, 0x68, 0xb3, 0xbc, 0x98, 0x84, 0x20, 0x92, 0x96, 0x32, 0x00, 0x0e,
+    0x76, 0x59, 0x95, 0xe9, 0x8c, 0xc9, 0x4b, 0xfd, 0xd9, 0x45, 0x61, 0x7c, 0xba, 0x93, 0xe7, 0x36,
+    0xbc, 0xbc, 0xcb, 0xf9, 0x89, 0xff, 0x18, 0x8a, 0x69, 0x86, 0xc1, 0x93, 0x76, 0x37, 0xa5, 0x6e,
+    0xeb, 0xaf, 0x70, 0x0c, 0x26, 0xc7, 0xa6, 0x4f, 0x5a, 0x24, 0x98, 0xdb, 0x78, 0x25, 0xd4, 0x73,
+    0xb2, 0x74, 0xc0, 0x71, 0xed, 0xba, 0xd5, 0x77, 0x74, 0x3f, 0x28, 0xd7, 0x8d, 0x5b, 0x12, 0x42,
+    0x72, 0x9d, 0x62, 0x8e, 0xf7, 0x07, 0x9b, 0x05, 0xcd, 0xed, 0x7e, 0xfe, 0xeb, 0x83, 0x53, 0xf7,
+    0x95, 0xbb, 0x28, 0x7d, 0xc7, 0xf7, 0xb5, 0x25, 0xdf, 0x86, 0x34, 0xc7, 0xfe, 0x0f, 0x98, 0x1f,
+    0x51, 0xb5, 0xbb, 0x02, 0xe8, 0x03, 0x00, 0x00,
+};
+
+static Bytes acgt(size_t n) {
+    Bytes d;
+    uint32_t x = 1;
+    for (size_t i = 0; i < n; i++) {
+        x = (x * 1103515245u + 12345u) & 0x7fffffff;
+        d.push_back((uint8_t)"ACGT"[(x >> 16) & 3]);
+    }
+    return d;
+}
+
+void setUp() {}
+void tearDown() {}
+
+// ============================================================
+// HEADER
+// ============================================================
+static void test_optional_header_fields_in_single_byte_feeds() {
+    const Bytes data = firmwareLike(1, 5000);
+    const Bytes body = deflateFixed(data);
+    const uint8_t combos[] = {0,
+                              GZ_FEXTRA,
+                              GZ_FNAME,
+                              GZ_FCOMMENT,
+                              GZ_FHCRC,
+                              GZ_FNAME | GZ_FHCRC,
+                              GZ_FEXTRA | GZ_FCOMMENT,
+                              GZ_FEXTRA | GZ_FNAME | GZ_FCOMMENT | GZ_FHCRC};
+    for (uint8_t flags : combos) {
+        Run run = {{}, SIZE_MAX};
+        GzipInflater gz;
+        TEST_ASSERT_TRUE(inflate(gz, run, gzipWrap(data, body, flags), 1));
+        TEST_ASSERT_TRUE(gz.isDone());
+        TEST_ASSERT_FALSE(gz.hasError());
+        TEST_ASSERT_EQUAL_UINT32(data.size(), run.out.size());
+        TEST_ASSERT_EQUAL_MEMORY(data.data(), run.out.data(), data.size());
+    }
+}
+
+static void test_rejects_bad_magic_and_method() {
+    const Bytes data = firmwareLike(2, 1000);
+    const Bytes good = gzipWrap(data, deflateFixed(data), GZ_FNAME);
+    const int at[] = {0, 1, 2};   // ID1, ID2, CM
+    for (int i : at) {
+        Bytes bad = good;
+        bad[i] ^= (i == 2) ? 0x01 : 0x40;   // CM 8 -> 9 (not deflate)
+        Run run = {{}, SIZE_MAX};
+        GzipInflater gz;
+        TEST_ASSERT_FALSE(inflate(gz, run, bad, 1));
+        TEST_ASSERT_TRUE(gz.hasError());
+        TEST_ASSERT_FALSE(gz.isDone());
+        TEST_ASSERT_EQUAL_UINT32(0, run.out.size());
+        TEST_ASSERT_FALSE(gz.feed(&good[10], 1));   // stays failed
+    }
+}
+
+// ============================================================
+// BODY
+// ============================================================
+static void test_output_past_the_window_wraps() {
+    // 300 KB: the 32 KB window wraps ~9 times, back-references
+    // straddle the wrap point, stored blocks land in between
+    const Bytes data = firmwareLike(3, 300000);
+    for (int storedEvery = 0; storedEvery <= 3; storedEvery += 3) {
+        const Bytes gzs = gzipWrap(data, deflateFixed(data, 20000, storedEvery));
+        Run run = {{}, SIZE_MAX};
+        GzipInflater gz;
+        TEST_ASSERT_TRUE(inflate(gz, run, gzs, 3000));
+        TEST_ASSERT_TRUE(gz.isDone());
+        TEST_ASSERT_EQUAL_UINT32(data.size(), run.out.size());
+        TEST_ASSERT_EQUAL_MEMORY(data.data(), run.out.data(), data.size());
+    }
+}
+
+static void test_dynamic_huffman_block() {
+    const Bytes gzs(DYNAMIC_GZ, DYNAMIC_GZ + sizeof(DYNAMIC_GZ));
+    TEST_ASSERT_EQUAL_UINT8(2 << 1, gzs[10] & 0x06);   // BTYPE 2
+    const Bytes expect = acgt(1000);
+    for (size_t maxChunk : {(size_t)1, (size_t)7, gzs.size()}) {
+        Run run = {{}, SIZE_MAX};
+        GzipInflater gz;
+        TEST_ASSERT_TRUE(inflate(gz, run, gzs, maxChunk));
+        TEST_ASSERT_TRUE(gz.isDone());
+        TEST_ASSERT_EQUAL_UINT32(expect.size(), run.out.size());
+        TEST_ASSERT_EQUAL_MEMORY(expect.data(), run.out.data(), expect.size());
+    }
+}
+
+static void test_truncated_stream_is_not_done() {
+    const Bytes data = firmwareLike(4, 50000);
+    const Bytes gzs = gzipWrap(data, deflateFixed(data));
+    const size_t cuts[] = {5, 20, gzs.size() / 2, gzs.size() - 9};   // header, body, body, last body byte
+    for (size_t cut : cuts) {
+        Run run = {{}, SIZE_MAX};
+        GzipInflater gz;
+        TEST_ASSERT_TRUE(inflate(gz, run, Bytes(gzs.begin(), gzs.begin() + cut), 512));
+        TEST_ASSERT_FALSE(gz.isDone());
+        TEST_ASSERT_FALSE(gz.hasError());
+        TEST_ASSERT_TRUE(run.out.size() <= data.size());   // the cut may fall after the last literal
+        TEST_ASSERT_EQUAL_MEMORY(data.data(), run.out.data(), run.out.size());
+    }
+}
+
+static void test_sink_failure_stops_the_stream() {
+    const Bytes data = firmwareLike(5, 100000);
+    const Bytes gzs = gzipWrap(data, deflateFixed(data));
+    Run run = {{}, 40000};   // flash write fails after 40 KB
+    GzipInflater gz;
+    TEST_ASSERT_FALSE(inflate(gz, run, gzs, 2048));
+    TEST_ASSERT_TRUE(gz.hasError());
+    TEST_ASSERT_FALSE(gz.isDone());
+    TEST_ASSERT_TRUE(run.out.size() <= 40000);
+    TEST_ASSERT_FALSE(gz.feed(&gzs[gzs.size() - 8], 1));
+}
+
+// ============================================================
+// GZIP -> DELTA
+// ============================================================
+struct Base {
+    Bytes image;
+};
+
+static bool readBase(void *ctx, uint32_t offset, uint8_t *out, size_t len) {
+    const Base *base = static_cast<const Base *>(ctx);
+    if (offset + len > base->image.size()) return false;
+    memcpy(out, &base->image[offset], len);
+    return true;
+}
+
+static void test_gzipped_delta_round_trip() {
+    // What the OTA job does with a .delta.gz: inflate straight
+    // into the patcher, patcher into the image writer
+    Base base = {firmwareLike(6, 200000)};
+    uint8_t baseSha[Sha256::DIGEST_BYTES];
+    Sha256 sha;
+    sha.update(base.image.data(), base.image.size());
+    sha.finish(baseSha);
+
+    Bytes target;
+    Bytes patch(OTA_DELTA_MAGIC, OTA_DELTA_MAGIC + 4);
+    putLe(patch, (uint32_t)base.image.size(), 4);
+    patch.insert(patch.end(), baseSha, baseSha + sizeof(baseSha));
+    const size_t targetSizeAt = patch.size();
+    putLe(patch, 0, 4);
+    for (uint32_t pos = 0; pos < base.image.size(); pos += 25000) {
+        patch.push_back(0x01);   // COPY 24000 of every 25000
+        putLe(patch, pos, 4);
+        putLe(patch, 24000, 4);
+        target.insert(target.end(), base.image.begin() + pos, base.image.begin() + pos + 24000);
+        patch.push_back(0x02);   // INSERT 500
+        putLe(patch, 500, 4);
+        for (int i = 0; i < 500; i++) {
+            patch.push_back((uint8_t)rand());
+            target.push_back(patch.back());
+        }
+    }
+    patch.push_back(0x00);
+    const uint32_t targetSize = (uint32_t)target.size();
+    memcpy(&patch[targetSizeAt], &targetSize, 4);
+
+    const Bytes gzs = gzipWrap(patch, deflateFixed(patch), GZ_FNAME);
+    Run run = {{}, SIZE_MAX};
+    static uint8_t scratch[1024];
+    DeltaPatcher patcher;
+    patcher.begin(sink, &run, readBase, &base, base.image.size(), baseSha, scratch, sizeof(scratch));
+    GzipInflater gz;
+    TEST_ASSERT_TRUE(gz.begin(DeltaPatcher::feedThunk, &patcher));
+    for (size_t at = 0; at < gzs.size(); at += 1460) {
+        TEST_ASSERT_TRUE(gz.feed(&gzs[at], (gzs.size() - at < 1460) ? gzs.size() - at : 1460));
+    }
+    TEST_ASSERT_TRUE(gz.isDone());
+    TEST_ASSERT_TRUE(patcher.isDone());
+    TEST_ASSERT_EQUAL_UINT32(target.size(), run.out.size());
+    TEST_ASSERT_EQUAL_MEMORY(target.data(), run.out.data(), target.size());
+}
+
+// ============================================================
+// BENCHMARK
+// ============================================================
+static void test_bench_inflate_throughput() {
+    // About the size of the app image, fed in TCP-sized chunks
+    const Bytes data = firmwareLike(11, 1700000);
+    const Bytes gzs = gzipWrap(data, deflateFixed(data));
+    Run run = {{}, SIZE_MAX};
+    run.out.reserve(data.size());
+    GzipInflater gz;
+
+    const auto start = std::chrono::steady_clock::now();
+    TEST_ASSERT_TRUE(inflate(gz, run, gzs, 1460));
+    const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    TEST_ASSERT_TRUE(gz.isDone());
+    TEST_ASSERT_EQUAL_MEMORY(data.data(), run.out.data(), data.size());
+
+    char line[160];
+    snprintf(line, sizeof(line), "%u-byte image from %u gzip bytes (%.1f%%): %.0f MB/s on host",
+             (unsigned)data.size(), (unsigned)gzs.size(), 100.0 * gzs.size() / data.size(), data.size() / s / 1e6);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(gzs.size() < data.size());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_optional_header_fields_in_single_byte_feeds);
+    RUN_TEST(test_rejects_bad_magic_and_method);
+    RUN_TEST(test_output_past_the_window_wraps);
+    RUN_TEST(test_dynamic_huffman_block);
+    RUN_TEST(test_truncated_stream_is_not_done);
+    RUN_TEST(test_sink_failure_stops_the_stream);
+    RUN_TEST(test_gzipped_delta_round_trip);
+    RUN_TEST(test_bench_inflate_throughput);
+    return UNITY_END();
+}
@@ -0,0 +1,186 @@
+// ============================================================
+// OTA IMAGE WRITER TESTS (pio test -e native)
+// The download job's flash + hash path over a FileFlashRegion
+// standing in for the inactive OTA partition
+// ============================================================
+
+#include <unity.h>
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "config.h"
+#include "flash_region.h"
+#include "ota_image_writer.h"
+#include "sha256.h"
+
+static const char *IMAGE = "test_ota_image_writer.img";
+static const uint32_t PARTITION_BYTES = 64 * OTA_SECTOR_BYTES;
+
+static FileFlashRegion region;
+static std::vector<uint8_t> firmware;
+static char firmwareSha[2 * Sha256::DIGEST_BYTES + 1];
+static uint8_t scratch[OTA_BUFFER_BYTES];
+
+static void shaHex(const uint8_t *data, size_t len, char *hex) {
+    Sha256 sha;
+    uint8_t digest[Sha256::DIGEST_BYTES];
+    sha.update(data, len);
+    sha.finish(digest);
+    Sha256::toHex(digest, hex);
+}
+
+// Feeds bytes [from, to) in uneven chunks, as socket reads arrive
+static void stream(OtaImageWriter &writer, const std::vector<uint8_t> &image, uint32_t from, uint32_t to) {
+    uint32_t pos = from;
+    unsigned seed = from;
+    while (pos < to) {
+        seed = seed * 1103515245u + 12345u;
+        uint32_t n = 1 + (seed >> 16) % 1500;
+        if (n > to - pos) n = to - pos;
+        TEST_ASSERT_TRUE(writer.write(&image[pos], n));
+        pos += n;
+    }
+}
+
+void setUp() {
+    remove(IMAGE);
+    TEST_ASSERT_TRUE(region.open(IMAGE, PARTITION_BYTES, OTA_SECTOR_BYTES));
+    firmware.resize(200000 + 123);   // not sector aligned
+    srand(2024);
+    for (size_t i = 0; i < firmware.size(); i++) firmware[i] = (uint8_t)rand();
+    shaHex(firmware.data(), firmware.size(), firmwareSha);
+}
+
+void tearDown() {
+    region.close();
+    remove(IMAGE);
+}
+
+static void test_sha256_known_answers() {
+    char hex[65];
+    shaHex((const uint8_t *)"", 0, hex);
+    TEST_ASSERT_EQUAL_STRING("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855", hex);
+    shaHex((const uint8_t *)"abc", 3, hex);
+    TEST_ASSERT_EQUAL_STRING("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", hex);
+    const char *two = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";   // 56 bytes: padding spills
+    shaHex((const uint8_t *)two, strlen(two), hex);
+    TEST_ASSERT_EQUAL_STRING("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1", hex);
+
+    // Byte-at-a-time updates give the same digest
+    Sha256 sha;
+    uint8_t digest[Sha256::DIGEST_BYTES];
+    for (size_t i = 0; i < firmware.size(); i++) sha.update(&firmware[i], 1);
+    sha.finish(digest);
+    Sha256::toHex(digest, hex);
+    TEST_ASSERT_EQUAL_STRING(firmwareSha, hex);
+}
+
+static void test_good_image_verifies_and_lands_in_flash() {
+    // Leftovers of an older image: NOR writes only clear bits, so every
+    // sector must be erased before it is programmed
+    std::vector<uint8_t> zeros(OTA_SECTOR_BYTES, 0x00);
+    for (uint32_t off = 0; off < PARTITION_BYTES; off += OTA_SECTOR_BYTES) {
+        TEST_ASSERT_TRUE(region.write(off, zeros.data(), zeros.size()));
+    }
+
+    OtaImageWriter writer(region);
+    writer.restart();
+    stream(writer, firmware, 0, firmware.size());
+    TEST_ASSERT_EQUAL_UINT32(firmware.size(), writer.offset());
+
+    char actual[65];
+    TEST_ASSERT_TRUE(writer.verify(firmwareSha, actual));
+    TEST_ASSERT_EQUAL_STRING(firmwareSha, actual);
+
+    std::vector<uint8_t> back(firmware.size());
+    TEST_ASSERT_TRUE(region.read(0, back.data(), back.size()));
+    TEST_ASSERT_EQUAL_MEMORY(firmware.data(), back.data(), firmware.size());
+}
+
+static void test_corrupted_image_is_rejected() {
+    std::vector<uint8_t> corrupted = firmware;
+    corrupted[123456] ^= 0x10;   // one bit flipped in transit
+
+    OtaImageWriter writer(region);
+    writer.restart();
+    stream(writer, corrupted, 0, corrupted.size());
+
+    char actual[65];
+    TEST_ASSERT_FALSE(writer.verify(firmwareSha, actual));
+    char corruptedSha[65];
+    shaHex(corrupted.data(), corrupted.size(), corruptedSha);
+    TEST_ASSERT_EQUAL_STRING(corruptedSha, actual);
+}
+
+static void test_truncated_image_and_bad_expected_hash_are_rejected() {
+    OtaImageWriter writer(region);
+    char actual[65];
+    writer.restart();
+    stream(writer, firmware, 0, firmware.size() - 1);
+    TEST_ASSERT_FALSE(writer.verify(firmwareSha, actual));
+
+    writer.restart();
+    stream(writer, firmware, 0, firmware.size());
+    TEST_ASSERT_FALSE(writer.verify("not-a-sha", actual));
+
+    // Upper-case hex from version.json is fine
+    char upper[65];
+    for (int i = 0; i < 65; i++) upper[i] = (char)toupper((unsigned char)firmwareSha[i]);
+    writer.restart();
+    stream(writer, firmware, 0, firmware.size());
+    TEST_ASSERT_TRUE(writer.verify(upper, actual));
+}
+
+// A dropped connection: a new writer (as after a reboot) resumes at the
+// last sector-aligned checkpoint and re-hashes the prefix from flash
+static void test_resume_rehashes_prefix_from_flash() {
+    const uint32_t cut = 77777;
+    const uint32_t checkpoint = cut & ~(OTA_SECTOR_BYTES - 1);
+    {
+        OtaImageWriter first(region);
+        first.restart();
+        stream(first, firmware, 0, cut);
+    }
+
+    OtaImageWriter writer(region);
+    TEST_ASSERT_TRUE(writer.resume(checkpoint, scratch, sizeof(scratch)));
+    TEST_ASSERT_EQUAL_UINT32(checkpoint, writer.offset());
+    stream(writer, firmware, checkpoint, firmware.size());
+    char actual[65];
+    TEST_ASSERT_TRUE(writer.verify(firmwareSha, actual));
+
+    // A prefix that was corrupted in flash fails the final check
+    const uint8_t zero = 0;
+    TEST_ASSERT_TRUE(region.write(100, &zero, 1));
+    TEST_ASSERT_TRUE(writer.resume(checkpoint, scratch, sizeof(scratch)));
+    stream(writer, firmware, checkpoint, firmware.size());
+    TEST_ASSERT_FALSE(writer.verify(firmwareSha, actual));
+
+    TEST_ASSERT_FALSE(writer.resume(checkpoint + 1, scratch, sizeof(scratch)));
+    TEST_ASSERT_EQUAL_UINT32(0, writer.offset());
+}
+
+static void test_image_larger_than_partition_fails() {
+    OtaImageWriter writer(region);
+    writer.restart();
+    std::vector<uint8_t> chunk(OTA_SECTOR_BYTES, 0xA5);
+    for (uint32_t off = 0; off < PARTITION_BYTES; off += OTA_SECTOR_BYTES) {
+        TEST_ASSERT_TRUE(writer.write(chunk.data(), chunk.size()));
+    }
+    TEST_ASSERT_FALSE(writer.write(chunk.data(), 1));
+    TEST_ASSERT_EQUAL_UINT32(PARTITION_BYTES, writer.offset());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_sha256_known_answers);
+    RUN_TEST(test_good_image_verifies_and_lands_in_flash);
+    RUN_TEST(test_corrupted_image_is_rejected);
+    RUN_TEST(test_truncated_image_and_bad_expected_hash_are_rejected);
+    RUN_TEST(test_resume_rehashes_prefix_from_flash);
+    RUN_TEST(test_image_larger_than_partition_fails);
+    return UNITY_END();
+}
@@ -0,0 +1,200 @@
+// ============================================================
+// OTA POLICY TESTS (pio test -e native)
+// Offer decision, rollout cohorts / waves and poll jitter
+// ============================================================
+
+#include <unity.h>
+
+#include <string.h>
+#include "config.h"
+#include "ota_policy.h"
+
+static const char *SHA = "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef";
+static const uint64_t MAC_BASE = 0x240AC4000000ULL;
+static const uint32_t T0 = 1760000000;
+
+static OtaOffer offer;
+static OtaRollout rollout;
+
+void setUp() {
+    memset(&offer, 0, sizeof(offer));
+    offer.version = "99.0.0";
+    offer.sha256 = SHA;
+    offer.hasDownloadUrl = true;
+    rollout = {100, 0, 0, 0, OTA_ROLLOUT_WAVE_S, "", false};
+}
+
+void tearDown() {}
+
+// ============================================================
+// OFFER
+// ============================================================
+static void test_same_version_is_none() {
+    OtaEncoding enc;
+    offer.version = FIRMWARE_VERSION;
+    TEST_ASSERT_EQUAL(OTA_ACT_NONE, otaDecide(offer, FIRMWARE_VERSION, enc));
+}
+
+static void test_malformed_sha_is_rejected() {
+    OtaEncoding enc;
+    offer.sha256 = "abc";
+    TEST_ASSERT_EQUAL(OTA_ACT_REJECT, otaDecide(offer, FIRMWARE_VERSION, enc));
+}
+
+static void test_delta_preferred_until_it_fails() {
+    OtaEncoding enc;
+    offer.fileSize = 1000000;
+    offer.hasDeltaUrl = true;
+    offer.hasGzipUrl = true;
+    TEST_ASSERT_EQUAL(OTA_ACT_INSTALL, otaDecide(offer, FIRMWARE_VERSION, enc));
+    TEST_ASSERT_EQUAL(OTA_ENC_DELTA, enc);
+
+    offer.encodedFailedBefore = true;
+    TEST_ASSERT_EQUAL(OTA_ACT_INSTALL, otaDecide(offer, FIRMWARE_VERSION, enc));
+    TEST_ASSERT_EQUAL(OTA_ENC_RAW, enc);
+}
+
+// A bad published image is skipped until version.json offers another sha256
+static void test_failed_image_blocked_until_sha_changes() {
+    OtaEncoding enc;
+    offer.imageFailedBefore = true;
+    TEST_ASSERT_EQUAL(OTA_ACT_BLOCKED, otaDecide(offer, FIRMWARE_VERSION, enc));
+    offer.version = FIRMWARE_VERSION;
+    TEST_ASSERT_EQUAL(OTA_ACT_NONE, otaDecide(offer, FIRMWARE_VERSION, enc));
+
+    offer.version = "99.0.1";
+    offer.imageFailedBefore = false;   // new sha256 in version.json
+    TEST_ASSERT_EQUAL(OTA_ACT_INSTALL, otaDecide(offer, FIRMWARE_VERSION, enc));
+}
+
+static void test_version_compare() {
+    TEST_ASSERT_TRUE(otaVersionCompare("1.10.0", "1.9.2") > 0);
+    TEST_ASSERT_TRUE(otaVersionCompare("v1.2", "1.2.0") == 0);
+    TEST_ASSERT_TRUE(otaVersionCompare("0.9.9", "1.0.0") < 0);
+}
+
+// ============================================================
+// ROLLOUT
+// ============================================================
+static void test_raising_percent_only_adds_devices() {
+    uint32_t start;
+    for (uint32_t i = 0; i < 2000; i++) {
+        rollout.percent = 10;
+        const bool inTen = otaRolloutDecide(rollout, "1.0.0", MAC_BASE + i, T0, 0, start) != OTA_ACT_NOT_SELECTED;
+        rollout.percent = 50;
+        const bool inFifty = otaRolloutDecide(rollout, "1.0.0", MAC_BASE + i, T0, 0, start) != OTA_ACT_NOT_SELECTED;
+        TEST_ASSERT_TRUE(!inTen || inFifty);
+    }
+}
+
+static void test_not_before_and_force_update() {
+    uint32_t start;
+    rollout.notBefore = T0 + 100;
+    TEST_ASSERT_EQUAL(OTA_ACT_DEFER, otaRolloutDecide(rollout, "1.0.0", MAC_BASE, T0, 0, start));
+    TEST_ASSERT_EQUAL_UINT32(T0 + 100, start);
+    TEST_ASSERT_EQUAL(OTA_ACT_INSTALL, otaRolloutDecide(rollout, "1.0.0", MAC_BASE, T0 + 100, 0, start));
+
+    rollout.forceUpdate = true;
+    TEST_ASSERT_EQUAL(OTA_ACT_INSTALL, otaRolloutDecide(rollout, "1.0.0", MAC_BASE, T0, 0, start));
+}
+
+// First device found in a wave after wave 0
+static uint64_t laterWaveDevice(uint32_t &startAfterSeen) {
+    for (uint32_t i = 0; i < 1000; i++) {
+        uint32_t start;
+        if (otaRolloutDecide(rollout, "1.0.0", MAC_BASE + i, T0, T0, start) == OTA_ACT_DEFER) {
+            startAfterSeen = start - T0;
+            return MAC_BASE + i;
+        }
+    }
+    return 0;
+}
+
+static void test_waves_count_from_first_sighting() {
+    rollout.maxConcurrent = 50;
+    rollout.fleetSize = 1000;
+    uint32_t offset = 0;
+    const uint64_t id = laterWaveDevice(offset);
+    TEST_ASSERT_TRUE(id != 0);
+    TEST_ASSERT_EQUAL_UINT32(0, offset % rollout.waveS);
+
+    uint32_t start;
+    TEST_ASSERT_EQUAL(OTA_ACT_DEFER, otaRolloutDecide(rollout, "1.0.0", id, T0 + offset - 1, T0, start));
+    TEST_ASSERT_EQUAL(OTA_ACT_INSTALL, otaRolloutDecide(rollout, "1.0.0", id, T0 + offset, T0, start));
+}
+
+static void test_wave_waits_for_clock() {
+    rollout.maxConcurrent = 50;
+    rollout.fleetSize = 1000;
+    uint32_t offset = 0;
+    const uint64_t id = laterWaveDevice(offset);
+
+    uint32_t start;
+    TEST_ASSERT_EQUAL(OTA_ACT_DEFER, otaRolloutDecide(rollout, "1.0.0", id, 45, 0, start));
+    TEST_ASSERT_EQUAL_UINT32(0, start);
+}
+
+static void test_sighting_before_ntp_sync_is_ignored() {
+    // Regression: a first sighting stored as uptime seconds (45) kept
+    // the device deferred until reboot
+    rollout.maxConcurrent = 50;
+    rollout.fleetSize = 1000;
+    uint32_t offset = 0;
+    const uint64_t id = laterWaveDevice(offset);
+
+    uint32_t start;
+    TEST_ASSERT_EQUAL(OTA_ACT_DEFER, otaRolloutDecide(rollout, "1.0.0", id, T0, 45, start));
+    TEST_ASSERT_EQUAL_UINT32(T0 + offset, start);
+    TEST_ASSERT_EQUAL(OTA_ACT_INSTALL, otaRolloutDecide(rollout, "1.0.0", id, T0 + offset, T0, start));
+}
+
+// ============================================================
+// JITTER
+// ============================================================
+static void test_check_interval_jitter_bounds() {
+    uint32_t state = otaJitterSeed(MAC_BASE);
+    const uint32_t interval = OTA_CHECK_INTERVAL_SECONDS * 1000UL;
+    for (int i = 0; i < 1000; i++) {
+        const uint32_t next = otaNextCheckMs(0, state);
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(interval, next);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(interval + (uint32_t)((uint64_t)interval * OTA_CHECK_JITTER_PCT / 100), next);
+    }
+}
+
+static void test_failed_checks_back_off_to_the_cap() {
+    const uint32_t interval = OTA_CHECK_INTERVAL_SECONDS * 1000UL;
+    TEST_ASSERT_EQUAL_UINT32(0, otaCheckBackoffMs(0));
+    TEST_ASSERT_EQUAL_UINT32(interval, otaCheckBackoffMs(1));
+    TEST_ASSERT_EQUAL_UINT32(2 * interval, otaCheckBackoffMs(2));
+    TEST_ASSERT_EQUAL_UINT32(4 * interval, otaCheckBackoffMs(3));
+    uint32_t last = 0;
+    for (int failures = 1; failures <= 255; failures++) {
+        const uint32_t backoff = otaCheckBackoffMs((uint8_t)failures);
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(last, backoff);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(OTA_CHECK_BACKOFF_MAX_MS, backoff);
+        last = backoff;
+    }
+    TEST_ASSERT_EQUAL_UINT32(OTA_CHECK_BACKOFF_MAX_MS, last);
+
+    // The jittered wait follows the backoff, and drops back after a success
+    uint32_t state = otaJitterSeed(MAC_BASE);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(OTA_CHECK_BACKOFF_MAX_MS, otaNextCheckMs(40, state));
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(interval + interval * OTA_CHECK_JITTER_PCT / 100, otaNextCheckMs(0, state));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_same_version_is_none);
+    RUN_TEST(test_malformed_sha_is_rejected);
+    RUN_TEST(test_delta_preferred_until_it_fails);
+    RUN_TEST(test_failed_image_blocked_until_sha_changes);
+    RUN_TEST(test_version_compare);
+    RUN_TEST(test_raising_percent_only_adds_devices);
+    RUN_TEST(test_not_before_and_force_update);
+    RUN_TEST(test_waves_count_from_first_sighting);
+    RUN_TEST(test_wave_waits_for_clock);
+    RUN_TEST(test_sighting_before_ntp_sync_is_ignored);
+    RUN_TEST(test_check_interval_jitter_bounds);
+    RUN_TEST(test_failed_checks_back_off_to_the_cap);
+    return UNITY_END();
+}
@@ -0,0 +1,173 @@
+// ============================================================
+// OTA RESUME TESTS (pio test -e native)
+// Connections cut at random offsets, resumed with Range from the
+// NVS checkpoint, with and without a reboot in between; the
+// partition is a FileFlashRegion, the writer the real one
+// ============================================================
+
+#include <unity.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "config.h"
+#include "flash_region.h"
+#include "ota_image_writer.h"
+#include "ota_policy.h"
+#include "sha256.h"
+
+static const char *IMAGE = "test_ota_resume.img";
+static const uint32_t PARTITION_BYTES = 512 * OTA_SECTOR_BYTES;   // 2 MB
+
+static FileFlashRegion region;
+static std::vector<uint8_t> firmware;
+static char firmwareSha[2 * Sha256::DIGEST_BYTES + 1];
+static uint8_t scratch[OTA_BUFFER_BYTES];
+
+void setUp() {
+    remove(IMAGE);
+    TEST_ASSERT_TRUE(region.open(IMAGE, PARTITION_BYTES, OTA_SECTOR_BYTES));
+    firmware.resize(1700000 + 321);   // the 1.7 MB image from the field
+    srand(9);
+    for (size_t i = 0; i < firmware.size(); i++) firmware[i] = (uint8_t)rand();
+    Sha256 sha;
+    uint8_t digest[Sha256::DIGEST_BYTES];
+    sha.update(firmware.data(), firmware.size());
+    sha.finish(digest);
+    Sha256::toHex(digest, firmwareSha);
+}
+
+void tearDown() {
+    region.close();
+    remove(IMAGE);
+}
+
+static void test_content_range_parsing() {
+    uint32_t first, total;
+    TEST_ASSERT_TRUE(otaParseContentRange("bytes 65536-1700320/1700321", first, total));
+    TEST_ASSERT_EQUAL_UINT32(65536, first);
+    TEST_ASSERT_EQUAL_UINT32(1700321, total);
+    TEST_ASSERT_TRUE(otaParseContentRange("bytes 0-0/1", first, total));
+
+    TEST_ASSERT_FALSE(otaParseContentRange("", first, total));
+    TEST_ASSERT_FALSE(otaParseContentRange("bytes */1700321", first, total));
+    TEST_ASSERT_FALSE(otaParseContentRange("bytes 10-5/100", first, total));
+    TEST_ASSERT_FALSE(otaParseContentRange("bytes 0-100/100", first, total));
+    TEST_ASSERT_FALSE(otaParseContentRange("bytes 0-99/*", first, total));
+    TEST_ASSERT_FALSE(otaParseContentRange("bytes 0-99/100x", first, total));
+    TEST_ASSERT_FALSE(otaParseContentRange("bytes 0-99/99999999999", first, total));
+}
+
+// The job loop of OTAManager: checkpoint every OTA_CHECKPOINT_BYTES and
+// on every interruption, always sector aligned. A retry within the job
+// continues at the exact offset; a reboot resumes from the checkpoint
+// and loses only what came after it
+struct ResumeRun {
+    uint32_t sessions;
+    uint32_t reboots;
+    uint64_t bytesOnWire;
+};
+
+static ResumeRun downloadWithCuts(unsigned seed, uint32_t maxSessionBytes, int rebootsPer10kSegments) {
+    srand(seed);
+    ResumeRun run = {0, 0, 0};
+    uint32_t checkpoint = 0;          // NVS dl_off
+    const uint32_t total = firmware.size();
+    OtaImageWriter *writer = new OtaImageWriter(region);
+    writer->restart();
+
+    while (writer->offset() < total) {
+        TEST_ASSERT_TRUE(run.sessions < 10000);
+        run.sessions++;
+        // Range GET from the writer's offset; the server cuts somewhere
+        const uint32_t from = writer->offset();
+        uint32_t cut = from + 1 + (uint32_t)(((uint64_t)rand() * rand()) % maxSessionBytes);
+        if (cut > total) cut = total;
+
+        uint32_t pos = from;
+        bool crashed = false;
+        while (pos < cut) {
+            uint32_t n = 1 + rand() % 1460;   // one TCP segment at a time
+            if (n > cut - pos) n = cut - pos;
+            TEST_ASSERT_TRUE(writer->write(&firmware[pos], n));
+            pos += n;
+            run.bytesOnWire += n;
+            if (pos - checkpoint >= OTA_CHECKPOINT_BYTES) checkpoint = pos & ~(OTA_SECTOR_BYTES - 1);
+            if (rand() % 10000 < rebootsPer10kSegments) {   // power cut mid-stream
+                crashed = true;
+                break;
+            }
+        }
+        if (writer->offset() == total) break;
+
+        if (crashed) {
+            // New job after boot: resume from NVS, re-hash the prefix
+            run.reboots++;
+            delete writer;
+            writer = new OtaImageWriter(region);
+            TEST_ASSERT_TRUE(writer->resume(checkpoint, scratch, sizeof(scratch)));
+        } else {
+            // Interrupted: save the aligned offset, retry with Range
+            checkpoint = writer->offset() & ~(OTA_SECTOR_BYTES - 1);
+        }
+    }
+
+    char actual[65];
+    TEST_ASSERT_TRUE(writer->verify(firmwareSha, actual));
+    delete writer;
+
+    std::vector<uint8_t> back(total);
+    TEST_ASSERT_TRUE(region.read(0, back.data(), total));
+    TEST_ASSERT_EQUAL_MEMORY(firmware.data(), back.data(), total);
+    return run;
+}
+
+static void report(const char *label, const ResumeRun &run) {
+    char line[128];
+    snprintf(line, sizeof(line), "%s: %lu sessions, %lu reboots, %.2fx the image on the wire", label,
+             (unsigned long)run.sessions, (unsigned long)run.reboots,
+             (double)run.bytesOnWire / firmware.size());
+    TEST_MESSAGE(line);
+}
+
+static void test_random_cuts_resume_to_a_verified_image() {
+    for (unsigned seed = 1; seed <= 3; seed++) {
+        const ResumeRun run = downloadWithCuts(seed, 200000, 0);
+        TEST_ASSERT_TRUE(run.sessions > 5);
+        // Retries within the job re-fetch nothing
+        TEST_ASSERT_EQUAL_UINT64(firmware.size(), run.bytesOnWire);
+        if (seed == 1) report("cuts every <200 KB", run);
+    }
+}
+
+static void test_reboots_resume_from_last_checkpoint() {
+    const ResumeRun run = downloadWithCuts(42, 400000, 20);
+    TEST_ASSERT_TRUE(run.reboots > 0);
+    // A reboot re-fetches at most one checkpoint interval (+ a sector)
+    TEST_ASSERT_TRUE(run.bytesOnWire <=
+                     firmware.size() + (uint64_t)run.reboots * (OTA_CHECKPOINT_BYTES + OTA_SECTOR_BYTES));
+    report("cuts + power loss", run);
+}
+
+static void test_tiny_sessions_still_finish() {
+    firmware.resize(300000);
+    Sha256 sha;
+    uint8_t digest[Sha256::DIGEST_BYTES];
+    sha.update(firmware.data(), firmware.size());
+    sha.finish(digest);
+    Sha256::toHex(digest, firmwareSha);
+    // Sessions shorter than a sector still add up byte for byte
+    const ResumeRun run = downloadWithCuts(7, OTA_SECTOR_BYTES / 2, 0);
+    TEST_ASSERT_EQUAL_UINT64(firmware.size(), run.bytesOnWire);
+    report("cuts every <2 KB", run);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_content_range_parsing);
+    RUN_TEST(test_random_cuts_resume_to_a_verified_image);
+    RUN_TEST(test_reboots_resume_from_last_checkpoint);
+    RUN_TEST(test_tiny_sessions_still_finish);
+    return UNITY_END();
+}
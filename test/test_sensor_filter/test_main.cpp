@@ -0,0 +1,179 @@
+// ============================================================
+// SENSOR FILTER TESTS (pio test -e native)
+// Values in 1/100 °C, as fed by the sensor registry
+// ============================================================
+
+#include <unity.h>
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "config.h"
+#include "sensor_filter.h"
+
+static const SensorChannelConfig PROBE = {
+    -5500, 8499,    // as the registry: -127 °C dropout and 85 °C reset value are out of range
+    DS18B20_MAX_RATE_CENTI_PER_S,
+    SENSOR_FILTER_MIN_STEP_CENTI,
+    SENSOR_STALE_MS,
+};
+
+void setUp() {}
+void tearDown() {}
+
+static void test_ring_window_keeps_last_n_oldest_first() {
+    RingWindow<int, 3> w;
+    for (int i = 1; i <= 5; i++) w.push(i);
+    TEST_ASSERT_TRUE(w.full());
+    TEST_ASSERT_EQUAL_INT(3, w.at(0));
+    TEST_ASSERT_EQUAL_INT(5, w.at(2));
+    w.clear();
+    TEST_ASSERT_EQUAL_UINT32(0, w.size());
+}
+
+static void test_median_drops_single_spike() {
+    MedianFilter<int32_t, 5> m;
+    const int32_t in[] = {100, 101, 2500, 99, 100, 102};
+    int32_t out = 0;
+    for (int32_t v : in) {
+        out = m.update(v);
+        TEST_ASSERT_TRUE(out < 200);
+    }
+    TEST_ASSERT_EQUAL_INT32(101, out);   // median of 101 2500 99 100 102
+}
+
+// Fractional state: a 1-count step still converges with shift 4
+static void test_ema_converges_without_truncation_stall() {
+    EmaFilter<int32_t, 4> e;
+    TEST_ASSERT_EQUAL_INT32(1000, e.update(1000));   // primed on the first sample
+    for (int i = 0; i < 200; i++) e.update(1001);
+    TEST_ASSERT_EQUAL_INT32(1001, e.value());
+    for (int i = 0; i < 200; i++) e.update(-500);
+    TEST_ASSERT_EQUAL_INT32(-500, e.value());
+}
+
+static void test_rate_limiter_rejects_outlier_and_reacquires_step() {
+    RateLimiter<int32_t> r(100, 25);
+    TEST_ASSERT_TRUE(r.check(1000, 0));
+    TEST_ASSERT_TRUE(r.check(1100, 750));        // 25 + 75 allowed
+    TEST_ASSERT_FALSE(r.check(3000, 1500));      // spike
+    TEST_ASSERT_TRUE(r.check(1120, 2250));       // back on track
+    TEST_ASSERT_FALSE(r.stepped());
+
+    // A real step: three agreeing rejects in a row are taken
+    TEST_ASSERT_FALSE(r.check(2500, 3000));
+    TEST_ASSERT_FALSE(r.check(2510, 3750));
+    TEST_ASSERT_TRUE(r.check(2505, 4500));
+    TEST_ASSERT_TRUE(r.stepped());
+    TEST_ASSERT_FALSE(r.stepped());
+}
+
+static void test_channel_dropout_goes_stale_and_recovers() {
+    SensorChannel<> ch(PROBE);
+    uint32_t t = 0;
+    for (; t < 10000; t += 750) TEST_ASSERT_TRUE(ch.update(450, t));
+    TEST_ASSERT_TRUE(ch.valid());
+    TEST_ASSERT_EQUAL_INT32(450, ch.value());
+
+    // -127 °C dropouts: held until SENSOR_STALE_MS, then invalid
+    const uint32_t lastGood = t - 750;
+    for (; t - lastGood < SENSOR_STALE_MS; t += 750) {
+        TEST_ASSERT_FALSE(ch.update(-12700, t));
+        TEST_ASSERT_TRUE(ch.valid());
+        TEST_ASSERT_EQUAL_INT32(450, ch.value());
+    }
+    TEST_ASSERT_FALSE(ch.update(-12700, t));
+    TEST_ASSERT_FALSE(ch.valid());
+
+    // Back at a different temperature: no rate limit against stale data
+    t += 750;
+    TEST_ASSERT_TRUE(ch.update(900, t));
+    TEST_ASSERT_TRUE(ch.valid());
+    TEST_ASSERT_EQUAL_INT32(900, ch.value());
+    TEST_ASSERT_EQUAL_UINT32(0, ch.stats().outliers);
+    TEST_ASSERT_TRUE(ch.stats().outOfRange > 0);
+}
+
+// Noise, glitches and fault codes at 1 °C, inside the 0..2 °C
+// refrigeration band, must never reach either threshold
+static void test_noisy_stream_stays_inside_hysteresis_band() {
+    SensorChannel<> ch(PROBE);
+    srand(42);
+    const int32_t truth = 100;   // 1.00 °C
+    int32_t lo = truth, hi = truth;
+    double rawErr = 0, filtErr = 0;
+    uint32_t n = 0;
+    for (uint32_t t = 0; t < 3600000; t += 750, n++) {
+        int32_t raw = truth + (rand() % 13) - 6;         // +/-0.06 °C noise
+        if (rand() % 200 == 0) raw += 2000;              // bus glitch
+        if (rand() % 500 == 0) raw = 8500;               // 85 °C power-on reset value
+        if (rand() % 500 == 0) raw = -12700;             // dropout
+        ch.update(raw, t);
+        if (n < 5) continue;
+        lo = ch.value() < lo ? ch.value() : lo;
+        hi = ch.value() > hi ? ch.value() : hi;
+        rawErr += (double)(raw - truth) * (raw - truth);
+        filtErr += (double)(ch.value() - truth) * (ch.value() - truth);
+    }
+    TEST_ASSERT_TRUE(ch.valid());
+    TEST_ASSERT_TRUE(lo > DEFAULT_REFRIG_OFF_TEMP2_C * 100 && hi < DEFAULT_REFRIG_ON_TEMP2_C * 100);
+    TEST_ASSERT_TRUE(hi - lo <= 15);   // raw noise alone spans 0.12 °C, glitches 20 °C
+    TEST_ASSERT_TRUE(ch.stats().outliers > 0);
+    TEST_ASSERT_EQUAL_UINT32(0, ch.stats().steps);
+    char line[96];
+    snprintf(line, sizeof(line), "RMS error raw %.1f, filtered %.2f (1/100 degC)", sqrt(rawErr / n),
+             sqrt(filtErr / n));
+    TEST_MESSAGE(line);
+}
+
+static void test_real_step_is_followed_within_a_few_samples() {
+    SensorChannel<> ch(PROBE);
+    uint32_t t = 0;
+    for (int i = 0; i < 20; i++, t += 750) ch.update(2000, t);
+    int samples = 0;
+    while (ch.value() < 2900 && samples < 20) {
+        ch.update(3000, t);   // door opened: +10 °C
+        t += 750;
+        samples++;
+    }
+    TEST_ASSERT_TRUE(samples <= 6);
+    TEST_ASSERT_EQUAL_UINT32(1, ch.stats().steps);
+}
+
+// ============================================================
+// BENCHMARK: cost of one SensorChannel<>::update()
+// ============================================================
+static void test_bench_channel_update() {
+    SensorChannel<> ch(PROBE);
+    static int32_t raw[4096];
+    srand(7);
+    for (size_t i = 0; i < 4096; i++) raw[i] = 2000 + (rand() % 21) - 10 + (i % 997 == 0 ? 3000 : 0);
+
+    const uint32_t N = 2000000;
+    int64_t sink = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < N; i++) {
+        ch.update(raw[i & 4095], i * 750);
+        sink += ch.value();
+    }
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / N;
+    char line[96];
+    snprintf(line, sizeof(line), "SensorChannel<>::update: %.1f ns/sample on host, %u bytes of state (checksum %lld)",
+             ns, (unsigned)sizeof(SensorChannel<>), (long long)sink);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(ns < 2000.0);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_ring_window_keeps_last_n_oldest_first);
+    RUN_TEST(test_median_drops_single_spike);
+    RUN_TEST(test_ema_converges_without_truncation_stall);
+    RUN_TEST(test_rate_limiter_rejects_outlier_and_reacquires_step);
+    RUN_TEST(test_channel_dropout_goes_stale_and_recovers);
+    RUN_TEST(test_noisy_stream_stays_inside_hysteresis_band);
+    RUN_TEST(test_real_step_is_followed_within_a_few_samples);
+    RUN_TEST(test_bench_channel_update);
+    return UNITY_END();
+}
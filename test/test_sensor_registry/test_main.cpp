@@ -0,0 +1,136 @@
+// ============================================================
+// SENSOR REGISTRY TESTS (pio test -e native)
+// Enumeration, naming, primary probe tracking and replacement
+// on simulated OneWire buses
+// ============================================================
+
+#include <unity.h>
+
+#include <string.h>
+#include "config.h"
+#include "hal.h"
+#include "sensor_registry.h"
+
+static uint32_t nowMs;
+
+void setUp() {
+    nowMs = simClock.millis();
+}
+
+void tearDown() {}
+
+// One conversion + collect, far enough apart for the rate limiter
+static void cycle(SensorRegistry &registry, uint32_t stepMs = 1000) {
+    nowMs += stepMs;
+    registry.requestConversion();
+    registry.collect(nowMs);
+}
+
+static float celsius(const SensorProbe *p) {
+    return p->filter.value() / 100.0f;
+}
+
+static void test_first_probe_per_bus_is_primary() {
+    SimTempBus bus1, bus2;
+    bus1.addProbe(0x100, 4.0f);
+    bus1.addProbe(0x101, 6.0f);
+    bus2.addProbe(0x200, 20.0f);
+
+    SensorRegistry registry;
+    registry.addBus(bus1);
+    registry.addBus(bus2);
+    registry.begin(12);
+    TEST_ASSERT_EQUAL(3, registry.count());
+
+    SensorProbe *p1 = registry.primary(0);
+    SensorProbe *p2 = registry.primary(1);
+    TEST_ASSERT_NOT_NULL(p1);
+    TEST_ASSERT_NOT_NULL(p2);
+    TEST_ASSERT_EQUAL_STRING("temp1", p1->name);
+    TEST_ASSERT_EQUAL_STRING("temp2", p2->name);
+    TEST_ASSERT_NOT_NULL(registry.find("temp1_2"));
+    TEST_ASSERT_TRUE(registry.find("temp1_2") != p1);
+
+    cycle(registry);
+    TEST_ASSERT_TRUE(p1->filter.valid());
+    TEST_ASSERT_FLOAT_WITHIN(0.07f, 4.0f, celsius(p1));
+    TEST_ASSERT_FLOAT_WITHIN(0.07f, 20.0f, celsius(p2));
+}
+
+static void test_primary_tracked_by_slot_not_name() {
+    SimTempBus bus1;
+    bus1.addProbe(0x100, 4.0f);
+    SensorRegistry registry;
+    registry.addBus(bus1);
+    registry.begin(12);
+
+    SensorProbe *p1 = registry.primary(0);
+    strcpy(p1->name, "freezer");      // as if named by SENSOR_PROBE_NAMES
+    TEST_ASSERT_NULL(registry.find("temp1"));
+    TEST_ASSERT_TRUE(registry.primary(0) == p1);
+    TEST_ASSERT_NULL(registry.primary(1));
+}
+
+static void test_replacement_probe_takes_over_the_primary_slot() {
+    SimTempBus bus1;
+    const int old = bus1.addProbe(0x100, 4.0f);
+    bus1.addProbe(0x101, 6.0f);
+    SensorRegistry registry;
+    registry.addBus(bus1);
+    registry.begin(12);
+    SensorProbe *p1 = registry.primary(0);
+    cycle(registry);
+
+    // Primary unplugged, a new probe wired in its place
+    bus1.setPresent(old, false);
+    bus1.addProbe(0x1FF, 3.0f);
+    for (int i = 0; i < SENSOR_RESCAN_FAILURES; i++) cycle(registry);
+    cycle(registry, SENSOR_RESCAN_INTERVAL_MS);
+
+    TEST_ASSERT_EQUAL(2, registry.count());
+    TEST_ASSERT_TRUE(registry.primary(0) == p1);
+    TEST_ASSERT_EQUAL_STRING("temp1", p1->name);
+    TEST_ASSERT_TRUE(p1->present);
+    TEST_ASSERT_EQUAL_UINT8(0xFF, p1->rom[1]);
+
+    for (int i = 0; i < 5; i++) cycle(registry);
+    TEST_ASSERT_TRUE(p1->filter.valid());
+    TEST_ASSERT_FLOAT_WITHIN(0.07f, 3.0f, celsius(p1));
+    TEST_ASSERT_FLOAT_WITHIN(0.07f, 6.0f, celsius(registry.find("temp1_2")));
+}
+
+static void test_other_probe_is_not_promoted() {
+    SimTempBus bus1;
+    const int old = bus1.addProbe(0x100, 4.0f);
+    bus1.addProbe(0x101, 6.0f);
+    SensorRegistry registry;
+    registry.addBus(bus1);
+    registry.begin(12);
+    SensorProbe *p1 = registry.primary(0);
+    cycle(registry);
+
+    bus1.setPresent(old, false);
+    for (int i = 0; i < SENSOR_RESCAN_FAILURES; i++) cycle(registry);
+    cycle(registry, SENSOR_RESCAN_INTERVAL_MS);
+    cycle(registry, SENSOR_STALE_MS);
+
+    TEST_ASSERT_TRUE(registry.primary(0) == p1);
+    TEST_ASSERT_FALSE(p1->present);
+    TEST_ASSERT_FALSE(p1->filter.valid());
+    TEST_ASSERT_TRUE(registry.find("temp1_2")->filter.valid());
+
+    // Back on the bus: same slot, no duplicate
+    bus1.setPresent(old, true);
+    cycle(registry, SENSOR_RESCAN_INTERVAL_MS);
+    TEST_ASSERT_EQUAL(2, registry.count());
+    TEST_ASSERT_TRUE(p1->present);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_probe_per_bus_is_primary);
+    RUN_TEST(test_primary_tracked_by_slot_not_name);
+    RUN_TEST(test_replacement_probe_takes_over_the_primary_slot);
+    RUN_TEST(test_other_probe_is_not_promoted);
+    return UNITY_END();
+}
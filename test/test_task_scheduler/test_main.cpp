@@ -0,0 +1,144 @@
+// ============================================================
+// TASK SCHEDULER TESTS (pio test -e native)
+// Fake clock: callbacks "take time" by advancing it
+// ============================================================
+
+#include <unity.h>
+
+#include <string.h>
+#include "task_scheduler.h"
+
+static uint32_t fakeNow;
+static uint32_t fakeClock() { return fakeNow; }
+
+static char order[32];
+static size_t orderLen;
+static uint32_t workMs;         // how long the next callback takes
+static uint32_t startTimes[64];
+static size_t startCount;
+
+static void record(char c) {
+    if (orderLen < sizeof(order) - 1) order[orderLen++] = c;
+    if (startCount < 64) startTimes[startCount++] = fakeNow;
+    fakeNow += workMs;
+}
+static void taskA() { record('A'); }
+static void taskB() { record('B'); }
+static void taskC() { record('C'); }
+
+void setUp() {
+    fakeNow = 1000;
+    memset(order, 0, sizeof(order));
+    orderLen = 0;
+    workMs = 0;
+    startCount = 0;
+}
+
+void tearDown() {}
+
+// Run everything due, stepping the clock 1 ms at a time until untilMs
+static void runUntil(TaskScheduler &s, uint32_t untilMs) {
+    while ((int32_t)(fakeNow - untilMs) < 0) {
+        if (!s.runNext()) fakeNow++;
+    }
+}
+
+static void test_fixed_grid_has_no_drift() {
+    TaskScheduler s(fakeClock);
+    const int id = s.addTask("ctl", taskA, 100);
+    s.start();
+    workMs = 7;   // every run costs 7 ms; "now + period" would drift 7 ms/run
+    runUntil(s, 1000 + 100 * 50);
+
+    TEST_ASSERT_EQUAL_UINT32(50, s.task(id)->stats.runs);
+    for (size_t i = 0; i < startCount; i++) {
+        TEST_ASSERT_EQUAL_UINT32(1000 + 100 * i, startTimes[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, s.task(id)->stats.maxLatenessMs);
+    TEST_ASSERT_EQUAL_UINT32(0, s.task(id)->stats.deadlineMisses);
+}
+
+static void test_overrun_skips_missed_periods_without_burst() {
+    TaskScheduler s(fakeClock);
+    const int id = s.addTask("net", taskA, 100);
+    s.start();
+
+    workMs = 350;   // first run overruns three and a half periods
+    TEST_ASSERT_TRUE(s.runNext());
+    TEST_ASSERT_EQUAL_UINT32(1350, fakeNow);
+    const ScheduledTask *t = s.task(id);
+    TEST_ASSERT_EQUAL_UINT32(3, t->stats.skippedPeriods);
+    TEST_ASSERT_EQUAL_UINT32(1400, t->nextDueMs);   // stays on the grid
+    TEST_ASSERT_EQUAL_UINT32(1, t->stats.deadlineMisses);
+
+    // No catch-up burst: nothing due until the next grid slot
+    TEST_ASSERT_FALSE(s.runNext());
+    TEST_ASSERT_EQUAL_UINT32(50, s.msUntilNextDue());
+    workMs = 0;
+    fakeNow = 1400;
+    TEST_ASSERT_TRUE(s.runNext());
+    TEST_ASSERT_EQUAL_UINT32(2, t->stats.runs);
+}
+
+static void test_priority_order_and_overdue_tiebreak() {
+    TaskScheduler s(fakeClock);
+    s.addTask("low", taskA, 100, 10, 1);
+    s.addTask("high", taskB, 100, 5, 5);
+    s.addTask("low2", taskC, 100, 0, 1);   // longest overdue of the two lows
+    s.start();
+    fakeNow += 20;
+
+    while (s.runNext()) {}
+    TEST_ASSERT_EQUAL_STRING("BCA", order);
+}
+
+static void test_high_priority_not_pushed_back_by_overrun() {
+    TaskScheduler s(fakeClock);
+    const int ctl = s.addTask("ctl", taskA, 100, 0, 10);
+    s.addTask("net", taskB, 1000, 50, 1);
+    s.start();
+
+    // net runs at 1050 and takes 80 ms; ctl was due at 1100
+    runUntil(s, 1050);
+    workMs = 80;
+    runUntil(s, 1051);
+    workMs = 0;
+    TEST_ASSERT_EQUAL_STRING("AB", order);
+    TEST_ASSERT_EQUAL_UINT32(1130, fakeNow);
+    TEST_ASSERT_TRUE(s.runNext());
+    TEST_ASSERT_EQUAL_STRING("ABA", order);
+    TEST_ASSERT_EQUAL_UINT32(30, s.task(ctl)->stats.lastLatenessMs);
+    TEST_ASSERT_EQUAL_UINT32(1200, s.task(ctl)->nextDueMs);   // still on the grid
+}
+
+static void test_table_full_and_bad_args() {
+    TaskScheduler s(fakeClock);
+    TEST_ASSERT_EQUAL_INT(-1, s.addTask("none", nullptr, 100));
+    TEST_ASSERT_EQUAL_INT(-1, s.addTask("zero", taskA, 0));
+    for (int i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        TEST_ASSERT_EQUAL_INT(i, s.addTask("t", taskA, 100));
+    }
+    TEST_ASSERT_EQUAL_INT(-1, s.addTask("over", taskA, 100));
+    TEST_ASSERT_NULL(s.task(SCHEDULER_MAX_TASKS));
+}
+
+static void test_millis_wrap() {
+    fakeNow = 0xFFFFFF00u;
+    TaskScheduler s(fakeClock);
+    const int id = s.addTask("ctl", taskA, 100);
+    s.start();
+    runUntil(s, 0x00000200u);
+    TEST_ASSERT_EQUAL_UINT32(8, s.task(id)->stats.runs);
+    TEST_ASSERT_EQUAL_UINT32(0, s.task(id)->stats.skippedPeriods);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_fixed_grid_has_no_drift);
+    RUN_TEST(test_overrun_skips_missed_periods_without_burst);
+    RUN_TEST(test_priority_order_and_overdue_tiebreak);
+    RUN_TEST(test_high_priority_not_pushed_back_by_overrun);
+    RUN_TEST(test_table_full_and_bad_args);
+    RUN_TEST(test_millis_wrap);
+    return UNITY_END();
+}
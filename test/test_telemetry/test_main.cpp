@@ -0,0 +1,153 @@
+// ============================================================
+// TELEMETRY TESTS (pio test -e native)
+// Multi-path payload building and the delta tracker
+// ============================================================
+
+#include <unity.h>
+
+#include <string.h>
+#include "config.h"
+#include "telemetry.h"
+
+static TelemetrySnapshot snap;
+static TelemetryPayload payload;
+
+void setUp() {
+    memset(&snap, 0, sizeof(snap));
+    snap.temp1 = 1.5f;
+    snap.temp2 = 22.25f;
+    snap.ambientTemp = 24.0f;
+    snap.ambientHumidity = 55.0f;
+    snap.temp1Valid = snap.temp2Valid = snap.ambientValid = true;
+    snap.heaterOn = true;
+    snap.autoMode = true;
+    snap.rssi = -61;
+    snap.freeHeap = 180000;
+    snap.uptimeS = 3600;
+    snap.epoch = 1700000000;
+}
+
+void tearDown() {}
+
+static bool contains(const char *needle) {
+    return strstr(payload.c_str(), needle) != nullptr;
+}
+
+// ============================================================
+// PAYLOAD
+// ============================================================
+static void test_full_payload_is_one_json_object() {
+    TEST_ASSERT_TRUE(buildTelemetryPayload(snap, payload));
+    const char *json = payload.c_str();
+    TEST_ASSERT_EQUAL('{', json[0]);
+    TEST_ASSERT_EQUAL('}', json[payload.length() - 1]);
+    TEST_ASSERT_EQUAL(strlen(json), payload.length());
+    TEST_ASSERT_TRUE(contains("\"sensors/temp1\":1.50"));
+    TEST_ASSERT_TRUE(contains("\"sensors/temp2\":22.25"));
+    TEST_ASSERT_TRUE(contains("\"sensors/temperature_unit\":\"" TEMPERATURE_UNIT_LABEL "\""));
+    TEST_ASSERT_TRUE(contains("\"relays/heater_state\":true"));
+    TEST_ASSERT_TRUE(contains("\"relays/refrig_state\":false"));
+    TEST_ASSERT_TRUE(contains("\"status/rssi\":-61"));
+    TEST_ASSERT_TRUE(contains("\"status/last_seen\":1700000000"));
+    TEST_ASSERT_FALSE(payload.overflowed());
+}
+
+static void test_selected_fields_only() {
+    TEST_ASSERT_TRUE(buildTelemetryPayload(snap, TF_TEMP1 | TF_FAN_STATE, payload));
+    TEST_ASSERT_EQUAL(2, payload.fieldCount());
+    TEST_ASSERT_EQUAL_STRING("{\"sensors/temp1\":1.50,\"relays/fan_state\":false}", payload.c_str());
+}
+
+static void test_invalid_sensors_reported_disconnected() {
+    snap.temp2Valid = false;
+    snap.ambientValid = false;
+    TEST_ASSERT_TRUE(buildTelemetryPayload(snap, payload));
+    TEST_ASSERT_TRUE(contains("\"sensors/temp2\":\"disconnected\""));
+    TEST_ASSERT_TRUE(contains("\"sensors/ambient_temp\":\"disconnected\""));
+    TEST_ASSERT_TRUE(contains("\"sensors/ambient_humidity\":\"disconnected\""));
+    TEST_ASSERT_TRUE(contains("\"sensors/valid\":true"));
+}
+
+static void test_non_finite_float_is_not_emitted_as_json_number() {
+    payload.reset();
+    payload.addFloat("sensors/temp1", 0.0f / 0.0f);
+    TEST_ASSERT_TRUE(payload.finish());
+    TEST_ASSERT_EQUAL_STRING("{\"sensors/temp1\":\"disconnected\"}", payload.c_str());
+}
+
+static void test_extra_probes_published_by_name() {
+    snap.probeCount = 2;
+    snap.probeName[0] = "freezer";
+    snap.probeTemp[0] = -18.0f;
+    snap.probeValid[0] = true;
+    snap.probeName[1] = "door";
+    snap.probeValid[1] = false;
+    TEST_ASSERT_TRUE(buildTelemetryPayload(snap, TF_PROBES, payload));
+    TEST_ASSERT_EQUAL_STRING("{\"sensors/freezer\":-18.00,\"sensors/door\":\"disconnected\"}",
+                             payload.c_str());
+}
+
+static void test_overflow_is_sticky_and_never_closed() {
+    payload.reset();
+    char path[64];
+    memset(path, 'x', sizeof(path) - 1);
+    path[sizeof(path) - 1] = '\0';
+    for (int i = 0; i < TELEMETRY_PAYLOAD_MAX_BYTES / 32; i++) {
+        payload.addUInt(path, (uint32_t)i);
+    }
+    TEST_ASSERT_TRUE(payload.overflowed());
+    TEST_ASSERT_FALSE(payload.finish());
+    TEST_ASSERT_LESS_THAN(TELEMETRY_PAYLOAD_MAX_BYTES, payload.length());
+    TEST_ASSERT_NOT_EQUAL('}', payload.c_str()[payload.length() - 1]);
+}
+
+// ============================================================
+// DELTA TRACKER
+// ============================================================
+static void test_tracker_sends_everything_first() {
+    TelemetryTracker tracker;
+    TEST_ASSERT_EQUAL_UINT32(TF_ALL, tracker.select(snap, 0));
+}
+
+static void test_tracker_honours_deadbands() {
+    TelemetryTracker tracker;
+    tracker.commit(snap, TF_ALL, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, tracker.select(snap, 1000));
+
+    snap.temp1 += TELEMETRY_DEADBAND_TEMP_C / 2;
+    TEST_ASSERT_EQUAL_UINT32(0, tracker.select(snap, 1000));
+
+    snap.temp1 += TELEMETRY_DEADBAND_TEMP_C;
+    const uint32_t fields = tracker.select(snap, 1000);
+    TEST_ASSERT_EQUAL_UINT32(TF_TEMP1 | TF_LAST_UPDATE, fields);
+    tracker.commit(snap, fields, 1000);
+    TEST_ASSERT_EQUAL_UINT32(0, tracker.select(snap, 2000));
+
+    snap.refrigOn = true;
+    TEST_ASSERT_EQUAL_UINT32(TF_REFRIG_STATE, tracker.select(snap, 2000));
+}
+
+static void test_tracker_heartbeat_and_full_sync() {
+    TelemetryTracker tracker;
+    tracker.commit(snap, TF_ALL, 0);
+    TEST_ASSERT_EQUAL_UINT32(TF_LAST_SEEN | TF_UPTIME,
+                             tracker.select(snap, FIREBASE_HEARTBEAT_INTERVAL_MS));
+    TEST_ASSERT_EQUAL_UINT32(TF_ALL, tracker.select(snap, FIREBASE_FULL_SYNC_INTERVAL_MS));
+
+    tracker.invalidate();
+    TEST_ASSERT_EQUAL_UINT32(TF_ALL, tracker.select(snap, 1));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_full_payload_is_one_json_object);
+    RUN_TEST(test_selected_fields_only);
+    RUN_TEST(test_invalid_sensors_reported_disconnected);
+    RUN_TEST(test_non_finite_float_is_not_emitted_as_json_number);
+    RUN_TEST(test_extra_probes_published_by_name);
+    RUN_TEST(test_overflow_is_sticky_and_never_closed);
+    RUN_TEST(test_tracker_sends_everything_first);
+    RUN_TEST(test_tracker_honours_deadbands);
+    RUN_TEST(test_tracker_heartbeat_and_full_sync);
+    return UNITY_END();
+}
@@ -0,0 +1,139 @@
+// ============================================================
+// TELEMETRY PUSH BENCHMARK (pio test -e native)
+// Round-trips and bytes for one hour of pushes against SimRtdb:
+// one request per field (the original pushToFirebase()), one
+// batched multi-path PATCH, and batched + delta
+// ============================================================
+
+#include <unity.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "config.h"
+#include "hal.h"
+#include "telemetry.h"
+#include "transport.h"
+
+static const uint32_t BENCH_CYCLES = 3600000UL / FIREBASE_UPDATE_INTERVAL_MS;   // one hour
+
+struct PushCost {
+    uint32_t roundTrips;
+    uint32_t bytes;       // path + JSON body per request
+};
+
+static TelemetrySnapshot snap;
+static TelemetryPayload payload;
+
+void setUp() {
+    memset(&snap, 0, sizeof(snap));
+    simRtdb.online = true;
+    simRtdb.updates = 0;
+    simRtdb.bytes = 0;
+}
+
+void tearDown() {}
+
+// Slow plant drift, sensor noise, a relay switching every few minutes
+static void plantAt(uint32_t cycle) {
+    const float t = cycle * (FIREBASE_UPDATE_INTERVAL_MS / 1000.0f);
+    const float noise = ((cycle * 2654435761u) >> 24) / 255.0f * 0.1f - 0.05f;
+    snap.temp1 = 1.0f + 1.0f * sinf(t / 600.0f) + noise;
+    snap.temp2 = 31.0f + 2.0f * sinf(t / 900.0f) - noise;
+    snap.ambientTemp = 24.0f + 0.5f * sinf(t / 3600.0f);
+    snap.ambientHumidity = 50.0f + 3.0f * sinf(t / 1800.0f);
+    snap.temp1Valid = snap.temp2Valid = snap.ambientValid = true;
+    snap.refrigOn = snap.temp1 > 1.0f;
+    snap.heaterOn = snap.temp2 < 31.0f;
+    snap.fanOn = (cycle / 24) % 3 != 2;
+    snap.autoMode = true;
+    snap.rssi = -60 - (int32_t)(cycle % 7);
+    snap.freeHeap = 180000 - (cycle % 5) * 512;
+    snap.minFreeHeap = 170000;
+    snap.maxAllocHeap = 110000;
+    snap.uptimeS = (uint32_t)t;
+    snap.epoch = 1760000000 + (uint32_t)t;
+}
+
+// The original path: one setFloat/setBool/... request per field
+static PushCost runPerField() {
+    PushCost cost = {0, 0};
+    for (uint32_t c = 0; c < BENCH_CYCLES; c++) {
+        plantAt(c);
+        for (uint32_t bit = 1; bit < TF_ALL; bit <<= 1) {
+            if (!buildTelemetryPayload(snap, bit, payload) || payload.fieldCount() == 0) continue;
+            // {"sensors/temp1":1.50} -> PUT <base>/sensors/temp1 with body 1.50
+            const char *doc = payload.c_str();
+            const char *colon = strstr(doc, "\":");
+            char path[96];
+            snprintf(path, sizeof(path), "%s/%.*s", FIREBASE_BASE_PATH, (int)(colon - doc - 2), doc + 2);
+            char value[48];
+            snprintf(value, sizeof(value), "%.*s", (int)(payload.length() - (colon - doc) - 3), colon + 2);
+            TEST_ASSERT_TRUE(hal.rtdb->update(path, value));
+            cost.roundTrips++;
+            cost.bytes += strlen(path) + strlen(value);
+        }
+    }
+    return cost;
+}
+
+static PushCost runBatched(bool delta) {
+    TelemetryTracker tracker;
+    PushCost cost = {0, 0};
+    for (uint32_t c = 0; c < BENCH_CYCLES; c++) {
+        plantAt(c);
+        const uint32_t nowMs = c * FIREBASE_UPDATE_INTERVAL_MS;
+        const uint32_t fields = delta ? tracker.select(snap, nowMs) : TF_ALL;
+        if (!fields) continue;
+        TEST_ASSERT_TRUE(buildTelemetryPayload(snap, fields, payload));
+        TEST_ASSERT_TRUE(transport->publishTelemetry(payload.c_str()));
+        tracker.commit(snap, fields, nowMs);
+        cost.roundTrips++;
+        cost.bytes += strlen(FIREBASE_BASE_PATH) + payload.length();
+    }
+    return cost;
+}
+
+static void report(const char *label, const PushCost &cost) {
+    char line[128];
+    snprintf(line, sizeof(line), "%-16s %6lu round-trips  %8lu bytes  (%.1f per push cycle)", label,
+             (unsigned long)cost.roundTrips, (unsigned long)cost.bytes,
+             (double)cost.roundTrips / BENCH_CYCLES);
+    TEST_MESSAGE(line);
+}
+
+static void test_push_round_trips_and_bytes_per_hour() {
+    const PushCost perField = runPerField();
+    TEST_ASSERT_EQUAL_UINT32(perField.roundTrips, simRtdb.updates);
+    simRtdb.updates = 0;
+    const PushCost batched = runBatched(false);
+    TEST_ASSERT_EQUAL_UINT32(batched.roundTrips, simRtdb.updates);
+    TEST_ASSERT_EQUAL_STRING(FIREBASE_BASE_PATH, simRtdb.lastPath.c_str());
+    const PushCost delta = runBatched(true);
+
+    report("per field", perField);
+    report("batched", batched);
+    report("batched + delta", delta);
+
+    // One request per cycle instead of one per field
+    TEST_ASSERT_EQUAL_UINT32(BENCH_CYCLES, batched.roundTrips);
+    TEST_ASSERT_GREATER_THAN(15 * BENCH_CYCLES, perField.roundTrips);
+    // Delta pushes skip quiet cycles and send fewer fields
+    TEST_ASSERT_LESS_THAN(batched.roundTrips, delta.roundTrips);
+    TEST_ASSERT_LESS_THAN(batched.bytes / 2, delta.bytes);
+}
+
+static void test_offline_push_fails_without_counting() {
+    simRtdb.online = false;
+    TEST_ASSERT_FALSE(transport->ready());
+    TEST_ASSERT_TRUE(buildTelemetryPayload(snap, payload));
+    TEST_ASSERT_FALSE(transport->publishTelemetry(payload.c_str()));
+    TEST_ASSERT_EQUAL_UINT32(0, simRtdb.updates);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_push_round_trips_and_bytes_per_hour);
+    RUN_TEST(test_offline_push_fails_without_counting);
+    return UNITY_END();
+}
@@ -0,0 +1,238 @@
+// ============================================================
+// TIME-SERIES STORE TESTS (pio test -e native)
+// FileFlashRegion image; a remount is a close + reopen +
+// begin(), as after a reset
+// ============================================================
+
+#include <unity.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "config.h"
+#include "flash_region.h"
+#include "timeseries.h"
+
+static const char *IMAGE = "test_timeseries.img";
+static const uint32_t SECTOR = 4096;
+static const uint32_t EPOCH0 = 1760000000;
+
+// Same image, read() only: exercises the copy path used without a mapping
+class UnmappedRegion : public FileFlashRegion {
+public:
+    const uint8_t *map() override { return nullptr; }
+};
+
+static UnmappedRegion region;
+static uint32_t regionBytes;
+
+static void openImage(uint32_t sectors) {
+    regionBytes = sectors * SECTOR;
+    TEST_ASSERT_TRUE(region.open(IMAGE, regionBytes, SECTOR));
+}
+
+static void remount(TimeSeriesStore &ts) {
+    region.close();
+    TEST_ASSERT_TRUE(region.open(IMAGE, regionBytes, SECTOR));
+    TEST_ASSERT_TRUE(ts.begin());
+}
+
+static TsConfig exactConfig() {
+    TsConfig c = {2, 600, 1024, {0, 0, 0, 0}};
+    return c;
+}
+
+// Random walk with occasional jumps, dropouts and relay changes
+static std::vector<TsSample> makeSeries(size_t n, uint32_t periodS, unsigned seed) {
+    srand(seed);
+    std::vector<TsSample> out(n);
+    int16_t v[TS_NUMERIC_CHANNELS] = {40, 300, 240, 500};
+    uint8_t relays = TS_RELAY_AUTO;
+    for (size_t i = 0; i < n; i++) {
+        TsSample &s = out[i];
+        s.epoch = EPOCH0 + i * periodS;
+        for (int ch = 0; ch < TS_NUMERIC_CHANNELS; ch++) {
+            const int r = rand() % 100;
+            if (r < 2) v[ch] += (rand() % 2000) - 1000;   // beyond the 8-bit delta
+            else if (r < 40) v[ch] += (rand() % 7) - 3;
+            s.value[ch] = (rand() % 500 == 0) ? TS_INVALID : v[ch];
+        }
+        if (rand() % 60 == 0) relays ^= 1 << (rand() % 3);
+        s.relays = relays;
+    }
+    return out;
+}
+
+struct Collect {
+    std::vector<TsSample> samples;
+};
+
+static bool collect(void *ctx, const TsSample &s) {
+    static_cast<Collect *>(ctx)->samples.push_back(s);
+    return true;
+}
+
+static void expectSame(const TsSample &want, const TsSample &got) {
+    TEST_ASSERT_EQUAL_UINT32(want.epoch, got.epoch);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(want.value, got.value, TS_NUMERIC_CHANNELS);
+    TEST_ASSERT_EQUAL_UINT8(want.relays, got.relays);
+}
+
+void setUp() {
+    remove(IMAGE);
+}
+
+void tearDown() {
+    region.close();
+    remove(IMAGE);
+}
+
+static void test_round_trip_3000_samples_with_remounts() {
+    openImage(16);
+    TimeSeriesStore ts(region, exactConfig());
+    TEST_ASSERT_TRUE(ts.begin());
+    const std::vector<TsSample> series = makeSeries(3000, 2, 7);
+
+    for (size_t i = 0; i < series.size(); i++) {
+        TEST_ASSERT_TRUE(ts.append(series[i]));
+        if (i % 400 == 399) {
+            TEST_ASSERT_TRUE(ts.flush());
+            remount(ts);
+            TEST_ASSERT_EQUAL_UINT32(series[i].epoch, ts.newestEpoch());
+        }
+    }
+
+    Collect got;
+    TEST_ASSERT_EQUAL_UINT32(series.size(), ts.query(0, UINT32_MAX, collect, &got));
+    for (size_t i = 0; i < series.size(); i++) expectSame(series[i], got.samples[i]);
+
+    TEST_ASSERT_TRUE(ts.flush());
+    remount(ts);
+    got.samples.clear();
+    TEST_ASSERT_EQUAL_UINT32(series.size(), ts.query(0, UINT32_MAX, collect, &got));
+    for (size_t i = 0; i < series.size(); i++) expectSame(series[i], got.samples[i]);
+    TEST_ASSERT_EQUAL_UINT32(EPOCH0, ts.oldestEpoch());
+}
+
+// Without flush() a reset loses the RAM block only; begin() picks up
+// the last sealed sample
+static void test_unflushed_remount_loses_open_block_only() {
+    openImage(4);
+    TimeSeriesStore ts(region, exactConfig());
+    TEST_ASSERT_TRUE(ts.begin());
+    const std::vector<TsSample> series = makeSeries(200, 2, 11);
+    for (size_t i = 0; i < 150; i++) TEST_ASSERT_TRUE(ts.append(series[i]));
+    TEST_ASSERT_TRUE(ts.flush());
+    for (size_t i = 150; i < 200; i++) TEST_ASSERT_TRUE(ts.append(series[i]));
+
+    remount(ts);
+    TEST_ASSERT_EQUAL_UINT32(series[149].epoch, ts.newestEpoch());
+    Collect got;
+    TEST_ASSERT_EQUAL_UINT32(150, ts.query(0, UINT32_MAX, collect, &got));
+    expectSame(series[149], got.samples.back());
+}
+
+static void test_gap_and_range_query() {
+    openImage(4);
+    TimeSeriesStore ts(region, exactConfig());
+    TEST_ASSERT_TRUE(ts.begin());
+    std::vector<TsSample> series = makeSeries(100, 2, 3);
+    for (size_t i = 50; i < 100; i++) series[i].epoch += 3600;   // an hour offline
+    for (size_t i = 0; i < series.size(); i++) TEST_ASSERT_TRUE(ts.append(series[i]));
+    TEST_ASSERT_TRUE(ts.flush());
+    TEST_ASSERT_EQUAL_UINT32(2, ts.blocksSealed());
+
+    Collect got;
+    TEST_ASSERT_EQUAL_UINT32(10, ts.query(series[60].epoch, series[69].epoch, collect, &got));
+    for (size_t i = 0; i < 10; i++) expectSame(series[60 + i], got.samples[i]);
+    TEST_ASSERT_EQUAL_UINT32(2, ts.lastQueryBlocksScanned());
+    TEST_ASSERT_EQUAL_UINT32(1, ts.lastQueryBlocksDecoded());
+    TEST_ASSERT_EQUAL_UINT32(0, ts.query(series[49].epoch + 1, series[50].epoch - 1, collect, &got));
+}
+
+static void test_wrap_keeps_newest_contiguous() {
+    openImage(3);
+    TsConfig cfg = exactConfig();
+    cfg.sealIntervalS = 120;
+    TimeSeriesStore ts(region, cfg);
+    TEST_ASSERT_TRUE(ts.begin());
+    const std::vector<TsSample> series = makeSeries(20000, 2, 5);
+    for (size_t i = 0; i < series.size(); i++) TEST_ASSERT_TRUE(ts.append(series[i]));
+    TEST_ASSERT_TRUE(ts.flush());
+    remount(ts);
+
+    Collect got;
+    const size_t n = ts.query(0, UINT32_MAX, collect, &got);
+    TEST_ASSERT_TRUE(n > 0 && n < series.size());
+    TEST_ASSERT_EQUAL_UINT32(got.samples.front().epoch, ts.oldestEpoch());
+    const size_t first = series.size() - n;
+    for (size_t i = 0; i < n; i++) expectSame(series[first + i], got.samples[i]);
+}
+
+// ============================================================
+// BENCHMARK: a day of 2 s samples with the shipped config
+// ============================================================
+static void test_bench_bytes_per_sample_and_blocks_scanned() {
+    FileFlashRegion mapped;   // mmap'd like the flash cache on target
+    TEST_ASSERT_TRUE(mapped.open(IMAGE, HISTORY_BYTES, SECTOR));
+    TEST_ASSERT_NOT_NULL(mapped.map());
+    const TsConfig cfg = {
+        HISTORY_SAMPLE_PERIOD_S,
+        HISTORY_SEAL_INTERVAL_S,
+        HISTORY_BLOCK_MAX_BYTES,
+        {HISTORY_DEADBAND_TEMP_DECI, HISTORY_DEADBAND_TEMP_DECI, HISTORY_DEADBAND_TEMP_DECI, HISTORY_DEADBAND_RH_DECI},
+    };
+    TimeSeriesStore ts(mapped, cfg);
+    TEST_ASSERT_TRUE(ts.begin());
+
+    // Slow plant cycles plus +/-0.1 sensor noise, relays every ~10 min
+    const uint32_t samples = 86400 / HISTORY_SAMPLE_PERIOD_S;
+    srand(1);
+    for (uint32_t i = 0; i < samples; i++) {
+        const uint32_t t = i * HISTORY_SAMPLE_PERIOD_S;
+        const int phase = (t / 600) % 2;
+        TsSample s;
+        s.epoch = EPOCH0 + t;
+        s.value[TS_CH_TEMP1] = (int16_t)(phase ? 20 - (t % 600) / 30 : (t % 600) / 30) + rand() % 3 - 1;
+        s.value[TS_CH_TEMP2] = (int16_t)(310 + (t / 900) % 20) + rand() % 3 - 1;
+        s.value[TS_CH_AMBIENT] = (int16_t)(240 + (t / 3600) % 10) + rand() % 3 - 1;
+        s.value[TS_CH_HUMIDITY] = (int16_t)(500 + (t / 1800) % 30) + rand() % 3 - 1;
+        s.relays = TS_RELAY_AUTO | TS_RELAY_FAN | (phase ? TS_RELAY_REFRIG : TS_RELAY_HEATER);
+        TEST_ASSERT_TRUE(ts.append(s));
+    }
+    TEST_ASSERT_TRUE(ts.flush());
+
+    const uint32_t used = ts.bytesUsed();
+    const double perSample = (double)used / samples;
+    char line[128];
+    snprintf(line, sizeof(line), "%lu samples in %lu bytes: %.2f bytes/sample (%u raw), %lu blocks",
+             (unsigned long)samples, (unsigned long)used, perSample, (unsigned)sizeof(TsSample),
+             (unsigned long)ts.blocksSealed());
+    TEST_MESSAGE(line);
+
+    // One hour out of the middle of the day
+    Collect got;
+    const uint32_t from = EPOCH0 + 12 * 3600;
+    const size_t n = ts.query(from, from + 3599, collect, &got);
+    snprintf(line, sizeof(line), "1 h query: %lu samples, %lu blocks scanned, %lu decoded",
+             (unsigned long)n, (unsigned long)ts.lastQueryBlocksScanned(),
+             (unsigned long)ts.lastQueryBlocksDecoded());
+    TEST_MESSAGE(line);
+
+    TEST_ASSERT_EQUAL_UINT32(3600 / HISTORY_SAMPLE_PERIOD_S, n);
+    TEST_ASSERT_EQUAL_UINT32(ts.blocksSealed(), ts.lastQueryBlocksScanned());
+    TEST_ASSERT_LESS_OR_EQUAL(3600 / HISTORY_SEAL_INTERVAL_S + 1, ts.lastQueryBlocksDecoded());
+    TEST_ASSERT_TRUE(perSample < 2.0);
+    mapped.close();
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_3000_samples_with_remounts);
+    RUN_TEST(test_unflushed_remount_loses_open_block_only);
+    RUN_TEST(test_gap_and_range_query);
+    RUN_TEST(test_wrap_keeps_newest_contiguous);
+    RUN_TEST(test_bench_bytes_per_sample_and_blocks_scanned);
+    return UNITY_END();
+}
@@ -0,0 +1,81 @@
+// ============================================================
+// TRANSPORT COMMAND TESTS (pio test -e native)
+// Broker message -> (path, value) as MqttTransport hands it to
+// the command handler: root prefix, cleared retained values,
+// values too long for the buffer
+// ============================================================
+
+#include <unity.h>
+
+#include <string.h>
+#include "config.h"
+#include "transport.h"
+
+static const char *path;
+static char value[TRANSPORT_COMMAND_VALUE_BYTES];
+
+static bool parse(const char *topic, const char *payload) {
+    path = nullptr;
+    memset(value, 0x55, sizeof(value));
+    return parseTransportCommand(MQTT_TOPIC_ROOT, topic, (const uint8_t *)payload, strlen(payload), path, value,
+                                 sizeof(value));
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_path_below_the_root() {
+    TEST_ASSERT_TRUE(parse(MQTT_TOPIC_ROOT "/relays/control/heater", "true"));
+    TEST_ASSERT_EQUAL_STRING("relays/control/heater", path);
+    TEST_ASSERT_EQUAL_STRING("true", value);
+
+    TEST_ASSERT_TRUE(parse(MQTT_TOPIC_ROOT "/settings/heater_onTemp", "31.5"));
+    TEST_ASSERT_EQUAL_STRING("settings/heater_onTemp", path);
+    TEST_ASSERT_EQUAL_STRING("31.5", value);
+}
+
+static void test_topics_outside_the_root_are_refused() {
+    TEST_ASSERT_FALSE(parse("other/device/settings/heater_onTemp", "31.5"));
+    TEST_ASSERT_FALSE(parse(MQTT_TOPIC_ROOT "2/settings/heater_onTemp", "31.5"));   // sibling device id
+    TEST_ASSERT_FALSE(parse(MQTT_TOPIC_ROOT, "31.5"));
+    TEST_ASSERT_FALSE(parse("espota", "31.5"));
+    TEST_ASSERT_NULL(path);
+}
+
+static void test_empty_retained_payload_is_ignored() {
+    // Clearing a retained setting must not apply "" (strtof -> 0)
+    TEST_ASSERT_FALSE(parse(MQTT_TOPIC_ROOT "/settings/heater_onTemp", ""));
+    TEST_ASSERT_NULL(path);
+}
+
+static void test_overlong_value_is_rejected_not_truncated() {
+    char longest[TRANSPORT_COMMAND_VALUE_BYTES];
+    memset(longest, '1', sizeof(longest) - 1);
+    longest[sizeof(longest) - 1] = '\0';
+    TEST_ASSERT_TRUE(parse(MQTT_TOPIC_ROOT "/settings/refrig_onTemp", longest));
+    TEST_ASSERT_EQUAL_STRING(longest, value);
+
+    // One digit more: truncating would apply a number 10x smaller
+    TEST_ASSERT_FALSE(parse(MQTT_TOPIC_ROOT "/settings/refrig_onTemp", "1111111111111111111111111"));
+    TEST_ASSERT_FALSE(parse(MQTT_TOPIC_ROOT "/settings/heater_onTemp", "30.000000000000000000000001"));
+    TEST_ASSERT_NULL(path);
+    TEST_ASSERT_EQUAL_UINT8(0x55, (uint8_t)value[0]);   // buffer untouched
+}
+
+static void test_payload_is_not_nul_terminated() {
+    // Broker payloads are raw bytes: only length counts
+    const char raw[] = "25.0GARBAGE";
+    TEST_ASSERT_TRUE(parseTransportCommand(MQTT_TOPIC_ROOT, MQTT_TOPIC_ROOT "/settings/heater_offTemp",
+                                           (const uint8_t *)raw, 4, path, value, sizeof(value)));
+    TEST_ASSERT_EQUAL_STRING("25.0", value);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_path_below_the_root);
+    RUN_TEST(test_topics_outside_the_root_are_refused);
+    RUN_TEST(test_empty_retained_payload_is_ignored);
+    RUN_TEST(test_overlong_value_is_rejected_not_truncated);
+    RUN_TEST(test_payload_is_not_nul_terminated);
+    return UNITY_END();
+}